@@ -0,0 +1,442 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "Commandlets/RTIKBenchCommandlet.h"
+#include "IK/Constraints.h"
+#include "IK/IKSolveRecorder.h"
+#include "IK/RangeLimitedFABRIK.h"
+#include "Testing/RTIKTestChains.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+
+namespace
+{
+	typedef TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> FBenchJsonWriter;
+
+	const float BenchBoneLength = 10.0f;
+
+	// Targets per configuration. Each is solved Repeats times.
+	const int32 NumBenchTargets = 16;
+
+	struct FBenchResult
+	{
+		FBenchResult()
+			:
+			NumSolves(0),
+			TotalSeconds(0.0),
+			TotalIterations(0),
+			NumConverged(0),
+			TotalError(0.0),
+			TotalExcessError(0.0),
+			MaxError(0.0f)
+		{ }
+
+		int32 NumSolves;
+		double TotalSeconds;
+		int64 TotalIterations;
+		int32 NumConverged;
+
+		// Distance from effector to target. Excess error is the part of it that is not forced by the target being out of reach.
+		double TotalError;
+		double TotalExcessError;
+		float MaxError;
+
+		// Accuracy is measured once per target, not once per repeat
+		void AddOutcome(const FIKSolveStats& Stats, float Error, float UnavoidableError)
+		{
+			TotalIterations  += Stats.Iterations;
+			NumConverged     += (Stats.Termination == EIKSolveTermination::IK_Converged ||
+				Stats.Termination == EIKSolveTermination::IK_AlreadyAtTarget) ? 1 : 0;
+			TotalError       += Error;
+			TotalExcessError += FMath::Max(Error - UnavoidableError, 0.0f);
+			MaxError          = FMath::Max(MaxError, Error);
+		}
+
+		void Write(const FBenchJsonWriter& Writer, int32 NumOutcomes, bool bHasIterations) const
+		{
+			Writer->WriteValue(TEXT("ns_per_solve"), NumSolves > 0 ? TotalSeconds * 1.0e9 / NumSolves : 0.0);
+			if (bHasIterations)
+			{
+				Writer->WriteValue(TEXT("mean_iterations"), static_cast<double>(TotalIterations) / NumOutcomes);
+				Writer->WriteValue(TEXT("converged_fraction"), static_cast<double>(NumConverged) / NumOutcomes);
+			}
+			Writer->WriteValue(TEXT("mean_error"), TotalError / NumOutcomes);
+			Writer->WriteValue(TEXT("mean_excess_error"), TotalExcessError / NumOutcomes);
+			Writer->WriteValue(TEXT("max_error"), static_cast<double>(MaxError));
+		}
+	};
+
+	enum class EBenchSolver : uint8
+	{
+		FABRIK,
+		ClosedLoop,
+		CoarseToFine,
+		ParallelSegmented,
+		DampedLeastSquares,
+		Spline
+	};
+
+	const EBenchSolver BenchSolvers[] = { EBenchSolver::FABRIK, EBenchSolver::ClosedLoop, EBenchSolver::CoarseToFine,
+		EBenchSolver::ParallelSegmented, EBenchSolver::DampedLeastSquares, EBenchSolver::Spline };
+
+	// Bones per segment for the segmented solvers, so chains of 32 points and up are actually segmented
+	const int32 BenchSegmentLength = 8;
+
+	const TCHAR* GetBenchSolverName(EBenchSolver Solver)
+	{
+		switch (Solver)
+		{
+		case EBenchSolver::ClosedLoop:         return TEXT("SolveClosedLoopFABRIK");
+		case EBenchSolver::CoarseToFine:       return TEXT("SolveCoarseToFineFABRIK");
+		case EBenchSolver::ParallelSegmented:  return TEXT("SolveParallelSegmentedFABRIK");
+		case EBenchSolver::DampedLeastSquares: return TEXT("SolveDampedLeastSquares");
+		case EBenchSolver::Spline:             return TEXT("SolveSplineIK");
+		default:                               return TEXT("SolveRangeLimitedFABRIK");
+		}
+	}
+
+	void BenchChainSolver(const FBenchJsonWriter& Writer, EBenchSolver Solver, int32 NumPoints, float ConstraintDensity,
+		bool bReachable, int32 Repeats, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		FRTIKTestChain Chain;
+		Chain.Generate(Random, NumPoints, BenchBoneLength, ConstraintDensity);
+
+		TArray<FVector> SplineControlPoints;
+		TArray<float> SplineArcLengths;
+		FRangeLimitedFABRIK::ComputeSplineArcLengths(Chain.Transforms, SplineArcLengths);
+
+		TArray<FTransform> OutTransforms;
+		FIKSolveStats Stats;
+		FBenchResult Result;
+
+		for (int32 TargetIndex = 0; TargetIndex < NumBenchTargets; ++TargetIndex)
+		{
+			FVector Target = Chain.MakeTarget(Random, bReachable);
+
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Repeat = 0; Repeat < Repeats; ++Repeat)
+			{
+				switch (Solver)
+				{
+				case EBenchSolver::ClosedLoop:
+					FRangeLimitedFABRIK::SolveClosedLoopFABRIK(Chain.Transforms, Chain.Constraints, Target, OutTransforms,
+						10.0f, 1.0f, 0.01f, 20, nullptr, 1.0f, 0.0f, &Stats);
+					break;
+				case EBenchSolver::CoarseToFine:
+					FRangeLimitedFABRIK::SolveCoarseToFineFABRIK(Chain.Transforms, Chain.Constraints, Target, OutTransforms,
+						0.0f, 1.0f, 0.01f, 20, BenchSegmentLength, 3, EIKUnreachableRule::IK_Reach, nullptr, &Stats);
+					break;
+				case EBenchSolver::ParallelSegmented:
+					FRangeLimitedFABRIK::SolveParallelSegmentedFABRIK(Chain.Transforms, Chain.Constraints, Target,
+						OutTransforms, 0.0f, 1.0f, 0.01f, 20, BenchSegmentLength, 2, EIKUnreachableRule::IK_Reach, nullptr,
+						&Stats);
+					break;
+				case EBenchSolver::DampedLeastSquares:
+					FRangeLimitedFABRIK::SolveDampedLeastSquares(Chain.Transforms, Chain.Constraints, Target, OutTransforms,
+						0.01f, 20, 1.0f, EIKUnreachableRule::IK_Reach, nullptr, &Stats);
+					break;
+				case EBenchSolver::Spline:
+					FRangeLimitedFABRIK::SolveSplineIK(Chain.Transforms, Target, OutTransforms, SplineControlPoints,
+						SplineArcLengths, 0.01f, 20, EIKUnreachableRule::IK_Reach, nullptr, &Stats);
+					break;
+				default:
+					FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(Chain.Transforms, Chain.Constraints, Target, OutTransforms,
+						0.0f, 1.0f, 0.01f, 20, EIKUnreachableRule::IK_Reach, nullptr, 1.0f, 0.0f, &Stats);
+					break;
+				}
+			}
+			Result.TotalSeconds += FPlatformTime::Seconds() - StartTime;
+			Result.NumSolves    += Repeats;
+
+			float Error            = FVector::Dist(OutTransforms.Last().GetLocation(), Target);
+			float UnavoidableError = FMath::Max(FVector::Dist(Chain.Transforms[0].GetLocation(), Target) - Chain.Reach, 0.0f);
+			Result.AddOutcome(Stats, Error, UnavoidableError);
+		}
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("solver"), GetBenchSolverName(Solver));
+		Writer->WriteValue(TEXT("points"), NumPoints);
+		Writer->WriteValue(TEXT("constraint_density"), static_cast<double>(ConstraintDensity));
+		Writer->WriteValue(TEXT("reachable"), bReachable);
+		Result.Write(Writer, NumBenchTargets, true);
+		Writer->WriteObjectEnd();
+	}
+
+	// How many iterations FABRIK and DLS each take to bring the effector within Precision of reachable targets. The
+	// iteration limit is generous, so counts aren't cut short. A DLS iteration costs more than a FABRIK iteration, so
+	// time per solve is written too.
+	void BenchIterationsToPrecision(const FBenchJsonWriter& Writer, int32 NumPoints, float ConstraintDensity,
+		float Precision, int32 Repeats, int32 Seed)
+	{
+		const int32 IterationLimit = 200;
+
+		FRandomStream Random(Seed);
+		FRTIKTestChain Chain;
+		Chain.Generate(Random, NumPoints, BenchBoneLength, ConstraintDensity);
+
+		TArray<FTransform> OutTransforms;
+		FIKSolveStats Stats;
+		FBenchResult FABRIKResult;
+		FBenchResult DLSResult;
+
+		for (int32 TargetIndex = 0; TargetIndex < NumBenchTargets; ++TargetIndex)
+		{
+			FVector Target = Chain.MakeTarget(Random, true);
+
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Repeat = 0; Repeat < Repeats; ++Repeat)
+			{
+				FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(Chain.Transforms, Chain.Constraints, Target, OutTransforms,
+					0.0f, 1.0f, Precision, IterationLimit, EIKUnreachableRule::IK_Reach, nullptr, 1.0f, 0.0f, &Stats);
+			}
+			FABRIKResult.TotalSeconds += FPlatformTime::Seconds() - StartTime;
+			FABRIKResult.NumSolves    += Repeats;
+			FABRIKResult.AddOutcome(Stats, FVector::Dist(OutTransforms.Last().GetLocation(), Target), 0.0f);
+
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Repeat = 0; Repeat < Repeats; ++Repeat)
+			{
+				FRangeLimitedFABRIK::SolveDampedLeastSquares(Chain.Transforms, Chain.Constraints, Target, OutTransforms,
+					Precision, IterationLimit, 1.0f, EIKUnreachableRule::IK_Reach, nullptr, &Stats);
+			}
+			DLSResult.TotalSeconds += FPlatformTime::Seconds() - StartTime;
+			DLSResult.NumSolves    += Repeats;
+			DLSResult.AddOutcome(Stats, FVector::Dist(OutTransforms.Last().GetLocation(), Target), 0.0f);
+		}
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("points"), NumPoints);
+		Writer->WriteValue(TEXT("constraint_density"), static_cast<double>(ConstraintDensity));
+		Writer->WriteValue(TEXT("precision"), static_cast<double>(Precision));
+		Writer->WriteValue(TEXT("iteration_limit"), IterationLimit);
+		Writer->WriteObjectStart(TEXT("fabrik"));
+		FABRIKResult.Write(Writer, NumBenchTargets, true);
+		Writer->WriteObjectEnd();
+		Writer->WriteObjectStart(TEXT("dls"));
+		DLSResult.Write(Writer, NumBenchTargets, true);
+		Writer->WriteObjectEnd();
+		Writer->WriteObjectEnd();
+	}
+
+	void BenchNoisyThreePoint(const FBenchJsonWriter& Writer, bool bReachable, int32 Repeats, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		FNoisyThreePointClosedLoop Loop(
+			FTransform(FVector(50.0f, 0.0f, 0.0f)),
+			FTransform(FVector(0.0f, 50.0f, 0.0f)),
+			FTransform(FVector(0.0f, 0.0f, 0.0f)),
+			50.0f,
+			50.0f,
+			50.0f * FMath::Sqrt(2.0f));
+
+		FNoisyThreePointClosedLoop OutLoop;
+		FBenchResult Result;
+
+		for (int32 TargetIndex = 0; TargetIndex < NumBenchTargets; ++TargetIndex)
+		{
+			// Reachable targets are the effectors, jittered; unreachable ones are pulled well apart
+			FVector TargetA = Loop.EffectorATransform.GetLocation() + Random.GetUnitVector() * Random.FRandRange(0.0f, 15.0f);
+			FVector TargetB = Loop.EffectorBTransform.GetLocation() + Random.GetUnitVector() * Random.FRandRange(0.0f, 15.0f);
+			if (!bReachable)
+			{
+				FVector Midpoint = (TargetA + TargetB) * 0.5f;
+				TargetA = Midpoint + (TargetA - Midpoint) * 3.0f;
+				TargetB = Midpoint + (TargetB - Midpoint) * 3.0f;
+			}
+
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Repeat = 0; Repeat < Repeats; ++Repeat)
+			{
+				FRangeLimitedFABRIK::SolveNoisyThreePoint(Loop, FTransform(TargetA), FTransform(TargetB), OutLoop,
+					10.0f, 1.0f, 0.01f, 20);
+			}
+			Result.TotalSeconds += FPlatformTime::Seconds() - StartTime;
+			Result.NumSolves    += Repeats;
+
+			// The loop can't stretch, so any extra distance between the targets can't be closed
+			float Error = 0.5f * (FVector::Dist(OutLoop.EffectorATransform.GetLocation(), TargetA) +
+				FVector::Dist(OutLoop.EffectorBTransform.GetLocation(), TargetB));
+			float UnavoidableError = 0.5f * FMath::Max(FVector::Dist(TargetA, TargetB) - Loop.TargetABDistance, 0.0f);
+			Result.AddOutcome(FIKSolveStats(), Error, UnavoidableError);
+		}
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("solver"), TEXT("SolveNoisyThreePoint"));
+		Writer->WriteValue(TEXT("points"), 3);
+		Writer->WriteValue(TEXT("reachable"), bReachable);
+		Result.Write(Writer, NumBenchTargets, false);
+		Writer->WriteObjectEnd();
+	}
+
+	// Times each planar constraint on a fully constrained chain, once through the compiled table and once through
+	// the virtual FIKBoneConstraint::EnforceConstraint path. The chain is bent out of its plane first, so every
+	// enforcement has work to do.
+	void BenchConstraintEnforcement(const FBenchJsonWriter& Writer, int32 NumPoints, int32 Repeats, int32 Seed)
+	{
+		FRandomStream Random(Seed);
+		FRTIKTestChain Chain;
+		Chain.Generate(Random, NumPoints, BenchBoneLength, 1.0f);
+
+		TArray<FTransform> Bent = Chain.Transforms;
+		for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+		{
+			Bent[PointIndex].AddToTranslation(Random.GetUnitVector() * BenchBoneLength * 0.5f);
+		}
+
+		TArray<FTransform> Working;
+		int32 NumEnforcements = (NumPoints - 1) * Repeats * NumBenchTargets;
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Pass = 0; Pass < Repeats * NumBenchTargets; ++Pass)
+		{
+			Working = Bent;
+			for (int32 PointIndex = 0; PointIndex < NumPoints - 1; ++PointIndex)
+			{
+				FPlanarRotation::EnforceCompiled(Chain.Constraints.Entries[PointIndex],
+					Working[PointIndex].GetLocation(), Working[PointIndex + 1]);
+			}
+		}
+		double CompiledSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Pass = 0; Pass < Repeats * NumBenchTargets; ++Pass)
+		{
+			Working = Bent;
+			for (int32 PointIndex = 0; PointIndex < NumPoints - 1; ++PointIndex)
+			{
+				Chain.Constraints.Constraints[PointIndex]->EnforceConstraint(PointIndex, Chain.Transforms,
+					Chain.Constraints.Constraints, Working);
+			}
+		}
+		double VirtualSeconds = FPlatformTime::Seconds() - StartTime;
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("points"), NumPoints);
+		Writer->WriteValue(TEXT("compiled_ns_per_enforcement"), CompiledSeconds * 1.0e9 / NumEnforcements);
+		Writer->WriteValue(TEXT("virtual_ns_per_enforcement"), VirtualSeconds * 1.0e9 / NumEnforcements);
+		Writer->WriteObjectEnd();
+	}
+}
+
+URTIKBenchCommandlet::URTIKBenchCommandlet()
+{
+	IsClient     = false;
+	IsServer     = false;
+	IsEditor     = false;
+	LogToConsole = true;
+}
+
+int32 URTIKBenchCommandlet::Main(const FString& Params)
+{
+	FString OutputPath = FPaths::GameSavedDir() / TEXT("RTIK") / TEXT("Bench.json");
+	FParse::Value(*Params, TEXT("output="), OutputPath);
+
+	int32 Repeats = 50;
+	FParse::Value(*Params, TEXT("repeats="), Repeats);
+	Repeats = FMath::Max(Repeats, 1);
+
+	int32 Seed = 1;
+	FParse::Value(*Params, TEXT("seed="), Seed);
+
+	FString ReplayPath;
+	FParse::Value(*Params, TEXT("replay="), ReplayPath);
+
+	const int32 ChainLengths[]        = { 2, 3, 4, 8, 16, 32, 64, 128 };
+	const float ConstraintDensities[] = { 0.0f, 0.5f, 1.0f };
+
+	FString Json;
+	FBenchJsonWriter Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("seed"), Seed);
+	Writer->WriteValue(TEXT("repeats"), Repeats);
+	Writer->WriteValue(TEXT("targets_per_config"), NumBenchTargets);
+
+	UE_LOG(LogRTIK, Display, TEXT("RTIKBench: benchmarking chain solvers"));
+	Writer->WriteArrayStart(TEXT("chain_solvers"));
+	for (EBenchSolver Solver : BenchSolvers)
+	{
+		for (int32 NumPoints : ChainLengths)
+		{
+			for (float ConstraintDensity : ConstraintDensities)
+			{
+				for (bool bReachable : { true, false })
+				{
+					BenchChainSolver(Writer, Solver, NumPoints, ConstraintDensity, bReachable, Repeats, Seed);
+				}
+			}
+		}
+	}
+	Writer->WriteArrayEnd();
+
+	UE_LOG(LogRTIK, Display, TEXT("RTIKBench: comparing iterations to precision for FABRIK and DLS"));
+	Writer->WriteArrayStart(TEXT("iterations_to_precision"));
+	for (int32 NumPoints : ChainLengths)
+	{
+		for (float ConstraintDensity : ConstraintDensities)
+		{
+			for (float Precision : { 1.0f, 0.1f, 0.01f })
+			{
+				BenchIterationsToPrecision(Writer, NumPoints, ConstraintDensity, Precision, Repeats, Seed);
+			}
+		}
+	}
+	Writer->WriteArrayEnd();
+
+	UE_LOG(LogRTIK, Display, TEXT("RTIKBench: benchmarking SolveNoisyThreePoint"));
+	Writer->WriteArrayStart(TEXT("noisy_three_point"));
+	BenchNoisyThreePoint(Writer, true, Repeats, Seed);
+	BenchNoisyThreePoint(Writer, false, Repeats, Seed);
+	Writer->WriteArrayEnd();
+
+	UE_LOG(LogRTIK, Display, TEXT("RTIKBench: benchmarking constraint enforcement"));
+	Writer->WriteArrayStart(TEXT("constraint_enforcement"));
+	for (int32 NumPoints : ChainLengths)
+	{
+		BenchConstraintEnforcement(Writer, NumPoints, Repeats, Seed);
+	}
+	Writer->WriteArrayEnd();
+
+	if (!ReplayPath.IsEmpty())
+	{
+		TArray<FIKSolveRecord> Records;
+		if (!FIKSolveRecorder::LoadRecording(ReplayPath, Records))
+		{
+			UE_LOG(LogRTIK, Error, TEXT("RTIKBench: could not load recording %s"), *ReplayPath);
+			return 1;
+		}
+
+		UE_LOG(LogRTIK, Display, TEXT("RTIKBench: replaying %d recorded solves"), Records.Num());
+		FIKReplaySummary Summary;
+		FIKSolveReplayer::Replay(Records, Repeats, Summary);
+		FIKSolveReplayer::LogSummary(Summary);
+
+		Writer->WriteObjectStart(TEXT("replay"));
+		Writer->WriteValue(TEXT("file"), ReplayPath);
+		Writer->WriteValue(TEXT("records"), Summary.NumRecords);
+		Writer->WriteValue(TEXT("ns_per_solve"), Summary.GetNanosecondsPerSolve());
+		Writer->WriteValue(TEXT("recorded_iterations"), Summary.RecordedIterations);
+		Writer->WriteValue(TEXT("replayed_iterations"), Summary.ReplayedIterations);
+		Writer->WriteValue(TEXT("recorded_total_slop"), static_cast<double>(Summary.RecordedSlop));
+		Writer->WriteValue(TEXT("replayed_total_slop"), static_cast<double>(Summary.ReplayedSlop));
+		Writer->WriteValue(TEXT("mismatched"), Summary.NumMismatched);
+		Writer->WriteValue(TEXT("targets_mismatched"), Summary.NumTargetsMismatched);
+		Writer->WriteValue(TEXT("not_compared"), Summary.NumApproximate);
+		Writer->WriteValue(TEXT("max_deviation"), static_cast<double>(Summary.MaxDeviation));
+		Writer->WriteObjectEnd();
+	}
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	if (!FFileHelper::SaveStringToFile(Json, *OutputPath))
+	{
+		UE_LOG(LogRTIK, Error, TEXT("RTIKBench: could not write %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogRTIK, Display, TEXT("RTIKBench: wrote %s"), *OutputPath);
+	return 0;
+}
@@ -1,257 +1,340 @@
-// Copyright(c) Henry Cooney 2017
-
-#include "rtik.h"
-#include "AnimNode_HumanoidLegIK.h"
-#include "Components/SkeletalMeshComponent.h"
-#include "TwoBoneIK.h"
-#include "RangeLimitedFABRIK.h"
-#include "Utility/AnimUtil.h"
-
-#if WITH_EDITOR
-#include "Utility/DebugDrawUtil.h"
-#endif
-
-DECLARE_CYCLE_STAT(TEXT("IK Humanoid Leg IK Eval"), STAT_HumanoidLegIK_Eval, STATGROUP_Anim);
-
-void FAnimNode_HumanoidLegIK::Initialize_AnyThread(const FAnimationInitializeContext & Context)
-{
-	Super::Initialize_AnyThread(Context);
-	BaseComponentPose.Initialize(Context);
-}
-
-void FAnimNode_HumanoidLegIK::CacheBones_AnyThread(const FAnimationCacheBonesContext & Context)
-{
-	Super::CacheBones_AnyThread(Context);
-	BaseComponentPose.CacheBones(Context);
-}
-
-void FAnimNode_HumanoidLegIK::UpdateInternal(const FAnimationUpdateContext & Context)
-{
-	BaseComponentPose.Update(Context);
-	DeltaTime = Context.GetDeltaTime();	
-}
-
-void FAnimNode_HumanoidLegIK::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext & Output, TArray<FBoneTransform>& OutBoneTransforms)
-{
-	SCOPE_CYCLE_COUNTER(STAT_HumanoidLegIK_Eval);
-
-#if ENABLE_ANIM_DEBUG
-	check(Output.AnimInstanceProxy->GetSkelMeshComponent());
-#endif
-	check(OutBoneTransforms.Num() == 0);
-
-	// Input pin pointers are checked in IsValid -- don't need to check here
-
-	USkeletalMeshComponent* SkelComp   = Output.AnimInstanceProxy->GetSkelMeshComponent();
-	
-	FMatrix ToCS               = SkelComp->GetComponentToWorld().ToMatrixNoScale().Inverse();
-	FTransform HipCSTransform  = FAnimUtil::GetBoneCSTransform(*SkelComp, Output.Pose, Leg->Chain.HipBone.BoneIndex);
-	FTransform KneeCSTransform = FAnimUtil::GetBoneCSTransform(*SkelComp, Output.Pose, Leg->Chain.ThighBone.BoneIndex);
-	FTransform FootCSTransform = FAnimUtil::GetBoneCSTransform(*SkelComp, Output.Pose, Leg->Chain.ShinBone.BoneIndex);
-	FVector HipCS              = HipCSTransform.GetLocation();
-	FVector KneeCS             = KneeCSTransform.GetLocation();
-	FVector FootCS             = FootCSTransform.GetLocation();
-
-	FVector FootTargetCS;
-	FVector FloorCS;
-			
-	if (Mode == EHumanoidLegIKMode::IK_Human_Leg_Locomotion)
-	{		
-		// Check that we have some valid trace data
-		if (TraceData->GetTraceData().FootHitResult.GetActor() == nullptr &&
-			TraceData->GetTraceData().ToeHitResult.GetActor() == nullptr)
-		{
-#if ENABLE_IK_DEBUG_VERBOSE
-			UE_LOG(LogRTIK, Warning, TEXT("Leg IK trace did not hit a valid actor"));
-#endif
-			return;
-		}
-
-		// Use trace data to figure out where the foot should go.
-		FComponentSpacePoseContext BasePose(Output);
-		BaseComponentPose.EvaluateComponentSpace(BasePose);
-
-		// If within foot rotation limit, use the low point. Otherwise, use the higher point and the foot shouldn't rotate.
-		bool bWithinRotationLimit = Leg->Chain.GetIKFloorPointCS(*SkelComp, TraceData->GetTraceData(), FloorCS);
-
-		FVector BaseRootCS = FAnimUtil::GetBoneCSLocation(*SkelComp, BasePose.Pose, FCompactPoseBoneIndex(0));
-		FVector BaseFootCS = FAnimUtil::GetBoneCSLocation(*SkelComp, BasePose.Pose, Leg->Chain.ShinBone.BoneIndex);
-		
-		// How high the foot should be above the root. If below this, IK turns on.
-		float FootHeightAboveRoot = BaseFootCS.Z - BaseRootCS.Z;
-
-		// Old method included FootRadius -- could cause IK to cut in suddenly during level movement. Leaving in for historical interest
-		// float MinimumHeight = FloorCS.Z + HeightAboveRoot + Leg->Chain.FootRadius;		
-
-		float MinimumFootHeight = FloorCS.Z + FootHeightAboveRoot;
-
-		// Don't move foot unless the foot is below the target height
-		if (FootCS.Z < MinimumFootHeight)
-		{
-			//Again, foot radius is now ignored. Don't need it 
-			//FootTargetCS = FVector(FootCS.X, FootCS.Y, FloorCS.Z + FootHeightAboveRoot + Leg->Chain.FootRadius);
-			FootTargetCS = FVector(FootCS.X, FootCS.Y, FloorCS.Z + FootHeightAboveRoot);
-		}
-		else
-		{
-			FootTargetCS = FootCS;
-		}
-
-	}
-	else
-	{
-		FootTargetCS = ToCS.TransformPosition(FootTargetWorld.GetLocation());
-	}
-
-	// Interpolate the foot target (if needed)
-	if (bEffectorMovesInstantly)
-	{
-		LastEffectorOffset = FVector(0.0f, 0.0f, 0.0f);		
-	}
-	else
-	{
-		FVector OffsetFootPos = FootCS + LastEffectorOffset;
-		FVector RequiredDelta = FootTargetCS - OffsetFootPos;
-
-		if (RequiredDelta.Size() > EffectorVelocity * DeltaTime)
-		{
-			RequiredDelta = RequiredDelta.GetClampedToMaxSize(EffectorVelocity * DeltaTime);
-		}
-		
-		FootTargetCS          = OffsetFootPos + RequiredDelta;
-		LastEffectorOffset    = LastEffectorOffset + RequiredDelta;
-	}
-
-	// Will contain post-IK transforms	
-	TArray<FTransform> DestCSTransforms;
-
-	if (Solver == EHumanoidLegIKSolver::IK_Human_Leg_Solver_FABRIK)
-	{
-		// Gather bone transforms and constraints
-		TArray<FTransform> SourceCSTransforms({
-			HipCSTransform,
-			KneeCSTransform,
-			FootCSTransform
-		});
-
-		TArray<FIKBoneConstraint*> Constraints({
-			Leg->Chain.HipBone.GetConstraint(),
-			Leg->Chain.ThighBone.GetConstraint(),
-			Leg->Chain.ShinBone.GetConstraint()
-		});
-
-		bool bBoneLocationUpdated = FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(
-			SourceCSTransforms,
-			Constraints,
-			FootTargetCS,
-			DestCSTransforms,
-			0.0f,
-			1.0f,
-			Precision,
-			MaxIterations,
-			Cast<ACharacter>(SkelComp->GetOwner())
-		);
-	}
-	else if (Solver == EHumanoidLegIKSolver::IK_Human_Leg_Solver_TwoBone)
-	{
-		DestCSTransforms.Reserve(3);
-		DestCSTransforms.Add(HipCSTransform);
-		DestCSTransforms.Add(KneeCSTransform);
-		DestCSTransforms.Add(FootCSTransform);
-
-		AnimationCore::SolveTwoBoneIK(
-			DestCSTransforms[0],
-			DestCSTransforms[1],
-			DestCSTransforms[2],
-			FVector(1.0f, 0.0f, 0.0f), // Use forward direction, knee correction node will fix it
-			FootTargetCS,
-			false,
-			1.0f,
-			1.0f
-		);
-	}
-
-	OutBoneTransforms.Add(FBoneTransform(Leg->Chain.HipBone.BoneIndex, DestCSTransforms[0]));
-	OutBoneTransforms.Add(FBoneTransform(Leg->Chain.ThighBone.BoneIndex, DestCSTransforms[1]));
-	OutBoneTransforms.Add(FBoneTransform(Leg->Chain.ShinBone.BoneIndex, DestCSTransforms[2]));
-
-#if WITH_EDITOR
-	if (bEnableDebugDraw)
-	{
-		UWorld* World = SkelComp->GetWorld();		
-		FMatrix ToWorld = SkelComp->GetComponentToWorld().ToMatrixNoScale();
-		FVector EffectorWorld = ToWorld.TransformPosition(FootTargetCS);
-
-		FDebugDrawUtil::DrawSphere(World, EffectorWorld, FColor(255, 0, 255));
-		FDebugDrawUtil::DrawSphere(World, ToWorld.TransformPosition(FloorCS), FColor(255, 0, 0));
-		FDebugDrawUtil::DrawSphere(World, TraceData->GetTraceData().FootHitResult.ImpactPoint, FColor(255, 255, 0), 10.0f);
-		FDebugDrawUtil::DrawSphere(World, TraceData->GetTraceData().ToeHitResult.ImpactPoint, FColor(255, 255, 0), 10.0f);
-
-		// Leg before IK, in yellow:
-		FDebugDrawUtil::DrawLine(World,
-			ToWorld.TransformPosition(HipCSTransform.GetLocation()),
-			ToWorld.TransformPosition(KneeCSTransform.GetLocation()),
-			FColor(255, 255, 0)
-		);
-		FDebugDrawUtil::DrawLine(World,
-			ToWorld.TransformPosition(KneeCSTransform.GetLocation()),
-			ToWorld.TransformPosition(FootCSTransform.GetLocation()),
-			FColor(255, 255, 0)
-		);
-
-		// Leg after IK, in cyan
-		FDebugDrawUtil::DrawLine(World,
-			ToWorld.TransformPosition(DestCSTransforms[0].GetLocation()),
-			ToWorld.TransformPosition(DestCSTransforms[1].GetLocation()),
-			FColor(0, 255, 255)
-		);
-		FDebugDrawUtil::DrawLine(World,
-			ToWorld.TransformPosition(DestCSTransforms[1].GetLocation()),
-			ToWorld.TransformPosition(DestCSTransforms[2].GetLocation()),
-			FColor(0, 255, 255)
-		);	   
-	}
-#endif // WITH_EDITOR
-}
-
-bool FAnimNode_HumanoidLegIK::IsValidToEvaluate(const USkeleton * Skeleton, const FBoneContainer & RequiredBones)
-{
-	if (Leg == nullptr || TraceData == nullptr)
-	{
-#if ENABLE_IK_DEBUG_VERBOSE
-		UE_LOG(LogRTIK, Warning, TEXT("IK Node Humanoid IK Leg was not valid to evaluate -- an input wrapper object was null"));		
-#endif ENABLE_IK_DEBUG_VERBOSE
-		return false;
-	}
-	
-	bool bValid = Leg->InitIfInvalid(RequiredBones);
-
-#if ENABLE_IK_DEBUG_VERBOSE
-	if (!bValid)
-	{
-		UE_LOG(LogRTIK, Warning, TEXT("IK Node Humanoid IK Leg was not valid to evaluate"));
-	}
-#endif // ENABLE_ANIM_DEBUG
-
-	return bValid;
-}
-
-void FAnimNode_HumanoidLegIK::InitializeBoneReferences(const FBoneContainer& RequiredBones)
-{
-
-	if (Leg == nullptr || TraceData == nullptr)
-	{
-#if ENABLE_IK_DEBUG
-		UE_LOG(LogRTIK, Warning, TEXT("Could not initialize Humanoid IK Leg -- An input wrapper object was null"));
-#endif // ENABLE_IK_DEBUG
-
-		return;
-	}
-
-	if (!Leg->InitBoneReferences(RequiredBones))
-	{
-#if ENABLE_IK_DEBUG
-		UE_LOG(LogRTIK, Warning, TEXT("Could not initialize Humanoid IK Leg"));
-#endif // ENABLE_IK_DEBUG
-	}
-}
+// Copyright(c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "AnimNode_HumanoidLegIK.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "TwoBoneIK.h"
+#include "RangeLimitedFABRIK.h"
+#include "AnalyticIK.h"
+#include "IKSolveRecorder.h"
+#include "Utility/AnimUtil.h"
+#include "Utility/DebugDrawUtil.h"
+
+DECLARE_CYCLE_STAT(TEXT("IK Humanoid Leg IK Eval"), STAT_HumanoidLegIK_Eval, STATGROUP_RTIK);
+
+void FAnimNode_HumanoidLegIK::Initialize_AnyThread(const FAnimationInitializeContext & Context)
+{
+	Super::Initialize_AnyThread(Context);
+	BaseComponentPose.Initialize(Context);
+	InstanceState = FIKInstanceState::FindOrCreate(Context.AnimInstanceProxy);
+}
+
+void FAnimNode_HumanoidLegIK::CacheBones_AnyThread(const FAnimationCacheBonesContext & Context)
+{
+	Super::CacheBones_AnyThread(Context);
+	BaseComponentPose.CacheBones(Context);
+}
+
+void FAnimNode_HumanoidLegIK::UpdateInternal(const FAnimationUpdateContext & Context)
+{
+	BaseComponentPose.Update(Context);
+	DeltaTime = Context.GetDeltaTime();	
+}
+
+void FAnimNode_HumanoidLegIK::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext & Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HumanoidLegIK_Eval);
+	RTIK_SCOPE_OWNER_CYCLE_COUNTER(Output.AnimInstanceProxy);
+
+	FHumanoidLegChain* LegChain       = FIKInstanceState::ResolveLeg(InstanceState.Get(), Leg, LegHandle);
+	FHumanoidIKTraceState* TraceState = FIKInstanceState::ResolveTraceData(InstanceState.Get(), TraceData, TraceDataHandle);
+
+#if ENABLE_ANIM_DEBUG
+	check(Output.AnimInstanceProxy->GetSkelMeshComponent());
+#endif
+	check(OutBoneTransforms.Num() == 0);
+
+	// Input pin pointers are checked in IsValid -- don't need to check here
+
+	USkeletalMeshComponent* SkelComp   = Output.AnimInstanceProxy->GetSkelMeshComponent();
+	
+	FMatrix ToCS               = SkelComp->GetComponentToWorld().ToMatrixNoScale().Inverse();
+	FTransform HipCSTransform  = FAnimUtil::GetBoneCSTransform(*SkelComp, Output.Pose, LegChain->HipBone.BoneIndex);
+	FTransform KneeCSTransform = FAnimUtil::GetBoneCSTransform(*SkelComp, Output.Pose, LegChain->ThighBone.BoneIndex);
+	FTransform FootCSTransform = FAnimUtil::GetBoneCSTransform(*SkelComp, Output.Pose, LegChain->ShinBone.BoneIndex);
+	FVector HipCS              = HipCSTransform.GetLocation();
+	FVector KneeCS             = KneeCSTransform.GetLocation();
+	FVector FootCS             = FootCSTransform.GetLocation();
+
+	FHumanoidLegIKTargetInputs TargetInputs;
+	TargetInputs.bFromTrace              = Mode == EHumanoidLegIKMode::IK_Human_Leg_Locomotion;
+	TargetInputs.FootCS                  = FootCS;
+	TargetInputs.bEffectorMovesInstantly = bEffectorMovesInstantly;
+	TargetInputs.EffectorVelocity        = EffectorVelocity;
+			
+	if (TargetInputs.bFromTrace)
+	{		
+		const FHumanoidIKTraceData& Trace = TraceState->GetTraceData();
+		TargetInputs.bFootHit = Trace.FootHitResult.GetActor() != nullptr;
+		TargetInputs.bToeHit  = Trace.ToeHitResult.GetActor() != nullptr;
+
+		// Check that we have some valid trace data
+		if (!TargetInputs.bFootHit && !TargetInputs.bToeHit)
+		{
+#if ENABLE_IK_DEBUG_VERBOSE
+			UE_LOG(LogRTIK, Warning, TEXT("Leg IK trace did not hit a valid actor"));
+#endif
+			return;
+		}
+
+		// Use trace data to figure out where the foot should go.
+		FComponentSpacePoseContext BasePose(Output);
+		BaseComponentPose.EvaluateComponentSpace(BasePose);
+
+		FVector BaseRootCS = FAnimUtil::GetBoneCSLocation(*SkelComp, BasePose.Pose, FCompactPoseBoneIndex(0));
+		FVector BaseFootCS = FAnimUtil::GetBoneCSLocation(*SkelComp, BasePose.Pose, LegChain->ShinBone.BoneIndex);
+		
+		// How high the foot should be above the root. If below this, IK turns on.
+		TargetInputs.FootHeightAboveRoot = BaseFootCS.Z - BaseRootCS.Z;
+
+		// Trace points relative to the component, as FHumanoidLegChain::GetIKFloorPointCS takes them
+		FVector ToFloorCS                   = -1 * SkelComp->GetComponentLocation();
+		TargetInputs.FootFloorCS            = ToFloorCS + Trace.FootHitResult.ImpactPoint;
+		TargetInputs.ToeFloorCS             = ToFloorCS + Trace.ToeHitResult.ImpactPoint;
+		TargetInputs.MaxFootRotationDegrees = LegChain->MaxFootRotationDegrees;
+	}
+	else
+	{
+		TargetInputs.FootTargetCS = ToCS.TransformPosition(FootTargetWorld.GetLocation());
+	}
+
+	// Kept for the solve record, which replays the target derivation from it
+	FVector LastEffectorOffsetBefore = LastEffectorOffset;
+
+	FVector FootTargetCS;
+	FVector FloorCS(0.0f, 0.0f, 0.0f);
+	ComputeFootTargetCS(TargetInputs, DeltaTime, LastEffectorOffset, FootTargetCS, FloorCS);
+
+	// DestCSTransforms will contain post-IK transforms	
+	if (Solver == EHumanoidLegIKSolver::IK_Human_Leg_Solver_FABRIK ||
+		Solver == EHumanoidLegIKSolver::IK_Human_Leg_Solver_Auto)
+	{
+		// Gather bone transforms; constraints were compiled by the chain
+		SourceCSTransforms.Reset(3);
+		SourceCSTransforms.Add(HipCSTransform);
+		SourceCSTransforms.Add(KneeCSTransform);
+		SourceCSTransforms.Add(FootCSTransform);
+
+		bool bBoneLocationUpdated = false;
+		bool bSolvedAnalytically = Solver == EHumanoidLegIKSolver::IK_Human_Leg_Solver_Auto &&
+			FAnalyticIK::SolveTwoBone(
+				SourceCSTransforms,
+				LegChain->GetConstraintTable(),
+				FootTargetCS,
+				DestCSTransforms,
+				Precision,
+				bBoneLocationUpdated
+			);
+
+		if (!bSolvedAnalytically)
+		{
+			int32 IterationBudget = bAdaptiveIterations
+				? AdaptiveIterations.GetBudget(MaxIterations, bAllowIterationsBeyondMax)
+				: MaxIterations;
+			FIKCharacterDebugDrawer DebugDrawer(Cast<ACharacter>(SkelComp->GetOwner()));
+
+			FIKSolveStats SolveStats;
+			bBoneLocationUpdated = FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(
+				SourceCSTransforms,
+				LegChain->GetConstraintTable(),
+				FootTargetCS,
+				DestCSTransforms,
+				0.0f,
+				1.0f,
+				Precision,
+				IterationBudget,
+				UnreachableRule,
+				DebugDrawer.GetIfValid(),
+				1.0f,
+				0.0f,
+				&SolveStats
+			);
+
+			if (bAdaptiveIterations)
+			{
+				AdaptiveIterations.Record(SolveStats, MaxIterations, bAllowIterationsBeyondMax);
+			}
+
+			if (FIKSolveRecorder::IsRecording())
+			{
+				FIKSolveRecord SolveRecord;
+				SolveRecord.SetInputs(EIKRecordedSolver::IKRS_FABRIK, SourceCSTransforms, LegChain->GetConstraintTable(),
+					FootTargetCS, DeltaTime);
+				SolveRecord.Precision       = Precision;
+				SolveRecord.MaxIterations   = IterationBudget;
+				SolveRecord.UnreachableRule = UnreachableRule;
+				SolveRecord.SetLegTarget(TargetInputs, LastEffectorOffsetBefore);
+				SolveRecord.SetResults(DestCSTransforms, SolveStats);
+				FIKSolveRecorder::Record(SolveRecord);
+			}
+		}
+	}
+	else if (Solver == EHumanoidLegIKSolver::IK_Human_Leg_Solver_TwoBone)
+	{
+		DestCSTransforms.Reset(3);
+		DestCSTransforms.Add(HipCSTransform);
+		DestCSTransforms.Add(KneeCSTransform);
+		DestCSTransforms.Add(FootCSTransform);
+
+		AnimationCore::SolveTwoBoneIK(
+			DestCSTransforms[0],
+			DestCSTransforms[1],
+			DestCSTransforms[2],
+			FVector(1.0f, 0.0f, 0.0f), // Use forward direction, knee correction node will fix it
+			FootTargetCS,
+			false,
+			1.0f,
+			1.0f
+		);
+	}
+
+	OutBoneTransforms.Add(FBoneTransform(LegChain->HipBone.BoneIndex, DestCSTransforms[0]));
+	OutBoneTransforms.Add(FBoneTransform(LegChain->ThighBone.BoneIndex, DestCSTransforms[1]));
+	OutBoneTransforms.Add(FBoneTransform(LegChain->ShinBone.BoneIndex, DestCSTransforms[2]));
+
+#if WITH_EDITOR
+	if (bEnableDebugDraw)
+	{
+		UWorld* World = SkelComp->GetWorld();		
+		FMatrix ToWorld = SkelComp->GetComponentToWorld().ToMatrixNoScale();
+		FVector EffectorWorld = ToWorld.TransformPosition(FootTargetCS);
+
+		FDebugDrawUtil::DrawSphere(World, EffectorWorld, FColor(255, 0, 255));
+		FDebugDrawUtil::DrawSphere(World, ToWorld.TransformPosition(FloorCS), FColor(255, 0, 0));
+		FDebugDrawUtil::DrawSphere(World, TraceState->GetTraceData().FootHitResult.ImpactPoint, FColor(255, 255, 0), 10.0f);
+		FDebugDrawUtil::DrawSphere(World, TraceState->GetTraceData().ToeHitResult.ImpactPoint, FColor(255, 255, 0), 10.0f);
+
+		// Leg before IK, in yellow:
+		FDebugDrawUtil::DrawLine(World,
+			ToWorld.TransformPosition(HipCSTransform.GetLocation()),
+			ToWorld.TransformPosition(KneeCSTransform.GetLocation()),
+			FColor(255, 255, 0)
+		);
+		FDebugDrawUtil::DrawLine(World,
+			ToWorld.TransformPosition(KneeCSTransform.GetLocation()),
+			ToWorld.TransformPosition(FootCSTransform.GetLocation()),
+			FColor(255, 255, 0)
+		);
+
+		// Leg after IK, in cyan
+		FDebugDrawUtil::DrawLine(World,
+			ToWorld.TransformPosition(DestCSTransforms[0].GetLocation()),
+			ToWorld.TransformPosition(DestCSTransforms[1].GetLocation()),
+			FColor(0, 255, 255)
+		);
+		FDebugDrawUtil::DrawLine(World,
+			ToWorld.TransformPosition(DestCSTransforms[1].GetLocation()),
+			ToWorld.TransformPosition(DestCSTransforms[2].GetLocation()),
+			FColor(0, 255, 255)
+		);	   
+	}
+#endif // WITH_EDITOR
+}
+
+bool FAnimNode_HumanoidLegIK::ComputeFootTargetCS(const FHumanoidLegIKTargetInputs& Inputs, float InDeltaTime,
+	FVector& InOutLastEffectorOffset, FVector& OutFootTargetCS, FVector& OutFloorCS)
+{
+	FVector FootTargetCS;
+
+	if (Inputs.bFromTrace)
+	{
+		if (!Inputs.bFootHit && !Inputs.bToeHit)
+		{
+			return false;
+		}
+
+		// If within foot rotation limit, use the low point. Otherwise, use the higher point and the foot shouldn't rotate.
+		FHumanoidLegChain::GetIKFloorPointCS(Inputs.FootFloorCS, Inputs.ToeFloorCS, Inputs.bFootHit, Inputs.bToeHit,
+			Inputs.MaxFootRotationDegrees, OutFloorCS);
+
+		// Old method included FootRadius -- could cause IK to cut in suddenly during level movement. Leaving in for historical interest
+		// float MinimumHeight = FloorCS.Z + HeightAboveRoot + LegChain->FootRadius;		
+
+		float MinimumFootHeight = OutFloorCS.Z + Inputs.FootHeightAboveRoot;
+
+		// Don't move foot unless the foot is below the target height
+		if (Inputs.FootCS.Z < MinimumFootHeight)
+		{
+			//Again, foot radius is now ignored. Don't need it 
+			//FootTargetCS = FVector(FootCS.X, FootCS.Y, FloorCS.Z + FootHeightAboveRoot + LegChain->FootRadius);
+			FootTargetCS = FVector(Inputs.FootCS.X, Inputs.FootCS.Y, MinimumFootHeight);
+		}
+		else
+		{
+			FootTargetCS = Inputs.FootCS;
+		}
+	}
+	else
+	{
+		FootTargetCS = Inputs.FootTargetCS;
+	}
+
+	// Interpolate the foot target (if needed)
+	if (Inputs.bEffectorMovesInstantly)
+	{
+		InOutLastEffectorOffset = FVector(0.0f, 0.0f, 0.0f);		
+	}
+	else
+	{
+		FVector OffsetFootPos = Inputs.FootCS + InOutLastEffectorOffset;
+		FVector RequiredDelta = FootTargetCS - OffsetFootPos;
+
+		if (RequiredDelta.Size() > Inputs.EffectorVelocity * InDeltaTime)
+		{
+			RequiredDelta = RequiredDelta.GetClampedToMaxSize(Inputs.EffectorVelocity * InDeltaTime);
+		}
+		
+		FootTargetCS            = OffsetFootPos + RequiredDelta;
+		InOutLastEffectorOffset = InOutLastEffectorOffset + RequiredDelta;
+	}
+
+	OutFootTargetCS = FootTargetCS;
+	return true;
+}
+
+bool FAnimNode_HumanoidLegIK::IsValidToEvaluate(const USkeleton * Skeleton, const FBoneContainer & RequiredBones)
+{
+	FHumanoidLegChain* LegChain       = FIKInstanceState::ResolveLeg(InstanceState.Get(), Leg, LegHandle);
+	FHumanoidIKTraceState* TraceState = FIKInstanceState::ResolveTraceData(InstanceState.Get(), TraceData, TraceDataHandle);
+
+	if (LegChain == nullptr || TraceState == nullptr)
+	{
+#if ENABLE_IK_DEBUG_VERBOSE
+		UE_LOG(LogRTIK, Warning, TEXT("IK Node Humanoid IK Leg was not valid to evaluate -- an input was not set"));		
+#endif ENABLE_IK_DEBUG_VERBOSE
+		return false;
+	}
+	
+	bool bValid = LegChain->InitIfInvalid(RequiredBones);
+
+#if ENABLE_IK_DEBUG_VERBOSE
+	if (!bValid)
+	{
+		UE_LOG(LogRTIK, Warning, TEXT("IK Node Humanoid IK Leg was not valid to evaluate"));
+	}
+#endif // ENABLE_ANIM_DEBUG
+
+	return bValid;
+}
+
+void FAnimNode_HumanoidLegIK::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	FHumanoidLegChain* LegChain       = FIKInstanceState::ResolveLeg(InstanceState.Get(), Leg, LegHandle);
+	FHumanoidIKTraceState* TraceState = FIKInstanceState::ResolveTraceData(InstanceState.Get(), TraceData, TraceDataHandle);
+
+	if (LegChain == nullptr || TraceState == nullptr)
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not initialize Humanoid IK Leg -- An input was not set"));
+#endif // ENABLE_IK_DEBUG
+
+		return;
+	}
+
+	if (!LegChain->RefreshCachedValidity(RequiredBones))
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not initialize Humanoid IK Leg"));
+#endif // ENABLE_IK_DEBUG
+	}
+}
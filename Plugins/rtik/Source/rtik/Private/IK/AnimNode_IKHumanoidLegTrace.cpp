@@ -1,86 +1,106 @@
-// Copyright(c) Henry Cooney 2017
-
-#include "rtik.h"
-#include "AnimNode_IKHumanoidLegTrace.h"
-#include "Components/SkeletalMeshComponent.h"
-#include "Animation/AnimInstanceProxy.h"
-#include "Runtime/AnimationCore/Public/TwoBoneIK.h"
-#include "Utility/AnimUtil.h" 
-
-#if WITH_EDITOR
-#include "Utility/DebugDrawUtil.h"
-#endif
-
-DECLARE_CYCLE_STAT(TEXT("IK Humanoid Leg IK Trace"), STAT_IKHumanoidLegTrace_Eval, STATGROUP_Anim);
-
-void FAnimNode_IKHumanoidLegTrace::UpdateInternal(const FAnimationUpdateContext & Context)
-{
-	// Mark trace data as stale
-	TraceData->bUpdatedThisTick = false;
-}
-
-void FAnimNode_IKHumanoidLegTrace::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, 
-	TArray<FBoneTransform>& OutBoneTransforms) 
-{
-	SCOPE_CYCLE_COUNTER(STAT_IKHumanoidLegTrace_Eval);
-
-	if (Leg == nullptr || PelvisBone == nullptr) 
-	{
-		return;
-	}
-
-	USkeletalMeshComponent* SkelComp    = Output.AnimInstanceProxy->GetSkelMeshComponent();
-	ACharacter* Character               = Cast<ACharacter>(SkelComp->GetOwner());
-	const FBoneContainer& RequiredBones = Output.AnimInstanceProxy->GetRequiredBones();
-
-	FHumanoidIK::HumanoidIKLegTrace(Character, Output.Pose, Leg->Chain,
-		PelvisBone->Bone, MaxPelvisAdjustSize, TraceData->TraceData, false);
-	
-	TraceData->bUpdatedThisTick = true;
-}
-
-
-bool FAnimNode_IKHumanoidLegTrace::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer & RequiredBones)
-{
-	if (Leg == nullptr || PelvisBone == nullptr)
-	{
-#if ENABLE_IK_DEBUG_VERBOSE
-		UE_LOG(LogRTIK, Warning, TEXT("IK Node Humanoid IK Leg Trace was not valid to evaluate -- a bone wrapper was null"));		
-#endif ENABLE_IK_DEBUG_VERBOSE
-		return false;
-	}
-
-	if (TraceData == nullptr)
-	{
-#if ENABLE_IK_DEBUG_VERBOSE
-		UE_LOG(LogRTIK, Warning, TEXT("IK Node Humanoid IK Leg Trace was not valid to evaluate -- Trace data was null"));		
-#endif ENABLE_IK_DEBUG_VERBOSE
-		return false;
-	}
-		
-	bool bValid = Leg->InitIfInvalid(RequiredBones);
-
-	return bValid;
-}
-
-
-void FAnimNode_IKHumanoidLegTrace::InitializeBoneReferences(const FBoneContainer& RequiredBones)
-{
-	if (Leg == nullptr)
-	{
-#if ENABLE_IK_DEBUG
-		UE_LOG(LogRTIK, Warning, TEXT("Could not initialize Humanoid IK Leg Trace -- Leg invalid"));
-#endif // ENABLE_IK_DEBUG
-
-		return;
-	}
-
-	if (!Leg->InitBoneReferences(RequiredBones))
-	{
-#if ENABLE_IK_DEBUG
-		UE_LOG(LogRTIK, Warning, TEXT("Could not initialize Humanoid IK Leg Trace"));
-#endif // ENABLE_IK_DEBUG
-	}
-}
-
-
+// Copyright(c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "AnimNode_IKHumanoidLegTrace.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Runtime/AnimationCore/Public/TwoBoneIK.h"
+#include "Utility/AnimUtil.h" 
+
+#if WITH_EDITOR
+#include "Utility/DebugDrawUtil.h"
+#endif
+
+DECLARE_CYCLE_STAT(TEXT("IK Humanoid Leg IK Trace"), STAT_IKHumanoidLegTrace_Eval, STATGROUP_RTIK);
+
+void FAnimNode_IKHumanoidLegTrace::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	Super::Initialize_AnyThread(Context);
+	InstanceState = FIKInstanceState::FindOrCreate(Context.AnimInstanceProxy);
+}
+
+void FAnimNode_IKHumanoidLegTrace::UpdateInternal(const FAnimationUpdateContext & Context)
+{
+	// Mark trace data as stale
+	FHumanoidIKTraceState* TraceState = FIKInstanceState::ResolveTraceData(InstanceState.Get(), TraceData, TraceDataHandle);
+	if (TraceState != nullptr)
+	{
+		TraceState->bUpdatedThisTick = false;
+	}
+}
+
+void FAnimNode_IKHumanoidLegTrace::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, 
+	TArray<FBoneTransform>& OutBoneTransforms) 
+{
+	SCOPE_CYCLE_COUNTER(STAT_IKHumanoidLegTrace_Eval);
+	RTIK_SCOPE_OWNER_CYCLE_COUNTER(Output.AnimInstanceProxy);
+
+	FHumanoidLegChain* LegChain       = FIKInstanceState::ResolveLeg(InstanceState.Get(), Leg, LegHandle);
+	FIKBone* Pelvis                   = FIKInstanceState::ResolveBone(InstanceState.Get(), PelvisBone, PelvisBoneHandle);
+	FHumanoidIKTraceState* TraceState = FIKInstanceState::ResolveTraceData(InstanceState.Get(), TraceData, TraceDataHandle);
+
+	// Inputs are checked in IsValidToEvaluate, so only debug builds check again here
+#if ENABLE_IK_DEBUG
+	if (LegChain == nullptr || Pelvis == nullptr || TraceState == nullptr) 
+	{
+		return;
+	}
+#endif // ENABLE_IK_DEBUG
+
+	USkeletalMeshComponent* SkelComp    = Output.AnimInstanceProxy->GetSkelMeshComponent();
+	ACharacter* Character               = Cast<ACharacter>(SkelComp->GetOwner());
+	const FBoneContainer& RequiredBones = Output.AnimInstanceProxy->GetRequiredBones();
+
+	FHumanoidIK::HumanoidIKLegTrace(Character, Output.Pose, *LegChain,
+		*Pelvis, MaxPelvisAdjustSize, TraceState->TraceData, false);
+	
+	TraceState->bUpdatedThisTick = true;
+}
+
+
+bool FAnimNode_IKHumanoidLegTrace::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer & RequiredBones)
+{
+	FHumanoidLegChain* LegChain = FIKInstanceState::ResolveLeg(InstanceState.Get(), Leg, LegHandle);
+
+	if (LegChain == nullptr || FIKInstanceState::ResolveBone(InstanceState.Get(), PelvisBone, PelvisBoneHandle) == nullptr)
+	{
+#if ENABLE_IK_DEBUG_VERBOSE
+		UE_LOG(LogRTIK, Warning, TEXT("IK Node Humanoid IK Leg Trace was not valid to evaluate -- a bone input was not set"));		
+#endif ENABLE_IK_DEBUG_VERBOSE
+		return false;
+	}
+
+	if (FIKInstanceState::ResolveTraceData(InstanceState.Get(), TraceData, TraceDataHandle) == nullptr)
+	{
+#if ENABLE_IK_DEBUG_VERBOSE
+		UE_LOG(LogRTIK, Warning, TEXT("IK Node Humanoid IK Leg Trace was not valid to evaluate -- Trace data was not set"));		
+#endif ENABLE_IK_DEBUG_VERBOSE
+		return false;
+	}
+		
+	bool bValid = LegChain->InitIfInvalid(RequiredBones);
+
+	return bValid;
+}
+
+
+void FAnimNode_IKHumanoidLegTrace::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	FHumanoidLegChain* LegChain = FIKInstanceState::ResolveLeg(InstanceState.Get(), Leg, LegHandle);
+
+	if (LegChain == nullptr)
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not initialize Humanoid IK Leg Trace -- Leg invalid"));
+#endif // ENABLE_IK_DEBUG
+
+		return;
+	}
+
+	if (!LegChain->RefreshCachedValidity(RequiredBones))
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not initialize Humanoid IK Leg Trace"));
+#endif // ENABLE_IK_DEBUG
+	}
+}
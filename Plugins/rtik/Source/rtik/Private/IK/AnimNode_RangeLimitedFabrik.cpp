@@ -1,278 +1,437 @@
-// Copyright(c) Henry Cooney 2017
-
-#include "rtik.h"
-#include "AnimNode_RangeLimitedFabrik.h"
-#include "AnimationRuntime.h"
-#include "Animation/AnimInstanceProxy.h"
-#include "Components/SkeletalMeshComponent.h"
-#include "IK/RangeLimitedFABRIK.h"
-#include "Utility/DebugDrawUtil.h"
-
-DECLARE_CYCLE_STAT(TEXT("IK Range Limited FABRIK"), STAT_RangeLimitedFabrik_Eval, STATGROUP_Anim);
-
-void FAnimNode_RangeLimitedFabrik::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
-{
-	SCOPE_CYCLE_COUNTER(STAT_RangeLimitedFabrik_Eval);
-	
-	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
-
-	// Update EffectorLocation if it is based off a bone position
-	FTransform CSEffectorTransform = EffectorTransform;
-	FAnimationRuntime::ConvertBoneSpaceTransformToCS(Output.AnimInstanceProxy->GetComponentTransform(),
-		Output.Pose, CSEffectorTransform, EffectorTransformBone.GetCompactPoseIndex(BoneContainer), 
-		EffectorTransformSpace);
-	
-	FVector CSEffectorLocation = CSEffectorTransform.GetLocation();
-
-#if WITH_EDITOR
-	CachedEffectorCSTransform = CSEffectorTransform;
-#endif	
-	check(OutBoneTransforms.Num() == 0);
-
-	int32 NumChainLinks = IKChain->Chain.Num();
-	if (NumChainLinks < 2)
-	{
-		return;
-	}
-
-	// Maximum length of skeleton segment at full extension
-	float MaximumReach = 0;
-
-	// Gather bone transforms and constraints
-	TArray<FTransform> SourceCSTransforms;
-	TArray<FIKBoneConstraint*> Constraints;
-	SourceCSTransforms.Reserve(NumChainLinks);
-	Constraints.Reserve(NumChainLinks);
-	for (int32 i = 0; i < NumChainLinks; ++i)
-	{
-		SourceCSTransforms.Add(Output.Pose.GetComponentSpaceTransform(IKChain->Chain[i].BoneIndex));
-		Constraints.Add(IKChain->Chain[i].GetConstraint());
-	}
-
-	TArray<FTransform> DestCSTransforms;
-
-	ACharacter* Character = Cast<ACharacter>(Output.AnimInstanceProxy->GetSkelMeshComponent()->GetOwner());
-	bool bBoneLocationUpdated = false;
-
-	if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_Normal)
-	{
-		bBoneLocationUpdated = FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(
-			SourceCSTransforms,
-			Constraints,
-			CSEffectorTransform.GetLocation(),
-			DestCSTransforms,
-			MaxRootDragDistance,
-			RootDragStiffness,
-			Precision,
-			MaxIterations,
-			Character
-		);
-	}
-	else if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_ClosedLoop)
-	{
-		bBoneLocationUpdated = FRangeLimitedFABRIK::SolveClosedLoopFABRIK(
-			SourceCSTransforms,
-			Constraints,
-			CSEffectorTransform.GetLocation(),
-			DestCSTransforms,
-			MaxRootDragDistance,
-			RootDragStiffness,
-			Precision,
-			MaxIterations,
-			Character
-		);
-	}
-
-	// Special handling for tip bone's rotation.
-	int32 TipBoneIndex = NumChainLinks - 1;
-	switch (EffectorRotationSource)
-	{
-	case BRS_KeepLocalSpaceRotation:
-		if (NumChainLinks > 1)
-		{
-			DestCSTransforms[TipBoneIndex] = Output.Pose.GetLocalSpaceTransform(IKChain->Chain[TipBoneIndex].BoneIndex) *
-				DestCSTransforms[TipBoneIndex - 1];
-		}
-		break;
-	case BRS_CopyFromTarget:
-		DestCSTransforms[TipBoneIndex].SetRotation(CSEffectorTransform.GetRotation());
-		break;
-	case BRS_KeepComponentSpaceRotation:
-		// Don't change the orientation at all
-		break;
-	default:
-		break;
-	}
-
-	// Commit the changes, if there were any
-	if (bBoneLocationUpdated)
-	{
-		OutBoneTransforms.Reserve(NumChainLinks);
-
-		for (int32 i = 0; i < NumChainLinks; ++i)
-		{
-			OutBoneTransforms.Add(FBoneTransform(IKChain->Chain[i].BoneIndex, DestCSTransforms[i]));
-		}
-	}
-
-
-#if WITH_EDITOR
-
-	if (bEnableDebugDraw)
-	{
-		USkeletalMeshComponent* SkelComp = Output.AnimInstanceProxy->GetSkelMeshComponent();
-		UWorld* World = SkelComp->GetWorld();
-		FMatrix ToWorld = SkelComp->GetComponentToWorld().ToMatrixNoScale();
-
-		if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_Normal)
-		{
-			// Draw chain before adjustment, in yellow
-			for (int32 i = 0; i < NumChainLinks - 1; ++i)
-			{
-				FVector ParentLoc = ToWorld.TransformPosition(SourceCSTransforms[i].GetLocation());
-				FVector ChildLoc = ToWorld.TransformPosition(SourceCSTransforms[i + 1].GetLocation());
-				FDebugDrawUtil::DrawLine(World, ParentLoc, ChildLoc, FColor(255, 255, 0));
-				FDebugDrawUtil::DrawSphere(World, ChildLoc, FColor(255, 255, 0), 3.0f);
-			}
-
-			// Draw root drag radius
-			if (MaxRootDragDistance > KINDA_SMALL_NUMBER)
-			{
-				FDebugDrawUtil::DrawSphere(World,
-					ToWorld.TransformPosition(SourceCSTransforms[0].GetLocation()),
-					FColor(255, 0, 0), MaxRootDragDistance, 12, -1.0f, 0.5f);
-			}
-
-			// Draw chain after adjustment, in cyan
-			for (int32 i = 0; i < NumChainLinks - 1; ++i)
-			{
-				FVector ParentLoc = ToWorld.TransformPosition(DestCSTransforms[i].GetLocation());
-				FVector ChildLoc = ToWorld.TransformPosition(DestCSTransforms[i + 1].GetLocation());
-				FDebugDrawUtil::DrawLine(World, ParentLoc, ChildLoc, FColor(0, 255, 255));
-				FDebugDrawUtil::DrawSphere(World, ChildLoc, FColor(0, 255, 255), 3.0f);
-			}
-		}
-		else if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_ClosedLoop)
-		{
-			// Draw chain before adjustment, in yellow
-			for (int32 i = 0; i < NumChainLinks - 1; ++i)
-			{
-				FVector ParentLoc = ToWorld.TransformPosition(SourceCSTransforms[i].GetLocation());
-				FVector ChildLoc = ToWorld.TransformPosition(SourceCSTransforms[i + 1].GetLocation());
-				FDebugDrawUtil::DrawLine(World, ParentLoc, ChildLoc, FColor(255, 255, 0));
-				FDebugDrawUtil::DrawSphere(World, ChildLoc, FColor(255, 255, 0), 3.0f);
-			}
-
-			FDebugDrawUtil::DrawLine(World,
-				ToWorld.TransformPosition(SourceCSTransforms[0].GetLocation()),
-				ToWorld.TransformPosition(SourceCSTransforms[NumChainLinks-1].GetLocation()),
-				FColor(255, 255, 0));
-
-			// Draw root drag radius
-			if (MaxRootDragDistance > KINDA_SMALL_NUMBER)
-			{
-				FDebugDrawUtil::DrawSphere(World,
-					ToWorld.TransformPosition(SourceCSTransforms[0].GetLocation()),
-					FColor(255, 0, 0), MaxRootDragDistance, 12, -1.0f, 0.5f);
-			}
-
-			// Draw chain after adjustment, in cyan
-			for (int32 i = 0; i < NumChainLinks - 1; ++i)
-			{
-				FVector ParentLoc = ToWorld.TransformPosition(DestCSTransforms[i].GetLocation());
-				FVector ChildLoc = ToWorld.TransformPosition(DestCSTransforms[i + 1].GetLocation());
-				FDebugDrawUtil::DrawLine(World, ParentLoc, ChildLoc, FColor(0, 255, 255));
-				FDebugDrawUtil::DrawSphere(World, ChildLoc, FColor(0, 255, 255), 3.0f);
-			}
-
-			FDebugDrawUtil::DrawLine(World,
-				ToWorld.TransformPosition(DestCSTransforms[0].GetLocation()),
-				ToWorld.TransformPosition(DestCSTransforms[NumChainLinks-1].GetLocation()),
-				FColor(0, 255, 255));	
-		}
-	}
-
-#endif
-
-
-}
-
-void FAnimNode_RangeLimitedFabrik::UpdateParentRotation(FTransform& ParentTransform, const FIKBone& ParentBone,
-	FTransform& ChildTransform, const FIKBone& ChildBone, FCSPose<FCompactPose>& Pose) const
-{
-	
-	// Calculate pre-translation vector between this bone and child
-	FTransform OldParentTransform = Pose.GetComponentSpaceTransform(ParentBone.BoneIndex);
-	FTransform OldChildTransform = Pose.GetComponentSpaceTransform(ChildBone.BoneIndex);
-	FVector OldDir = (OldChildTransform.GetLocation() - OldParentTransform.GetLocation()).GetUnsafeNormal();
-
-	// Get vector from the post-translation bone to it's child
-	FVector NewDir = (ChildTransform.GetLocation() -
-		ParentTransform.GetLocation()).GetUnsafeNormal();
-	
-	// Calculate axis of rotation from pre-translation vector to post-translation vector
-	FVector RotationAxis = FVector::CrossProduct(OldDir, NewDir).GetSafeNormal();
-	float RotationAngle = FMath::Acos(FVector::DotProduct(OldDir, NewDir));
-	FQuat DeltaRotation = FQuat(RotationAxis, RotationAngle);
-	// We're going to multiply it, in order to not have to re-normalize the final quaternion, it has to be a unit quaternion.
-	checkSlow(DeltaRotation.IsNormalized());
-	
-	// Calculate absolute rotation and set it
-	ParentTransform.SetRotation(DeltaRotation * OldParentTransform.GetRotation());
-	ParentTransform.NormalizeRotation();
-}
-
-
-bool FAnimNode_RangeLimitedFabrik::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
-{
-
-	if (IKChain == nullptr)
-	{
-#if ENABLE_IK_DEBUG_VERBOSE
-		UE_LOG(LogRTIK, Warning, TEXT("AnimNode_RangeLimitedFabrik was not valid to evaluate -- an input wrapper object was null"));		
-#endif ENABLE_IK_DEBUG_VERBOSE
-		return false;
-	}
-
-	if (IKChain->Chain.Num() < 2)
-	{
-		return false;
-	}
-
-	// Allow evaluation if all parameters are initialized and TipBone is child of RootBone
-	return (
-		Precision > 0
-		&& IKChain->IsValid(RequiredBones)
-		);
-}
-
-void FAnimNode_RangeLimitedFabrik::InitializeBoneReferences(const FBoneContainer& RequiredBones)
-{
-
-	if (IKChain == nullptr)
-	{
-#if ENABLE_IK_DEBUG
-		UE_LOG(LogRTIK, Warning, TEXT("Could not initialize FAnimNode_RangeLimitedFabrik -- An input wrapper object was null"));
-#endif // ENABLE_IK_DEBUG
-		return;
-	}
-
-	IKChain->InitIfInvalid(RequiredBones);
-	size_t NumBones = IKChain->Chain.Num();
-
-	if (NumBones < 2)
-	{
-		return;
-	}
-	
-	EffectorTransformBone = IKChain->Chain[NumBones - 1].BoneRef;
-	EffectorTransformBone.Initialize(RequiredBones);
-}
-
-void FAnimNode_RangeLimitedFabrik::GatherDebugData(FNodeDebugData& DebugData)
-{
-	FString DebugLine = DebugData.GetNodeName(this);
-
-	DebugData.AddDebugItem(DebugLine);
-	ComponentPose.GatherDebugData(DebugData);
-}
+// Copyright(c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "AnimNode_RangeLimitedFabrik.h"
+#include "AnimationRuntime.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "GameFramework/Character.h"
+#include "IK/RangeLimitedFABRIK.h"
+#include "IK/AnalyticIK.h"
+#include "IK/IKSolveRecorder.h"
+#include "Utility/DebugDrawUtil.h"
+
+DECLARE_CYCLE_STAT(TEXT("IK Range Limited FABRIK"), STAT_RangeLimitedFabrik_Eval, STATGROUP_RTIK);
+
+void FAnimNode_RangeLimitedFabrik::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	Super::Initialize_AnyThread(Context);
+	InstanceState = FIKInstanceState::FindOrCreate(Context.AnimInstanceProxy);
+}
+
+void FAnimNode_RangeLimitedFabrik::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RangeLimitedFabrik_Eval);
+	RTIK_SCOPE_OWNER_CYCLE_COUNTER(Output.AnimInstanceProxy);
+
+	FRangeLimitedIKChain* Chain = FIKInstanceState::ResolveChain(InstanceState.Get(), IKChain, IKChainHandle);
+
+	const FBoneContainer& BoneContainer = Output.Pose.GetPose().GetBoneContainer();
+
+	// Update EffectorLocation if it is based off a bone position
+	FTransform CSEffectorTransform = EffectorTransform;
+	FAnimationRuntime::ConvertBoneSpaceTransformToCS(Output.AnimInstanceProxy->GetComponentTransform(),
+		Output.Pose, CSEffectorTransform, EffectorTransformBone.GetCompactPoseIndex(BoneContainer), 
+		EffectorTransformSpace);
+	
+	FVector CSEffectorLocation = CSEffectorTransform.GetLocation();
+
+#if WITH_EDITOR
+	CachedEffectorCSTransform = CSEffectorTransform;
+#endif	
+	check(OutBoneTransforms.Num() == 0);
+
+	int32 NumChainLinks = Chain->Num();
+	if (NumChainLinks < 2)
+	{
+		return;
+	}
+
+	// Maximum length of skeleton segment at full extension
+	float MaximumReach = 0;
+
+	// Gather bone transforms; constraints were compiled by the chain
+	SourceCSTransforms.Reset(NumChainLinks);
+	for (int32 i = 0; i < NumChainLinks; ++i)
+	{
+		SourceCSTransforms.Add(Output.Pose.GetComponentSpaceTransform((*Chain)[i].BoneIndex));
+	}
+	const FIKCompiledConstraintTable& Constraints = Chain->GetConstraintTable();
+
+	FIKCharacterDebugDrawer CharacterDebugDrawer(Cast<ACharacter>(Output.AnimInstanceProxy->GetSkelMeshComponent()->GetOwner()));
+	IIKDebugDrawer* DebugDrawer = CharacterDebugDrawer.GetIfValid();
+	bool bBoneLocationUpdated = false;
+	LastSolveStats = FIKSolveStats();
+
+	int32 IterationBudget = bAdaptiveIterations
+		? AdaptiveIterations.GetBudget(MaxIterations, bAllowIterationsBeyondMax)
+		: MaxIterations;
+
+	bool bSolvedAnalytically = false;
+	if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_Auto && MaxRootDragDistance < KINDA_SMALL_NUMBER)
+	{
+		bSolvedAnalytically = FAnalyticIK::TrySolve(
+			SourceCSTransforms,
+			Constraints,
+			CSEffectorTransform.GetLocation(),
+			DestCSTransforms,
+			Precision,
+			bBoneLocationUpdated
+		);
+	}
+
+	if (bSolvedAnalytically)
+	{
+		// Done
+	}
+	else if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_Normal ||
+		SolverMode == ERangeLimitedFABRIKSolverMode::RLF_Auto)
+	{
+		bBoneLocationUpdated = FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(
+			SourceCSTransforms,
+			Constraints,
+			CSEffectorTransform.GetLocation(),
+			DestCSTransforms,
+			MaxRootDragDistance,
+			RootDragStiffness,
+			Precision,
+			IterationBudget,
+			UnreachableRule,
+			DebugDrawer,
+			Relaxation,
+			StagnationRatio,
+			&LastSolveStats
+		);
+	}
+	else if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_CoarseToFine)
+	{
+		bBoneLocationUpdated = FRangeLimitedFABRIK::SolveCoarseToFineFABRIK(
+			SourceCSTransforms,
+			Constraints,
+			CSEffectorTransform.GetLocation(),
+			DestCSTransforms,
+			MaxRootDragDistance,
+			RootDragStiffness,
+			Precision,
+			IterationBudget,
+			CoarseSegmentLength,
+			FineIterations,
+			UnreachableRule,
+			DebugDrawer,
+			&LastSolveStats
+		);
+	}
+	else if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_ParallelSegmented)
+	{
+		bBoneLocationUpdated = FRangeLimitedFABRIK::SolveParallelSegmentedFABRIK(
+			SourceCSTransforms,
+			Constraints,
+			CSEffectorTransform.GetLocation(),
+			DestCSTransforms,
+			MaxRootDragDistance,
+			RootDragStiffness,
+			Precision,
+			IterationBudget,
+			CoarseSegmentLength,
+			FineIterations,
+			UnreachableRule,
+			DebugDrawer,
+			&LastSolveStats
+		);
+	}
+	else if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_DampedLeastSquares)
+	{
+		bBoneLocationUpdated = FRangeLimitedFABRIK::SolveDampedLeastSquares(
+			SourceCSTransforms,
+			Constraints,
+			CSEffectorTransform.GetLocation(),
+			DestCSTransforms,
+			Precision,
+			IterationBudget,
+			Damping,
+			UnreachableRule,
+			DebugDrawer,
+			&LastSolveStats
+		);
+	}
+	else if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_Spline)
+	{
+		bBoneLocationUpdated = FRangeLimitedFABRIK::SolveSplineIK(
+			SourceCSTransforms,
+			CSEffectorTransform.GetLocation(),
+			DestCSTransforms,
+			SplineControlPoints,
+			SplineArcLengths,
+			Precision,
+			IterationBudget,
+			UnreachableRule,
+			DebugDrawer,
+			&LastSolveStats
+		);
+	}
+	else if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_ClosedLoop)
+	{
+		bBoneLocationUpdated = FRangeLimitedFABRIK::SolveClosedLoopFABRIK(
+			SourceCSTransforms,
+			Constraints,
+			CSEffectorTransform.GetLocation(),
+			DestCSTransforms,
+			MaxRootDragDistance,
+			RootDragStiffness,
+			Precision,
+			IterationBudget,
+			DebugDrawer,
+			Relaxation,
+			StagnationRatio,
+			&LastSolveStats
+		);
+	}
+
+	if (bAdaptiveIterations)
+	{
+		AdaptiveIterations.Record(LastSolveStats, MaxIterations, bAllowIterationsBeyondMax);
+	}
+
+	bool bRecordable = SolverMode == ERangeLimitedFABRIKSolverMode::RLF_Normal ||
+		SolverMode == ERangeLimitedFABRIKSolverMode::RLF_Auto ||
+		SolverMode == ERangeLimitedFABRIKSolverMode::RLF_ClosedLoop;
+	if (bRecordable && !bSolvedAnalytically && FIKSolveRecorder::IsRecording())
+	{
+		FIKSolveRecord SolveRecord;
+		SolveRecord.SetInputs(
+			SolverMode == ERangeLimitedFABRIKSolverMode::RLF_ClosedLoop ? EIKRecordedSolver::IKRS_ClosedLoop :
+				EIKRecordedSolver::IKRS_FABRIK,
+			SourceCSTransforms,
+			Constraints,
+			CSEffectorLocation,
+			Output.AnimInstanceProxy->GetDeltaSeconds()
+		);
+		SolveRecord.MaxRootDragDistance = MaxRootDragDistance;
+		SolveRecord.RootDragStiffness   = RootDragStiffness;
+		SolveRecord.Precision           = Precision;
+		SolveRecord.MaxIterations       = IterationBudget;
+		SolveRecord.UnreachableRule     = UnreachableRule;
+		SolveRecord.Relaxation          = Relaxation;
+		SolveRecord.StagnationRatio     = StagnationRatio;
+		SolveRecord.SetResults(DestCSTransforms, LastSolveStats);
+		FIKSolveRecorder::Record(SolveRecord);
+	}
+
+	// Special handling for tip bone's rotation.
+	int32 TipBoneIndex = NumChainLinks - 1;
+	switch (EffectorRotationSource)
+	{
+	case BRS_KeepLocalSpaceRotation:
+		if (NumChainLinks > 1)
+		{
+			DestCSTransforms[TipBoneIndex] = Output.Pose.GetLocalSpaceTransform((*Chain)[TipBoneIndex].BoneIndex) *
+				DestCSTransforms[TipBoneIndex - 1];
+		}
+		break;
+	case BRS_CopyFromTarget:
+		DestCSTransforms[TipBoneIndex].SetRotation(CSEffectorTransform.GetRotation());
+		break;
+	case BRS_KeepComponentSpaceRotation:
+		// Don't change the orientation at all
+		break;
+	default:
+		break;
+	}
+
+	// Commit the changes, if there were any
+	if (bBoneLocationUpdated)
+	{
+		OutBoneTransforms.Reserve(NumChainLinks);
+
+		for (int32 i = 0; i < NumChainLinks; ++i)
+		{
+			OutBoneTransforms.Add(FBoneTransform((*Chain)[i].BoneIndex, DestCSTransforms[i]));
+		}
+	}
+
+
+#if WITH_EDITOR
+
+	if (bEnableDebugDraw)
+	{
+		USkeletalMeshComponent* SkelComp = Output.AnimInstanceProxy->GetSkelMeshComponent();
+		UWorld* World = SkelComp->GetWorld();
+		FMatrix ToWorld = SkelComp->GetComponentToWorld().ToMatrixNoScale();
+
+		if (SolverMode != ERangeLimitedFABRIKSolverMode::RLF_ClosedLoop)
+		{
+			// Draw chain before adjustment, in yellow
+			for (int32 i = 0; i < NumChainLinks - 1; ++i)
+			{
+				FVector ParentLoc = ToWorld.TransformPosition(SourceCSTransforms[i].GetLocation());
+				FVector ChildLoc = ToWorld.TransformPosition(SourceCSTransforms[i + 1].GetLocation());
+				FDebugDrawUtil::DrawLine(World, ParentLoc, ChildLoc, FColor(255, 255, 0));
+				FDebugDrawUtil::DrawSphere(World, ChildLoc, FColor(255, 255, 0), 3.0f);
+			}
+
+			// Draw root drag radius
+			if (MaxRootDragDistance > KINDA_SMALL_NUMBER)
+			{
+				FDebugDrawUtil::DrawSphere(World,
+					ToWorld.TransformPosition(SourceCSTransforms[0].GetLocation()),
+					FColor(255, 0, 0), MaxRootDragDistance, 12, -1.0f, 0.5f);
+			}
+
+			// Draw chain after adjustment, in cyan
+			for (int32 i = 0; i < NumChainLinks - 1; ++i)
+			{
+				FVector ParentLoc = ToWorld.TransformPosition(DestCSTransforms[i].GetLocation());
+				FVector ChildLoc = ToWorld.TransformPosition(DestCSTransforms[i + 1].GetLocation());
+				FDebugDrawUtil::DrawLine(World, ParentLoc, ChildLoc, FColor(0, 255, 255));
+				FDebugDrawUtil::DrawSphere(World, ChildLoc, FColor(0, 255, 255), 3.0f);
+			}
+		}
+		else if (SolverMode == ERangeLimitedFABRIKSolverMode::RLF_ClosedLoop)
+		{
+			// Draw chain before adjustment, in yellow
+			for (int32 i = 0; i < NumChainLinks - 1; ++i)
+			{
+				FVector ParentLoc = ToWorld.TransformPosition(SourceCSTransforms[i].GetLocation());
+				FVector ChildLoc = ToWorld.TransformPosition(SourceCSTransforms[i + 1].GetLocation());
+				FDebugDrawUtil::DrawLine(World, ParentLoc, ChildLoc, FColor(255, 255, 0));
+				FDebugDrawUtil::DrawSphere(World, ChildLoc, FColor(255, 255, 0), 3.0f);
+			}
+
+			FDebugDrawUtil::DrawLine(World,
+				ToWorld.TransformPosition(SourceCSTransforms[0].GetLocation()),
+				ToWorld.TransformPosition(SourceCSTransforms[NumChainLinks-1].GetLocation()),
+				FColor(255, 255, 0));
+
+			// Draw root drag radius
+			if (MaxRootDragDistance > KINDA_SMALL_NUMBER)
+			{
+				FDebugDrawUtil::DrawSphere(World,
+					ToWorld.TransformPosition(SourceCSTransforms[0].GetLocation()),
+					FColor(255, 0, 0), MaxRootDragDistance, 12, -1.0f, 0.5f);
+			}
+
+			// Draw chain after adjustment, in cyan
+			for (int32 i = 0; i < NumChainLinks - 1; ++i)
+			{
+				FVector ParentLoc = ToWorld.TransformPosition(DestCSTransforms[i].GetLocation());
+				FVector ChildLoc = ToWorld.TransformPosition(DestCSTransforms[i + 1].GetLocation());
+				FDebugDrawUtil::DrawLine(World, ParentLoc, ChildLoc, FColor(0, 255, 255));
+				FDebugDrawUtil::DrawSphere(World, ChildLoc, FColor(0, 255, 255), 3.0f);
+			}
+
+			FDebugDrawUtil::DrawLine(World,
+				ToWorld.TransformPosition(DestCSTransforms[0].GetLocation()),
+				ToWorld.TransformPosition(DestCSTransforms[NumChainLinks-1].GetLocation()),
+				FColor(0, 255, 255));	
+		}
+	}
+
+#endif
+
+
+}
+
+void FAnimNode_RangeLimitedFabrik::UpdateParentRotation(FTransform& ParentTransform, const FIKBone& ParentBone,
+	FTransform& ChildTransform, const FIKBone& ChildBone, FCSPose<FCompactPose>& Pose) const
+{
+	
+	// Calculate pre-translation vector between this bone and child
+	FTransform OldParentTransform = Pose.GetComponentSpaceTransform(ParentBone.BoneIndex);
+	FTransform OldChildTransform = Pose.GetComponentSpaceTransform(ChildBone.BoneIndex);
+	FVector OldDir = (OldChildTransform.GetLocation() - OldParentTransform.GetLocation()).GetUnsafeNormal();
+
+	// Get vector from the post-translation bone to it's child
+	FVector NewDir = (ChildTransform.GetLocation() -
+		ParentTransform.GetLocation()).GetUnsafeNormal();
+	
+	// Calculate shortest rotation from pre-translation vector to post-translation vector
+	FQuat DeltaRotation = FQuat::FindBetweenNormals(OldDir, NewDir);
+	// We're going to multiply it, in order to not have to re-normalize the final quaternion, it has to be a unit quaternion.
+	checkSlow(DeltaRotation.IsNormalized());
+	
+	// Calculate absolute rotation and set it
+	ParentTransform.SetRotation(DeltaRotation * OldParentTransform.GetRotation());
+	ParentTransform.NormalizeRotation();
+}
+
+
+bool FAnimNode_RangeLimitedFabrik::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+{
+	FRangeLimitedIKChain* Chain = FIKInstanceState::ResolveChain(InstanceState.Get(), IKChain, IKChainHandle);
+
+	if (Chain == nullptr)
+	{
+#if ENABLE_IK_DEBUG_VERBOSE
+		UE_LOG(LogRTIK, Warning, TEXT("AnimNode_RangeLimitedFabrik was not valid to evaluate -- an input was not set"));		
+#endif ENABLE_IK_DEBUG_VERBOSE
+		return false;
+	}
+
+	if (Chain->Num() < 2)
+	{
+		return false;
+	}
+
+	// Allow evaluation if all parameters are initialized and TipBone is child of RootBone
+	return (
+		Precision > 0
+		&& Chain->IsValidCached(RequiredBones)
+		);
+}
+
+void FAnimNode_RangeLimitedFabrik::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	FRangeLimitedIKChain* Chain = FIKInstanceState::ResolveChain(InstanceState.Get(), IKChain, IKChainHandle);
+
+	if (Chain == nullptr)
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not initialize FAnimNode_RangeLimitedFabrik -- An input was not set"));
+#endif // ENABLE_IK_DEBUG
+		return;
+	}
+
+	Chain->RefreshCachedValidity(RequiredBones);
+	size_t NumBones = Chain->Num();
+
+	if (NumBones < 2)
+	{
+		return;
+	}
+	
+	EffectorTransformBone = (*Chain)[NumBones - 1].BoneRef;
+	EffectorTransformBone.Initialize(RequiredBones);
+
+	// Spline arc-length table. Left empty if any bone is missing, so the solver measures the pose instead.
+	SplineArcLengths.Reset();
+	const FReferenceSkeleton& RefSkeleton = RequiredBones.GetReferenceSkeleton();
+	TArray<FTransform> RefPoseCSTransforms;
+	RefPoseCSTransforms.Reserve(static_cast<int32>(NumBones));
+	for (size_t i = 0; i < NumBones; ++i)
+	{
+		int32 BoneIndex = (*Chain)[i].BoneRef.BoneIndex;
+		if (!RefSkeleton.IsValidIndex(BoneIndex))
+		{
+			return;
+		}
+		RefPoseCSTransforms.Add(FAnimationRuntime::GetComponentSpaceTransformRefPose(RefSkeleton, BoneIndex));
+	}
+	FRangeLimitedFABRIK::ComputeSplineArcLengths(RefPoseCSTransforms, SplineArcLengths);
+}
+
+void FAnimNode_RangeLimitedFabrik::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine = DebugData.GetNodeName(this);
+
+	const UEnum* TerminationEnum = FindObject<UEnum>(ANY_PACKAGE, TEXT("EIKSolveTermination"));
+	if (TerminationEnum != nullptr)
+	{
+		DebugLine += FString::Printf(TEXT("(Iterations: %d, Slop: %.3f, %s)"),
+			LastSolveStats.Iterations,
+			LastSolveStats.FinalSlop,
+			*TerminationEnum->GetNameStringByValue(static_cast<int64>(LastSolveStats.Termination)));
+	}
+
+	DebugData.AddDebugItem(DebugLine);
+	ComponentPose.GatherDebugData(DebugData);
+}
@@ -1,263 +1,304 @@
-// Copyright (c) Henry Cooney 2017
-
-#include "rtik.h"
-#include "HumanoidIK.h"
-#include "Utility/AnimUtil.h"
-#include "Utility/TraceUtil.h"
-#include "Components/SkeletalMeshComponent.h"
-
-void FHumanoidIK::HumanoidIKLegTrace(ACharacter* Character,
-	FCSPose<FCompactPose>& MeshBases,
-	FHumanoidLegChain& LegChain,
-	FIKBone& PelvisBone,
-	float MaxPelvisAdjustHeight,
-	FHumanoidIKTraceData& OutTraceData,
-	bool bEnableDebugDraw)
-{
-	// Traces to find floor points below foot bone and toe. 
-
-    // Each trace proceeds downward in a vertical line through the foot / toe bone. The start point is the
-    // pelvis height, foot height, or toe height, whichever is greatest. The end point is determined by the max leg exention length.
-
-    // Trace direction is downward axis of skeletal mesh component.
-
-	if (Character == nullptr)
-	{		
-		return;
-	}
-
-	USkeletalMeshComponent* SkelComp = Character->GetMesh();
-	UWorld* World = Character->GetWorld();
-	const FBoneContainer& RequiredBones = MeshBases.GetPose().GetBoneContainer();	
-	FVector TraceDirection = -1 * Character->GetActorUpVector();
-
-	// All calcuations done in CS; will be translated to world space for final trace
-	FVector PelvisLocation = FAnimUtil::GetBoneCSLocation(*SkelComp,
-		MeshBases,
-		PelvisBone.BoneIndex);
-
-	FVector FootLocation = FAnimUtil::GetBoneCSLocation(*SkelComp, MeshBases, LegChain.ShinBone.BoneIndex);
-	FVector ToeLocation = FAnimUtil::GetBoneCSLocation(*SkelComp, MeshBases, LegChain.FootBone.BoneIndex);
-
-	float TraceStartHeight = FMath::Max3(FootLocation.Z + LegChain.FootRadius,
-		ToeLocation.Z + LegChain.ToeRadius,
-		PelvisLocation.Z);
-	float TraceEndHeight = PelvisLocation.Z - (LegChain.GetTotalChainLength() + LegChain.FootRadius + LegChain.ToeRadius + MaxPelvisAdjustHeight);
-
-	FVector FootTraceStart(FootLocation.X, FootLocation.Y, TraceStartHeight);
-	FVector FootTraceEnd(FootLocation.X, FootLocation.Y, TraceEndHeight);
-
-	FVector ToeTraceStart(ToeLocation.X, ToeLocation.Y, TraceStartHeight);
-	FVector ToeTraceEnd(ToeLocation.X, ToeLocation.Y, TraceEndHeight);
-
-	// Convert to world space for tracing
-	FTransform ComponentToWorld = SkelComp->GetComponentToWorld();
-	FootTraceStart = ComponentToWorld.TransformPosition(FootTraceStart);
-	FootTraceEnd   = ComponentToWorld.TransformPosition(FootTraceEnd);
-	ToeTraceStart  = ComponentToWorld.TransformPosition(ToeTraceStart);
-	ToeTraceEnd    = ComponentToWorld.TransformPosition(ToeTraceEnd);
-	
-	UTraceUtil::LineTrace(World,
-		Character,
-		FootTraceStart,
-		FootTraceEnd,
-		OutTraceData.FootHitResult,
-		ECC_Pawn,
-		false,
-		bEnableDebugDraw);
-
-	UTraceUtil::LineTrace(World,
-		Character,
-		ToeTraceStart,
-		ToeTraceEnd,
-		OutTraceData.ToeHitResult,
-		ECC_Pawn,
-		false,
-		bEnableDebugDraw);
-}
-
-bool FHumanoidLegChain::IsValid(const FBoneContainer& RequiredBones)
-{
-	bool bValid = HipBone.IsValid(RequiredBones)
-		&& ThighBone.IsValid(RequiredBones)
-		&& ShinBone.IsValid(RequiredBones)
-		&& FootBone.IsValid(RequiredBones);
-
-	return bValid;
-}
-
-float FHumanoidLegChain::GetTotalChainLength() const
-{
-	return TotalChainLength;
-}
-
-bool FHumanoidLegChain::FindWithinFootRotationLimit(const USkeletalMeshComponent& SkelComp,
-	const FHumanoidIKTraceData& TraceData,
-	float& OutAngleRad) const
-{
-
-	if (TraceData.FootHitResult.GetActor() == nullptr ||
-		TraceData.ToeHitResult.GetActor() == nullptr)
-	{
-		return false;
-	}
-
-	FVector ToCS = -1 * SkelComp.GetComponentLocation();
-
-	FVector FootFloorCS = ToCS + TraceData.FootHitResult.ImpactPoint;
-	FVector ToeFloorCS  = ToCS + TraceData.ToeHitResult.ImpactPoint;
-	
-	FVector FloorSlopeVec = ToeFloorCS - FootFloorCS;
-	FVector FloorFlatVec(FloorSlopeVec);
-	FloorFlatVec.Z = 0.0f;
-	
-	if(!FloorSlopeVec.Normalize() || !FloorFlatVec.Normalize())
-	{
-		OutAngleRad = 0.0f;
-		return false;
-	}
-   
-	OutAngleRad = FMath::Acos(FVector::DotProduct(FloorFlatVec, FloorSlopeVec));
-	float RequiredRotationDeg = FMath::RadiansToDegrees(OutAngleRad);
-
-	if (RequiredRotationDeg > MaxFootRotationDegrees)
-	{
-		return false;
-	}
-	
-	return true;
-}
-
-bool FHumanoidLegChain::GetIKFloorPointCS(const USkeletalMeshComponent& SkelComp,
-	const FHumanoidIKTraceData& TraceData,
-	FVector& OutTraceLocationCS) const 
-{
-	FVector ToCS        = -1 * SkelComp.GetComponentLocation();
-	FVector FootFloorCS = ToCS + TraceData.FootHitResult.ImpactPoint;
-	FVector ToeFloorCS  = ToCS + TraceData.ToeHitResult.ImpactPoint;
-
-	// If one of the trace results is invalid, don't rotate, and use the other one
-	if (TraceData.FootHitResult.GetActor() == nullptr || TraceData.ToeHitResult.GetActor() == nullptr)
-	{
-		if (TraceData.FootHitResult.GetActor() != nullptr)
-		{
-			OutTraceLocationCS = FootFloorCS;
-		}
-		else if (TraceData.ToeHitResult.GetActor() != nullptr)
-		{
-			OutTraceLocationCS = ToeFloorCS;
-		}
-
-#if ENABLE_IK_DEBUG_VERBOSE
-		else
-		{
-			UE_LOG(LogRTIK, Warning, TEXT("Warning, GetIKFloorPointCS was called on an invalid trace result. The output floor point may be invalid."));
-			// check (false);
-		}
-#endif // ENABLE_IK_DEBUG
-		
-		return false;
-	}
-
-	float Unused;
-	// If within foot rotation limit, always use the foot. Otherwise, use the higher point and the foot shouldn't rotate.
-	bool bWithinRotationLimit = FindWithinFootRotationLimit(SkelComp, TraceData, Unused);
-	
-	if (bWithinRotationLimit)
-	{
-		OutTraceLocationCS = FootFloorCS;
-	}
-	else
-	{
-		OutTraceLocationCS = FootFloorCS.Z > ToeFloorCS.Z ? FootFloorCS : ToeFloorCS;
-	}
-
-	return bWithinRotationLimit;
-}
-
-bool FHumanoidLegChain::InitBoneReferences(const FBoneContainer& RequiredBones)
-{
-	TotalChainLength = 0.0f;
-	bInitOk = true;
-		
-	if (!HipBone.Init(RequiredBones))
-	{
-#if ENABLE_IK_DEBUG
-		UE_LOG(LogRTIK, Warning, TEXT("Could not initialized IK leg chain - Hip Bone invalid"));
-#endif // ENABLE_IK_DEBUG			
-		bInitOk = false;
-	}
-	
-	if (!ThighBone.Init(RequiredBones))
-	{
-#if ENABLE_IK_DEBUG
-		UE_LOG(LogRTIK, Warning, TEXT("Could not initialized IK leg chain - Thigh Bone invalid"));
-#endif // ENABLE_IK_DEBUG
-		bInitOk = false;
-	}
-	
-	if (!ShinBone.Init(RequiredBones))
-	{
-#if ENABLE_IK_DEBUG
-		UE_LOG(LogRTIK, Warning, TEXT("Could not initialized IK leg chain - Shin Bone invalid"));
-#endif // ENABLE_IK_DEBUG			
-		bInitOk = false;
-	}
-	
-	if (!FootBone.Init(RequiredBones))
-	{
-#if ENABLE_IK_DEBUG
-		UE_LOG(LogRTIK, Warning, TEXT("Could not initialized IK leg chain - Foot Bone invalid"));
-#endif // ENABLE_IK_DEBUG
-		bInitOk = false;
-	}
-	
-	// Compute extended chain length
-	if (bInitOk)
-	{
-		const TArray<FTransform>& RefTransforms = RequiredBones.GetRefPoseArray();
-
-		FVector HipLoc   = RefTransforms[HipBone.BoneRef.BoneIndex].GetLocation();
-		FVector KneeLoc  = RefTransforms[ThighBone.BoneRef.BoneIndex].GetLocation();
-		FVector AnkleLoc = RefTransforms[ShinBone.BoneRef.BoneIndex].GetLocation();
-		FVector ToeLoc   = RefTransforms[FootBone.BoneRef.BoneIndex].GetLocation();
-		
-		FVector ThighVec = KneeLoc - HipLoc;
-		FVector ShinVec  = AnkleLoc - KneeLoc;
-		FVector FootVec  = ToeLoc - AnkleLoc;
-
-		float ThighSize  = ThighVec.Size();
-		float ShinSize   = ShinVec.Size();
-		float FootSize   = FootVec.Size();
-
-		TotalChainLength = ThighSize + ShinSize + FootSize;
-	}
-	
-	return bInitOk;
-}
-
-/*
-bool FHumanoidArmChain::InitBoneReferences(const FBoneContainer & RequiredBones)
-{
-	// Automatically set up chain
-	BonesRootToEffector.Empty();
-	BonesRootToEffector.Reserve(2);
-	BonesRootToEffector.Add(UpperArmBone);
-	BonesRootToEffector.Add(LowerArmBone);
-
-	UpperArmBone.Init(RequiredBones);
-	LowerArmBone.Init(RequiredBones);
-	
-	Super::InitBoneReferences(RequiredBones);
-}
-
-bool FHumanoidArmChain::IsValid(const FBoneContainer & RequiredBones)
-{
-	bool bValid = true;
-	bValid &= UpperArmBone.IsValid(RequiredBones);
-	bValid &= LowerArmBone.IsValid(RequiredBones);
-	bValid &= Super::InitBoneReferences(RequiredBones);
-
-	return bValid;
-}
-*/
+// Copyright (c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "HumanoidIK.h"
+#include "Utility/AnimUtil.h"
+#include "Utility/TraceUtil.h"
+#include "Components/SkeletalMeshComponent.h"
+
+void FHumanoidIK::HumanoidIKLegTrace(ACharacter* Character,
+	FCSPose<FCompactPose>& MeshBases,
+	FHumanoidLegChain& LegChain,
+	FIKBone& PelvisBone,
+	float MaxPelvisAdjustHeight,
+	FHumanoidIKTraceData& OutTraceData,
+	bool bEnableDebugDraw)
+{
+	// Traces to find floor points below foot bone and toe. 
+
+    // Each trace proceeds downward in a vertical line through the foot / toe bone. The start point is the
+    // pelvis height, foot height, or toe height, whichever is greatest. The end point is determined by the max leg exention length.
+
+    // Trace direction is downward axis of skeletal mesh component.
+
+	if (Character == nullptr)
+	{		
+		// Foot and toe traces
+		INC_DWORD_STAT_BY(STAT_RTIK_TracesSkipped, 2);
+		FIKFrameCounters::AddTraces(0, 2);
+		return;
+	}
+
+	USkeletalMeshComponent* SkelComp = Character->GetMesh();
+	UWorld* World = Character->GetWorld();
+	const FBoneContainer& RequiredBones = MeshBases.GetPose().GetBoneContainer();	
+	FVector TraceDirection = -1 * Character->GetActorUpVector();
+
+	// All calcuations done in CS; will be translated to world space for final trace
+	FVector PelvisLocation = FAnimUtil::GetBoneCSLocation(*SkelComp,
+		MeshBases,
+		PelvisBone.BoneIndex);
+
+	FVector FootLocation = FAnimUtil::GetBoneCSLocation(*SkelComp, MeshBases, LegChain.ShinBone.BoneIndex);
+	FVector ToeLocation = FAnimUtil::GetBoneCSLocation(*SkelComp, MeshBases, LegChain.FootBone.BoneIndex);
+
+	float TraceStartHeight = FMath::Max3(FootLocation.Z + LegChain.FootRadius,
+		ToeLocation.Z + LegChain.ToeRadius,
+		PelvisLocation.Z);
+	float TraceEndHeight = PelvisLocation.Z - (LegChain.GetTotalChainLength() + LegChain.FootRadius + LegChain.ToeRadius + MaxPelvisAdjustHeight);
+
+	FVector FootTraceStart(FootLocation.X, FootLocation.Y, TraceStartHeight);
+	FVector FootTraceEnd(FootLocation.X, FootLocation.Y, TraceEndHeight);
+
+	FVector ToeTraceStart(ToeLocation.X, ToeLocation.Y, TraceStartHeight);
+	FVector ToeTraceEnd(ToeLocation.X, ToeLocation.Y, TraceEndHeight);
+
+	// Convert to world space for tracing
+	FTransform ComponentToWorld = SkelComp->GetComponentToWorld();
+	FootTraceStart = ComponentToWorld.TransformPosition(FootTraceStart);
+	FootTraceEnd   = ComponentToWorld.TransformPosition(FootTraceEnd);
+	ToeTraceStart  = ComponentToWorld.TransformPosition(ToeTraceStart);
+	ToeTraceEnd    = ComponentToWorld.TransformPosition(ToeTraceEnd);
+	
+	UTraceUtil::LineTrace(World,
+		Character,
+		FootTraceStart,
+		FootTraceEnd,
+		OutTraceData.FootHitResult,
+		ECC_Pawn,
+		false,
+		bEnableDebugDraw);
+
+	UTraceUtil::LineTrace(World,
+		Character,
+		ToeTraceStart,
+		ToeTraceEnd,
+		OutTraceData.ToeHitResult,
+		ECC_Pawn,
+		false,
+		bEnableDebugDraw);
+}
+
+bool FHumanoidLegChain::IsValid(const FBoneContainer& RequiredBones)
+{
+	bool bValid = HipBone.IsValid(RequiredBones)
+		&& ThighBone.IsValid(RequiredBones)
+		&& ShinBone.IsValid(RequiredBones)
+		&& FootBone.IsValid(RequiredBones);
+
+	return bValid;
+}
+
+float FHumanoidLegChain::GetTotalChainLength() const
+{
+	return TotalChainLength;
+}
+
+bool FHumanoidLegChain::FindWithinFootRotationLimit(const USkeletalMeshComponent& SkelComp,
+	const FHumanoidIKTraceData& TraceData,
+	float& OutCosAngle) const
+{
+
+	if (TraceData.FootHitResult.GetActor() == nullptr ||
+		TraceData.ToeHitResult.GetActor() == nullptr)
+	{
+		return false;
+	}
+
+	FVector ToCS = -1 * SkelComp.GetComponentLocation();
+
+	return FindWithinFootRotationLimit(ToCS + TraceData.FootHitResult.ImpactPoint,
+		ToCS + TraceData.ToeHitResult.ImpactPoint, MaxFootRotationDegrees, OutCosAngle);
+}
+
+bool FHumanoidLegChain::FindWithinFootRotationLimit(const FVector& FootFloorCS, const FVector& ToeFloorCS,
+	float InMaxFootRotationDegrees, float& OutCosAngle)
+{
+	FVector FloorSlopeVec = ToeFloorCS - FootFloorCS;
+	FVector FloorFlatVec(FloorSlopeVec);
+	FloorFlatVec.Z = 0.0f;
+	
+	if(!FloorSlopeVec.Normalize() || !FloorFlatVec.Normalize())
+	{
+		OutCosAngle = 1.0f;
+		return false;
+	}
+   
+	// Smaller cosine means a steeper slope. The limit's cosine is taken here, rather than cached, since
+	// MaxFootRotationDegrees can be changed at any time from blueprint.
+	OutCosAngle = FVector::DotProduct(FloorFlatVec, FloorSlopeVec);
+	float MaxFootRotationCos = FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(InMaxFootRotationDegrees, 0.0f, 180.0f)));
+	if (OutCosAngle < MaxFootRotationCos)
+	{
+		return false;
+	}
+	
+	return true;
+}
+
+bool FHumanoidLegChain::GetIKFloorPointCS(const USkeletalMeshComponent& SkelComp,
+	const FHumanoidIKTraceData& TraceData,
+	FVector& OutTraceLocationCS) const 
+{
+	FVector ToCS = -1 * SkelComp.GetComponentLocation();
+
+	return GetIKFloorPointCS(ToCS + TraceData.FootHitResult.ImpactPoint, ToCS + TraceData.ToeHitResult.ImpactPoint,
+		TraceData.FootHitResult.GetActor() != nullptr, TraceData.ToeHitResult.GetActor() != nullptr,
+		MaxFootRotationDegrees, OutTraceLocationCS);
+}
+
+bool FHumanoidLegChain::GetIKFloorPointCS(const FVector& FootFloorCS, const FVector& ToeFloorCS, bool bFootHit,
+	bool bToeHit, float InMaxFootRotationDegrees, FVector& OutTraceLocationCS)
+{
+	// If one of the trace results is invalid, don't rotate, and use the other one
+	if (!bFootHit || !bToeHit)
+	{
+		if (bFootHit)
+		{
+			OutTraceLocationCS = FootFloorCS;
+		}
+		else if (bToeHit)
+		{
+			OutTraceLocationCS = ToeFloorCS;
+		}
+
+#if ENABLE_IK_DEBUG_VERBOSE
+		else
+		{
+			UE_LOG(LogRTIK, Warning, TEXT("Warning, GetIKFloorPointCS was called on an invalid trace result. The output floor point may be invalid."));
+			// check (false);
+		}
+#endif // ENABLE_IK_DEBUG
+		
+		return false;
+	}
+
+	float UnusedCos;
+	// If within foot rotation limit, always use the foot. Otherwise, use the higher point and the foot shouldn't rotate.
+	bool bWithinRotationLimit = FindWithinFootRotationLimit(FootFloorCS, ToeFloorCS, InMaxFootRotationDegrees, UnusedCos);
+	
+	if (bWithinRotationLimit)
+	{
+		OutTraceLocationCS = FootFloorCS;
+	}
+	else
+	{
+		OutTraceLocationCS = FootFloorCS.Z > ToeFloorCS.Z ? FootFloorCS : ToeFloorCS;
+	}
+
+	return bWithinRotationLimit;
+}
+
+void FHumanoidLegChain::GatherDefinitionInputs(TArray<FName>& OutBoneNames,
+	TArray<FIKBoneConstraint*>& OutConstraints)
+{
+	HipBone.InitConstraint();
+	ThighBone.InitConstraint();
+	ShinBone.InitConstraint();
+	FootBone.InitConstraint();
+
+	OutBoneNames.Reset(4);
+	OutBoneNames.Add(HipBone.BoneRef.BoneName);
+	OutBoneNames.Add(ThighBone.BoneRef.BoneName);
+	OutBoneNames.Add(ShinBone.BoneRef.BoneName);
+	OutBoneNames.Add(FootBone.BoneRef.BoneName);
+
+	OutConstraints.Reset(3);
+	OutConstraints.Add(HipBone.GetConstraint());
+	OutConstraints.Add(ThighBone.GetConstraint());
+	OutConstraints.Add(ShinBone.GetConstraint());
+}
+
+bool FHumanoidLegChain::InitBoneReferences(const FBoneContainer& RequiredBones)
+{
+	bInitOk = true;
+
+	TArray<FName> BoneNames;
+	TArray<FIKBoneConstraint*> LegConstraints;
+	GatherDefinitionInputs(BoneNames, LegConstraints);
+
+	// Name lookups and the extended chain length are worked out once per mesh, by the definition. A rig asset
+	// may have done them already.
+	if (BakedDefinition.IsValid() && BakedDefinition->IsFor(RequiredBones))
+	{
+		Definition = BakedDefinition;
+	}
+	else
+	{
+		Definition = FIKChainDefinitionCache::FindOrBuild(RequiredBones, BoneNames, LegConstraints,
+			GetDefinitionChecks());
+	}
+	const TArray<int32>& MeshBoneIndices = Definition->MeshBoneIndices;
+		
+	if (!HipBone.InitFromDefinition(RequiredBones, MeshBoneIndices[0]))
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not initialized IK leg chain - Hip Bone invalid"));
+#endif // ENABLE_IK_DEBUG			
+		bInitOk = false;
+	}
+	
+	if (!ThighBone.InitFromDefinition(RequiredBones, MeshBoneIndices[1]))
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not initialized IK leg chain - Thigh Bone invalid"));
+#endif // ENABLE_IK_DEBUG
+		bInitOk = false;
+	}
+	
+	if (!ShinBone.InitFromDefinition(RequiredBones, MeshBoneIndices[2]))
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not initialized IK leg chain - Shin Bone invalid"));
+#endif // ENABLE_IK_DEBUG			
+		bInitOk = false;
+	}
+	
+	if (!FootBone.InitFromDefinition(RequiredBones, MeshBoneIndices[3]))
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not initialized IK leg chain - Foot Bone invalid"));
+#endif // ENABLE_IK_DEBUG
+		bInitOk = false;
+	}
+	
+	// Thigh, shin and foot lengths
+	TotalChainLength = bInitOk ? Definition->TotalLength : 0.0f;
+
+	if (Definition->bHasSharedConstraints)
+	{
+		ConstraintTable.Reset();
+	}
+	else
+	{
+		ConstraintTable.Compile(LegConstraints);
+	}
+	
+	return bInitOk;
+}
+
+/*
+bool FHumanoidArmChain::InitBoneReferences(const FBoneContainer & RequiredBones)
+{
+	// Automatically set up chain
+	BonesRootToEffector.Empty();
+	BonesRootToEffector.Reserve(2);
+	BonesRootToEffector.Add(UpperArmBone);
+	BonesRootToEffector.Add(LowerArmBone);
+
+	UpperArmBone.Init(RequiredBones);
+	LowerArmBone.Init(RequiredBones);
+	
+	Super::InitBoneReferences(RequiredBones);
+}
+
+bool FHumanoidArmChain::IsValid(const FBoneContainer & RequiredBones)
+{
+	bool bValid = true;
+	bValid &= UpperArmBone.IsValid(RequiredBones);
+	bValid &= LowerArmBone.IsValid(RequiredBones);
+	bValid &= Super::InitBoneReferences(RequiredBones);
+
+	return bValid;
+}
+*/
@@ -0,0 +1,324 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "IKChainDefinition.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	// Everything a definition is built from
+	struct FChainDefinitionKey
+	{
+	public:
+
+		FChainDefinitionKey(const UObject* InAsset, const TArray<FName>& InBoneNames,
+			const TArray<FIKBoneConstraint*>& ChainConstraints, EIKChainDefinitionChecks InChecks)
+			:
+			Asset(InAsset),
+			BoneNames(InBoneNames),
+			Checks(InChecks),
+			bHasCustomConstraints(false)
+		{
+			FIKCompiledConstraintTable::CompileEntries(ChainConstraints, Entries);
+			for (const FIKCompiledConstraint& Entry : Entries)
+			{
+				bHasCustomConstraints |= (Entry.Type == EIKCompiledConstraintType::IKCC_Custom);
+			}
+
+			if (bHasCustomConstraints)
+			{
+				Entries.Empty();
+			}
+		}
+
+		FWeakObjectPtr Asset;
+		TArray<FName> BoneNames;
+		EIKChainDefinitionChecks Checks;
+
+		// If there are custom constraints, Entries is empty; those chains share everything but constraints
+		bool bHasCustomConstraints;
+		TArray<FIKCompiledConstraint> Entries;
+
+		bool operator==(const FChainDefinitionKey& Other) const
+		{
+			if (!(Asset == Other.Asset) || BoneNames != Other.BoneNames || Checks != Other.Checks ||
+				bHasCustomConstraints != Other.bHasCustomConstraints || Entries.Num() != Other.Entries.Num())
+			{
+				return false;
+			}
+
+			for (int32 i = 0; i < Entries.Num(); ++i)
+			{
+				if (!EntriesMatch(Entries[i], Other.Entries[i]))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		friend uint32 GetTypeHash(const FChainDefinitionKey& Key)
+		{
+			uint32 Hash = HashCombine(GetTypeHash(Key.Asset), static_cast<uint32>(Key.Checks));
+			for (const FName& BoneName : Key.BoneNames)
+			{
+				Hash = HashCombine(Hash, GetTypeHash(BoneName));
+			}
+
+			// Planar entries are compared in full by operator==; their types are enough to spread the hash
+			for (const FIKCompiledConstraint& Entry : Key.Entries)
+			{
+				Hash = HashCombine(Hash, static_cast<uint32>(Entry.Type));
+			}
+			return Hash;
+		}
+
+	protected:
+
+		// Only planar entries carry data; the rest of an entry is left uninitialized
+		static bool EntriesMatch(const FIKCompiledConstraint& A, const FIKCompiledConstraint& B)
+		{
+			if (A.Type != B.Type)
+			{
+				return false;
+			}
+
+			if (A.Type != EIKCompiledConstraintType::IKCC_Planar)
+			{
+				return true;
+			}
+
+			return A.RotationAxis == B.RotationAxis
+				&& A.ForwardDirection == B.ForwardDirection
+				&& A.UpDirection == B.UpDirection
+				&& A.FailsafeDirection == B.FailsafeDirection
+				&& A.MinDirection == B.MinDirection
+				&& A.MaxDirection == B.MaxDirection
+				&& A.MinPseudoAngle == B.MinPseudoAngle
+				&& A.MaxPseudoAngle == B.MaxPseudoAngle;
+		}
+	};
+
+	FCriticalSection DefinitionsLock;
+	TMap<FChainDefinitionKey, FIKChainDefinitionPtr> Definitions;
+
+#if WITH_EDITOR
+	FDelegateHandle ObjectPropertyChangedHandle;
+
+	// Editing or reimporting a mesh can move its bones, so definitions built from it are out of date
+	void HandleObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent)
+	{
+		FScopeLock Lock(&DefinitionsLock);
+		for (auto It = Definitions.CreateIterator(); It; ++It)
+		{
+			if (It.Key().Asset.Get() == Object)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+#endif // WITH_EDITOR
+
+	// Keeps the first reason a definition isn't valid
+	void SetProblem(FString* OutProblem, const TCHAR* Problem, const FName& BoneName)
+	{
+		if (OutProblem != nullptr && OutProblem->IsEmpty())
+		{
+			*OutProblem = FString::Printf(Problem, *BoneName.ToString());
+		}
+	}
+
+	// Bone indices in RefSkeleton are the pose indices of the asset it belongs to. If the definition isn't valid,
+	// and OutProblem is given, it is set to the first reason why.
+	FIKChainDefinitionPtr BuildDefinition(const FReferenceSkeleton& RefSkeleton, const FChainDefinitionKey& Key,
+		FString* OutProblem = nullptr)
+	{
+		FIKChainDefinition* Definition    = new FIKChainDefinition();
+		const int32 NumBones              = Key.BoneNames.Num();
+		const TArray<FTransform>& RefPose = RefSkeleton.GetRefBonePose();
+
+		Definition->Asset = Key.Asset;
+		Definition->BoneNames = Key.BoneNames;
+		Definition->MeshBoneIndices.Reserve(NumBones);
+		Definition->BoneLengths.Reserve(FMath::Max(NumBones - 1, 0));
+		Definition->bValid = true;
+
+		for (int32 i = 0; i < NumBones; ++i)
+		{
+			const FName& BoneName = Key.BoneNames[i];
+			int32 MeshBoneIndex   = RefSkeleton.FindBoneIndex(BoneName);
+			Definition->MeshBoneIndices.Add(MeshBoneIndex);
+
+			if (MeshBoneIndex == INDEX_NONE)
+			{
+#if ENABLE_IK_DEBUG
+				UE_LOG(LogRTIK, Warning, TEXT("Could not build IK chain definition - no bone named %s"),
+					*BoneName.ToString());
+#endif // ENABLE_IK_DEBUG
+				SetProblem(OutProblem, TEXT("no bone named %s"), BoneName);
+				Definition->bValid = false;
+			}
+
+			if (i == 0)
+			{
+				continue;
+			}
+
+			int32 PreviousMeshBoneIndex = Definition->MeshBoneIndices[i - 1];
+			float BoneLength            = 0.0f;
+			if (MeshBoneIndex != INDEX_NONE && PreviousMeshBoneIndex != INDEX_NONE)
+			{
+				BoneLength = FVector::Dist(RefPose[MeshBoneIndex].GetLocation(),
+					RefPose[PreviousMeshBoneIndex].GetLocation());
+			}
+			Definition->BoneLengths.Add(BoneLength);
+			Definition->TotalLength += BoneLength;
+
+			if (Key.Checks != EIKChainDefinitionChecks::IKCDC_Hierarchy)
+			{
+				continue;
+			}
+
+			if (PreviousMeshBoneIndex >= MeshBoneIndex)
+			{
+#if ENABLE_IK_DEBUG
+				UE_LOG(LogRTIK, Warning, TEXT("Could not build IK chain definition - bone named %s was not preceeded by a skeletal parent"),
+					*BoneName.ToString());
+#endif // ENABLE_IK_DEBUG
+				SetProblem(OutProblem, TEXT("bone named %s was not preceeded by a skeletal parent"), BoneName);
+				Definition->bValid = false;
+			}
+			else if (BoneLength < KINDA_SMALL_NUMBER)
+			{
+#if ENABLE_IK_DEBUG
+				UE_LOG(LogRTIK, Warning, TEXT("Could not build IK chain definition - bone named %s has zero length"),
+					*BoneName.ToString());
+#endif // ENABLE_IK_DEBUG
+				SetProblem(OutProblem, TEXT("bone named %s has zero length"), BoneName);
+				Definition->bValid = false;
+			}
+		}
+
+		if (!Key.bHasCustomConstraints)
+		{
+			FIKCompiledConstraintTable& Table = Definition->ConstraintTable;
+			Table.Entries = Key.Entries;
+			Table.Constraints.Init(nullptr, Table.Entries.Num());
+			for (const FIKCompiledConstraint& Entry : Table.Entries)
+			{
+				Table.bHasActiveConstraints |= (Entry.Type != EIKCompiledConstraintType::IKCC_None);
+			}
+			Definition->bHasSharedConstraints = true;
+		}
+
+		return FIKChainDefinitionPtr(Definition);
+	}
+
+	FAutoConsoleCommand ListDefinitionsCommand(
+		TEXT("rtik.ChainDefinitions.List"),
+		TEXT("Logs every cached IK chain definition, and how many chains share it."),
+		FConsoleCommandDelegate::CreateStatic(&FIKChainDefinitionCache::LogDefinitions));
+
+	FAutoConsoleCommand FlushDefinitionsCommand(
+		TEXT("rtik.ChainDefinitions.Flush"),
+		TEXT("Drops every cached IK chain definition. Chains rebuild theirs when they are next initialized."),
+		FConsoleCommandDelegate::CreateStatic(&FIKChainDefinitionCache::Empty));
+}
+
+void FIKChainDefinitionCache::Startup()
+{
+#if WITH_EDITOR
+	ObjectPropertyChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddStatic(&HandleObjectPropertyChanged);
+#endif // WITH_EDITOR
+}
+
+void FIKChainDefinitionCache::Shutdown()
+{
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(ObjectPropertyChangedHandle);
+	ObjectPropertyChangedHandle.Reset();
+#endif // WITH_EDITOR
+
+	Empty();
+}
+
+FIKChainDefinitionPtr FIKChainDefinitionCache::FindOrBuild(const FBoneContainer& RequiredBones,
+	const TArray<FName>& BoneNames, const TArray<FIKBoneConstraint*>& ChainConstraints, EIKChainDefinitionChecks Checks)
+{
+	FChainDefinitionKey Key(RequiredBones.GetAsset(), BoneNames, ChainConstraints, Checks);
+
+	FScopeLock Lock(&DefinitionsLock);
+
+	if (const FIKChainDefinitionPtr* Found = Definitions.Find(Key))
+	{
+		return *Found;
+	}
+
+	// Only building is slow, so only building pays to drop definitions for meshes that are gone
+	for (auto It = Definitions.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().Asset.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	FIKChainDefinitionPtr Definition = BuildDefinition(RequiredBones.GetReferenceSkeleton(), Key);
+	Definitions.Add(Key, Definition);
+	return Definition;
+}
+
+FIKChainDefinitionPtr FIKChainDefinitionCache::Build(const UObject* Asset, const FReferenceSkeleton& RefSkeleton,
+	const TArray<FName>& BoneNames, const TArray<FIKBoneConstraint*>& ChainConstraints, EIKChainDefinitionChecks Checks)
+{
+	return BuildDefinition(RefSkeleton, FChainDefinitionKey(Asset, BoneNames, ChainConstraints, Checks));
+}
+
+bool FIKChainDefinitionCache::CheckChain(const FReferenceSkeleton& RefSkeleton, const TArray<FName>& BoneNames,
+	EIKChainDefinitionChecks Checks, FString& OutProblem)
+{
+	OutProblem.Empty();
+	TArray<FIKBoneConstraint*> NoConstraints;
+	return BuildDefinition(RefSkeleton, FChainDefinitionKey(nullptr, BoneNames, NoConstraints, Checks), &OutProblem)->bValid;
+}
+
+int32 FIKChainDefinitionCache::Num()
+{
+	FScopeLock Lock(&DefinitionsLock);
+	return Definitions.Num();
+}
+
+void FIKChainDefinitionCache::Empty()
+{
+	FScopeLock Lock(&DefinitionsLock);
+	Definitions.Empty();
+}
+
+void FIKChainDefinitionCache::LogDefinitions()
+{
+	FScopeLock Lock(&DefinitionsLock);
+
+	UE_LOG(LogRTIK, Display, TEXT("%d IK chain definitions"), Definitions.Num());
+	for (const auto& Pair : Definitions)
+	{
+		const FIKChainDefinition& Definition = *Pair.Value;
+		const UObject* Asset                 = Pair.Key.Asset.Get();
+
+		FString Bones;
+		for (const FName& BoneName : Definition.BoneNames)
+		{
+			Bones += (Bones.IsEmpty() ? TEXT("") : TEXT(", ")) + BoneName.ToString();
+		}
+
+		// The cache holds one reference itself
+		UE_LOG(LogRTIK, Display, TEXT("  %s: [%s] length %.2f, %s, %s, %d chains"),
+			Asset != nullptr ? *Asset->GetName() : TEXT("(collected)"),
+			*Bones,
+			Definition.TotalLength,
+			Definition.bValid ? TEXT("valid") : TEXT("invalid"),
+			Definition.bHasSharedConstraints ? TEXT("shared constraints") : TEXT("per-chain constraints"),
+			Pair.Value.GetSharedReferenceCount() - 1);
+	}
+}
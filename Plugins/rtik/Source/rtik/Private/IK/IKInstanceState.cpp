@@ -0,0 +1,178 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "IKInstanceState.h"
+#include "RTIKRigAsset.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	typedef TWeakPtr<FIKInstanceState, ESPMode::ThreadSafe> FIKInstanceStateWeakPtr;
+
+	// A proxy's address may be reused once it is destroyed, but by then the nodes holding its state are gone too,
+	// so the weak pointer has expired
+	FCriticalSection InstanceStatesLock;
+	TMap<const FAnimInstanceProxy*, FIKInstanceStateWeakPtr> InstanceStates;
+
+	template<typename SlotType>
+	SlotType& FindOrAddSlot(TMap<FName, TUniquePtr<SlotType>>& Slots, FName Name, const SlotType& Settings)
+	{
+		TUniquePtr<SlotType>& Slot = Slots.FindOrAdd(Name);
+		if (!Slot.IsValid())
+		{
+			Slot = MakeUnique<SlotType>(Settings);
+			Slot->InvalidateCache();
+		}
+		return *Slot;
+	}
+
+	// Adds a slot set up from RigSettings, using the rig's baked definition. Uses Settings instead if the rig has
+	// no chain named Name.
+	template<typename SlotType>
+	SlotType& AddRigSlot(TMap<FName, TUniquePtr<SlotType>>& Slots, FName Name, const SlotType& Settings,
+		const URTIKRigAsset& Rig, const SlotType* RigSettings, const FIKChainDefinitionPtr& BakedDefinition)
+	{
+		if (RigSettings == nullptr)
+		{
+#if ENABLE_IK_DEBUG
+			UE_LOG(LogRTIK, Warning, TEXT("RTIK rig %s has no chain named %s -- using the handle's settings instead"),
+				*Rig.GetName(), *Name.ToString());
+#endif // ENABLE_IK_DEBUG
+			return FindOrAddSlot(Slots, Name, Settings);
+		}
+
+		SlotType& Slot = FindOrAddSlot(Slots, Name, *RigSettings);
+		Slot.SetBakedDefinition(BakedDefinition);
+		return Slot;
+	}
+}
+
+TSharedRef<FIKInstanceState, ESPMode::ThreadSafe> FIKInstanceState::FindOrCreate(const FAnimInstanceProxy* Proxy)
+{
+	FScopeLock Lock(&InstanceStatesLock);
+
+	if (const FIKInstanceStateWeakPtr* Found = InstanceStates.Find(Proxy))
+	{
+		FIKInstanceStatePtr State = Found->Pin();
+		if (State.IsValid())
+		{
+			return State.ToSharedRef();
+		}
+	}
+
+	for (auto It = InstanceStates.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	TSharedRef<FIKInstanceState, ESPMode::ThreadSafe> State = MakeShareable(new FIKInstanceState());
+	InstanceStates.Add(Proxy, State);
+	return State;
+}
+
+FHumanoidLegChain& FIKInstanceState::FindOrAddLeg(const FHumanoidLegChainHandle& Handle)
+{
+	// Rig lookups are only needed the first time
+	if (Handle.Rig != nullptr && !Legs.Contains(Handle.Name))
+	{
+		FIKChainDefinitionPtr BakedDefinition;
+		const FHumanoidLegChain* RigSettings = Handle.Rig->FindLeg(Handle.Name, BakedDefinition);
+		return AddRigSlot(Legs, Handle.Name, Handle.Chain, *Handle.Rig, RigSettings, BakedDefinition);
+	}
+
+	return FindOrAddSlot(Legs, Handle.Name, Handle.Chain);
+}
+
+FRangeLimitedIKChain& FIKInstanceState::FindOrAddChain(const FRangeLimitedIKChainHandle& Handle)
+{
+	if (Handle.Rig != nullptr && !Chains.Contains(Handle.Name))
+	{
+		FIKChainDefinitionPtr BakedDefinition;
+		const FRangeLimitedIKChain* RigSettings = Handle.Rig->FindChain(Handle.Name, BakedDefinition);
+		return AddRigSlot(Chains, Handle.Name, Handle.Chain, *Handle.Rig, RigSettings, BakedDefinition);
+	}
+
+	return FindOrAddSlot(Chains, Handle.Name, Handle.Chain);
+}
+
+FIKBone& FIKInstanceState::FindOrAddBone(const FIKBoneHandle& Handle)
+{
+	return FindOrAddSlot(Bones, Handle.Name, Handle.Bone);
+}
+
+FHumanoidIKTraceState& FIKInstanceState::FindOrAddTraceData(const FHumanoidIKTraceDataHandle& Handle)
+{
+	TUniquePtr<FHumanoidIKTraceState>& Slot = TraceData.FindOrAdd(Handle.Name);
+	if (!Slot.IsValid())
+	{
+		Slot = MakeUnique<FHumanoidIKTraceState>();
+	}
+	return *Slot;
+}
+
+FHumanoidLegChain* FIKInstanceState::ResolveLeg(FIKInstanceState* State, UHumanoidLegChain_Wrapper* Wrapper,
+	const FHumanoidLegChainHandle& Handle)
+{
+	if (Wrapper != nullptr)
+	{
+		if (!Wrapper->IsInitialized())
+		{
+#if ENABLE_IK_DEBUG
+			UE_LOG(LogRTIK, Warning, TEXT("Humanoid IK Leg Chain wrapper was not initialized -- make sure you call Initialize function in blueprint before use"));
+#endif // ENABLE_IK_DEBUG
+			return nullptr;
+		}
+		return &Wrapper->Chain;
+	}
+
+	return (State != nullptr && Handle.IsSet()) ? &State->FindOrAddLeg(Handle) : nullptr;
+}
+
+FRangeLimitedIKChain* FIKInstanceState::ResolveChain(FIKInstanceState* State, URangeLimitedIKChainWrapper* Wrapper,
+	const FRangeLimitedIKChainHandle& Handle)
+{
+	if (Wrapper != nullptr)
+	{
+		if (!Wrapper->IsInitialized())
+		{
+#if ENABLE_IK_DEBUG
+			UE_LOG(LogRTIK, Warning, TEXT("Range limited IK chain wrapper was not initialized -- make sure you call Initialize function in blueprint before use"));
+#endif // ENABLE_IK_DEBUG
+			return nullptr;
+		}
+		return &Wrapper->Chain;
+	}
+
+	return (State != nullptr && Handle.IsSet()) ? &State->FindOrAddChain(Handle) : nullptr;
+}
+
+FIKBone* FIKInstanceState::ResolveBone(FIKInstanceState* State, UIKBoneWrapper* Wrapper, const FIKBoneHandle& Handle)
+{
+	if (Wrapper != nullptr)
+	{
+		if (!Wrapper->IsInitialized())
+		{
+#if ENABLE_IK_DEBUG
+			UE_LOG(LogRTIK, Warning, TEXT("IK Bone Wrapper was not initialized -- you must call Initialize in blueprint before use"));
+#endif // ENABLE_IK_DEBUG
+			return nullptr;
+		}
+		return &Wrapper->Bone;
+	}
+
+	return (State != nullptr && Handle.IsSet()) ? &State->FindOrAddBone(Handle) : nullptr;
+}
+
+FHumanoidIKTraceState* FIKInstanceState::ResolveTraceData(FIKInstanceState* State, UHumanoidIKTraceData_Wrapper* Wrapper,
+	const FHumanoidIKTraceDataHandle& Handle)
+{
+	if (Wrapper != nullptr)
+	{
+		return &Wrapper->GetTraceState();
+	}
+
+	return (State != nullptr && Handle.IsSet()) ? &State->FindOrAddTraceData(Handle) : nullptr;
+}
@@ -0,0 +1,424 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "IKSolveRecorder.h"
+#include "RangeLimitedFABRIK.h"
+#include "AnimNode_HumanoidLegIK.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	// 'RTIK', then the format version. Bump the version whenever the record layout changes.
+	const uint32 RecordingMagic   = 0x4B495452;
+	const uint32 RecordingVersion = 2;
+
+	const float ReplayMismatchTolerance = 0.01f;
+
+	FThreadSafeBool bRecording;
+	FCriticalSection RecordingLock;
+	TUniquePtr<FArchive> RecordingWriter;
+
+	// Rotation and translation only
+	void SerializeCompactTransform(FArchive& Ar, FTransform& Transform)
+	{
+		FQuat Rotation      = Transform.GetRotation();
+		FVector Translation = Transform.GetTranslation();
+		Ar << Rotation << Translation;
+
+		if (Ar.IsLoading())
+		{
+			Transform = FTransform(Rotation, Translation);
+		}
+	}
+
+	void SerializeConstraint(FArchive& Ar, FIKCompiledConstraint& Constraint)
+	{
+		uint8 Type = static_cast<uint8>(Constraint.Type);
+		Ar << Type;
+
+		if (Ar.IsLoading())
+		{
+			Constraint = FIKCompiledConstraint();
+			Constraint.Type = static_cast<EIKCompiledConstraintType>(Type);
+		}
+
+		if (Constraint.Type == EIKCompiledConstraintType::IKCC_Planar)
+		{
+			Ar << Constraint.RotationAxis << Constraint.ForwardDirection << Constraint.UpDirection;
+			Ar << Constraint.FailsafeDirection << Constraint.MinDirection << Constraint.MaxDirection;
+			Ar << Constraint.MinPseudoAngle << Constraint.MaxPseudoAngle;
+		}
+		else if (Constraint.Type != EIKCompiledConstraintType::IKCC_None)
+		{
+			// Custom constraints are never written, so this is a corrupt file
+			Ar.SetError();
+		}
+	}
+
+	void HandleStartRecording(const TArray<FString>& Args)
+	{
+		FString Filename = Args.Num() > 0 ? Args[0] :
+			FPaths::GameSavedDir() / TEXT("RTIK") / FString::Printf(TEXT("Solves-%s.rtiksolves"), *FDateTime::Now().ToString());
+
+		if (FIKSolveRecorder::StartRecording(Filename))
+		{
+			UE_LOG(LogRTIK, Display, TEXT("Recording IK solves to %s"), *Filename);
+		}
+	}
+
+	void HandleReplay(const TArray<FString>& Args)
+	{
+		if (Args.Num() < 1)
+		{
+			UE_LOG(LogRTIK, Display, TEXT("Usage: rtik.Replay Filename [Repeats]"));
+			return;
+		}
+
+		TArray<FIKSolveRecord> Records;
+		if (!FIKSolveRecorder::LoadRecording(Args[0], Records))
+		{
+			return;
+		}
+
+		int32 Repeats = Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 1;
+
+		FIKReplaySummary Summary;
+		FIKSolveReplayer::Replay(Records, Repeats, Summary);
+		FIKSolveReplayer::LogSummary(Summary);
+	}
+
+	FAutoConsoleCommand StartRecordingCommand(
+		TEXT("rtik.Record.Start"),
+		TEXT("Records the inputs of every FABRIK solve to a file, for rtik.Replay. Takes an optional filename."),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&HandleStartRecording));
+
+	FAutoConsoleCommand StopRecordingCommand(
+		TEXT("rtik.Record.Stop"),
+		TEXT("Stops recording IK solves."),
+		FConsoleCommandDelegate::CreateStatic(&FIKSolveRecorder::StopRecording));
+
+	FAutoConsoleCommand ReplayCommand(
+		TEXT("rtik.Replay"),
+		TEXT("Replays a recording of IK solves, and logs timing and how the results compare to what was recorded. ")
+		TEXT("Usage: rtik.Replay Filename [Repeats]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&HandleReplay));
+}
+
+void FIKSolveRecord::SetInputs(EIKRecordedSolver InSolver, const TArray<FTransform>& ChainTransforms,
+	const FIKCompiledConstraintTable& InConstraints, const FVector& InEffectorTargetLocation, float InDeltaTime)
+{
+	Solver                 = InSolver;
+	InTransforms           = ChainTransforms;
+	EffectorTargetLocation = InEffectorTargetLocation;
+	DeltaTime              = InDeltaTime;
+
+	Constraints.Reset(InTransforms.Num());
+	bHadCustomConstraints = false;
+	for (int32 PointIndex = 0; PointIndex < InTransforms.Num(); ++PointIndex)
+	{
+		FIKCompiledConstraint& Entry = Constraints[Constraints.AddDefaulted()];
+		if (InConstraints.bHasActiveConstraints && InConstraints.Entries.IsValidIndex(PointIndex))
+		{
+			Entry = InConstraints.Entries[PointIndex];
+			if (Entry.Type == EIKCompiledConstraintType::IKCC_Custom)
+			{
+				Entry = FIKCompiledConstraint();
+				bHadCustomConstraints = true;
+			}
+			Entry.Source = nullptr;
+		}
+	}
+}
+
+void FIKSolveRecord::SetResults(const TArray<FTransform>& OutTransforms, const FIKSolveStats& Stats)
+{
+	RecordedLocations.Reset(OutTransforms.Num());
+	for (const FTransform& Transform : OutTransforms)
+	{
+		RecordedLocations.Add(Transform.GetLocation());
+	}
+	RecordedStats = Stats;
+}
+
+void FIKSolveRecord::SetLegTarget(const FHumanoidLegIKTargetInputs& InLegTargetInputs, const FVector& InLastEffectorOffset)
+{
+	bHasLegTarget      = true;
+	LegTargetInputs    = InLegTargetInputs;
+	LastEffectorOffset = InLastEffectorOffset;
+}
+
+FArchive& operator<<(FArchive& Ar, FIKSolveRecord& Record)
+{
+	uint8 Solver          = static_cast<uint8>(Record.Solver);
+	uint8 UnreachableRule = static_cast<uint8>(Record.UnreachableRule);
+	uint8 Termination     = static_cast<uint8>(Record.RecordedStats.Termination);
+	FHumanoidLegIKTargetInputs& Leg = Record.LegTargetInputs;
+	uint8 Flags           = (Record.bHasLegTarget ? 1 : 0) | (Leg.bFootHit ? 2 : 0) | (Leg.bToeHit ? 4 : 0) |
+		(Record.bHadCustomConstraints ? 8 : 0) | (Leg.bFromTrace ? 16 : 0) | (Leg.bEffectorMovesInstantly ? 32 : 0);
+
+	Ar << Solver << Flags << Record.DeltaTime;
+
+	int32 NumPoints = Record.InTransforms.Num();
+	Ar << NumPoints;
+	if (Ar.IsLoading())
+	{
+		if (NumPoints < 0 || NumPoints > 0xFFFF)
+		{
+			Ar.SetError();
+			return Ar;
+		}
+		Record.InTransforms.SetNum(NumPoints);
+		Record.Constraints.SetNum(NumPoints);
+		Record.RecordedLocations.SetNum(NumPoints);
+	}
+
+	for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+	{
+		SerializeCompactTransform(Ar, Record.InTransforms[PointIndex]);
+		SerializeConstraint(Ar, Record.Constraints[PointIndex]);
+		Ar << Record.RecordedLocations[PointIndex];
+	}
+
+	Ar << Record.EffectorTargetLocation << Record.MaxRootDragDistance << Record.RootDragStiffness << Record.Precision;
+	Ar << Record.MaxIterations << UnreachableRule << Record.Relaxation << Record.StagnationRatio;
+	Ar << Record.RecordedStats.Iterations << Record.RecordedStats.FinalSlop << Termination;
+
+	if (Flags & 1)
+	{
+		Ar << Leg.FootCS << Leg.FootTargetCS << Leg.FootHeightAboveRoot << Leg.FootFloorCS << Leg.ToeFloorCS;
+		Ar << Leg.MaxFootRotationDegrees << Leg.EffectorVelocity << Record.LastEffectorOffset;
+	}
+
+	if (Ar.IsLoading())
+	{
+		Record.Solver                    = static_cast<EIKRecordedSolver>(Solver);
+		Record.UnreachableRule           = static_cast<EIKUnreachableRule>(UnreachableRule);
+		Record.RecordedStats.Termination = static_cast<EIKSolveTermination>(Termination);
+		Record.bHasLegTarget             = (Flags & 1) != 0;
+		Leg.bFootHit                     = (Flags & 2) != 0;
+		Leg.bToeHit                      = (Flags & 4) != 0;
+		Record.bHadCustomConstraints     = (Flags & 8) != 0;
+		Leg.bFromTrace                   = (Flags & 16) != 0;
+		Leg.bEffectorMovesInstantly      = (Flags & 32) != 0;
+	}
+
+	return Ar;
+}
+
+bool FIKSolveRecorder::IsRecording()
+{
+	return bRecording;
+}
+
+bool FIKSolveRecorder::StartRecording(const FString& Filename)
+{
+	StopRecording();
+
+	FArchive* Writer = IFileManager::Get().CreateFileWriter(*Filename);
+	if (Writer == nullptr)
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not start recording IK solves -- could not open %s"), *Filename);
+#endif // ENABLE_IK_DEBUG
+		return false;
+	}
+
+	uint32 Magic   = RecordingMagic;
+	uint32 Version = RecordingVersion;
+	*Writer << Magic << Version;
+
+	FScopeLock Lock(&RecordingLock);
+	RecordingWriter.Reset(Writer);
+	bRecording = true;
+	return true;
+}
+
+void FIKSolveRecorder::StopRecording()
+{
+	FScopeLock Lock(&RecordingLock);
+	bRecording = false;
+	if (RecordingWriter.IsValid())
+	{
+		RecordingWriter->Close();
+		RecordingWriter.Reset();
+	}
+}
+
+void FIKSolveRecorder::Record(FIKSolveRecord& SolveRecord)
+{
+	if (!bRecording)
+	{
+		return;
+	}
+
+	// Serialize outside the lock; only the write to the file is serialized between threads
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	Writer << SolveRecord;
+
+	FScopeLock Lock(&RecordingLock);
+	if (RecordingWriter.IsValid())
+	{
+		RecordingWriter->Serialize(Bytes.GetData(), Bytes.Num());
+	}
+}
+
+bool FIKSolveRecorder::LoadRecording(const FString& Filename, TArray<FIKSolveRecord>& OutRecords)
+{
+	OutRecords.Reset();
+
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!Reader.IsValid())
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not load IK solve recording -- could not open %s"), *Filename);
+#endif // ENABLE_IK_DEBUG
+		return false;
+	}
+
+	uint32 Magic   = 0;
+	uint32 Version = 0;
+	*Reader << Magic << Version;
+	if (Magic != RecordingMagic || Version != RecordingVersion)
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Could not load IK solve recording -- %s is not a version %u recording"),
+			*Filename, RecordingVersion);
+#endif // ENABLE_IK_DEBUG
+		return false;
+	}
+
+	while (!Reader->AtEnd() && !Reader->IsError())
+	{
+		FIKSolveRecord& NewRecord = OutRecords[OutRecords.AddDefaulted()];
+		*Reader << NewRecord;
+	}
+
+	if (Reader->IsError())
+	{
+		// A recording that was not stopped cleanly may end with a partial record
+		OutRecords.Pop();
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("IK solve recording %s is truncated or corrupt; read %d records"),
+			*Filename, OutRecords.Num());
+#endif // ENABLE_IK_DEBUG
+	}
+
+	return true;
+}
+
+bool FIKSolveReplayer::ReplayOne(const FIKSolveRecord& Record, TArray<FTransform>& OutTransforms, FIKSolveStats& OutStats,
+	FVector* OutEffectorTarget)
+{
+	// Leg IK targets are derived again, as the node did, from what it derived them from
+	FVector EffectorTarget = Record.EffectorTargetLocation;
+	if (Record.bHasLegTarget)
+	{
+		FVector EffectorOffset = Record.LastEffectorOffset;
+		FVector FloorCS;
+		FAnimNode_HumanoidLegIK::ComputeFootTargetCS(Record.LegTargetInputs, Record.DeltaTime, EffectorOffset,
+			EffectorTarget, FloorCS);
+	}
+
+	if (OutEffectorTarget != nullptr)
+	{
+		*OutEffectorTarget = EffectorTarget;
+	}
+
+	// Recorded constraints never include custom ones, so there are no sources to point to
+	FIKCompiledConstraintTable Constraints;
+	Constraints.Constraints.Init(nullptr, Record.InTransforms.Num());
+	Constraints.Entries = Record.Constraints;
+	for (const FIKCompiledConstraint& Entry : Constraints.Entries)
+	{
+		Constraints.bHasActiveConstraints |= (Entry.Type != EIKCompiledConstraintType::IKCC_None);
+	}
+
+	switch (Record.Solver)
+	{
+	case EIKRecordedSolver::IKRS_ClosedLoop:
+		return FRangeLimitedFABRIK::SolveClosedLoopFABRIK(Record.InTransforms, Constraints,
+			EffectorTarget, OutTransforms, Record.MaxRootDragDistance, Record.RootDragStiffness,
+			Record.Precision, Record.MaxIterations, nullptr, Record.Relaxation, Record.StagnationRatio, &OutStats);
+
+	case EIKRecordedSolver::IKRS_FABRIK:
+	default:
+		return FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(Record.InTransforms, Constraints,
+			EffectorTarget, OutTransforms, Record.MaxRootDragDistance, Record.RootDragStiffness,
+			Record.Precision, Record.MaxIterations, Record.UnreachableRule, nullptr, Record.Relaxation,
+			Record.StagnationRatio, &OutStats);
+	}
+}
+
+void FIKSolveReplayer::Replay(const TArray<FIKSolveRecord>& Records, int32 Repeats, FIKReplaySummary& OutSummary)
+{
+	OutSummary = FIKReplaySummary();
+	OutSummary.NumRecords = Records.Num();
+
+	TArray<FTransform> OutTransforms;
+	FIKSolveStats Stats;
+	FVector EffectorTarget;
+
+	for (int32 Repeat = 0; Repeat < Repeats; ++Repeat)
+	{
+		for (const FIKSolveRecord& Record : Records)
+		{
+			double StartTime = FPlatformTime::Seconds();
+			ReplayOne(Record, OutTransforms, Stats, &EffectorTarget);
+			OutSummary.TotalSeconds += FPlatformTime::Seconds() - StartTime;
+			++OutSummary.NumSolves;
+
+			// Results are the same every repeat; compare them once
+			if (Repeat > 0)
+			{
+				continue;
+			}
+
+			OutSummary.RecordedIterations += Record.RecordedStats.Iterations;
+			OutSummary.ReplayedIterations += Stats.Iterations;
+			OutSummary.RecordedSlop       += Record.RecordedStats.FinalSlop;
+			OutSummary.ReplayedSlop       += Stats.FinalSlop;
+
+			if (FVector::Dist(EffectorTarget, Record.EffectorTargetLocation) > ReplayMismatchTolerance)
+			{
+				++OutSummary.NumTargetsMismatched;
+			}
+
+			if (Record.bHadCustomConstraints)
+			{
+				++OutSummary.NumApproximate;
+				continue;
+			}
+
+			float Deviation = 0.0f;
+			for (int32 PointIndex = 0; PointIndex < Record.RecordedLocations.Num(); ++PointIndex)
+			{
+				Deviation = FMath::Max(Deviation,
+					FVector::Dist(Record.RecordedLocations[PointIndex], OutTransforms[PointIndex].GetLocation()));
+			}
+
+			OutSummary.MaxDeviation = FMath::Max(OutSummary.MaxDeviation, Deviation);
+			if (Deviation > ReplayMismatchTolerance)
+			{
+				++OutSummary.NumMismatched;
+			}
+		}
+	}
+}
+
+void FIKSolveReplayer::LogSummary(const FIKReplaySummary& Summary)
+{
+	UE_LOG(LogRTIK, Display, TEXT("Replayed %d IK solves (%d records): %.0f ns per solve"),
+		Summary.NumSolves, Summary.NumRecords, Summary.GetNanosecondsPerSolve());
+	UE_LOG(LogRTIK, Display, TEXT("Iterations: %d recorded, %d replayed. Total final slop: %f recorded, %f replayed"),
+		Summary.RecordedIterations, Summary.ReplayedIterations, Summary.RecordedSlop, Summary.ReplayedSlop);
+	UE_LOG(LogRTIK, Display, TEXT("%d records mismatched (max deviation %f); %d had custom constraints and were not compared"),
+		Summary.NumMismatched, Summary.MaxDeviation, Summary.NumApproximate);
+	UE_LOG(LogRTIK, Display, TEXT("%d records derived a different target than was recorded"), Summary.NumTargetsMismatched);
+}
@@ -0,0 +1,412 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "RTIKRigAsset.h"
+#include "Engine/SkeletalMesh.h"
+#include "SkeletalMeshTypes.h"
+
+/*
+* Baked data layout. Everything is 4-byte aligned, and sizes don't depend on the platform:
+*
+*   FRigBlobHeader
+*   FRigBlobChain          x NumChains      (legs, then chains)
+*   int32                  x NumBones       mesh bone index of each bone of each chain
+*   float                  x NumBones       length from the previous bone; the first bone of a chain has 0
+*   FRigBlobConstraint     x NumConstraints
+*/
+namespace
+{
+	// Bump when the layout changes. Data with another version is ignored, and rebaked when the asset is next saved.
+	const uint32 RigBlobVersion = 1;
+
+	struct FRigBlobHeader
+	{
+		uint32 Version;
+		int32 NumChains;
+		int32 NumBones;
+		int32 NumConstraints;
+	};
+
+	struct FRigBlobChain
+	{
+		int32 FirstBone;
+		int32 NumBones;
+		int32 FirstConstraint;
+		int32 NumConstraints;
+		float TotalLength;
+		uint32 LODMask;
+		uint8 bValid;
+		uint8 bHasSharedConstraints;
+		uint8 Padding[2];
+	};
+
+	// FIKCompiledConstraint without the source pointer, which is only used by custom constraints
+	struct FRigBlobConstraint
+	{
+		uint8 Type;
+		uint8 Padding[3];
+		FVector RotationAxis;
+		FVector ForwardDirection;
+		FVector UpDirection;
+		FVector FailsafeDirection;
+		FVector MinDirection;
+		FVector MaxDirection;
+		float MinPseudoAngle;
+		float MaxPseudoAngle;
+	};
+
+	// What a chain's definition is built from
+	struct FRigChainSource
+	{
+		TArray<FName> BoneNames;
+		TArray<FIKBoneConstraint*> Constraints;
+		EIKChainDefinitionChecks Checks;
+	};
+
+	// Copies of the settings, so gathering can initialize their constraints. Legs first, then chains.
+	struct FRigSettingsCopy
+	{
+		TArray<FHumanoidLegChain> Legs;
+		TArray<FRangeLimitedIKChain> Chains;
+		TArray<FRigChainSource> Sources;
+
+		FRigSettingsCopy(const TArray<FRTIKRigLeg>& InLegs, const TArray<FRTIKRigChain>& InChains)
+		{
+			// Sources point at the copies' constraints, so the copies must not move
+			Legs.Reserve(InLegs.Num());
+			Chains.Reserve(InChains.Num());
+			Sources.SetNum(InLegs.Num() + InChains.Num());
+
+			for (int32 i = 0; i < InLegs.Num(); ++i)
+			{
+				FHumanoidLegChain& Leg = Legs[Legs.Add(InLegs[i].Chain)];
+				Leg.GatherDefinitionInputs(Sources[i].BoneNames, Sources[i].Constraints);
+				Sources[i].Checks = FHumanoidLegChain::GetDefinitionChecks();
+			}
+
+			for (int32 i = 0; i < InChains.Num(); ++i)
+			{
+				FRigChainSource& Source = Sources[InLegs.Num() + i];
+				FRangeLimitedIKChain& Chain = Chains[Chains.Add(InChains[i].Chain)];
+				Chain.GatherDefinitionInputs(Source.BoneNames, Source.Constraints);
+				Source.Checks = FRangeLimitedIKChain::GetDefinitionChecks();
+			}
+		}
+	};
+
+	template<typename T>
+	T* AppendToBlob(TArray<uint8>& Blob, int32 Num)
+	{
+		int32 Offset = Blob.AddZeroed(sizeof(T) * Num);
+		return reinterpret_cast<T*>(Blob.GetData() + Offset);
+	}
+
+	// Bit i is set if LOD i of Mesh has every bone in MeshBoneIndices. Bits past the last LOD are set, so a chain
+	// every LOD can use has every bit set.
+	uint32 BuildLODMask(const USkeletalMesh& Mesh, const TArray<int32>& MeshBoneIndices)
+	{
+		uint32 LODMask = MAX_uint32;
+
+#if WITH_EDITOR
+		const FSkeletalMeshResource* Resource = Mesh.GetImportedResource();
+		if (Resource == nullptr)
+		{
+			return LODMask;
+		}
+
+		for (int32 LODIndex = 0; LODIndex < FMath::Min(Resource->LODModels.Num(), 32); ++LODIndex)
+		{
+			const TArray<FBoneIndexType>& LODBones = Resource->LODModels[LODIndex].RequiredBones;
+			bool bHasAllBones = true;
+			for (int32 MeshBoneIndex : MeshBoneIndices)
+			{
+				bHasAllBones &= (MeshBoneIndex != INDEX_NONE && LODBones.Contains(static_cast<FBoneIndexType>(MeshBoneIndex)));
+			}
+
+			if (!bHasAllBones)
+			{
+				LODMask &= ~(1u << LODIndex);
+			}
+		}
+#endif // WITH_EDITOR
+
+		return LODMask;
+	}
+}
+
+const FHumanoidLegChain* URTIKRigAsset::FindLeg(FName Name, FIKChainDefinitionPtr& OutDefinition) const
+{
+	for (int32 i = 0; i < Legs.Num(); ++i)
+	{
+		if (Legs[i].Name == Name)
+		{
+			OutDefinition = IsBaked() ? BakedDefinitions[i] : nullptr;
+			return &Legs[i].Chain;
+		}
+	}
+
+	OutDefinition = nullptr;
+	return nullptr;
+}
+
+const FRangeLimitedIKChain* URTIKRigAsset::FindChain(FName Name, FIKChainDefinitionPtr& OutDefinition) const
+{
+	for (int32 i = 0; i < Chains.Num(); ++i)
+	{
+		if (Chains[i].Name == Name)
+		{
+			OutDefinition = IsBaked() ? BakedDefinitions[Legs.Num() + i] : nullptr;
+			return &Chains[i].Chain;
+		}
+	}
+
+	OutDefinition = nullptr;
+	return nullptr;
+}
+
+void URTIKRigAsset::Bake()
+{
+	BakedData.Reset();
+	BakedDefinitions.Reset();
+
+	if (Mesh == nullptr)
+	{
+		return;
+	}
+
+	FRigSettingsCopy Settings(Legs, Chains);
+	const int32 NumChains = Settings.Sources.Num();
+
+	TArray<FIKChainDefinitionPtr> Definitions;
+	Definitions.Reserve(NumChains);
+	int32 NumBones       = 0;
+	int32 NumConstraints = 0;
+	for (const FRigChainSource& Source : Settings.Sources)
+	{
+		Definitions.Add(FIKChainDefinitionCache::Build(Mesh, Mesh->RefSkeleton, Source.BoneNames,
+			Source.Constraints, Source.Checks));
+		NumBones += Source.BoneNames.Num();
+		NumConstraints += Source.Constraints.Num();
+	}
+
+	// Each append may reallocate, so pointers into the blob are only kept until the next one
+	FRigBlobHeader* Header = AppendToBlob<FRigBlobHeader>(BakedData, 1);
+	Header->Version        = RigBlobVersion;
+	Header->NumChains      = NumChains;
+	Header->NumBones       = NumBones;
+	Header->NumConstraints = NumConstraints;
+
+	FRigBlobChain* BlobChains = AppendToBlob<FRigBlobChain>(BakedData, NumChains);
+	int32 FirstBone       = 0;
+	int32 FirstConstraint = 0;
+	for (int32 i = 0; i < NumChains; ++i)
+	{
+		const FIKChainDefinition& Definition = *Definitions[i];
+		FRigBlobChain& BlobChain             = BlobChains[i];
+		BlobChain.FirstBone             = FirstBone;
+		BlobChain.NumBones              = Definition.MeshBoneIndices.Num();
+		BlobChain.FirstConstraint       = FirstConstraint;
+		BlobChain.NumConstraints        = Settings.Sources[i].Constraints.Num();
+		BlobChain.TotalLength           = Definition.TotalLength;
+		BlobChain.LODMask               = BuildLODMask(*Mesh, Definition.MeshBoneIndices);
+		BlobChain.bValid                = Definition.bValid ? 1 : 0;
+		BlobChain.bHasSharedConstraints = Definition.bHasSharedConstraints ? 1 : 0;
+
+		FirstBone += BlobChain.NumBones;
+		FirstConstraint += BlobChain.NumConstraints;
+
+#if ENABLE_IK_DEBUG
+		if (!Definition.bValid)
+		{
+			UE_LOG(LogRTIK, Warning, TEXT("RTIK rig %s: chain %d is not valid for mesh %s"),
+				*GetName(), i, *Mesh->GetName());
+		}
+		else if (BlobChain.LODMask != MAX_uint32)
+		{
+			UE_LOG(LogRTIK, Warning, TEXT("RTIK rig %s: chain %d is missing bones at some LODs of mesh %s (LOD mask 0x%x)"),
+				*GetName(), i, *Mesh->GetName(), BlobChain.LODMask);
+		}
+#endif // ENABLE_IK_DEBUG
+	}
+
+	int32* BlobBoneIndices = AppendToBlob<int32>(BakedData, NumBones);
+	for (const FIKChainDefinitionPtr& Definition : Definitions)
+	{
+		FMemory::Memcpy(BlobBoneIndices, Definition->MeshBoneIndices.GetData(), sizeof(int32) * Definition->MeshBoneIndices.Num());
+		BlobBoneIndices += Definition->MeshBoneIndices.Num();
+	}
+
+	float* BlobBoneLengths = AppendToBlob<float>(BakedData, NumBones);
+	for (const FIKChainDefinitionPtr& Definition : Definitions)
+	{
+		if (Definition->MeshBoneIndices.Num() > 0)
+		{
+			FMemory::Memcpy(BlobBoneLengths + 1, Definition->BoneLengths.GetData(), sizeof(float) * Definition->BoneLengths.Num());
+		}
+		BlobBoneLengths += Definition->MeshBoneIndices.Num();
+	}
+
+	// Shared constraints are compiled by the definition. Otherwise the chain has custom constraints, which it
+	// compiles itself, so only the entry types are kept.
+	FRigBlobConstraint* BlobConstraints = AppendToBlob<FRigBlobConstraint>(BakedData, NumConstraints);
+	for (int32 i = 0; i < NumChains; ++i)
+	{
+		TArray<FIKCompiledConstraint> Entries;
+		FIKCompiledConstraintTable::CompileEntries(Settings.Sources[i].Constraints, Entries);
+
+		for (const FIKCompiledConstraint& Entry : Entries)
+		{
+			FRigBlobConstraint& BlobConstraint = *BlobConstraints++;
+			BlobConstraint.Type = static_cast<uint8>(Entry.Type);
+			if (Entry.Type == EIKCompiledConstraintType::IKCC_Planar)
+			{
+				BlobConstraint.RotationAxis      = Entry.RotationAxis;
+				BlobConstraint.ForwardDirection  = Entry.ForwardDirection;
+				BlobConstraint.UpDirection       = Entry.UpDirection;
+				BlobConstraint.FailsafeDirection = Entry.FailsafeDirection;
+				BlobConstraint.MinDirection      = Entry.MinDirection;
+				BlobConstraint.MaxDirection      = Entry.MaxDirection;
+				BlobConstraint.MinPseudoAngle    = Entry.MinPseudoAngle;
+				BlobConstraint.MaxPseudoAngle    = Entry.MaxPseudoAngle;
+			}
+		}
+	}
+
+	UnpackBakedData();
+}
+
+bool URTIKRigAsset::IsBaked() const
+{
+	return BakedDefinitions.Num() > 0 && BakedDefinitions.Num() == Legs.Num() + Chains.Num();
+}
+
+void URTIKRigAsset::UnpackBakedData()
+{
+	BakedDefinitions.Reset();
+
+	if (Mesh == nullptr || BakedData.Num() < static_cast<int32>(sizeof(FRigBlobHeader)))
+	{
+		return;
+	}
+
+	const uint8* Blob            = BakedData.GetData();
+	const FRigBlobHeader& Header = *reinterpret_cast<const FRigBlobHeader*>(Blob);
+	FRigSettingsCopy Settings(Legs, Chains);
+
+	int64 ExpectedSize = sizeof(FRigBlobHeader) + sizeof(FRigBlobChain) * static_cast<int64>(Header.NumChains)
+		+ (sizeof(int32) + sizeof(float)) * static_cast<int64>(Header.NumBones)
+		+ sizeof(FRigBlobConstraint) * static_cast<int64>(Header.NumConstraints);
+
+	if (Header.Version != RigBlobVersion || Header.NumChains != Settings.Sources.Num() || ExpectedSize != BakedData.Num())
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("RTIK rig %s: baked data is out of date; chains will look bones up by name. Resave the asset to rebake it."),
+			*GetName());
+#endif // ENABLE_IK_DEBUG
+		return;
+	}
+
+	const FRigBlobChain* BlobChains            = reinterpret_cast<const FRigBlobChain*>(Blob + sizeof(FRigBlobHeader));
+	const int32* BlobBoneIndices               = reinterpret_cast<const int32*>(BlobChains + Header.NumChains);
+	const float* BlobBoneLengths               = reinterpret_cast<const float*>(BlobBoneIndices + Header.NumBones);
+	const FRigBlobConstraint* BlobConstraints  = reinterpret_cast<const FRigBlobConstraint*>(BlobBoneLengths + Header.NumBones);
+
+	TArray<FIKChainDefinitionPtr> Definitions;
+	Definitions.Reserve(Header.NumChains);
+	for (int32 i = 0; i < Header.NumChains; ++i)
+	{
+		const FRigBlobChain& BlobChain = BlobChains[i];
+		const FRigChainSource& Source  = Settings.Sources[i];
+
+		// Settings changed since the data was baked
+		if (BlobChain.NumBones != Source.BoneNames.Num() || BlobChain.NumConstraints != Source.Constraints.Num()
+			|| BlobChain.FirstBone + BlobChain.NumBones > Header.NumBones
+			|| BlobChain.FirstConstraint + BlobChain.NumConstraints > Header.NumConstraints)
+		{
+#if ENABLE_IK_DEBUG
+			UE_LOG(LogRTIK, Warning, TEXT("RTIK rig %s: baked data doesn't match chain %d; chains will look bones up by name. Resave the asset to rebake it."),
+				*GetName(), i);
+#endif // ENABLE_IK_DEBUG
+			return;
+		}
+
+		FIKChainDefinition* Definition = new FIKChainDefinition();
+		Definition->Asset                 = Mesh;
+		Definition->bBaked                = true;
+		Definition->BoneNames             = Source.BoneNames;
+		Definition->TotalLength           = BlobChain.TotalLength;
+		Definition->bValid                = BlobChain.bValid != 0;
+		Definition->bHasSharedConstraints = BlobChain.bHasSharedConstraints != 0;
+		Definition->LODMask               = BlobChain.LODMask;
+		Definition->MeshBoneIndices.Append(BlobBoneIndices + BlobChain.FirstBone, BlobChain.NumBones);
+		if (BlobChain.NumBones > 1)
+		{
+			Definition->BoneLengths.Append(BlobBoneLengths + BlobChain.FirstBone + 1, BlobChain.NumBones - 1);
+		}
+
+		if (Definition->bHasSharedConstraints)
+		{
+			FIKCompiledConstraintTable& Table = Definition->ConstraintTable;
+			Table.Entries.SetNum(BlobChain.NumConstraints);
+			Table.Constraints.Init(nullptr, BlobChain.NumConstraints);
+			for (int32 j = 0; j < BlobChain.NumConstraints; ++j)
+			{
+				const FRigBlobConstraint& BlobConstraint = BlobConstraints[BlobChain.FirstConstraint + j];
+				FIKCompiledConstraint& Entry             = Table.Entries[j];
+				Entry.Type              = static_cast<EIKCompiledConstraintType>(BlobConstraint.Type);
+				Entry.RotationAxis      = BlobConstraint.RotationAxis;
+				Entry.ForwardDirection  = BlobConstraint.ForwardDirection;
+				Entry.UpDirection       = BlobConstraint.UpDirection;
+				Entry.FailsafeDirection = BlobConstraint.FailsafeDirection;
+				Entry.MinDirection      = BlobConstraint.MinDirection;
+				Entry.MaxDirection      = BlobConstraint.MaxDirection;
+				Entry.MinPseudoAngle    = BlobConstraint.MinPseudoAngle;
+				Entry.MaxPseudoAngle    = BlobConstraint.MaxPseudoAngle;
+				Table.bHasActiveConstraints |= (Entry.Type != EIKCompiledConstraintType::IKCC_None);
+			}
+		}
+
+		Definitions.Add(FIKChainDefinitionPtr(Definition));
+	}
+
+	BakedDefinitions = MoveTemp(Definitions);
+}
+
+void URTIKRigAsset::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	// One bulk read on load
+	BakedData.BulkSerialize(Ar);
+}
+
+void URTIKRigAsset::PostLoad()
+{
+	Super::PostLoad();
+
+	if (Mesh != nullptr)
+	{
+		Mesh->ConditionalPostLoad();
+	}
+
+#if WITH_EDITOR
+	// The mesh may have been reimported since the asset was saved, so in the editor, don't trust the baked data
+	Bake();
+#else
+	UnpackBakedData();
+#endif // WITH_EDITOR
+}
+
+#if WITH_EDITOR
+void URTIKRigAsset::PreSave(const class ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+	Bake();
+}
+
+void URTIKRigAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	Bake();
+}
+#endif // WITH_EDITOR
@@ -0,0 +1,220 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "Misc/AutomationTest.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Animation/Skeleton.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "AnimNode_RangeLimitedFabrik.h"
+#include "AnimNode_HumanoidArmTorsoAdjust.h"
+#include "AnimNode_HumanoidLegIK.h"
+#include "RTIKAllocationCounter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// A proxy for an anim instance that is never ticked, with every bone of its mesh required
+	struct FRTIKTestAnimInstanceProxy : public FAnimInstanceProxy
+	{
+		FRTIKTestAnimInstanceProxy(UAnimInstance* Instance, USkeletalMesh& Mesh)
+			:
+			FAnimInstanceProxy(Instance)
+		{
+			InitializeObjects(Instance);
+
+			TArray<FBoneIndexType> RequiredBoneIndices;
+			for (int32 BoneIndex = 0; BoneIndex < Mesh.RefSkeleton.GetNum(); ++BoneIndex)
+			{
+				RequiredBoneIndices.Add(BoneIndex);
+			}
+			GetRequiredBones().InitializeTo(RequiredBoneIndices, FCurveEvaluationOption(false), Mesh);
+		}
+	};
+
+	// A minimal humanoid: spine up +Z, left arm along +Y, right arm along -Y, left leg down -Z
+	struct FRTIKTestCharacter
+	{
+		USkeleton* Skeleton;
+		USkeletalMesh* Mesh;
+		USkeletalMeshComponent* Component;
+		UAnimInstance* Instance;
+		TUniquePtr<FRTIKTestAnimInstanceProxy> Proxy;
+
+		FRTIKTestCharacter()
+		{
+			Skeleton  = NewObject<USkeleton>();
+			Mesh      = NewObject<USkeletalMesh>();
+			Component = NewObject<USkeletalMeshComponent>();
+
+			{
+				FReferenceSkeletonModifier Modifier(Mesh->RefSkeleton, nullptr);
+				auto AddBone = [&](const TCHAR* Name, const TCHAR* ParentName, const FVector& Offset)
+				{
+					int32 ParentIndex = ParentName == nullptr ? INDEX_NONE : Mesh->RefSkeleton.FindRawBoneIndex(ParentName);
+					Modifier.Add(FMeshBoneInfo(Name, Name, ParentIndex), FTransform(Offset));
+				};
+
+				AddBone(TEXT("root"), nullptr, FVector::ZeroVector);
+				AddBone(TEXT("pelvis"), TEXT("root"), FVector(0.0f, 0.0f, 100.0f));
+				AddBone(TEXT("spine_01"), TEXT("pelvis"), FVector(0.0f, 0.0f, 10.0f));
+				AddBone(TEXT("spine_02"), TEXT("spine_01"), FVector(0.0f, 0.0f, 15.0f));
+				AddBone(TEXT("spine_03"), TEXT("spine_02"), FVector(0.0f, 0.0f, 15.0f));
+				AddBone(TEXT("neck"), TEXT("spine_03"), FVector(0.0f, 0.0f, 15.0f));
+				AddBone(TEXT("head"), TEXT("neck"), FVector(0.0f, 0.0f, 10.0f));
+				AddBone(TEXT("clavicle_l"), TEXT("spine_03"), FVector(0.0f, 5.0f, 10.0f));
+				AddBone(TEXT("upperarm_l"), TEXT("clavicle_l"), FVector(0.0f, 15.0f, 0.0f));
+				AddBone(TEXT("lowerarm_l"), TEXT("upperarm_l"), FVector(0.0f, 30.0f, 0.0f));
+				AddBone(TEXT("hand_l"), TEXT("lowerarm_l"), FVector(0.0f, 25.0f, 0.0f));
+				AddBone(TEXT("clavicle_r"), TEXT("spine_03"), FVector(0.0f, -5.0f, 10.0f));
+				AddBone(TEXT("upperarm_r"), TEXT("clavicle_r"), FVector(0.0f, -15.0f, 0.0f));
+				AddBone(TEXT("lowerarm_r"), TEXT("upperarm_r"), FVector(0.0f, -30.0f, 0.0f));
+				AddBone(TEXT("hand_r"), TEXT("lowerarm_r"), FVector(0.0f, -25.0f, 0.0f));
+				AddBone(TEXT("thigh_l"), TEXT("pelvis"), FVector(0.0f, 10.0f, -5.0f));
+				AddBone(TEXT("calf_l"), TEXT("thigh_l"), FVector(0.0f, 0.0f, -45.0f));
+				AddBone(TEXT("foot_l"), TEXT("calf_l"), FVector(0.0f, 0.0f, -45.0f));
+				AddBone(TEXT("ball_l"), TEXT("foot_l"), FVector(15.0f, 0.0f, -5.0f));
+			}
+
+			Skeleton->MergeAllBonesToBoneTree(Mesh);
+			Mesh->Skeleton          = Skeleton;
+			Component->SkeletalMesh = Mesh;
+			Instance                = NewObject<UAnimInstance>(Component);
+
+			Skeleton->AddToRoot();
+			Mesh->AddToRoot();
+			Component->AddToRoot();
+			Instance->AddToRoot();
+
+			Proxy = MakeUnique<FRTIKTestAnimInstanceProxy>(Instance, *Mesh);
+		}
+
+		~FRTIKTestCharacter()
+		{
+			Proxy.Reset();
+			Instance->RemoveFromRoot();
+			Component->RemoveFromRoot();
+			Mesh->RemoveFromRoot();
+			Skeleton->RemoveFromRoot();
+		}
+
+		// Initializes Node, then evaluates it twice on the reference pose, the way the anim graph would. Returns
+		// the allocator calls made during the second evaluation. The pose itself is set up outside the count.
+		int32 CountSteadyStateAllocations(FAnimNode_SkeletalControlBase& Node)
+		{
+			Node.Initialize_AnyThread(FAnimationInitializeContext(Proxy.Get()));
+			Node.CacheBones_AnyThread(FAnimationCacheBonesContext(Proxy.Get()));
+
+			FMemMark Mark(FMemStack::Get());
+			FComponentSpacePoseContext Output(Proxy.Get());
+			TArray<FBoneTransform> BoneTransforms;
+			BoneTransforms.Reserve(Mesh->RefSkeleton.GetNum());
+
+			int32 NumAllocatorCalls = 0;
+			for (int32 Evaluation = 0; Evaluation < 2; ++Evaluation)
+			{
+				Output.ResetToRefPose();
+				BoneTransforms.Reset();
+
+				FRTIKAllocationCounterScope AllocationCounter;
+				if (Node.IsValidToEvaluate(Skeleton, Proxy->GetRequiredBones()))
+				{
+					Node.EvaluateSkeletalControl_AnyThread(Output, BoneTransforms);
+				}
+				NumAllocatorCalls = AllocationCounter.GetNumCalls();
+			}
+
+			return NumAllocatorCalls;
+		}
+	};
+
+	void AddBones(TArray<FIKBone>& Bones, std::initializer_list<const TCHAR*> Names)
+	{
+		for (const TCHAR* Name : Names)
+		{
+			FIKBone Bone;
+			Bone.BoneRef.BoneName = Name;
+			Bones.Add(Bone);
+		}
+	}
+}
+
+// The nodes the sample characters run every frame, as the anim graph runs them: each is initialized, then
+// evaluated twice. The first evaluation sizes the node's scratch arrays and warms the thread's FMemStack; the
+// second must not touch the heap. Stats collection should be off, since a stats capture buffers its own messages.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRTIKNodeAllocationTest, "RTIK.Nodes.NoSteadyStateAllocations",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FRTIKNodeAllocationTest::RunTest(const FString& Parameters)
+{
+	FRTIKTestCharacter Character;
+
+	// Spine to head, to a target off to the side, with every solver
+	for (ERangeLimitedFABRIKSolverMode SolverMode : {
+		ERangeLimitedFABRIKSolverMode::RLF_Auto,
+		ERangeLimitedFABRIKSolverMode::RLF_Normal,
+		ERangeLimitedFABRIKSolverMode::RLF_ClosedLoop,
+		ERangeLimitedFABRIKSolverMode::RLF_CoarseToFine,
+		ERangeLimitedFABRIKSolverMode::RLF_ParallelSegmented,
+		ERangeLimitedFABRIKSolverMode::RLF_DampedLeastSquares,
+		ERangeLimitedFABRIKSolverMode::RLF_Spline })
+	{
+		FAnimNode_RangeLimitedFabrik Node;
+		Node.IKChainHandle.Name = FName(*FString::Printf(TEXT("Spine%d"), static_cast<int32>(SolverMode)));
+		AddBones(Node.IKChainHandle.Chain.BonesRootToEffector,
+			{ TEXT("spine_01"), TEXT("spine_02"), TEXT("spine_03"), TEXT("neck"), TEXT("head") });
+		Node.EffectorTransformSpace = BCS_ComponentSpace;
+		Node.EffectorTransform      = FTransform(FVector(20.0f, 10.0f, 155.0f));
+		Node.SolverMode             = SolverMode;
+
+		TestEqual(FString::Printf(TEXT("Range limited FABRIK, solver mode %d: allocator calls"),
+			static_cast<int32>(SolverMode)), Character.CountSteadyStateAllocations(Node), 0);
+	}
+
+	// Both arms to targets in front of the chest, solved separately and as one tree, with the torso fit
+	for (EHumanoidArmTorsoArmSolver ArmSolver : {
+		EHumanoidArmTorsoArmSolver::IK_Human_ArmTorso_Solver_Independent,
+		EHumanoidArmTorsoArmSolver::IK_Human_ArmTorso_Solver_Tree })
+	{
+		FAnimNode_HumanoidArmTorsoAdjust Node;
+		FString Suffix = FString::FromInt(static_cast<int32>(ArmSolver));
+		Node.LeftArmHandle.Name  = FName(*(TEXT("LeftArm") + Suffix));
+		Node.RightArmHandle.Name = FName(*(TEXT("RightArm") + Suffix));
+		AddBones(Node.LeftArmHandle.Chain.BonesRootToEffector,
+			{ TEXT("upperarm_l"), TEXT("lowerarm_l"), TEXT("hand_l") });
+		AddBones(Node.RightArmHandle.Chain.BonesRootToEffector,
+			{ TEXT("upperarm_r"), TEXT("lowerarm_r"), TEXT("hand_r") });
+		Node.WaistBone.BoneRef.BoneName = TEXT("spine_01");
+		Node.Mode                       = EHumanoidArmTorsoIKMode::IK_Human_ArmTorso_BothArms;
+		Node.ArmSolver                  = ArmSolver;
+		Node.ClosedLoopMode             = EHumanoidArmTorsoClosedLoopMode::IK_Human_ArmTorso_ClosedLoop_RigidFit;
+		Node.LeftArmWorldTarget         = FTransform(FVector(40.0f, 20.0f, 140.0f));
+		Node.RightArmWorldTarget        = FTransform(FVector(40.0f, -20.0f, 140.0f));
+
+		TestEqual(FString::Printf(TEXT("Humanoid arm torso adjust, arm solver %s: allocator calls"), *Suffix),
+			Character.CountSteadyStateAllocations(Node), 0);
+	}
+
+	// A leg onto a raised world location, through its source and dest scratch arrays
+	{
+		FAnimNode_HumanoidLegIK Node;
+		Node.LegHandle.Name                             = TEXT("LeftLeg");
+		Node.LegHandle.Chain.HipBone.BoneRef.BoneName   = TEXT("thigh_l");
+		Node.LegHandle.Chain.ThighBone.BoneRef.BoneName = TEXT("calf_l");
+		Node.LegHandle.Chain.ShinBone.BoneRef.BoneName  = TEXT("foot_l");
+		Node.LegHandle.Chain.FootBone.BoneRef.BoneName  = TEXT("ball_l");
+		Node.TraceDataHandle.Name                       = TEXT("LeftLegTrace");
+		Node.Mode                                       = EHumanoidLegIKMode::IK_Human_Leg_WorldLocation;
+		Node.Solver                                     = EHumanoidLegIKSolver::IK_Human_Leg_Solver_FABRIK;
+		Node.bEffectorMovesInstantly                    = true;
+		Node.FootTargetWorld                            = FTransform(FVector(15.0f, 10.0f, 30.0f));
+
+		TestEqual(TEXT("Humanoid leg IK: allocator calls"), Character.CountSteadyStateAllocations(Node), 0);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,100 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "AnimNode_HumanoidLegIK.h"
+#include "IKSolveRecorder.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Leg IK records go through a recording and back, and replay derives the same foot target the node did: onto the
+// traced floor, and eased toward it over a frame, as well as onto a given target
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRTIKSolveReplayTest, "RTIK.Replay.DerivesLegTargets",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FRTIKSolveReplayTest::RunTest(const FString& Parameters)
+{
+	const float Tolerance = 0.001f;
+
+	// A leg standing at the origin, with the foot 10 units above the root
+	TArray<FTransform> LegTransforms;
+	LegTransforms.Add(FTransform(FVector(0.0f, 0.0f, 90.0f)));
+	LegTransforms.Add(FTransform(FVector(0.0f, 5.0f, 50.0f)));
+	LegTransforms.Add(FTransform(FVector(0.0f, 0.0f, 10.0f)));
+	FIKCompiledConstraintTable NoConstraints;
+
+	FHumanoidLegIKTargetInputs OnStep;
+	OnStep.bFromTrace          = true;
+	OnStep.FootCS              = LegTransforms[2].GetLocation();
+	OnStep.FootHeightAboveRoot = 10.0f;
+	OnStep.bFootHit            = true;
+	OnStep.bToeHit             = true;
+	OnStep.FootFloorCS         = FVector(0.0f, 0.0f, 8.0f);
+	OnStep.ToeFloorCS          = FVector(20.0f, 0.0f, 8.0f);
+
+	FHumanoidLegIKTargetInputs EasedOntoStep = OnStep;
+	EasedOntoStep.bEffectorMovesInstantly = false;
+	EasedOntoStep.EffectorVelocity        = 100.0f;
+
+	FHumanoidLegIKTargetInputs OntoTarget;
+	OntoTarget.FootCS       = LegTransforms[2].GetLocation();
+	OntoTarget.FootTargetCS = FVector(10.0f, 0.0f, 20.0f);
+
+	const FHumanoidLegIKTargetInputs* Cases[] = { &OnStep, &EasedOntoStep, &OntoTarget };
+	const TCHAR* CaseNames[]                  = { TEXT("on step"), TEXT("eased onto step"), TEXT("onto target") };
+	const FVector ExpectedTargets[]           = { FVector(0.0f, 0.0f, 18.0f), FVector(0.0f, 0.0f, 11.0f),
+		FVector(10.0f, 0.0f, 20.0f) };
+
+	const float DeltaTime = 0.01f;
+	const FVector LastEffectorOffset(0.0f, 0.0f, 0.0f);
+
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	for (const FHumanoidLegIKTargetInputs* Inputs : Cases)
+	{
+		FVector EffectorOffset = LastEffectorOffset;
+		FVector FootTargetCS;
+		FVector FloorCS;
+		FAnimNode_HumanoidLegIK::ComputeFootTargetCS(*Inputs, DeltaTime, EffectorOffset, FootTargetCS, FloorCS);
+
+		FIKSolveRecord Record;
+		Record.SetInputs(EIKRecordedSolver::IKRS_FABRIK, LegTransforms, NoConstraints, FootTargetCS, DeltaTime);
+		Record.SetLegTarget(*Inputs, LastEffectorOffset);
+		Writer << Record;
+	}
+
+	TArray<FIKSolveRecord> Records;
+	FMemoryReader Reader(Bytes);
+	while (!Reader.AtEnd() && !Reader.IsError())
+	{
+		FIKSolveRecord& Record = Records[Records.AddDefaulted()];
+		Reader << Record;
+	}
+
+	TestFalse(TEXT("Records read back"), Reader.IsError());
+	const int32 NumCases = ARRAY_COUNT(Cases);
+	TestEqual(TEXT("Number of records read back"), Records.Num(), NumCases);
+	if (Records.Num() != NumCases)
+	{
+		return false;
+	}
+
+	TArray<FTransform> OutTransforms;
+	FIKSolveStats Stats;
+	for (int32 CaseIndex = 0; CaseIndex < Records.Num(); ++CaseIndex)
+	{
+		FVector ReplayedTarget;
+		FIKSolveReplayer::ReplayOne(Records[CaseIndex], OutTransforms, Stats, &ReplayedTarget);
+
+		TestTrue(FString::Printf(TEXT("%s: target derived as expected"), CaseNames[CaseIndex]),
+			Records[CaseIndex].EffectorTargetLocation.Equals(ExpectedTargets[CaseIndex], Tolerance));
+		TestTrue(FString::Printf(TEXT("%s: replay derives the recorded target"), CaseNames[CaseIndex]),
+			ReplayedTarget.Equals(Records[CaseIndex].EffectorTargetLocation, Tolerance));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -1,100 +1,263 @@
-// Copyright (c) Henry Cooney 2017
-
-#include "rtik.h"
-#include "DebugDrawUtil.h"
-#include "AnimUtil.h"
-#include "Kismet/KismetSystemLibrary.h"
-#include "Components/SkeletalMeshComponent.h"
-#include "Async.h"
-
-void FDebugDrawUtil::DrawLine(UWorld* World, const FVector& Start, const FVector& Finish, const FLinearColor& Color, float Duration, float Thickness)
-{
-	AsyncTask(ENamedThreads::GameThread, [World, Start, Finish, Color, Duration, Thickness]() {
-		UKismetSystemLibrary::DrawDebugLine(Cast<UObject>(World), Start, Finish, Color, Duration, Thickness);
-	});
-}
-
-void FDebugDrawUtil::DrawSphere(UWorld* World, const FVector& Center, const FLinearColor& Color, float Radius, int32 Segments, float Duration, float Thickness)
-{ 
-	AsyncTask(ENamedThreads::GameThread, [World, Center, Radius, Segments, Color, Duration, Thickness]() {
-		UKismetSystemLibrary::DrawDebugSphere(Cast<UObject>(World), Center, Radius, Segments, Color, Duration, Thickness);
-	});
-}
-
-void FDebugDrawUtil::DrawString(UWorld* World, const FVector& Location, const FString& Text, AActor * BaseActor, const FColor& Color, float Duration)
-{
-	AsyncTask(ENamedThreads::GameThread, [World, Location, Text, BaseActor, Color, Duration]() {
-		UKismetSystemLibrary::DrawDebugString(Cast<UObject>(World), Location, Text, BaseActor, Color, Duration);
-	});
-}
-
-void FDebugDrawUtil::DrawPlane(UWorld* World, const FVector& PlaneBase, const FVector& PlaneNormal,
-	float Size, const FLinearColor& Color, bool bDrawNormal, float Duration)
-{
-	if (bDrawNormal)
-	{
-		DrawVector(World, PlaneBase, PlaneNormal, Color);
-	}
-
-	FPlane Plane(PlaneBase, PlaneNormal);
-	AsyncTask(ENamedThreads::GameThread, [World, Plane, PlaneBase, Size, Color, Duration]() {		
-		UKismetSystemLibrary::DrawDebugPlane(Cast<UObject>(World), Plane, PlaneBase, Size, Color, Duration);
-	});
-}
-
-void FDebugDrawUtil::DrawVector(UWorld * World, const FVector& Base, FVector Direction, const FLinearColor& Color, float Length, float Duration, float Thickness)
-{
-	if (!Direction.Normalize())
-	{
-		return;
-	}
-	Direction *= Length;
-	DrawLine(World, Base, Base + Direction, Color, Duration, Thickness);
-}
-
-void FDebugDrawUtil::DrawBone(UWorld* World, USkeletalMeshComponent& SkelComp, FCSPose<FCompactPose>& Pose,
-	const FCompactPoseBoneIndex& ChildBone, const FLinearColor& Color, float Duration, float Thickness)
-{
-
-	int32 ChildIndex = ChildBone.GetInt();
-	FName ChildName = SkelComp.GetBoneName(ChildIndex);
-	FName ParentName = SkelComp.GetParentBone(ChildName);
-
-	if (ParentName == NAME_None)
-	{
-		return;
-	}
-
-	int32 ParentIndex = SkelComp.GetBoneIndex(ParentName);
-	FCompactPoseBoneIndex ParentBone(ParentIndex);
-
-	FVector ChildLocation = FAnimUtil::GetBoneWorldLocation(SkelComp, Pose, ChildBone);
-	FVector ParentLocation = FAnimUtil::GetBoneWorldLocation(SkelComp, Pose, ParentBone);
-
-	DrawLine(World, ParentLocation, ChildLocation, Color, Duration, Thickness);
-}
-
-void FDebugDrawUtil::DrawBoneChain(UWorld* World, USkeletalMeshComponent& SkelComp, FCSPose<FCompactPose>& Pose,
-	const FCompactPoseBoneIndex& ChainStartChild, const FCompactPoseBoneIndex& ChainEndParent,
-	const FLinearColor& Color, float Duration, float Thickness)
-{
-	int32 ParentIndex = ChainEndParent.GetInt();
-	int32 ChildIndex = ChainStartChild.GetInt();
-
-	const FName ChildName = SkelComp.GetBoneName(ChildIndex);
-	const FName ParentName = SkelComp.GetBoneName(ParentIndex);
-
-	if (!SkelComp.BoneIsChildOf(ChildName, ParentName))
-	{
-		return;
-	}
-
-	FName CurrChild = ChildName;
-
-	while (CurrChild != ParentName && CurrChild != NAME_None) 
-	{
-		FCompactPoseBoneIndex CurrBone(SkelComp.GetBoneIndex(CurrChild));
-		DrawBone(World, SkelComp, Pose, CurrBone, Color, Duration, Thickness);
-		CurrChild = SkelComp.GetParentBone(CurrChild);
-	}
-}
+// Copyright (c) Henry Cooney 2017
+
+#include "rtik.h"
+#include "DebugDrawUtil.h"
+#include "AnimUtil.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Containers/Queue.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+
+namespace
+{
+	enum class EDebugDrawCommandType : uint8
+	{
+		Line,
+		Sphere,
+		String,
+		ValueString,
+		Plane
+	};
+
+	// One queued primitive. Fields not used by a type are left at their defaults.
+	struct FDebugDrawCommand
+	{
+		EDebugDrawCommandType Type;
+		TWeakObjectPtr<UWorld> World;
+		FVector Start;
+		FVector Finish;
+		FLinearColor Color;
+		float Duration;
+		float Thickness;
+		float Size;
+		int32 Segments;
+		FPlane Plane;
+		TWeakObjectPtr<AActor> BaseActor;
+		FString Text;
+		const TCHAR* Format;
+		float Values[2];
+
+		FDebugDrawCommand(EDebugDrawCommandType InType, UWorld* InWorld)
+			:
+			Type(InType),
+			World(InWorld),
+			Start(FVector::ZeroVector),
+			Finish(FVector::ZeroVector),
+			Color(FLinearColor::White),
+			Duration(-1.0f),
+			Thickness(1.0f),
+			Size(0.0f),
+			Segments(0),
+			Plane(ForceInitToZero),
+			Format(nullptr)
+		{
+			Values[0] = 0.0f;
+			Values[1] = 0.0f;
+		}
+	};
+
+	// Lock-free for any number of producing threads; only the game thread consumes
+	TQueue<FDebugDrawCommand, EQueueMode::Mpsc> PendingCommands;
+
+	FDelegateHandle PostActorTickHandle;
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+	{
+		FDebugDrawUtil::FlushDeferredDrawing();
+	}
+}
+
+void FDebugDrawUtil::DrawLine(UWorld* World, const FVector& Start, const FVector& Finish, const FLinearColor& Color, float Duration, float Thickness)
+{
+	FDebugDrawCommand Command(EDebugDrawCommandType::Line, World);
+	Command.Start     = Start;
+	Command.Finish    = Finish;
+	Command.Color     = Color;
+	Command.Duration  = Duration;
+	Command.Thickness = Thickness;
+	PendingCommands.Enqueue(MoveTemp(Command));
+}
+
+void FDebugDrawUtil::DrawSphere(UWorld* World, const FVector& Center, const FLinearColor& Color, float Radius, int32 Segments, float Duration, float Thickness)
+{ 
+	FDebugDrawCommand Command(EDebugDrawCommandType::Sphere, World);
+	Command.Start     = Center;
+	Command.Color     = Color;
+	Command.Size      = Radius;
+	Command.Segments  = Segments;
+	Command.Duration  = Duration;
+	Command.Thickness = Thickness;
+	PendingCommands.Enqueue(MoveTemp(Command));
+}
+
+void FDebugDrawUtil::DrawString(UWorld* World, const FVector& Location, const FString& Text, AActor * BaseActor, const FColor& Color, float Duration)
+{
+	FDebugDrawCommand Command(EDebugDrawCommandType::String, World);
+	Command.Start     = Location;
+	Command.Text      = Text;
+	Command.BaseActor = BaseActor;
+	Command.Color     = Color;
+	Command.Duration  = Duration;
+	PendingCommands.Enqueue(MoveTemp(Command));
+}
+
+void FDebugDrawUtil::DrawValueString(UWorld* World, const FVector& Location, const TCHAR* Format, float Value,
+	AActor* BaseActor, const FColor& Color, float Duration, float SecondValue)
+{
+	FDebugDrawCommand Command(EDebugDrawCommandType::ValueString, World);
+	Command.Start     = Location;
+	Command.Format    = Format;
+	Command.Values[0] = Value;
+	Command.Values[1] = SecondValue;
+	Command.BaseActor = BaseActor;
+	Command.Color     = Color;
+	Command.Duration  = Duration;
+	PendingCommands.Enqueue(MoveTemp(Command));
+}
+
+void FDebugDrawUtil::DrawPlane(UWorld* World, const FVector& PlaneBase, const FVector& PlaneNormal,
+	float Size, const FLinearColor& Color, bool bDrawNormal, float Duration)
+{
+	if (bDrawNormal)
+	{
+		DrawVector(World, PlaneBase, PlaneNormal, Color);
+	}
+
+	FDebugDrawCommand Command(EDebugDrawCommandType::Plane, World);
+	Command.Plane    = FPlane(PlaneBase, PlaneNormal);
+	Command.Start    = PlaneBase;
+	Command.Size     = Size;
+	Command.Color    = Color;
+	Command.Duration = Duration;
+	PendingCommands.Enqueue(MoveTemp(Command));
+}
+
+void FDebugDrawUtil::StartupDeferredDrawing()
+{
+	if (!PostActorTickHandle.IsValid())
+	{
+		PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddStatic(&OnWorldPostActorTick);
+	}
+}
+
+void FDebugDrawUtil::ShutdownDeferredDrawing()
+{
+	if (PostActorTickHandle.IsValid())
+	{
+		FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+		PostActorTickHandle.Reset();
+	}
+
+	PendingCommands.Empty();
+}
+
+void FDebugDrawUtil::FlushDeferredDrawing()
+{
+	check(IsInGameThread());
+
+	FDebugDrawCommand Command(EDebugDrawCommandType::Line, nullptr);
+	while (PendingCommands.Dequeue(Command))
+	{
+		UWorld* World = Command.World.Get();
+		if (World == nullptr)
+		{
+			continue;
+		}
+
+		switch (Command.Type)
+		{
+		case EDebugDrawCommandType::Line:
+			UKismetSystemLibrary::DrawDebugLine(World, Command.Start, Command.Finish, Command.Color,
+				Command.Duration, Command.Thickness);
+			break;
+		case EDebugDrawCommandType::Sphere:
+			UKismetSystemLibrary::DrawDebugSphere(World, Command.Start, Command.Size, Command.Segments, Command.Color,
+				Command.Duration, Command.Thickness);
+			break;
+		case EDebugDrawCommandType::String:
+			UKismetSystemLibrary::DrawDebugString(World, Command.Start, Command.Text, Command.BaseActor.Get(),
+				Command.Color, Command.Duration);
+			break;
+		case EDebugDrawCommandType::ValueString:
+			UKismetSystemLibrary::DrawDebugString(World, Command.Start,
+				FString::Printf(Command.Format, Command.Values[0], Command.Values[1]), Command.BaseActor.Get(),
+				Command.Color, Command.Duration);
+			break;
+		case EDebugDrawCommandType::Plane:
+			UKismetSystemLibrary::DrawDebugPlane(World, Command.Plane, Command.Start, Command.Size, Command.Color,
+				Command.Duration);
+			break;
+		}
+	}
+}
+
+void FDebugDrawUtil::DrawVector(UWorld * World, const FVector& Base, FVector Direction, const FLinearColor& Color, float Length, float Duration, float Thickness)
+{
+	if (!Direction.Normalize())
+	{
+		return;
+	}
+	Direction *= Length;
+	DrawLine(World, Base, Base + Direction, Color, Duration, Thickness);
+}
+
+void FDebugDrawUtil::DrawBone(UWorld* World, USkeletalMeshComponent& SkelComp, FCSPose<FCompactPose>& Pose,
+	const FCompactPoseBoneIndex& ChildBone, const FLinearColor& Color, float Duration, float Thickness)
+{
+
+	int32 ChildIndex = ChildBone.GetInt();
+	FName ChildName = SkelComp.GetBoneName(ChildIndex);
+	FName ParentName = SkelComp.GetParentBone(ChildName);
+
+	if (ParentName == NAME_None)
+	{
+		return;
+	}
+
+	int32 ParentIndex = SkelComp.GetBoneIndex(ParentName);
+	FCompactPoseBoneIndex ParentBone(ParentIndex);
+
+	FVector ChildLocation = FAnimUtil::GetBoneWorldLocation(SkelComp, Pose, ChildBone);
+	FVector ParentLocation = FAnimUtil::GetBoneWorldLocation(SkelComp, Pose, ParentBone);
+
+	DrawLine(World, ParentLocation, ChildLocation, Color, Duration, Thickness);
+}
+
+void FDebugDrawUtil::DrawBoneChain(UWorld* World, USkeletalMeshComponent& SkelComp, FCSPose<FCompactPose>& Pose,
+	const FCompactPoseBoneIndex& ChainStartChild, const FCompactPoseBoneIndex& ChainEndParent,
+	const FLinearColor& Color, float Duration, float Thickness)
+{
+	int32 ParentIndex = ChainEndParent.GetInt();
+	int32 ChildIndex = ChainStartChild.GetInt();
+
+	const FName ChildName = SkelComp.GetBoneName(ChildIndex);
+	const FName ParentName = SkelComp.GetBoneName(ParentIndex);
+
+	if (!SkelComp.BoneIsChildOf(ChildName, ParentName))
+	{
+		return;
+	}
+
+	FName CurrChild = ChildName;
+
+	while (CurrChild != ParentName && CurrChild != NAME_None) 
+	{
+		FCompactPoseBoneIndex CurrBone(SkelComp.GetBoneIndex(CurrChild));
+		DrawBone(World, SkelComp, Pose, CurrBone, Color, Duration, Thickness);
+		CurrChild = SkelComp.GetParentBone(CurrChild);
+	}
+}
+
+void FIKCharacterDebugDrawer::DrawVector(const FVector& Base, const FVector& Direction, const FLinearColor& Color)
+{
+	FMatrix ToWorld = Character->GetMesh()->GetComponentToWorld().ToMatrixNoScale();
+	FDebugDrawUtil::DrawVector(Character->GetWorld(), ToWorld.TransformPosition(Base), ToWorld.TransformVector(Direction),
+		Color);
+}
+
+void FIKCharacterDebugDrawer::DrawValueString(const FVector& Offset, const TCHAR* Format, float Value, float SecondValue,
+	const FColor& Color)
+{
+	FDebugDrawUtil::DrawValueString(Character->GetWorld(), Offset, Format, Value, Character, Color, 0.0f, SecondValue);
+}
@@ -0,0 +1,36 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "RTIKBenchCommandlet.generated.h"
+
+/*
+* Headless solver microbenchmarks. Needs no world or renderer; run with
+*
+*   UE4Editor-Cmd <Project> -run=RTIKBench -nullrhi [-output=File.json] [-repeats=N] [-seed=N] [-replay=Recording]
+*
+* Times the chain solvers (SolveRangeLimitedFABRIK, SolveClosedLoopFABRIK, SolveCoarseToFineFABRIK, 
+* SolveParallelSegmentedFABRIK, SolveDampedLeastSquares and SolveSplineIK) over generated chains of 2 to 128 points,
+* at several constraint densities, with reachable and unreachable targets; how many iterations FABRIK and DLS each
+* need to reach several precisions; SolveNoisyThreePoint; and the compiled and virtual constraint enforcement paths.
+* Chains and targets come from a seeded random stream, so runs are repeatable.
+*
+* Results are written as JSON (by default to Saved/RTIK/Bench.json): nanoseconds per solve, mean iterations (for
+* solvers that report them), and how far the effector ended up from the target. If -replay is given, a recording made with rtik.Record.Start is
+* replayed as well (see FIKSolveReplayer).
+*/
+UCLASS()
+class URTIKBenchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	URTIKBenchCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+	// End UCommandlet interface
+};
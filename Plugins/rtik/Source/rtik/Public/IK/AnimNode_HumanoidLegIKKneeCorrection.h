@@ -1,62 +1,69 @@
-// Copyright (c) Henry Cooney 2017
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "HumanoidIK.h"
-#include "BoneControllers/AnimNode_SkeletalControlBase.h"
-#include "AnimNode_HumanoidLegIKKneeCorrection.generated.h"
-
-
-/*
-* Corrects rotation of the knee after IK. The IK solver will often leave the knee in a bad position; rotating inward or even
-* folding backward. This node returns the knee to the proper angle, without moving the end effector. You should usually have it 
-* as a post-processing step after IK.
-*
-* The corrected knee angle is determined by comparing the direction of the foot and knee in the
-* original animation. Therefore, the corrected angle should blend seamlessly with the original
-* animation, without creating an awkward or stiff look.
-*/
-USTRUCT()
-struct RTIK_API FAnimNode_HumanoidLegIKKneeCorrection : public FAnimNode_SkeletalControlBase
-{
-
-	GENERATED_USTRUCT_BODY()
-
-public:
-
-	// Pose before any IK or IK pre-processing (e.g., pelvis adjustment) is applied
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Links)
-	FComponentSpacePoseLink BaseComponentPose;
-
-	// The leg on which IK is applied
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bones, meta = (PinShownByDefault))
-	UHumanoidLegChain_Wrapper* Leg;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
-	bool bEnableDebugDraw;
-
-public:
-
-	FAnimNode_HumanoidLegIKKneeCorrection()
-		:
-		bEnableDebugDraw(false),
-		DeltaTime(0.0f)
-	{ }
-
-	// FAnimNode_SkeletalControlBase Interface
-	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
-	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
-
-
-	virtual void UpdateInternal(const FAnimationUpdateContext& Context) override;
-	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
-	//virtual void EvaluateComponentSpaceInternal(FComponentSpacePoseContext& Output) override;
-	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
-	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
-	// End FAnimNode_SkeletalControlBase Interface
-
-protected:
-	float DeltaTime;
-
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HumanoidIK.h"
+#include "IKInstanceState.h"
+#include "BoneControllers/AnimNode_SkeletalControlBase.h"
+#include "AnimNode_HumanoidLegIKKneeCorrection.generated.h"
+
+
+/*
+* Corrects rotation of the knee after IK. The IK solver will often leave the knee in a bad position; rotating inward or even
+* folding backward. This node returns the knee to the proper angle, without moving the end effector. You should usually have it 
+* as a post-processing step after IK.
+*
+* The corrected knee angle is determined by comparing the direction of the foot and knee in the
+* original animation. Therefore, the corrected angle should blend seamlessly with the original
+* animation, without creating an awkward or stiff look.
+*/
+USTRUCT()
+struct RTIK_API FAnimNode_HumanoidLegIKKneeCorrection : public FAnimNode_SkeletalControlBase
+{
+
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	// Pose before any IK or IK pre-processing (e.g., pelvis adjustment) is applied
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Links)
+	FComponentSpacePoseLink BaseComponentPose;
+
+	// The leg on which IK is applied
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bones, meta = (PinShownByDefault))
+	FHumanoidLegChainHandle LegHandle;
+
+	// Wrapper object input, for older graphs. Used instead of the handle if set.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bones, meta = (PinHiddenByDefault))
+	UHumanoidLegChain_Wrapper* Leg;
+		
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	bool bEnableDebugDraw;
+
+public:
+
+	FAnimNode_HumanoidLegIKKneeCorrection()
+		:
+		bEnableDebugDraw(false),
+		DeltaTime(0.0f)
+	{ }
+
+	// FAnimNode_SkeletalControlBase Interface
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void CacheBones_AnyThread(const FAnimationCacheBonesContext& Context) override;
+
+
+	virtual void UpdateInternal(const FAnimationUpdateContext& Context) override;
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+	//virtual void EvaluateComponentSpaceInternal(FComponentSpacePoseContext& Output) override;
+	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
+	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
+	// End FAnimNode_SkeletalControlBase Interface
+
+protected:
+	float DeltaTime;
+
+	// Holds the slots the handles name
+	FIKInstanceStatePtr InstanceState;
 };
\ No newline at end of file
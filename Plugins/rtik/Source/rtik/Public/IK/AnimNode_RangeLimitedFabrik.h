@@ -1,120 +1,218 @@
-// Copyright(c) Henry Cooney 2017
-
-#pragma once
-
-#include "CoreMinimal.h"
-#include "IK/IK.h"
-#include "BoneControllers/AnimNode_SkeletalControlBase.h"
-#include "AnimNode_RangeLimitedFabrik.generated.h"
-
-
-/*
-	Range-limited FABRIK solver. Based on UE4 FABRIK solver (see AnimNode_Fabrik.h), but will
-	additionally enforce range-of-motion constraints.
-
-	See IK.h for a description of ROM constraints.
-	
-	See RangeLimitedFABRIK.h for more detailed description of the FABRIK algorithm(s) as implemented here.
-*/
-
-/*
-* Which solver method to use
-*/
-UENUM(BlueprintType)
-enum class ERangeLimitedFABRIKSolverMode : uint8
-{	
-	// Standard FABRIK chain solver	
-	RLF_Normal UMETA(DisplayName = "Normal Chain solver"),
-
-	// Closed loop solver, assumes root and effector are connected	
-	RLF_ClosedLoop UMETA(DisplayName = "Closed Loop")
-};
-
-USTRUCT()
-struct RTIK_API FAnimNode_RangeLimitedFabrik : public FAnimNode_SkeletalControlBase
-{
-	GENERATED_USTRUCT_BODY()
-
-
-	FAnimNode_RangeLimitedFabrik()
-		: 
-		EffectorTransform(FTransform::Identity),
-		EffectorTransformSpace(BCS_ComponentSpace),
-		EffectorRotationSource(BRS_KeepLocalSpaceRotation),
-		SolverMode(ERangeLimitedFABRIKSolverMode::RLF_Normal),
-		Precision(1.f),
-		MaxIterations(10),
-		MaxRootDragDistance(0.0f),
-		RootDragStiffness(1.0f),
-		bEnableDebugDraw(false)
-	{ }
-
-	
-
-	// Coordinates for target location of tip bone - if EffectorLocationSpace is bone, this is the offset from Target Bone to use as target location
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = EndEffector, meta = (PinShownByDefault))
-	FTransform EffectorTransform;
-
-	// Reference frame of Effector Transform. 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = EndEffector)
-	TEnumAsByte<enum EBoneControlSpace> EffectorTransformSpace;
-
-	// If EffectorTransformSpace is a bone, this is the bone to use. *
-	UPROPERTY(EditAnywhere, Category = EndEffector)
-	FBoneReference EffectorTransformBone;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bones, meta = (PinShownByDefault))
-	URangeLimitedIKChainWrapper* IKChain;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = EndEffector)
-	TEnumAsByte<enum EBoneRotationSource> EffectorRotationSource;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (PinShownByDefault))
-	ERangeLimitedFABRIKSolverMode SolverMode;
-
-	// Tolerance for final tip location delta from EffectorLocation
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver)
-	float Precision;
-
-	// Maximum number of iterations allowed, to control performance. 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver)
-	int32 MaxIterations;
-
-	// How far IK may 'drag' the root from its starting position. If set to 0 (or lower), the root remains fixed.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver)
-	float MaxRootDragDistance;
-
-	// Divides the root displacement before clamping. Set to 1.0f for default stiffness. Higher stiffness will make the 
-	// root displace less; lower stiffness will make it displace more. Use a value less than 1.0f at your own risk.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (UIMin = 0.0f))
-	float RootDragStiffness;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
-	bool bEnableDebugDraw;
-
-public:
-
-	// FAnimNode_Base interface
-	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
-	// End of FAnimNode_Base interface
-
-	// FAnimNode_SkeletalControlBase interface
-	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
-	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
-	// End of FAnimNode_SkeletalControlBase interface
-
-
-protected:
-	// FAnimNode_SkeletalControlBase interface
-	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
-	// End of FAnimNode_SkeletalControlBase interface
-
-	// Update rotation of parent bone to reflect new position of the child. 
-	void UpdateParentRotation(FTransform& ParentTransform, const FIKBone& ParentBone,
-		FTransform& ChildTransform, const FIKBone& ChildBone, FCSPose<FCompactPose>& Pose) const;
-
-#if WITH_EDITOR
-	// Cached CS location when in editor for debug drawing
-	FTransform CachedEffectorCSTransform;
-#endif
-};
+// Copyright(c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IK/IK.h"
+#include "IK/IKInstanceState.h"
+#include "BoneControllers/AnimNode_SkeletalControlBase.h"
+#include "AnimNode_RangeLimitedFabrik.generated.h"
+
+
+/*
+	Range-limited FABRIK solver. Based on UE4 FABRIK solver (see AnimNode_Fabrik.h), but will
+	additionally enforce range-of-motion constraints.
+
+	See IK.h for a description of ROM constraints.
+	
+	See RangeLimitedFABRIK.h for more detailed description of the FABRIK algorithm(s) as implemented here.
+*/
+
+/*
+* Which solver method to use
+*/
+UENUM(BlueprintType)
+enum class ERangeLimitedFABRIKSolverMode : uint8
+{	
+	// Standard FABRIK chain solver	
+	RLF_Normal UMETA(DisplayName = "Normal Chain solver"),
+
+	// Closed loop solver, assumes root and effector are connected	
+	RLF_ClosedLoop UMETA(DisplayName = "Closed Loop"),
+
+	// Solves 2-bone chains, and 3-bone chains with a fixed first bone, analytically when their constraints allow it.
+	// Otherwise (and whenever the root may drag), same as the normal chain solver. See AnalyticIK.h.
+	RLF_Auto UMETA(DisplayName = "Auto (analytic when possible)"),
+
+	// For long chains (tails, tentacles, ropes): solves a chain of every Nth point first, then refines each segment
+	// in between. See FRangeLimitedFABRIK::SolveCoarseToFineFABRIK.
+	RLF_CoarseToFine UMETA(DisplayName = "Coarse to Fine (long chains)"),
+
+	// For very long chains (hundreds of bones): solves segments of the chain on worker threads, joining them up
+	// between sweeps. See FRangeLimitedFABRIK::SolveParallelSegmentedFABRIK.
+	RLF_ParallelSegmented UMETA(DisplayName = "Parallel Segmented (very long chains)"),
+
+	// Jacobian (damped least squares) solver. Converges in fewer iterations than FABRIK on heavily constrained
+	// chains, such as spines. The root does not drag. See FRangeLimitedFABRIK::SolveDampedLeastSquares.
+	RLF_DampedLeastSquares UMETA(DisplayName = "Damped Least Squares (constrained chains)"),
+
+	// For spines and tails: bends the chain along a smooth curve, fitted to the chain's length, to the target.
+	// Constraints are not enforced. See FRangeLimitedFABRIK::SolveSplineIK.
+	RLF_Spline UMETA(DisplayName = "Spline")
+};
+
+USTRUCT()
+struct RTIK_API FAnimNode_RangeLimitedFabrik : public FAnimNode_SkeletalControlBase
+{
+	GENERATED_USTRUCT_BODY()
+
+
+	FAnimNode_RangeLimitedFabrik()
+		: 
+		EffectorTransform(FTransform::Identity),
+		EffectorTransformSpace(BCS_ComponentSpace),
+		EffectorRotationSource(BRS_KeepLocalSpaceRotation),
+		SolverMode(ERangeLimitedFABRIKSolverMode::RLF_Normal),
+		Precision(1.f),
+		MaxIterations(10),
+		MaxRootDragDistance(0.0f),
+		RootDragStiffness(1.0f),
+		UnreachableRule(EIKUnreachableRule::IK_Reach),
+		Relaxation(1.0f),
+		StagnationRatio(0.0f),
+		bAdaptiveIterations(false),
+		bAllowIterationsBeyondMax(false),
+		CoarseSegmentLength(8),
+		FineIterations(3),
+		Damping(1.0f),
+		bEnableDebugDraw(false)
+	{ }
+
+	
+
+	// Coordinates for target location of tip bone - if EffectorLocationSpace is bone, this is the offset from Target Bone to use as target location
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = EndEffector, meta = (PinShownByDefault))
+	FTransform EffectorTransform;
+
+	// Reference frame of Effector Transform. 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = EndEffector)
+	TEnumAsByte<enum EBoneControlSpace> EffectorTransformSpace;
+
+	// If EffectorTransformSpace is a bone, this is the bone to use. *
+	UPROPERTY(EditAnywhere, Category = EndEffector)
+	FBoneReference EffectorTransformBone;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bones, meta = (PinShownByDefault))
+	FRangeLimitedIKChainHandle IKChainHandle;
+
+	// Wrapper object input, for older graphs. Used instead of the handle if set.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bones, meta = (PinHiddenByDefault))
+	URangeLimitedIKChainWrapper* IKChain;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = EndEffector)
+	TEnumAsByte<enum EBoneRotationSource> EffectorRotationSource;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (PinShownByDefault))
+	ERangeLimitedFABRIKSolverMode SolverMode;
+
+	// Tolerance for final tip location delta from EffectorLocation
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver)
+	float Precision;
+
+	// Maximum number of iterations allowed, to control performance. 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver)
+	int32 MaxIterations;
+
+	// How far IK may 'drag' the root from its starting position. If set to 0 (or lower), the root remains fixed.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver)
+	float MaxRootDragDistance;
+
+	// Divides the root displacement before clamping. Set to 1.0f for default stiffness. Higher stiffness will make the 
+	// root displace less; lower stiffness will make it displace more. Use a value less than 1.0f at your own risk.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (UIMin = 0.0f))
+	float RootDragStiffness;
+
+	// What to do if the effector target is out of reach. Out-of-reach targets are solved directly, without iterating,
+	// unless the chain has constraints. Not used by the closed-loop solver.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver)
+	EIKUnreachableRule UnreachableRule;
+
+	// Normal and Closed Loop only: over-relaxation. 1.0 is plain FABRIK; a little above 1 (1.2 - 1.5) often 
+	// converges in fewer iterations, but too high will overshoot and jitter. Tune per chain.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (UIMin = 1.0f, UIMax = 1.9f))
+	float Relaxation;
+
+	// Normal and Closed Loop only: stop iterating once several iterations in a row each improve the distance to the
+	// target by less than this fraction (e.g., 0.01), rather than spending the rest of Max Iterations making no
+	// progress, as when constraints keep the target out of reach. 0 (the default) always runs until Precision or
+	// Max Iterations is reached.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (UIMin = 0.0f, UIMax = 0.5f))
+	float StagnationRatio;
+
+	// If true, iterations are limited to what this chain has recently needed, which is often far fewer than Max
+	// Iterations. See FIKAdaptiveIterations.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver)
+	bool bAdaptiveIterations;
+
+	// Adaptive iterations only: if true, a chain that keeps running out of iterations may get more than Max
+	// Iterations, up to rtik.MaxIterationsCeiling. If false, Max Iterations is never exceeded.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (EditCondition = "bAdaptiveIterations"))
+	bool bAllowIterationsBeyondMax;
+
+	// Coarse to Fine and Parallel Segmented only: number of bones in each segment. Chains shorter than about two 
+	// segments use the normal chain solver.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (UIMin = 2))
+	int32 CoarseSegmentLength;
+
+	// Coarse to Fine and Parallel Segmented only: maximum iterations used to refine each segment (per sweep, for
+	// Parallel Segmented)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (UIMin = 1))
+	int32 FineIterations;
+
+	// Damped Least Squares only: higher values are more stable near a fully stretched chain, but converge more slowly.
+	// In the same units as bone lengths.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (UIMin = 0.0f))
+	float Damping;
+
+	// Spline only: points, in component space, that the curve bows toward; the first as it leaves the root, the last
+	// as it reaches the effector target. Without any, it bows the way the first bone points.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Solver, meta = (PinHiddenByDefault))
+	TArray<FVector> SplineControlPoints;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	bool bEnableDebugDraw;
+
+public:
+
+	// FAnimNode_Base interface
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+	// End of FAnimNode_Base interface
+
+	// FAnimNode_SkeletalControlBase interface
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
+	// End of FAnimNode_SkeletalControlBase interface
+
+
+protected:
+	// FAnimNode_SkeletalControlBase interface
+	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
+	// End of FAnimNode_SkeletalControlBase interface
+
+	// Update rotation of parent bone to reflect new position of the child. 
+	void UpdateParentRotation(FTransform& ParentTransform, const FIKBone& ParentBone,
+		FTransform& ChildTransform, const FIKBone& ChildBone, FCSPose<FCompactPose>& Pose) const;
+
+	// Per-node scratch buffers. Reset (not emptied) each evaluation, so after the first frame
+	// evaluation doesn't allocate.
+	TArray<FTransform> SourceCSTransforms;
+	TArray<FTransform> DestCSTransforms;
+
+	// Spline only: the chain's arc-length table, from the reference pose. Built in InitializeBoneReferences.
+	TArray<float> SplineArcLengths;
+
+	// How the last iterative solve went
+	FIKSolveStats LastSolveStats;
+
+	// Iteration budget for the solves that report stats, if bAdaptiveIterations is set
+	FIKAdaptiveIterations AdaptiveIterations;
+
+	// State block IKChainHandle refers to
+	FIKInstanceStatePtr InstanceState;
+
+#if WITH_EDITOR
+	// Cached CS location when in editor for debug drawing
+	FTransform CachedEffectorCSTransform;
+#endif
+};
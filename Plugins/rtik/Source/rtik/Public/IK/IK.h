@@ -1,377 +1,446 @@
-// Copyright (c) Henry Cooney 2017
-
-/*
-* Contains basic IK structures and definitions.
-*/
-
-#pragma once
-
-#include "rtik.h"
-#include "Animation/AnimNodeBase.h"
-#include "AnimNode_SkeletalControlBase.h"
-#include "CoreMinimal.h"
-#include "GameFramework/Character.h"
-#include "IK.generated.h"
-
-#define ENABLE_IK_DEBUG (1 && !(UE_BUILD_SHIPPING || UE_BUILD_TEST))
-#define ENABLE_IK_DEBUG_VERBOSE (0 && !(UE_BUILD_SHIPPING || UE_BUILD_TEST))
-
-
-/*
-* Specifies what IK should do if the target is unreachable
-*/
-UENUM(BlueprintType)
-enum class EIKUnreachableRule : uint8
-{
-	// Abort IK, return to pre-IK pose
-	IK_Abort        UMETA(DisplayName = "Abort IK"),
-
-	// Reach as far toward the target as possible without moving the root bone
-	IK_Reach        UMETA(DisplayName = "Reach for Target"),
-	
-	// Drag the root bone toward the target so it can be reached (caution, this is likely to give weird results)
-	IK_DragRoot     UMETA(DisplayName = "Drag Chain Root")
-
-};
-
-/*
-*	How the ROM constraint should behave.
-*/
-UENUM(BlueprintType)
-enum class EIKROMConstraintMode : uint8
-{	
-	// Constrain both pitch and yaw rotations
-	IKROM_Pitch_And_Yaw UMETA(DisplayName = "Constrain Pitch and Yaw"),
-
-	// Constrain pitch rotation; allow no yaw rotation
-	IKROM_Pitch_Only UMETA(DisplayName = "Constrain and Allow Only Pitch Rotation"),
-	
-	// Constrain yaw rotation; allow no pitch rotation
-	IKROM_Yaw_Only UMETA(DisplayName = "Constrain and Allow Only Yaw Rotation"),
-
-	// Constrain yaw rotation; allow no pitch rotation
-	// IKROM_Twist_Only UMETA(DisplayName = "Constrain and Allow Only Twist Rotation"),
-
-	// Do not constrain rotation
-	IKROM_No_Constraint UMETA(DisplayName = "No Constraint")
-};
-
-
-UENUM(BlueprintType)
-enum class EIKBoneAxis : uint8
-{
-	IKBA_X UMETA(DisplayName = "X"),
-	IKBA_Y UMETA(DisplayName = "Y"),
-	IKBA_Z UMETA(DisplayName = "Z"),
-	IKBA_XNeg UMETA(DisplayName = "X Negative"),
-	IKBA_YNeg UMETA(DisplayName = "Y Negative"),
-	IKBA_ZNeg UMETA(DisplayName = "Z Negative")
-};
-
-// IK utility functions
-struct FIKUtil
-{
-public:
-
-	// Convert an EIKBoneAxis to a unit vector.
-	static FVector IKBoneAxisToVector(EIKBoneAxis InBoneAxis);
-
-	// Get the specified axis of the skeletal mesh, in world space. Component space is always relative to the skeletal mesh, 6
-	// so for that just use IKBoneAxisToVector above :)	
-	static FVector GetSkeletalMeshWorldAxis(const USkeletalMeshComponent& SkelComp, EIKBoneAxis InBoneAxis);
-};
-
-
-
-/*
-* A range-of-motion constraint on a bone used in IK.
-* 
-* ROM constraints have access to the entire bone chain, before and after IK, and
-* may modify and and all transforms in the chain. 
-* 
-* The base constraint type does nothing.
-*/
-
-USTRUCT(BlueprintType)
-struct RTIK_API FIKBoneConstraint 
-{
-	
-	GENERATED_USTRUCT_BODY()
-
-public:
-
-	// Constraint should only be enforced if this is set to true
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Settings")
-	bool bEnabled;
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Settings")
-	bool bEnableDebugDraw;
-
-public:
-
-	FIKBoneConstraint()
-		:
-		bEnabled(true),
-		bEnableDebugDraw(false)
-	{ }
-
-	virtual ~FIKBoneConstraint()
-	{ }
-
-	// Initialize the constraint. This function must be called before
-	// the constraint is used. Returns initialization success.	
-	virtual	bool Initialize() 
-	{
-		return true;
-	}
-
-	// Enforces the constraint. Will modify OutCSTransforms if needed.
-	// @param Index - The index of this constraint in Constraints; should correspond to the same bone in in InCSTransforms and OutCSTransforms
-	// @param ReferenceCSTransforms - Array of bone transforms before skeletal controls (e.g., IK) are applied. Not necessarily in the reference pose (although they might be, depending on your needs)
-	// @param Constraints - Array of constraints for each bone (including this one, at index Index)	
-	// @param CSTransforms - Array of transforms as skeletal controls (e.g., IK) are being applied; this array will be modified in place
-	// @param Character - Optional owning Character; may to left to nullptr, but is required for debug drawing.
-	virtual void EnforceConstraint(
-		int32 Index,
-		const TArray<FTransform>& ReferenceCSTransforms,
-		const TArray<FIKBoneConstraint*>& Constraints,
-		TArray<FTransform>& CSTransforms,
-		ACharacter* Character = nullptr
-	) { }
-
-	// Optional lambda to evaluate before the constraint is enforced. It can set up examine the chain and set 
-	// things up appropriately. Returns a bool; the constraint should only be enforced if it returns true.
-	TFunction<void(
-		int32 Index,
-		const TArray<FTransform>& ReferenceCSTransforms,
-		const TArray<FIKBoneConstraint*>& Constraints,
-		TArray<FTransform>& CSTransforms
-		)> SetupFn = [](
-			int32 Index,
-			const TArray<FTransform>& ReferenceCSTransforms,
-			const TArray<FIKBoneConstraint*>& Constraints,
-			TArray<FTransform>& CSTransforms
-			) {};
-};
-
-/*
- * Wrapper class allows these to be set 'polymorphically' during property-window setup
- */
-UCLASS(BlueprintType, EditInlineNew, DefaultToInstanced, abstract)
-class UIKBoneConstraintWrapper : public UObject
-{ 
-	GENERATED_BODY()
-
-public:
-
-	// Subclasses must override this to return the internal constraint struct
-	virtual FIKBoneConstraint* GetConstraint() { return nullptr; }
-};
-
-/*
-* A bone used in IK.
-*
-* Range of motion constraints can be specified, but are not used unless the bone is being used
-* with an IK method that supports them.
-*
-*/
-USTRUCT(BlueprintType)
-struct RTIK_API FIKBone
-{
-	GENERATED_USTRUCT_BODY()
-		
-public:
-	
-	FIKBone()
-		:
-		BoneIndex(INDEX_NONE)
-	{ }
-		
-	UPROPERTY(EditAnywhere, Category = "Settings")
-	FBoneReference BoneRef;
-
-	FIKBoneConstraint* GetConstraint();
-
-	FCompactPoseBoneIndex BoneIndex;
-
-public:
-
-    // Check if this bone is valid, if not, attempt to initialize it. Return whether the bone is (after re-initialization if needed)
-	bool InitIfInvalid(const FBoneContainer& RequiredBones);
-	
-	// Initialize this IK Bone. Must be called before use.
-	bool Init(const FBoneContainer& RequiredBones);
-
-	bool IsValid(const FBoneContainer& RequiredBones);
-
-protected:
-
-	UPROPERTY(EditAnywhere, Instanced, NoClear, Export, Category = "Settings")
-	UIKBoneConstraintWrapper* Constraint;
-
-};
-
-/*
-* Allows bones to be passed around in BP
-*/
-UCLASS(BlueprintType)
-class RTIK_API UIKBoneWrapper : public UObject
-{
-	
-	GENERATED_BODY()
-
-public: 
-
-	UIKBoneWrapper(const FObjectInitializer& ObjectInitializer)
-		: 
-		Super(ObjectInitializer),
-		bInitialized(false)
-	{ }
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
-	FIKBone Bone;
-
-public: 
-
-	UFUNCTION(BlueprintCallable, Category = IK)
-	void Initialize(FIKBone InBone);
-
-	bool InitIfInvalid(const FBoneContainer& RequiredBones);
-	
-	bool Init(const FBoneContainer& RequiredBones);
-	
-	bool IsValid(const FBoneContainer& RequiredBones);
-	
-protected:
-
-	bool bInitialized;
-};
-
-
-/*
-* A basic IK chain. Doesn't contain any data yet, just an interface for testing validity. 
-*
-* The InitBoneReferences function must be called by the using animnode before use.
-* This function should initialize bone references, and assign the RootBone and EffectorBone as needed.
-*/
-USTRUCT(BlueprintType)
-struct RTIK_API FIKModChain 
-{
-	GENERATED_USTRUCT_BODY()
-		
-public:
-		   
-	// Checks if this chain is valid; if not, attempts to initialize it and checks again.
-    // Returns true if valid or initialization succeeds.
-	virtual bool InitIfInvalid(const FBoneContainer& RequiredBones);
-	
-	// Initialize all bones used in this chain. Must be called before use.
-	// Subclasses must override this.
-	virtual bool InitBoneReferences(const FBoneContainer& RequiredBones);
-	
-	// Check whether this chain is valid to use. Should be called in the IsValid method of your animnode.
-	// Subclasses must override this.
-	virtual bool IsValid(const FBoneContainer& RequiredBones);	
-};
-
-/*
-* An IK chain with range limits.
-*/
-USTRUCT(BlueprintType)
-struct RTIK_API FRangeLimitedIKChain : public FIKModChain
-{
-	
-	GENERATED_USTRUCT_BODY()
-
-public:
-
-	FRangeLimitedIKChain()
-		:
-		bValid(false)
-	{ }
-
-	virtual ~FRangeLimitedIKChain()
-	{ }
-
-	// Bones in the chain, ordered from the effector bone to the root.
-	// Each bone must be the skeletal parent of the preceeding bone. 	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RangeLimitedIK")
-	TArray<FIKBone> BonesRootToEffector;
-
-	FIKBone& operator[](size_t i);
-
-	// access the ith bone, starting from the effector (identical to operator [])
-	FIKBone& AccessFromEffector(size_t i);
-
-	// access the ith bone from the root - i.e., accesses bones in reverse order
-	FIKBone& AccessFromRoot(size_t i);
-	
-	size_t Num();
-
-	// Begin FIKModChain interface
-	virtual bool InitBoneReferences(const FBoneContainer& RequiredBones) override;
-	virtual bool IsValid(const FBoneContainer& RequiredBones) override;
-	// End FIKModChain interface
-
-protected:
-
-	bool bValid;
-
-};
-
-/*
-* Wraps an IK chain so it can be passed around in BPs
-*/
-UCLASS(BlueprintType)
-class RTIK_API UIKChainWrapper : public UObject
-{
-	GENERATED_BODY()
-
-public: 
-
-	UIKChainWrapper(const FObjectInitializer& ObjectInitializer)
-		: 
-		Super(ObjectInitializer),
-		bInitialized(false)
-	{ }
-
-	// Subclasses should implement an Initialize method that copies incoming chain
-    // into internal struct
-
-	// Checks if this chain is valid; if not, attempts to initialize it and checks again.
-    // Returns true if valid or initialization succeeds.
-	virtual bool InitIfInvalid(const FBoneContainer& RequiredBones);
-
-	// Initialize all bones used in this chain. Must be called before use.
-	virtual bool InitBoneReferences(const FBoneContainer& RequiredBones);
-
-	// Check whether this chain is valid to use. Should be called in the IsValid method of your animnode.
-	virtual bool IsValid(const FBoneContainer& RequiredBones);
-
-protected:
-	bool bInitialized;
-};
-
-
-UCLASS(BlueprintType)
-class RTIK_API URangeLimitedIKChainWrapper : public UIKChainWrapper
-{
-	GENERATED_BODY()
-
-public:
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
-	FRangeLimitedIKChain Chain;
-
-	UFUNCTION(BlueprintCallable, Category = IK)
-	void Initialize(FRangeLimitedIKChain InChain);
-
-	virtual bool InitIfInvalid(const FBoneContainer& RequiredBones);
-
-	// Initialize all bones used in this chain. Must be called before use.
-	virtual bool InitBoneReferences(const FBoneContainer& RequiredBones);
-
-	// Check whether this chain is valid to use. Should be called in the IsValid method of your animnode.
-	virtual bool IsValid(const FBoneContainer& RequiredBones);
-};
-
+// Copyright (c) Henry Cooney 2017
+
+/*
+* Contains basic IK structures and definitions for skeletons: bones and chains. Types the solvers share are in
+* IKSolverTypes.h, in rtikCore.
+*/
+
+#pragma once
+
+#include "rtik.h"
+#include "CoreMinimal.h"
+#include "BoneContainer.h"
+#include "IKSolverTypes.h"
+#include "Constraints.h"
+#include "IKChainDefinition.h"
+#include "IK.generated.h"
+
+class USkeletalMeshComponent;
+
+// Scopes the rest of a node's evaluation by the actor that owns the animated mesh, and adds its time to
+// FIKFrameCounters. Use after the node's SCOPE_CYCLE_COUNTER.
+#define RTIK_SCOPE_OWNER_CYCLE_COUNTER(AnimInstanceProxy) \
+	FIKFrameCounters::FNodeScope RTIKNodeCostScope; \
+	FScopeCycleCounterUObject RTIKOwnerCycleCounter((AnimInstanceProxy)->GetSkelMeshComponent()->GetOwner())
+
+/*
+*	How the ROM constraint should behave.
+*/
+UENUM(BlueprintType)
+enum class EIKROMConstraintMode : uint8
+{	
+	// Constrain both pitch and yaw rotations
+	IKROM_Pitch_And_Yaw UMETA(DisplayName = "Constrain Pitch and Yaw"),
+
+	// Constrain pitch rotation; allow no yaw rotation
+	IKROM_Pitch_Only UMETA(DisplayName = "Constrain and Allow Only Pitch Rotation"),
+	
+	// Constrain yaw rotation; allow no pitch rotation
+	IKROM_Yaw_Only UMETA(DisplayName = "Constrain and Allow Only Yaw Rotation"),
+
+	// Constrain yaw rotation; allow no pitch rotation
+	// IKROM_Twist_Only UMETA(DisplayName = "Constrain and Allow Only Twist Rotation"),
+
+	// Do not constrain rotation
+	IKROM_No_Constraint UMETA(DisplayName = "No Constraint")
+};
+
+
+UENUM(BlueprintType)
+enum class EIKBoneAxis : uint8
+{
+	IKBA_X UMETA(DisplayName = "X"),
+	IKBA_Y UMETA(DisplayName = "Y"),
+	IKBA_Z UMETA(DisplayName = "Z"),
+	IKBA_XNeg UMETA(DisplayName = "X Negative"),
+	IKBA_YNeg UMETA(DisplayName = "Y Negative"),
+	IKBA_ZNeg UMETA(DisplayName = "Z Negative")
+};
+
+// IK utility functions
+struct RTIK_API FIKUtil
+{
+public:
+
+	// Convert an EIKBoneAxis to a unit vector.
+	static FVector IKBoneAxisToVector(EIKBoneAxis InBoneAxis);
+
+	// Get the specified axis of the skeletal mesh, in world space. Component space is always relative to the skeletal mesh, 6
+	// so for that just use IKBoneAxisToVector above :)	
+	static FVector GetSkeletalMeshWorldAxis(const USkeletalMeshComponent& SkelComp, EIKBoneAxis InBoneAxis);
+};
+
+/*
+* Identifies the set of required bones an IK bone or chain was last initialized against.
+*
+* The anim instance proxy keeps one FBoneContainer alive and re-fills it when LOD or the mesh changes, so the
+* container's address alone says nothing. Per frame, IsFor compares only the cheap fields: the container, its asset
+* and its bone count. A re-fill that keeps all three (e.g., two LODs with the same number of bones) is caught by the
+* node's InitializeBoneReferences, which the anim graph calls on every re-fill; that path builds the key with
+* MakeHashed, which also hashes the required bone indices, so nodes sharing a chain only re-walk it for the first
+* of them to see a new bone set.
+*/
+struct RTIK_API FIKBoneContainerKey
+{
+public:
+
+	FIKBoneContainerKey()
+		:
+		Container(nullptr),
+		Asset(nullptr),
+		NumRequiredBones(INDEX_NONE),
+		RequiredBonesHash(0)
+	{ }
+
+	// The cheap fields only; RequiredBonesHash is left at 0
+	explicit FIKBoneContainerKey(const FBoneContainer& RequiredBones)
+		:
+		Container(&RequiredBones),
+		Asset(RequiredBones.GetAsset()),
+		NumRequiredBones(RequiredBones.GetBoneIndicesArray().Num()),
+		RequiredBonesHash(0)
+	{ }
+
+	// The cheap fields, plus a CRC of the required bone indices. Only for when the required bones change.
+	static FIKBoneContainerKey MakeHashed(const FBoneContainer& RequiredBones)
+	{
+		FIKBoneContainerKey Key(RequiredBones);
+		const TArray<FBoneIndexType>& BoneIndices = RequiredBones.GetBoneIndicesArray();
+		Key.RequiredBonesHash = FCrc::MemCrc32(BoneIndices.GetData(), BoneIndices.Num() * sizeof(FBoneIndexType));
+		return Key;
+	}
+
+	// Per-frame check: true if the key was made from RequiredBones, as far as the cheap fields can tell
+	bool IsFor(const FBoneContainer& RequiredBones) const
+	{
+		return Container == &RequiredBones
+			&& Asset == RequiredBones.GetAsset()
+			&& NumRequiredBones == RequiredBones.GetBoneIndicesArray().Num();
+	}
+
+	bool operator==(const FIKBoneContainerKey& Other) const
+	{
+		return Container == Other.Container
+			&& Asset == Other.Asset
+			&& NumRequiredBones == Other.NumRequiredBones
+			&& RequiredBonesHash == Other.RequiredBonesHash;
+	}
+
+	bool operator!=(const FIKBoneContainerKey& Other) const
+	{
+		return !(*this == Other);
+	}
+
+protected:
+	const FBoneContainer* Container;
+	const UObject* Asset;
+	int32 NumRequiredBones;
+	uint32 RequiredBonesHash;
+};
+
+/*
+* A bone used in IK.
+*
+* Range of motion constraints can be specified, but are not used unless the bone is being used
+* with an IK method that supports them. A planar constraint can be stored in the bone itself; other constraint types
+* need a constraint object.
+*
+*/
+USTRUCT(BlueprintType)
+struct RTIK_API FIKBone
+{
+	GENERATED_USTRUCT_BODY()
+		
+public:
+	
+	FIKBone()
+		:
+		BoneIndex(INDEX_NONE),
+		bUsePlanarConstraint(false),
+		bCachedValid(false)
+	{ }
+		
+	UPROPERTY(EditAnywhere, Category = "Settings")
+	FBoneReference BoneRef;
+
+	FIKBoneConstraint* GetConstraint();
+
+	FCompactPoseBoneIndex BoneIndex;
+
+public:
+
+    // Check if this bone is valid, if not, attempt to initialize it. Return whether the bone is (after re-initialization if needed)
+	// Only does work the first time it sees a new set of required bones; after that the cached result is returned.
+	bool InitIfInvalid(const FBoneContainer& RequiredBones);
+	
+	// Initialize this IK Bone. Must be called before use. Returns false if the bone can't be evaluated with
+	// RequiredBones, including when it exists but isn't required at the current LOD.
+	bool Init(const FBoneContainer& RequiredBones);
+
+	// Initialize this IK Bone from a chain definition, which has already looked up the bone's mesh pose index.
+	// Doesn't initialize the constraint; call InitConstraint first. Returns false if the bone isn't required at this LOD.
+	bool InitFromDefinition(const FBoneContainer& RequiredBones, int32 MeshBoneIndex);
+
+	// Initialize (normalize) this bone's constraint, if it has one
+	void InitConstraint();
+
+	bool IsValid(const FBoneContainer& RequiredBones);
+
+	// Forget the cached validity, so the next InitIfInvalid re-initializes the bone
+	void InvalidateCache();
+
+protected:
+
+	UPROPERTY(EditAnywhere, Instanced, NoClear, Export, Category = "Settings")
+	UIKBoneConstraintWrapper* Constraint;
+
+	// If true, the bone is constrained by PlanarConstraint rather than Constraint. Unlike a constraint object, it
+	// costs the garbage collector nothing.
+	UPROPERTY(EditAnywhere, Category = "Settings")
+	bool bUsePlanarConstraint;
+
+	UPROPERTY(EditAnywhere, Category = "Settings", meta = (EditCondition = "bUsePlanarConstraint"))
+	FPlanarRotation PlanarConstraint;
+
+	// Required bones this bone was last initialized against, and whether that succeeded
+	FIKBoneContainerKey CachedContainerKey;
+	bool bCachedValid;
+
+};
+
+/*
+* Allows bones to be passed around in BP
+*/
+UCLASS(BlueprintType)
+class RTIK_API UIKBoneWrapper : public UObject
+{
+	
+	GENERATED_BODY()
+
+public: 
+
+	UIKBoneWrapper(const FObjectInitializer& ObjectInitializer)
+		: 
+		Super(ObjectInitializer),
+		bInitialized(false)
+	{ }
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	FIKBone Bone;
+
+public: 
+
+	UFUNCTION(BlueprintCallable, Category = IK)
+	void Initialize(FIKBone InBone);
+
+	bool IsInitialized() const
+	{
+		return bInitialized;
+	}
+
+	bool InitIfInvalid(const FBoneContainer& RequiredBones);
+	
+	bool Init(const FBoneContainer& RequiredBones);
+	
+	bool IsValid(const FBoneContainer& RequiredBones);
+	
+protected:
+
+	bool bInitialized;
+};
+
+
+/*
+* A basic IK chain. Doesn't contain any data yet, just an interface for testing validity. 
+*
+* The InitBoneReferences function must be called by the using animnode before use.
+* This function should initialize bone references, and assign the RootBone and EffectorBone as needed.
+*/
+USTRUCT(BlueprintType)
+struct RTIK_API FIKModChain 
+{
+	GENERATED_USTRUCT_BODY()
+		
+public:
+
+	FIKModChain()
+		:
+		bCachedValid(false)
+	{ }
+
+	virtual ~FIKModChain()
+	{ }
+		   
+	// Checks if this chain is valid; if not, attempts to initialize it and checks again.
+    // Returns true if valid or initialization succeeds.
+	// The result is cached against RequiredBones, so this is cheap to call every frame.
+	virtual bool InitIfInvalid(const FBoneContainer& RequiredBones);
+	
+	// Initialize all bones used in this chain. Must be called before use.
+	// Subclasses must override this.
+	virtual bool InitBoneReferences(const FBoneContainer& RequiredBones);
+	
+	// Check whether this chain is valid to use. Should be called in the IsValid method of your animnode.
+	// Subclasses must override this.
+	virtual bool IsValid(const FBoneContainer& RequiredBones);	
+
+	// Re-initializes the chain against RequiredBones and caches the result, unless it was already initialized
+	// against the same bone set. Call this when the required bones change (i.e., from your animnode's
+	// InitializeBoneReferences).
+	bool RefreshCachedValidity(const FBoneContainer& RequiredBones);
+
+	// Returns the cached validity if it was computed for RequiredBones; otherwise falls back to IsValid.
+	bool IsValidCached(const FBoneContainer& RequiredBones);
+
+	// Forget the cached validity, so the next InitIfInvalid re-initializes the chain
+	void InvalidateCache();
+
+protected:
+
+	// Required bones this chain was last initialized against, and whether that succeeded
+	FIKBoneContainerKey CachedContainerKey;
+	bool bCachedValid;
+};
+
+/*
+* An IK chain with range limits.
+*/
+USTRUCT(BlueprintType)
+struct RTIK_API FRangeLimitedIKChain : public FIKModChain
+{
+	
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	FRangeLimitedIKChain()
+		:
+		bValid(false)
+	{ }
+
+	virtual ~FRangeLimitedIKChain()
+	{ }
+
+	// Bones in the chain, ordered from the effector bone to the root.
+	// Each bone must be the skeletal parent of the preceeding bone. 	
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RangeLimitedIK")
+	TArray<FIKBone> BonesRootToEffector;
+
+	FIKBone& operator[](size_t i);
+
+	// access the ith bone, starting from the effector (identical to operator [])
+	FIKBone& AccessFromEffector(size_t i);
+
+	// access the ith bone from the root - i.e., accesses bones in reverse order
+	FIKBone& AccessFromRoot(size_t i);
+	
+	size_t Num();
+
+	// Constraints of every bone in the chain, compiled when bone references are initialized
+	const FIKCompiledConstraintTable& GetConstraintTable() const
+	{
+		return (Definition.IsValid() && Definition->bHasSharedConstraints) ? Definition->ConstraintTable : ConstraintTable;
+	}
+
+	// Shared definition of this chain, set when bone references are initialized
+	const FIKChainDefinitionPtr& GetDefinition() const
+	{
+		return Definition;
+	}
+
+	// Bone names and constraints the definition is built from. Initializes the constraints.
+	void GatherDefinitionInputs(TArray<FName>& OutBoneNames, TArray<FIKBoneConstraint*>& OutConstraints);
+
+	// Checks the definition is built with
+	static EIKChainDefinitionChecks GetDefinitionChecks()
+	{
+		return EIKChainDefinitionChecks::IKCDC_Hierarchy;
+	}
+
+	// Use a definition baked by a rig asset (URTIKRigAsset) instead of building one, whenever bone references are
+	// initialized for the mesh it was baked for
+	void SetBakedDefinition(const FIKChainDefinitionPtr& InBakedDefinition)
+	{
+		BakedDefinition = InBakedDefinition;
+	}
+
+	// Begin FIKModChain interface
+	virtual bool InitBoneReferences(const FBoneContainer& RequiredBones) override;
+	virtual bool IsValid(const FBoneContainer& RequiredBones) override;
+	// End FIKModChain interface
+
+protected:
+
+	bool bValid;
+
+	FIKChainDefinitionPtr Definition;
+
+	// Set by SetBakedDefinition
+	FIKChainDefinitionPtr BakedDefinition;
+
+	// Only used if the definition can't share constraints
+	FIKCompiledConstraintTable ConstraintTable;
+
+};
+
+/*
+* Wraps an IK chain so it can be passed around in BPs
+*/
+UCLASS(BlueprintType)
+class RTIK_API UIKChainWrapper : public UObject
+{
+	GENERATED_BODY()
+
+public: 
+
+	UIKChainWrapper(const FObjectInitializer& ObjectInitializer)
+		: 
+		Super(ObjectInitializer),
+		bInitialized(false)
+	{ }
+
+	// Subclasses should implement an Initialize method that copies incoming chain
+    // into internal struct
+
+	bool IsInitialized() const
+	{
+		return bInitialized;
+	}
+
+	// Checks if this chain is valid; if not, attempts to initialize it and checks again.
+    // Returns true if valid or initialization succeeds.
+	virtual bool InitIfInvalid(const FBoneContainer& RequiredBones);
+
+	// Initialize all bones used in this chain. Must be called before use.
+	virtual bool InitBoneReferences(const FBoneContainer& RequiredBones);
+
+	// Check whether this chain is valid to use. Should be called in the IsValid method of your animnode.
+	virtual bool IsValid(const FBoneContainer& RequiredBones);
+
+protected:
+	bool bInitialized;
+};
+
+
+UCLASS(BlueprintType)
+class RTIK_API URangeLimitedIKChainWrapper : public UIKChainWrapper
+{
+	GENERATED_BODY()
+
+public:
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	FRangeLimitedIKChain Chain;
+
+	UFUNCTION(BlueprintCallable, Category = IK)
+	void Initialize(FRangeLimitedIKChain InChain);
+
+	virtual bool InitIfInvalid(const FBoneContainer& RequiredBones);
+
+	// Initialize all bones used in this chain. Must be called before use.
+	virtual bool InitBoneReferences(const FBoneContainer& RequiredBones);
+
+	// Check whether this chain is valid to use. Should be called in the IsValid method of your animnode.
+	virtual bool IsValid(const FBoneContainer& RequiredBones);
+};
+
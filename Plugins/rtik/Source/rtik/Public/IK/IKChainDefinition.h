@@ -0,0 +1,136 @@
+// Copyright (c) Henry Cooney 2017
+
+/*
+* Chain definitions: the parts of an IK chain that depend only on the mesh and the chain's setup, not on the
+* character using it. Every character with the same mesh and the same chain setup shares one definition, so
+* spawning many characters doesn't repeat bone name lookups, ref pose math and constraint compilation per instance.
+*
+* Chains hold only per-instance state (compact pose indices for the current LOD, cached validity, and constraint
+* objects) plus a pointer to their definition. See FRangeLimitedIKChain and FHumanoidLegChain.
+*
+* Definitions can also be baked ahead of time into a rig asset (URTIKRigAsset), so chains set up from one never
+* look bones up by name at runtime.
+*
+* Console commands:
+*   rtik.ChainDefinitions.List    Log every cached definition, and how many chains share it
+*   rtik.ChainDefinitions.Flush   Drop every cached definition; chains rebuild theirs when next initialized
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoneContainer.h"
+#include "ReferenceSkeleton.h"
+#include "UObject/WeakObjectPtr.h"
+#include "IKSolverTypes.h"
+
+/*
+* What a chain definition checks when it is built
+*/
+enum class EIKChainDefinitionChecks : uint8
+{
+	// Only check that every bone exists
+	IKCDC_BonesExist,
+
+	// Also check that each bone comes after the previous one in the skeleton, and is a nonzero distance from it
+	IKCDC_Hierarchy
+};
+
+/*
+* An immutable, shared chain definition. Built by FIKChainDefinitionCache, or loaded from a rig asset; never modified
+* afterward, so it can be read from any thread.
+*/
+struct RTIK_API FIKChainDefinition
+{
+public:
+
+	FIKChainDefinition()
+		:
+		TotalLength(0.0f),
+		bValid(false),
+		bHasSharedConstraints(false),
+		bBaked(false),
+		LODMask(MAX_uint32)
+	{ }
+
+	// The mesh (or skeleton) the definition was built for
+	FWeakObjectPtr Asset;
+
+	// Bone names, in chain order
+	TArray<FName> BoneNames;
+
+	// Mesh pose index of each bone. INDEX_NONE if the mesh has no bone of that name.
+	TArray<int32> MeshBoneIndices;
+
+	// Ref pose distance between each bone and the next one; one fewer entry than there are bones
+	TArray<float> BoneLengths;
+
+	// Sum of BoneLengths
+	float TotalLength;
+
+	// True if every bone exists, and the chain passed the checks it was built with
+	bool bValid;
+
+	// True if ConstraintTable holds the chain's compiled constraints. If the chain has constraints that can only be
+	// enforced through their source object (IKCC_Custom), those objects belong to the instance, so nothing is shared
+	// and each chain compiles its own table.
+	bool bHasSharedConstraints;
+
+	// Compiled constraints, if bHasSharedConstraints. Constraints holds only nulls; Entries never needs them.
+	FIKCompiledConstraintTable ConstraintTable;
+
+	// True if the definition was baked into a rig asset, rather than built by the cache
+	bool bBaked;
+
+	// Bit i is set if mesh LOD i has every bone in the chain, or there is no LOD i. Only worked out when baking;
+	// all set otherwise.
+	uint32 LODMask;
+
+	// True if the definition can be used with RequiredBones, i.e. it was built for the same asset
+	bool IsFor(const FBoneContainer& RequiredBones) const
+	{
+		return Asset.Get() == RequiredBones.GetAsset();
+	}
+};
+
+typedef TSharedPtr<const FIKChainDefinition, ESPMode::ThreadSafe> FIKChainDefinitionPtr;
+
+/*
+* Process-wide cache of chain definitions, keyed by the mesh (the asset the required bones were built for), bone
+* names, checks, and compiled constraints. Thread safe.
+*
+* Definitions for meshes that have been garbage collected are dropped the next time a definition is built. In the
+* editor, definitions for a mesh are also dropped when it is edited or reimported.
+*/
+struct RTIK_API FIKChainDefinitionCache
+{
+public:
+
+	// Called by the module. In the editor, starts watching for mesh edits; Shutdown stops, and empties the cache.
+	static void Startup();
+	static void Shutdown();
+
+	// Returns the definition for a chain of BoneNames, with ChainConstraints (already initialized; may contain
+	// nulls), on the mesh RequiredBones was built for. Builds it the first time it is asked for.
+	static FIKChainDefinitionPtr FindOrBuild(const FBoneContainer& RequiredBones, const TArray<FName>& BoneNames,
+		const TArray<FIKBoneConstraint*>& ChainConstraints, EIKChainDefinitionChecks Checks);
+
+	// Builds a definition for a chain of BoneNames in RefSkeleton, without caching it. Asset is what RefSkeleton
+	// belongs to. Used by rig assets when they bake.
+	static FIKChainDefinitionPtr Build(const UObject* Asset, const FReferenceSkeleton& RefSkeleton,
+		const TArray<FName>& BoneNames, const TArray<FIKBoneConstraint*>& ChainConstraints, EIKChainDefinitionChecks Checks);
+
+	// Checks a chain of BoneNames against RefSkeleton, the way building its definition would. Returns false if the
+	// definition would not be valid, with the first reason why in OutProblem. Used to validate nodes in the editor.
+	static bool CheckChain(const FReferenceSkeleton& RefSkeleton, const TArray<FName>& BoneNames,
+		EIKChainDefinitionChecks Checks, FString& OutProblem);
+
+	// Number of cached definitions
+	static int32 Num();
+
+	// Drops every cached definition. Chains keep the definition they have until they are next initialized.
+	static void Empty();
+
+	// Logs every cached definition
+	static void LogDefinitions();
+};
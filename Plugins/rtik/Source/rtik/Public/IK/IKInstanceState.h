@@ -0,0 +1,168 @@
+// Copyright (c) Henry Cooney 2017
+
+/*
+* Struct alternatives to the wrapper objects (UHumanoidLegChain_Wrapper, URangeLimitedIKChainWrapper, UIKBoneWrapper
+* and UHumanoidIKTraceData_Wrapper) for node input pins.
+*
+* A handle names a slot in the anim instance's FIKInstanceState, and carries the settings the slot is set up with.
+* Nodes given handles with the same name share the slot, the way they would share a wrapper object; that's how the
+* trace node hands its results to the nodes after it. Handles are plain values, so they can be made, stored and
+* connected in blueprints like any other struct, and there are no objects for the garbage collector to track.
+*
+* Nodes keep their wrapper pins for existing graphs. If a wrapper pin is connected, it is used instead of the handle.
+*
+* Give bones in handles their planar constraint inline (FIKBone::bUsePlanarConstraint). Constraint objects still
+* work, but nothing but the node pins they were set on keeps them alive.
+*
+* Leg and chain handles can name a rig asset (URTIKRigAsset) instead of carrying settings. The slot is then set up
+* from the rig's chain of the same name, with its baked definition.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IK.h"
+#include "HumanoidIK.h"
+#include "IKInstanceState.generated.h"
+
+struct FAnimInstanceProxy;
+class URTIKRigAsset;
+
+USTRUCT(BlueprintType)
+struct RTIK_API FHumanoidLegChainHandle
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	FHumanoidLegChainHandle()
+		:
+		Rig(nullptr)
+	{ }
+
+	// Identifies the leg within the anim instance. Leave as None to use the node's wrapper pin instead.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	FName Name;
+
+	// If set, the leg is set up from the rig's leg of the same name, and Chain is not used
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	URTIKRigAsset* Rig;
+
+	// Sets up the leg the first time a node uses it. Later changes are ignored.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	FHumanoidLegChain Chain;
+
+	bool IsSet() const
+	{
+		return Name != NAME_None;
+	}
+};
+
+USTRUCT(BlueprintType)
+struct RTIK_API FRangeLimitedIKChainHandle
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	FRangeLimitedIKChainHandle()
+		:
+		Rig(nullptr)
+	{ }
+
+	// Identifies the chain within the anim instance. Leave as None to use the node's wrapper pin instead.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	FName Name;
+
+	// If set, the chain is set up from the rig's chain of the same name, and Chain is not used
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	URTIKRigAsset* Rig;
+
+	// Sets up the chain the first time a node uses it. Later changes are ignored.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	FRangeLimitedIKChain Chain;
+
+	bool IsSet() const
+	{
+		return Name != NAME_None;
+	}
+};
+
+USTRUCT(BlueprintType)
+struct RTIK_API FIKBoneHandle
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	// Identifies the bone within the anim instance. Leave as None to use the node's wrapper pin instead.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	FName Name;
+
+	// Sets up the bone the first time a node uses it. Later changes are ignored.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	FIKBone Bone;
+
+	bool IsSet() const
+	{
+		return Name != NAME_None;
+	}
+};
+
+USTRUCT(BlueprintType)
+struct RTIK_API FHumanoidIKTraceDataHandle
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	// Identifies the trace data within the anim instance. Leave as None to use the node's wrapper pin instead.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	FName Name;
+
+	bool IsSet() const
+	{
+		return Name != NAME_None;
+	}
+};
+
+/*
+* RTIK state for one anim instance: the chains, bones and trace data its nodes' handles refer to. Nodes fetch it
+* when they are initialized and keep it alive; it goes away with the last node that uses it.
+*
+* Slots are only touched while the anim instance is initialized, updated or evaluated, which never happens on two
+* threads at once, so the block has no lock of its own.
+*/
+class RTIK_API FIKInstanceState
+{
+public:
+
+	// Returns the state block for the anim instance Proxy belongs to, creating it if needed. Thread safe.
+	static TSharedRef<FIKInstanceState, ESPMode::ThreadSafe> FindOrCreate(const FAnimInstanceProxy* Proxy);
+
+	// The slot for each handle, set up from the handle's settings if it is new. Handles must be set.
+	FHumanoidLegChain& FindOrAddLeg(const FHumanoidLegChainHandle& Handle);
+	FRangeLimitedIKChain& FindOrAddChain(const FRangeLimitedIKChainHandle& Handle);
+	FIKBone& FindOrAddBone(const FIKBoneHandle& Handle);
+	FHumanoidIKTraceState& FindOrAddTraceData(const FHumanoidIKTraceDataHandle& Handle);
+
+	// What a node should use for an input: the wrapper's contents, if the wrapper pin is connected, otherwise
+	// the slot in State for the handle. Null if neither is set, or the wrapper was never initialized.
+	static FHumanoidLegChain* ResolveLeg(FIKInstanceState* State, UHumanoidLegChain_Wrapper* Wrapper,
+		const FHumanoidLegChainHandle& Handle);
+	static FRangeLimitedIKChain* ResolveChain(FIKInstanceState* State, URangeLimitedIKChainWrapper* Wrapper,
+		const FRangeLimitedIKChainHandle& Handle);
+	static FIKBone* ResolveBone(FIKInstanceState* State, UIKBoneWrapper* Wrapper, const FIKBoneHandle& Handle);
+	static FHumanoidIKTraceState* ResolveTraceData(FIKInstanceState* State, UHumanoidIKTraceData_Wrapper* Wrapper,
+		const FHumanoidIKTraceDataHandle& Handle);
+
+protected:
+
+	// Slots are allocated separately, so references to them stay good as more are added
+	TMap<FName, TUniquePtr<FHumanoidLegChain>> Legs;
+	TMap<FName, TUniquePtr<FRangeLimitedIKChain>> Chains;
+	TMap<FName, TUniquePtr<FIKBone>> Bones;
+	TMap<FName, TUniquePtr<FHumanoidIKTraceState>> TraceData;
+};
+
+typedef TSharedPtr<FIKInstanceState, ESPMode::ThreadSafe> FIKInstanceStatePtr;
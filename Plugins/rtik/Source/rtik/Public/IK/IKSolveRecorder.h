@@ -0,0 +1,191 @@
+// Copyright (c) Henry Cooney 2017
+
+/*
+* Capture and replay of FABRIK solver inputs, for benchmarking and checking solver changes against real gameplay.
+*
+* While recording, the nodes write the inputs of every range-limited FABRIK solve they run (chain transforms,
+* compiled constraints, target, solver settings, and delta time) to a binary file, along with what the solve
+* produced. The leg IK node also writes what it derived the target from: trace results, the base pose's foot height,
+* and the effector interpolation state. Records are written from any thread.
+*
+* The replayer loads a recording and runs each solve again through FRangeLimitedFABRIK. Leg IK targets are derived
+* again first, from the recorded trace results and delta time, through FAnimNode_HumanoidLegIK::ComputeFootTargetCS.
+* It needs no world, and replay is deterministic: the same build always produces the same results from the same
+* recording.
+*
+* Console commands:
+*   rtik.Record.Start [Filename]   Start recording; by default, to a new file in Saved/RTIK
+*   rtik.Record.Stop               Stop recording and close the file
+*   rtik.Replay Filename [Repeats] Replay a recording Repeats times (default 1) and log timing and accuracy
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IK.h"
+#include "HumanoidIK.h"
+
+// Which solver a record was made from
+enum class EIKRecordedSolver : uint8
+{
+	// FRangeLimitedFABRIK::SolveRangeLimitedFABRIK
+	IKRS_FABRIK,
+
+	// FRangeLimitedFABRIK::SolveClosedLoopFABRIK
+	IKRS_ClosedLoop
+};
+
+// One recorded solve
+struct RTIK_API FIKSolveRecord
+{
+public:
+
+	FIKSolveRecord()
+		:
+		Solver(EIKRecordedSolver::IKRS_FABRIK),
+		DeltaTime(0.0f),
+		EffectorTargetLocation(0.0f, 0.0f, 0.0f),
+		MaxRootDragDistance(0.0f),
+		RootDragStiffness(1.0f),
+		Precision(0.01f),
+		MaxIterations(20),
+		UnreachableRule(EIKUnreachableRule::IK_Reach),
+		Relaxation(1.0f),
+		StagnationRatio(0.0f),
+		bHasLegTarget(false),
+		LastEffectorOffset(0.0f, 0.0f, 0.0f),
+		bHadCustomConstraints(false)
+	{ }
+
+	// Fills the inputs. Custom constraints can't be recorded, and are replayed as unconstrained.
+	void SetInputs(EIKRecordedSolver InSolver, const TArray<FTransform>& ChainTransforms,
+		const FIKCompiledConstraintTable& InConstraints, const FVector& InEffectorTargetLocation, float InDeltaTime);
+
+	// Fills the results, from the solver's output transforms and stats
+	void SetResults(const TArray<FTransform>& OutTransforms, const FIKSolveStats& Stats);
+
+	// Fills what the leg IK node derived the target from, with the effector offset it carried in from the last evaluation
+	void SetLegTarget(const FHumanoidLegIKTargetInputs& InLegTargetInputs, const FVector& InLastEffectorOffset);
+
+	friend FArchive& operator<<(FArchive& Ar, FIKSolveRecord& Record);
+
+	EIKRecordedSolver Solver;
+	float DeltaTime;
+
+	// Chain transforms before the solve. Scale is not recorded; the solvers don't use it.
+	TArray<FTransform> InTransforms;
+
+	// One entry per chain point. Never IKCC_Custom.
+	TArray<FIKCompiledConstraint> Constraints;
+
+	FVector EffectorTargetLocation;
+	float MaxRootDragDistance;
+	float RootDragStiffness;
+	float Precision;
+
+	// The iteration budget the solve actually ran with
+	int32 MaxIterations;
+
+	EIKUnreachableRule UnreachableRule;
+	float Relaxation;
+	float StagnationRatio;
+
+	// Leg IK only: what the target was derived from. If set, replay derives the target again instead of using
+	// EffectorTargetLocation.
+	bool bHasLegTarget;
+	FHumanoidLegIKTargetInputs LegTargetInputs;
+	FVector LastEffectorOffset;
+
+	// Chain point locations after the solve, and how the solve went
+	TArray<FVector> RecordedLocations;
+	FIKSolveStats RecordedStats;
+
+	// True if the chain had custom constraints, which were dropped; replay of this record won't match
+	bool bHadCustomConstraints;
+};
+
+struct RTIK_API FIKSolveRecorder
+{
+public:
+
+	// Cheap enough to check before every solve
+	static bool IsRecording();
+
+	// Starts writing records to Filename, stopping any recording in progress. Returns false if the file can't be opened.
+	static bool StartRecording(const FString& Filename);
+
+	static void StopRecording();
+
+	// Appends SolveRecord to the recording, if one is in progress. May be called from any thread.
+	static void Record(FIKSolveRecord& SolveRecord);
+
+	// Reads every record in Filename. Returns false if it is not a recording this build can read.
+	static bool LoadRecording(const FString& Filename, TArray<FIKSolveRecord>& OutRecords);
+};
+
+// Totals from replaying a recording
+struct FIKReplaySummary
+{
+public:
+
+	FIKReplaySummary()
+		:
+		NumRecords(0),
+		NumSolves(0),
+		NumMismatched(0),
+		NumTargetsMismatched(0),
+		NumApproximate(0),
+		TotalSeconds(0.0),
+		RecordedIterations(0),
+		ReplayedIterations(0),
+		RecordedSlop(0.0f),
+		ReplayedSlop(0.0f),
+		MaxDeviation(0.0f)
+	{ }
+
+	int32 NumRecords;
+
+	// Solves run: NumRecords times the number of repeats
+	int32 NumSolves;
+
+	// Records where a replayed chain point is more than 0.01 units from where it was recorded
+	int32 NumMismatched;
+
+	// Records whose replayed target (derived again, for leg IK) is more than 0.01 units from the recorded one
+	int32 NumTargetsMismatched;
+
+	// Records with custom constraints; they are replayed, but excluded from the mismatch count
+	int32 NumApproximate;
+
+	// Time spent in the solvers, over all repeats
+	double TotalSeconds;
+
+	// Over one pass of the recording
+	int32 RecordedIterations;
+	int32 ReplayedIterations;
+	float RecordedSlop;
+	float ReplayedSlop;
+
+	// Largest distance between a recorded and replayed chain point
+	float MaxDeviation;
+
+	double GetNanosecondsPerSolve() const
+	{
+		return NumSolves > 0 ? TotalSeconds * 1.0e9 / NumSolves : 0.0;
+	}
+};
+
+struct RTIK_API FIKSolveReplayer
+{
+public:
+
+	// Runs the solve in Record again, deriving the target again first if it is a leg IK record. OutTransforms and 
+	// OutStats are as returned by the solver. OutEffectorTarget, if given, receives the target that was solved for.
+	static bool ReplayOne(const FIKSolveRecord& Record, TArray<FTransform>& OutTransforms, FIKSolveStats& OutStats,
+		FVector* OutEffectorTarget = nullptr);
+
+	// Replays every record, Repeats times, and compares the results with what was recorded
+	static void Replay(const TArray<FIKSolveRecord>& Records, int32 Repeats, FIKReplaySummary& OutSummary);
+
+	static void LogSummary(const FIKReplaySummary& Summary);
+};
@@ -0,0 +1,109 @@
+// Copyright (c) Henry Cooney 2017
+
+/*
+* Rig assets: the legs and chains of one mesh, set up once in the editor instead of in every anim blueprint.
+*
+* When the asset is saved or cooked, each chain's definition (bone indices, bone lengths, total reach, compiled
+* constraints, and which LODs have every bone) is baked into a flat binary blob. Loading the blob is a single bulk
+* read, and chains set up from the asset use the baked definitions directly: no bones are looked up by name at
+* runtime, as long as the chain is used with the mesh it was baked for.
+*
+* To use a rig, set it on a node's handle (see IKInstanceState.h). The slot the handle names is then set up from the
+* rig's chain of the same name, rather than from the handle's own settings.
+*
+* Only mesh pose indices are baked. Which of them are in the compact pose depends on what the skeletal mesh
+* component requires at the time, so that mapping is still made at runtime, with a table lookup per bone.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "IK.h"
+#include "HumanoidIK.h"
+#include "RTIKRigAsset.generated.h"
+
+class USkeletalMesh;
+
+USTRUCT()
+struct RTIK_API FRTIKRigLeg
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	// Handles with this name use this leg
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FName Name;
+
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FHumanoidLegChain Chain;
+};
+
+USTRUCT()
+struct RTIK_API FRTIKRigChain
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	// Handles with this name use this chain
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FName Name;
+
+	UPROPERTY(EditAnywhere, Category = Settings)
+	FRangeLimitedIKChain Chain;
+};
+
+UCLASS(BlueprintType)
+class RTIK_API URTIKRigAsset : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	// The mesh chains are baked for. Chains used with other meshes still work, but look bones up by name.
+	UPROPERTY(EditAnywhere, Category = Rig)
+	USkeletalMesh* Mesh;
+
+	// Leg chains, by name
+	UPROPERTY(EditAnywhere, Category = Rig)
+	TArray<FRTIKRigLeg> Legs;
+
+	// Arms and other range limited chains (e.g. for FABRIK), by name
+	UPROPERTY(EditAnywhere, Category = Rig)
+	TArray<FRTIKRigChain> Chains;
+
+	// Returns the settings for the leg named Name and, in OutDefinition, its baked definition (null if it
+	// hasn't been baked). Returns null if there is no such leg.
+	const FHumanoidLegChain* FindLeg(FName Name, FIKChainDefinitionPtr& OutDefinition) const;
+
+	// Same as FindLeg, for range limited chains
+	const FRangeLimitedIKChain* FindChain(FName Name, FIKChainDefinitionPtr& OutDefinition) const;
+
+	// Rebuilds the baked definitions from Mesh and the chain settings. Called when the asset is saved or edited.
+	void Bake();
+
+	// True if every chain has a baked definition
+	bool IsBaked() const;
+
+	// Begin UObject interface
+	virtual void Serialize(FArchive& Ar) override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif // WITH_EDITOR
+	// End UObject interface
+
+protected:
+
+	// The baked definitions, as saved. See RTIKRigAsset.cpp for the layout.
+	TArray<uint8> BakedData;
+
+	// Definitions unpacked from BakedData: legs, then chains, in the same order as the settings
+	TArray<FIKChainDefinitionPtr> BakedDefinitions;
+
+	// Fills BakedDefinitions from BakedData. Leaves it empty if BakedData doesn't match the settings.
+	void UnpackBakedData();
+};
@@ -1,50 +1,96 @@
-// Copyright (c) Henry Cooney 2017
-
-#pragma once
-
-#include "Runtime/Core/Public/Math/Color.h"
-#include "Runtime/Core/Public/Math/Vector.h"
-#include "Runtime/Engine/Classes/GameFramework/Actor.h"
-#include "Runtime/Engine/Public/BonePose.h"
-#include "DebugDrawUtil.generated.h"
-
-/*
-* Thread-safe debug drawing utilities. Animgraph code may be multithreaded; debug-drawing on animation threads 
-* seems to cause crashes. Functions in this class use AsyncTasks to draw on the game thread, instead. 
-*/
-
-USTRUCT()
-struct FDebugDrawUtil
-{
-	GENERATED_USTRUCT_BODY()
-
-public: 
-
-	static void DrawLine(UWorld* World, const FVector& Start, const FVector& Finish,
-		const FLinearColor& Color= FColor(0, 255, 0), float Duration = -1.0f, float Thickness = 1.0f);
-
-	static void DrawSphere(UWorld* World, const FVector& Center, const FLinearColor& Color = FColor(0, 255, 0),
-		float Radius = 15.0f, int32 Segments = 12, float Duration = -1.0f, float Thickness = 0.75f);
-
-	static void DrawString(UWorld* World, const FVector& Location, const FString& Text,
-		AActor* BaseActor, const FColor& Color, float Duration = 0.0f);
-
-	static void DrawPlane(UWorld * World, const FVector& PlaneBase, const FVector& PlaneNormal, float Size = 100.0f,
-		const FLinearColor& Color = FColor(255, 0, 255, 90), bool bDrawNormal = true, float Duration = -1.0f);
-
-	// Draws a direction vector, starting at base, with some pre-decided length. Set length to a negative
-	static void DrawVector(UWorld* World, const FVector& Base, FVector Direction,
-		const FLinearColor& Color = FColor(255, 0, 0), float Length = 50.0f, 
-		float Duration = -1.0f, float Thickness = 1.0f);
-
-	// Draw a line from bone to its skeletal parent
-	static void DrawBone(UWorld * World, USkeletalMeshComponent& SkelComp, FCSPose<FCompactPose>& Pose,
-		const FCompactPoseBoneIndex& ChildBone, const FLinearColor& Color = FColor(0, 255, 255), 
-		float Duration = -1.0f, float Thickness = 1.0f);
-
-	// Draw bones from ChainStartChild to ChainEndParent. ChainStartChild must be a parent of ChainEndParent,
-	// otherwise nothing will happen.
-	static void DrawBoneChain(UWorld* World, USkeletalMeshComponent& SkelComp, FCSPose<FCompactPose>& Pose,
-		const FCompactPoseBoneIndex & ChainStartChild, const FCompactPoseBoneIndex& ChainEndParent,
-		const FLinearColor& Color = FColor(0, 255, 255), float Duration = -1.0f, float Thickness = 1.0f);
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "Runtime/Core/Public/Math/Color.h"
+#include "Runtime/Core/Public/Math/Vector.h"
+#include "Runtime/Engine/Classes/GameFramework/Actor.h"
+#include "Runtime/Engine/Public/BonePose.h"
+#include "IKDebugDraw.h"
+#include "DebugDrawUtil.generated.h"
+
+class ACharacter;
+
+/*
+* Thread-safe debug drawing utilities. Animgraph code may be multithreaded; debug-drawing on animation threads 
+* seems to cause crashes. Functions in this class may be called from any thread: they only queue a draw command,
+* without locking. The game thread draws everything queued in one batch each frame, after actors have ticked.
+*/
+
+USTRUCT()
+struct FDebugDrawUtil
+{
+	GENERATED_USTRUCT_BODY()
+
+public: 
+
+	static void DrawLine(UWorld* World, const FVector& Start, const FVector& Finish,
+		const FLinearColor& Color= FColor(0, 255, 0), float Duration = -1.0f, float Thickness = 1.0f);
+
+	static void DrawSphere(UWorld* World, const FVector& Center, const FLinearColor& Color = FColor(0, 255, 0),
+		float Radius = 15.0f, int32 Segments = 12, float Duration = -1.0f, float Thickness = 0.75f);
+
+	static void DrawString(UWorld* World, const FVector& Location, const FString& Text,
+		AActor* BaseActor, const FColor& Color, float Duration = 0.0f);
+
+	// As DrawString, but the text is only formatted when it is drawn, on the game thread. Format is a printf-style
+	// string literal taking up to two floats, e.g. TEXT("Pelvis Offset: %f"). It must outlive the frame.
+	static void DrawValueString(UWorld* World, const FVector& Location, const TCHAR* Format, float Value,
+		AActor* BaseActor, const FColor& Color, float Duration = 0.0f, float SecondValue = 0.0f);
+
+	static void DrawPlane(UWorld * World, const FVector& PlaneBase, const FVector& PlaneNormal, float Size = 100.0f,
+		const FLinearColor& Color = FColor(255, 0, 255, 90), bool bDrawNormal = true, float Duration = -1.0f);
+
+	// Draws a direction vector, starting at base, with some pre-decided length. Set length to a negative
+	static void DrawVector(UWorld* World, const FVector& Base, FVector Direction,
+		const FLinearColor& Color = FColor(255, 0, 0), float Length = 50.0f, 
+		float Duration = -1.0f, float Thickness = 1.0f);
+
+	// Draw a line from bone to its skeletal parent
+	static void DrawBone(UWorld * World, USkeletalMeshComponent& SkelComp, FCSPose<FCompactPose>& Pose,
+		const FCompactPoseBoneIndex& ChildBone, const FLinearColor& Color = FColor(0, 255, 255), 
+		float Duration = -1.0f, float Thickness = 1.0f);
+
+	// Draw bones from ChainStartChild to ChainEndParent. ChainStartChild must be a parent of ChainEndParent,
+	// otherwise nothing will happen.
+	static void DrawBoneChain(UWorld* World, USkeletalMeshComponent& SkelComp, FCSPose<FCompactPose>& Pose,
+		const FCompactPoseBoneIndex & ChainStartChild, const FCompactPoseBoneIndex& ChainEndParent,
+		const FLinearColor& Color = FColor(0, 255, 255), float Duration = -1.0f, float Thickness = 1.0f);
+
+	// Start and stop drawing queued commands. Called by the module.
+	static void StartupDeferredDrawing();
+	static void ShutdownDeferredDrawing();
+
+	// Draws everything queued so far. Game thread only.
+	static void FlushDeferredDrawing();
+};
+
+/*
+* Debug drawing for solvers run on a character's mesh. Solver locations are in the mesh's component space. Cheap
+* to construct; nothing is looked up until something is drawn.
+*/
+class RTIK_API FIKCharacterDebugDrawer : public IIKDebugDrawer
+{
+public:
+
+	explicit FIKCharacterDebugDrawer(ACharacter* InCharacter)
+		:
+		Character(InCharacter)
+	{ }
+
+	// This drawer, or nullptr if there is no character to draw for. Pass the result to the solver.
+	IIKDebugDrawer* GetIfValid()
+	{
+		return Character != nullptr ? this : nullptr;
+	}
+
+	// Begin IIKDebugDrawer interface
+	virtual void DrawVector(const FVector& Base, const FVector& Direction, const FLinearColor& Color) override;
+	virtual void DrawValueString(const FVector& Offset, const TCHAR* Format, float Value, float SecondValue,
+		const FColor& Color) override;
+	// End IIKDebugDrawer interface
+
+protected:
+
+	ACharacter* Character;
 };
\ No newline at end of file
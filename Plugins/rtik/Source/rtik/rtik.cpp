@@ -1,9 +1,28 @@
-// Copyright (c) Henry Cooney 2017 
-
-#include "rtik.h"
-#include "Modules/ModuleManager.h"
-
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, rtik, "rtik" );
-
-DEFINE_LOG_CATEGORY(LogRTIK)
-
+// Copyright (c) Henry Cooney 2017 
+
+#include "rtik.h"
+#include "Modules/ModuleManager.h"
+#include "Utility/DebugDrawUtil.h"
+#include "IK/IKSolveRecorder.h"
+#include "IK/IKChainDefinition.h"
+
+class FrtikModule : public FDefaultGameModuleImpl
+{
+public:
+
+	virtual void StartupModule() override
+	{
+		FDebugDrawUtil::StartupDeferredDrawing();
+		FIKChainDefinitionCache::Startup();
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FIKSolveRecorder::StopRecording();
+		FIKChainDefinitionCache::Shutdown();
+		FDebugDrawUtil::ShutdownDeferredDrawing();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FrtikModule, rtik, "rtik" );
+
@@ -0,0 +1,277 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "AnalyticIK.h"
+#include "Constraints.h"
+#include "RangeLimitedFABRIK.h"
+
+bool FAnalyticIK::SolveTwoBone(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraintTable& Constraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float Precision,
+	bool& bOutBoneLocationUpdated)
+{
+	if (InTransforms.Num() != 3)
+	{
+		return false;
+	}
+
+	return SolveLastTwoBones(InTransforms, Constraints, EffectorTargetLocation, OutTransforms,
+		Precision, bOutBoneLocationUpdated);
+}
+
+bool FAnalyticIK::SolveThreeBoneFixedRoot(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraintTable& Constraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float Precision,
+	bool& bOutBoneLocationUpdated)
+{
+	if (InTransforms.Num() != 4)
+	{
+		return false;
+	}
+
+	return SolveLastTwoBones(InTransforms, Constraints, EffectorTargetLocation, OutTransforms,
+		Precision, bOutBoneLocationUpdated);
+}
+
+bool FAnalyticIK::TrySolve(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraintTable& Constraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float Precision,
+	bool& bOutBoneLocationUpdated)
+{
+	switch (InTransforms.Num())
+	{
+	case 3:
+		return SolveTwoBone(InTransforms, Constraints, EffectorTargetLocation, OutTransforms,
+			Precision, bOutBoneLocationUpdated);
+	case 4:
+		return SolveThreeBoneFixedRoot(InTransforms, Constraints, EffectorTargetLocation, OutTransforms,
+			Precision, bOutBoneLocationUpdated);
+	default:
+		return false;
+	}
+}
+
+bool FAnalyticIK::SolveLastTwoBones(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraintTable& Constraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float Precision,
+	bool& bOutBoneLocationUpdated)
+{
+	int32 NumPoints = InTransforms.Num();
+	if (Constraints.Num() != NumPoints)
+	{
+		return false;
+	}
+
+	// Custom constraints can do anything; leave them to FABRIK
+	for (const FIKCompiledConstraint& Entry : Constraints.Entries)
+	{
+		if (Entry.Type == EIKCompiledConstraintType::IKCC_Custom)
+		{
+			return false;
+		}
+	}
+
+	int32 RootIndex     = NumPoints - 3;
+	int32 MidIndex      = NumPoints - 2;
+	int32 EffectorIndex = NumPoints - 1;
+
+	// Already there
+	if (FVector::Dist(InTransforms[EffectorIndex].GetLocation(), EffectorTargetLocation) <= Precision)
+	{
+		OutTransforms.Reset(NumPoints);
+		OutTransforms.Append(InTransforms);
+		bOutBoneLocationUpdated = false;
+		return true;
+	}
+
+	FVector NewMid;
+	if (!SolveTriangle(
+		InTransforms[RootIndex].GetLocation(),
+		InTransforms[MidIndex].GetLocation(),
+		InTransforms[EffectorIndex].GetLocation(),
+		Constraints.Entries[RootIndex],
+		Constraints.Entries[MidIndex],
+		EffectorTargetLocation,
+		Precision,
+		NewMid))
+	{
+		return false;
+	}
+
+	OutTransforms.Reset(NumPoints);
+	OutTransforms.Append(InTransforms);
+	OutTransforms[MidIndex].SetLocation(NewMid);
+	OutTransforms[EffectorIndex].SetLocation(EffectorTargetLocation);
+
+	// Bone lengths are known to be nonzero; SolveTriangle rejects degenerate bones
+	FRangeLimitedFABRIK::UpdateParentRotation(OutTransforms[RootIndex], InTransforms[RootIndex],
+		OutTransforms[MidIndex], InTransforms[MidIndex]);
+	FRangeLimitedFABRIK::UpdateParentRotation(OutTransforms[MidIndex], InTransforms[MidIndex],
+		OutTransforms[EffectorIndex], InTransforms[EffectorIndex]);
+
+	bOutBoneLocationUpdated = true;
+	return true;
+}
+
+bool FAnalyticIK::SolveTriangle(
+	const FVector& Root,
+	const FVector& Mid,
+	const FVector& Effector,
+	const FIKCompiledConstraint& RootConstraint,
+	const FIKCompiledConstraint& MidConstraint,
+	const FVector& EffectorTargetLocation,
+	float Precision,
+	FVector& OutMid)
+{
+	float UpperLength = FVector::Dist(Root, Mid);
+	float LowerLength = FVector::Dist(Mid, Effector);
+	if (UpperLength < KINDA_SMALL_NUMBER || LowerLength < KINDA_SMALL_NUMBER)
+	{
+		return false;
+	}
+
+	// Out-of-reach targets (too far, or too close) are left to FABRIK's unreachable handling
+	FVector ToTarget     = EffectorTargetLocation - Root;
+	float TargetDistance = ToTarget.Size();
+	if (TargetDistance < KINDA_SMALL_NUMBER ||
+		TargetDistance > UpperLength + LowerLength ||
+		TargetDistance < FMath::Abs(UpperLength - LowerLength))
+	{
+		return false;
+	}
+
+	FVector Direction = ToTarget / TargetDistance;
+
+	// The middle point lies on a circle around the root-target line. Law of cosines gives the circle's
+	// distance along the line from the root, and its radius.
+	float AlongLine    = (UpperLength * UpperLength - LowerLength * LowerLength + TargetDistance * TargetDistance) /
+		(2.0f * TargetDistance);
+	float Radius       = FMath::Sqrt(FMath::Max(0.0f, UpperLength * UpperLength - AlongLine * AlongLine));
+	FVector Center     = Root + Direction * AlongLine;
+
+	// Basis for the circle's plane. U points toward the current middle point, so angle 0 keeps the current bend.
+	FVector CircleU = FVector::VectorPlaneProject(Mid - Root, Direction);
+	bool bChainStraight = !CircleU.Normalize();
+	if (bChainStraight)
+	{
+		FVector Unused;
+		Direction.FindBestAxisVectors(CircleU, Unused);
+	}
+	FVector CircleV = FVector::CrossProduct(Direction, CircleU);
+
+	// Candidate points on the circle, as (cos, sin) pairs in the U, V basis, best first
+	FVector2D Candidates[2];
+	int32 NumCandidates = 0;
+
+	// Use a planar constraint as a hinge: the constrained bone must lie in its rotation plane
+	const FIKCompiledConstraint* Hinge = nullptr;
+	FVector PlanePoint;
+	if (MidConstraint.Type == EIKCompiledConstraintType::IKCC_Planar)
+	{
+		Hinge      = &MidConstraint;
+		PlanePoint = EffectorTargetLocation;
+	}
+	else if (RootConstraint.Type == EIKCompiledConstraintType::IKCC_Planar)
+	{
+		Hinge      = &RootConstraint;
+		PlanePoint = Root;
+	}
+
+	if (Hinge != nullptr)
+	{
+		// Solve Radius * (cos * UA + sin * VA) = K, where K is the plane's offset from the circle center
+		float UA         = FVector::DotProduct(CircleU, Hinge->RotationAxis);
+		float VA         = FVector::DotProduct(CircleV, Hinge->RotationAxis);
+		float AxisLength = FMath::Sqrt(UA * UA + VA * VA);
+		float K          = FVector::DotProduct(PlanePoint - Center, Hinge->RotationAxis);
+
+		if (Radius * AxisLength < KINDA_SMALL_NUMBER)
+		{
+			// Either the whole circle is in the plane, or none of it is
+			if (FMath::Abs(K) > Precision || bChainStraight)
+			{
+				return false;
+			}
+			Candidates[NumCandidates++] = FVector2D(1.0f, 0.0f);
+		}
+		else
+		{
+			float Cos = K / (Radius * AxisLength);
+			if (FMath::Abs(Cos) > 1.0f)
+			{
+				return false;
+			}
+			float Sin = FMath::Sqrt(1.0f - Cos * Cos);
+
+			// Rotate the in-plane solutions onto the axis' projection
+			FVector2D W(UA / AxisLength, VA / AxisLength);
+			FVector2D WPerp(-W.Y, W.X);
+			FVector2D First  = W * Cos + WPerp * Sin;
+			FVector2D Second = W * Cos - WPerp * Sin;
+
+			// Prefer the one nearer the current bend
+			if (First.X >= Second.X)
+			{
+				Candidates[NumCandidates++] = First;
+				Candidates[NumCandidates++] = Second;
+			}
+			else
+			{
+				Candidates[NumCandidates++] = Second;
+				Candidates[NumCandidates++] = First;
+			}
+		}
+	}
+	else
+	{
+		// No preferred bend direction for a straight chain
+		if (bChainStraight)
+		{
+			return false;
+		}
+		Candidates[NumCandidates++] = FVector2D(1.0f, 0.0f);
+	}
+
+	for (int32 i = 0; i < NumCandidates; ++i)
+	{
+		FVector Candidate = Center + (CircleU * Candidates[i].X + CircleV * Candidates[i].Y) * Radius;
+		if (SatisfiesConstraint(RootConstraint, Root, Candidate, Precision) &&
+			SatisfiesConstraint(MidConstraint, Candidate, EffectorTargetLocation, Precision))
+		{
+			OutMid = Candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FAnalyticIK::SatisfiesConstraint(
+	const FIKCompiledConstraint& Constraint,
+	const FVector& Parent,
+	const FVector& Child,
+	float Precision)
+{
+	switch (Constraint.Type)
+	{
+	case EIKCompiledConstraintType::IKCC_None:
+		return true;
+	case EIKCompiledConstraintType::IKCC_Planar:
+		return FVector::DistSquared(FPlanarRotation::EnforceCompiled(Constraint, Parent, Child), Child) <=
+			Precision * Precision;
+	default:
+		return false;
+	}
+}
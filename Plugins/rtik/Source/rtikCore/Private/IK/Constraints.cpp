@@ -0,0 +1,168 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "Constraints.h"
+
+
+#pragma region FIKNoBoneConstraint
+void FNoBoneConstraint::EnforceConstraint(
+	int32 Index,
+	const TArray<FTransform>& InCSTransforms,
+	const TArray<FIKBoneConstraint*>& Constraints,
+	TArray<FTransform>& OutCSTransforms,
+	IIKDebugDrawer* DebugDrawer
+)
+{
+	return;
+}
+
+bool FNoBoneConstraint::Initialize()
+{
+	return true;
+}
+
+bool FNoBoneConstraint::CompileInto(FIKCompiledConstraint& OutCompiled) const
+{
+	OutCompiled.Type = EIKCompiledConstraintType::IKCC_None;
+	return true;
+}
+
+#pragma endregion FIKNoBoneConstraint
+
+#pragma region FPlanarRotation
+bool FPlanarRotation::Initialize()
+{
+	// make sure axes are normalized; compute up axis
+	bool bAxesOK = true;
+	bAxesOK &= ForwardDirection.Normalize();
+	bAxesOK &= RotationAxis.Normalize();
+	bAxesOK &= FailsafeDirection.Normalize();
+	   
+	if (!bAxesOK)
+	{
+		UE_LOG(LogRTIK, Warning, TEXT("Planar Rotation Constraint was set up incorrectly. Forward direction direction and rotation axis must not be colinear."));
+		return false;
+	}
+	
+	return true;
+}
+
+bool FPlanarRotation::CompileInto(FIKCompiledConstraint& OutCompiled) const
+{
+#if WITH_EDITOR
+	// Debug drawing lives in EnforceConstraint
+	if (bEnableDebugDraw)
+	{
+		return false;
+	}
+#endif // WITH_EDITOR
+
+	if (!CompilePlanar(OutCompiled))
+	{
+		return false;
+	}
+
+	OutCompiled.Type = EIKCompiledConstraintType::IKCC_Planar;
+	return true;
+}
+
+bool FPlanarRotation::CompilePlanar(FIKCompiledConstraint& OutCompiled) const
+{
+	FVector Axis    = RotationAxis.GetSafeNormal();
+	FVector Forward = FVector::VectorPlaneProject(ForwardDirection, Axis).GetSafeNormal();
+	if (Axis.IsZero() || Forward.IsZero())
+	{
+		return false;
+	}
+
+	FVector Up = FVector::CrossProduct(Axis, Forward);
+
+	OutCompiled.RotationAxis     = Axis;
+	OutCompiled.ForwardDirection = Forward;
+	OutCompiled.UpDirection      = Up;
+
+	// Project the failsafe onto the plane now, so the solver always produces an in-plane direction
+	FVector Failsafe = Forward * FVector::DotProduct(FailsafeDirection, Forward) +
+		Up * FVector::DotProduct(FailsafeDirection, Up);
+	OutCompiled.FailsafeDirection = Failsafe.Normalize() ? Failsafe : Forward;
+
+	float MinDeg = FMath::Clamp(MinDegrees, -180.0f, 180.0f);
+	float MaxDeg = FMath::Clamp(MaxDegrees, -180.0f, 180.0f);
+	float SinMin, CosMin, SinMax, CosMax;
+	FMath::SinCos(&SinMin, &CosMin, FMath::DegreesToRadians(MinDeg));
+	FMath::SinCos(&SinMax, &CosMax, FMath::DegreesToRadians(MaxDeg));
+
+	OutCompiled.MinDirection   = Forward * CosMin + Up * SinMin;
+	OutCompiled.MaxDirection   = Forward * CosMax + Up * SinMax;
+
+	// Take the sign from the limit itself; sin(+-180 degrees) is not exactly zero in floating point
+	OutCompiled.MinPseudoAngle = FIKMath::PlanarPseudoAngle(CosMin, MinDeg);
+	OutCompiled.MaxPseudoAngle = FIKMath::PlanarPseudoAngle(CosMax, MaxDeg);
+
+	return true;
+}
+
+void FPlanarRotation::EnforceConstraint(
+	int32 Index,
+	const TArray<FTransform>& ReferenceCSTransforms,
+	const TArray<FIKBoneConstraint*>& Constraints,
+	TArray<FTransform>& CSTransforms,
+	IIKDebugDrawer* DebugDrawer
+) 
+{
+	int32 NumBones = CSTransforms.Num();
+	if (Index >= NumBones - 1)
+	{
+		// This constraint is not meaningful on the tip bone
+#if ENABLE_IK_DEBUG_VERBOSE
+		UE_LOG(LogRTIK, Warning, TEXT("IK: Can't use planar joint constraint on effector bone"));
+#endif //ENABLE_IK_DEBUG_VERBOSE
+		return;
+	}
+
+	// This is the slow path (used with SetupFn or debug drawing), so just compile on the spot
+	FIKCompiledConstraint Compiled;
+	if (!CompilePlanar(Compiled))
+	{
+#if ENABLE_IK_DEBUG_VERBOSE
+		UE_LOG(LogRTIK, Warning, TEXT("Planar rotation constraint has a degenerate rotation axis or forward direction"));
+#endif // ENABLE_IK_DEBUG_VERBOSE
+		return;
+	}
+
+	FVector ParentLoc = CSTransforms[Index].GetLocation();
+
+#if WITH_EDITOR
+	FVector PreClampDirection = CSTransforms[Index + 1].GetLocation() - ParentLoc;
+#endif // WITH_EDITOR
+
+	// Move the child. Don't update rotations yet; that's done the fabrik solver.
+	EnforceCompiled(Compiled, ParentLoc, CSTransforms[Index + 1]);
+
+#if WITH_EDITOR
+	if (bEnableDebugDraw && DebugDrawer != nullptr)
+	{
+		FVector BoneDirection = CSTransforms[Index + 1].GetLocation() - ParentLoc;
+
+		DebugDrawer->DrawVector(ParentLoc, BoneDirection, FColor(255, 255, 0));
+		DebugDrawer->DrawVector(ParentLoc, Compiled.ForwardDirection, FColor(255, 0, 0));
+		DebugDrawer->DrawVector(ParentLoc, Compiled.RotationAxis, FColor(0, 255, 0));
+		DebugDrawer->DrawVector(ParentLoc, Compiled.UpDirection, FColor(0, 0, 255));
+
+		// Draw a debug 'cone'
+		DebugDrawer->DrawVector(ParentLoc, Compiled.MaxDirection, FColor(0, 255, 255));
+		DebugDrawer->DrawVector(ParentLoc, Compiled.MinDirection, FColor(0, 255, 255));
+
+		float AngleDeg = FMath::RadiansToDegrees(FMath::Atan2(
+			FVector::DotProduct(PreClampDirection, Compiled.UpDirection),
+			FVector::DotProduct(PreClampDirection, Compiled.ForwardDirection)));
+		float TargetDeg = FMath::RadiansToDegrees(FMath::Atan2(
+			FVector::DotProduct(BoneDirection, Compiled.UpDirection),
+			FVector::DotProduct(BoneDirection, Compiled.ForwardDirection)));
+
+		DebugDrawer->DrawValueString(FVector(0.0f, 0.0f, 100.0f), TEXT("%f / %f"), AngleDeg, TargetDeg,
+			FColor(0, 0, 255));
+	}
+#endif
+}
+#pragma endregion FPlanarRotation
\ No newline at end of file
@@ -0,0 +1,131 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "IKSolverTypes.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarAdaptiveIterations(
+	TEXT("rtik.AdaptiveIterations"),
+	1,
+	TEXT("If nonzero, IK nodes with adaptive iterations enabled lower their iteration budget for chains that converge early, ")
+	TEXT("and, if the node allows it, raise it for chains that keep running out of iterations."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarMaxIterationsCeiling(
+	TEXT("rtik.MaxIterationsCeiling"),
+	40,
+	TEXT("The most iterations adaptive iteration budgets may grow to, on nodes that allow growth."),
+	ECVF_Default);
+
+#pragma region FIKBoneConstraint
+void FIKBoneConstraint::Compile(FIKCompiledConstraint& OutCompiled)
+{
+	OutCompiled = FIKCompiledConstraint();
+	OutCompiled.Source = this;
+
+	if (!bEnabled)
+	{
+		return;
+	}
+
+	if (SetupFn || !CompileInto(OutCompiled))
+	{
+		OutCompiled.Type = EIKCompiledConstraintType::IKCC_Custom;
+	}
+}
+
+void FIKCompiledConstraintTable::Compile(const TArray<FIKBoneConstraint*>& InConstraints)
+{
+	Constraints = InConstraints;
+	bHasActiveConstraints = CompileEntries(Constraints, Entries);
+}
+
+void FIKCompiledConstraintTable::Reset()
+{
+	Constraints.Reset();
+	Entries.Reset();
+	bHasActiveConstraints = false;
+}
+#pragma endregion FIKBoneConstraint
+
+int32 FIKAdaptiveIterations::GetBudget(int32 MaxIterations, bool bAllowGrowth) const
+{
+	if (CVarAdaptiveIterations.GetValueOnAnyThread() == 0 || Budget == 0 || RecordedMaxIterations != MaxIterations)
+	{
+		return MaxIterations;
+	}
+
+	int32 Ceiling = bAllowGrowth ? FMath::Max(CVarMaxIterationsCeiling.GetValueOnAnyThread(), MaxIterations) : MaxIterations;
+	return FMath::Min(Budget, Ceiling);
+}
+
+void FIKAdaptiveIterations::Record(const FIKSolveStats& Stats, int32 MaxIterations, bool bAllowGrowth)
+{
+	// Nothing to learn from solves that didn't iterate, or that stagnated: their iteration counts say nothing about
+	// how many this chain needs to converge
+	if (Stats.Termination == EIKSolveTermination::IK_NotSolved ||
+		Stats.Termination == EIKSolveTermination::IK_Unreachable ||
+		Stats.Termination == EIKSolveTermination::IK_Stagnated)
+	{
+		return;
+	}
+
+	if (RecordedMaxIterations != MaxIterations)
+	{
+		Reset();
+		RecordedMaxIterations = MaxIterations;
+	}
+
+	int32 CurrentBudget = GetBudget(MaxIterations, bAllowGrowth);
+	bool bMissed        = Stats.Termination == EIKSolveTermination::IK_MaxIterations;
+
+	// Ran out of a budget we lowered; the chain needs the full budget after all
+	if (bMissed && CurrentBudget < MaxIterations)
+	{
+		Reset();
+		RecordedMaxIterations = MaxIterations;
+		return;
+	}
+
+	IterationHistory[NextIndex] = Stats.Iterations;
+	MissHistory[NextIndex]      = bMissed;
+	NextIndex                   = (NextIndex + 1) % HistorySize;
+	NumRecorded                 = FMath::Min(NumRecorded + 1, static_cast<int32>(HistorySize));
+
+	if (NumRecorded < HistorySize)
+	{
+		return;
+	}
+
+	int32 NumMisses      = 0;
+	int32 MostIterations = 0;
+	for (int32 i = 0; i < HistorySize; ++i)
+	{
+		NumMisses      += MissHistory[i] ? 1 : 0;
+		MostIterations  = FMath::Max(MostIterations, IterationHistory[i]);
+	}
+
+	if (NumMisses * 4 > HistorySize)
+	{
+		// Chronically short of iterations. Grow if the node allows it, and judge the new budget on a fresh history.
+		if (bAllowGrowth)
+		{
+			int32 Ceiling = FMath::Max(CVarMaxIterationsCeiling.GetValueOnAnyThread(), MaxIterations);
+			Budget        = FMath::Min(CurrentBudget + FMath::Max(CurrentBudget / 2, 1), Ceiling);
+		}
+		NumRecorded = 0;
+		NextIndex   = 0;
+	}
+	else if (NumMisses == 0)
+	{
+		Budget = FMath::Clamp(MostIterations + 1, 1, CurrentBudget);
+	}
+}
+
+void FIKAdaptiveIterations::Reset()
+{
+	NumRecorded           = 0;
+	NextIndex             = 0;
+	Budget                = 0;
+	RecordedMaxIterations = 0;
+}
@@ -0,0 +1,66 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "IKStats.h"
+
+DEFINE_STAT(STAT_RTIK_Solves);
+DEFINE_STAT(STAT_RTIK_Iterations);
+DEFINE_STAT(STAT_RTIK_AlreadyAtTarget);
+DEFINE_STAT(STAT_RTIK_Converged);
+DEFINE_STAT(STAT_RTIK_Stagnated);
+DEFINE_STAT(STAT_RTIK_MaxIterations);
+DEFINE_STAT(STAT_RTIK_Unreachable);
+DEFINE_STAT(STAT_RTIK_NotSolved);
+DEFINE_STAT(STAT_RTIK_SlopTiny);
+DEFINE_STAT(STAT_RTIK_SlopSmall);
+DEFINE_STAT(STAT_RTIK_SlopMedium);
+DEFINE_STAT(STAT_RTIK_SlopLarge);
+DEFINE_STAT(STAT_RTIK_ConstraintEnforcements);
+DEFINE_STAT(STAT_RTIK_TracesIssued);
+DEFINE_STAT(STAT_RTIK_TracesSkipped);
+
+bool FIKFrameCounters::bEnabled                = false;
+volatile int64 FIKFrameCounters::NodeCycles    = 0;
+volatile int64 FIKFrameCounters::Solves        = 0;
+volatile int64 FIKFrameCounters::Iterations    = 0;
+volatile int64 FIKFrameCounters::TracesIssued  = 0;
+volatile int64 FIKFrameCounters::TracesSkipped = 0;
+
+void FIKFrameCounters::SetEnabled(bool bInEnabled)
+{
+	bEnabled = bInEnabled;
+}
+
+void FIKFrameCounters::AddNodeCycles(uint32 Cycles)
+{
+	FPlatformAtomics::InterlockedAdd(&NodeCycles, static_cast<int64>(Cycles));
+}
+
+void FIKFrameCounters::AddSolve(int32 SolveIterations)
+{
+	if (bEnabled)
+	{
+		FPlatformAtomics::InterlockedIncrement(&Solves);
+		FPlatformAtomics::InterlockedAdd(&Iterations, static_cast<int64>(SolveIterations));
+	}
+}
+
+void FIKFrameCounters::AddTraces(int32 Issued, int32 Skipped)
+{
+	if (bEnabled)
+	{
+		FPlatformAtomics::InterlockedAdd(&TracesIssued, static_cast<int64>(Issued));
+		FPlatformAtomics::InterlockedAdd(&TracesSkipped, static_cast<int64>(Skipped));
+	}
+}
+
+FIKFrameCounters::FTotals FIKFrameCounters::Consume()
+{
+	FTotals Totals;
+	Totals.NodeSeconds   = FPlatformTime::ToSeconds64(FPlatformAtomics::InterlockedExchange(&NodeCycles, 0));
+	Totals.Solves        = FPlatformAtomics::InterlockedExchange(&Solves, 0);
+	Totals.Iterations    = FPlatformAtomics::InterlockedExchange(&Iterations, 0);
+	Totals.TracesIssued  = FPlatformAtomics::InterlockedExchange(&TracesIssued, 0);
+	Totals.TracesSkipped = FPlatformAtomics::InterlockedExchange(&TracesSkipped, 0);
+	return Totals;
+}
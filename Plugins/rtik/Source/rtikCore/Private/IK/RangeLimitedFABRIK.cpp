@@ -0,0 +1,2395 @@
+﻿// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "RangeLimitedFABRIK.h"
+#include "Constraints.h"
+#include "FixedChainFABRIK.h"
+#include "Async/ParallelFor.h"
+
+bool FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(
+	const TArray<FTransform>& InTransforms,
+	const TArray<FIKBoneConstraint*>& Constraints,
+	const FVector & EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	EIKUnreachableRule UnreachableRule,
+	IIKDebugDrawer* DebugDrawer,
+	float Relaxation,
+	float StagnationRatio,
+	FIKSolveStats* OutStats)
+{
+	FMemMark Mark(FMemStack::Get());
+
+	FScratchConstraintArray CompiledConstraints;
+	bool bHasActiveConstraints = FIKCompiledConstraintTable::CompileEntries(Constraints, CompiledConstraints);
+
+	return SolveRangeLimitedFABRIKCompiled(
+		InTransforms,
+		Constraints,
+		bHasActiveConstraints ? CompiledConstraints.GetData() : nullptr,
+		EffectorTargetLocation,
+		OutTransforms,
+		MaxRootDragDistance,
+		RootDragStiffness,
+		Precision,
+		MaxIterations,
+		UnreachableRule,
+		DebugDrawer,
+		Relaxation,
+		StagnationRatio,
+		OutStats
+	);
+}
+
+bool FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraintTable& Constraints,
+	const FVector & EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	EIKUnreachableRule UnreachableRule,
+	IIKDebugDrawer* DebugDrawer,
+	float Relaxation,
+	float StagnationRatio,
+	FIKSolveStats* OutStats)
+{
+	return SolveRangeLimitedFABRIKCompiled(
+		InTransforms,
+		Constraints.Constraints,
+		Constraints.bHasActiveConstraints ? Constraints.Entries.GetData() : nullptr,
+		EffectorTargetLocation,
+		OutTransforms,
+		MaxRootDragDistance,
+		RootDragStiffness,
+		Precision,
+		MaxIterations,
+		UnreachableRule,
+		DebugDrawer,
+		Relaxation,
+		StagnationRatio,
+		OutStats
+	);
+}
+
+bool FRangeLimitedFABRIK::SolveRangeLimitedFABRIKCompiled(
+	const TArray<FTransform>& InTransforms,
+	const TArray<FIKBoneConstraint*>& Constraints,
+	const FIKCompiledConstraint* CompiledConstraints,
+	const FVector & EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	EIKUnreachableRule UnreachableRule,
+	IIKDebugDrawer* DebugDrawer,
+	float Relaxation,
+	float StagnationRatio,
+	FIKSolveStats* OutStats)
+{
+	// Out-of-reach targets have a closed-form answer for unconstrained chains, no need to iterate. Constrained
+	// chains iterate from the straight chain instead of the input pose.
+	bool bShortcutUpdated = false;
+	bool bSeeded          = false;
+	if (TrySolveUnreachable(InTransforms, CompiledConstraints, EffectorTargetLocation, OutTransforms,
+		MaxRootDragDistance, RootDragStiffness, UnreachableRule, bShortcutUpdated, bSeeded))
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_Unreachable);
+		return bShortcutUpdated;
+	}
+
+	// The seed already has the root dragged as far as the rule allows; keep it there. IK_DragRoot drags as far as
+	// it takes.
+	if (bSeeded && UnreachableRule == EIKUnreachableRule::IK_DragRoot)
+	{
+		MaxRootDragDistance = BIG_NUMBER;
+		RootDragStiffness   = 1.0f;
+	}
+
+	bool bRelax = !FMath::IsNearlyEqual(Relaxation, 1.0f);
+
+	// Short chains have unrolled specializations. They start from the input pose, so not for a seeded solve.
+	if (!bRelax && !bSeeded && TrySolveFixedChain(InTransforms, CompiledConstraints, EffectorTargetLocation, OutTransforms,
+		MaxRootDragDistance, RootDragStiffness, Precision, MaxIterations, StagnationRatio, OutStats, bShortcutUpdated))
+	{
+		return bShortcutUpdated;
+	}
+
+	FMemMark Mark(FMemStack::Get());
+
+	// Number of points in the chain. Number of bones = NumPoints - 1
+	int32 NumPoints = InTransforms.Num();
+
+	// Gather bone transforms, unless OutTransforms holds the seed. Reset keeps the caller's allocation.
+	if (!bSeeded)
+	{
+		OutTransforms.Reset(NumPoints);
+		OutTransforms.Append(InTransforms);
+	}
+
+	if (NumPoints < 2)
+	{
+		// Need at least one bone to do IK!
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_NotSolved);
+		return false;
+	}
+	
+	// Gather bone lengths. BoneLengths contains the length of the bone ENDING at this point,
+	// i.e., BoneLengths[i] contains the distance between point i-1 and point i
+	FScratchFloatArray BoneLengths;
+	ComputeBoneLengths(InTransforms, BoneLengths);
+
+	bool bBoneLocationUpdated = false;
+	int32 EffectorIndex       = NumPoints - 1;
+
+	// Point locations at the start of each iteration, for over-relaxation
+	FScratchVectorArray PreviousLocations;
+	if (bRelax)
+	{
+		PreviousLocations.AddUninitialized(NumPoints);
+	}
+	
+	// Check distance between tip location and effector location. The seed ignores constraints, so a seeded solve
+	// always iterates at least once.
+	float Slop = bSeeded ? BIG_NUMBER : FVector::Dist(OutTransforms[EffectorIndex].GetLocation(), EffectorTargetLocation);
+	if (Slop > Precision)
+	{
+		// Set tip bone at end effector location.
+		OutTransforms[EffectorIndex].SetLocation(EffectorTargetLocation);
+
+		// Out of reach, the slop settles at the shortfall instead of reaching Precision. Stop once it has settled.
+		const float UnreachableSettleRatio = 0.01f;
+		FIKIterationMonitor Monitor(Precision, MaxIterations,
+			bSeeded ? FMath::Max(StagnationRatio, UnreachableSettleRatio) : StagnationRatio);
+		while (Monitor.ShouldContinue(Slop))
+		{
+			if (bRelax)
+			{
+				for (int32 PointIndex = 1; PointIndex < EffectorIndex; ++PointIndex)
+				{
+					PreviousLocations[PointIndex] = OutTransforms[PointIndex].GetLocation();
+				}
+			}
+
+			// "Forward Reaching" stage - adjust bones from end effector.
+			FABRIKForwardPass(
+				InTransforms,
+				Constraints,
+				CompiledConstraints,
+				BoneLengths,
+				OutTransforms,
+				DebugDrawer
+			);	
+
+			// Drag the root if enabled
+			DragPointTethered(
+				InTransforms[0],
+				OutTransforms[1],
+				BoneLengths[1],
+				MaxRootDragDistance,
+				RootDragStiffness,
+				OutTransforms[0]
+			);
+
+			// Push the points further along the way they just moved; the backward pass restores bone lengths 
+			// and constraints
+			if (bRelax)
+			{
+				RelaxPoints(PreviousLocations, Relaxation, OutTransforms);
+			}
+
+			// "Backward Reaching" stage - adjust bones from root.
+			FABRIKBackwardPass(
+				InTransforms,
+				Constraints,
+				CompiledConstraints,
+				BoneLengths,
+				OutTransforms,
+				DebugDrawer
+			);
+
+			Slop = FMath::Abs(BoneLengths[EffectorIndex] - 
+				FVector::Dist(OutTransforms[EffectorIndex - 1].GetLocation(), EffectorTargetLocation));
+		}
+		Monitor.Report(OutStats, bSeeded);
+
+		// Place effector based on how close we got to the target
+		FVector EffectorLocation = OutTransforms[EffectorIndex].GetLocation();
+		FVector EffectorParentLocation = OutTransforms[EffectorIndex - 1].GetLocation();
+		EffectorLocation = EffectorParentLocation + (EffectorLocation - EffectorParentLocation).GetUnsafeNormal() * BoneLengths[EffectorIndex];
+		OutTransforms[EffectorIndex].SetLocation(EffectorLocation);
+		
+		bBoneLocationUpdated = true;
+	}
+	else
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_AlreadyAtTarget, 0, Slop);
+	}
+	
+	// Update bone rotations
+	if (bBoneLocationUpdated)
+	{
+		for (int32 PointIndex = 0; PointIndex < NumPoints - 1; ++PointIndex)
+		{
+			if (!FMath::IsNearlyZero(BoneLengths[PointIndex + 1]))
+			{
+				UpdateParentRotation(OutTransforms[PointIndex], InTransforms[PointIndex],
+					OutTransforms[PointIndex + 1], InTransforms[PointIndex + 1]);
+			}
+		}
+	}
+
+	return bBoneLocationUpdated;
+}
+
+bool FRangeLimitedFABRIK::SolveCoarseToFineFABRIK(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraintTable& Constraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	int32 SegmentLength,
+	int32 FineIterations,
+	EIKUnreachableRule UnreachableRule,
+	IIKDebugDrawer* DebugDrawer,
+	FIKSolveStats* OutStats)
+{
+	int32 NumPoints = InTransforms.Num();
+	SegmentLength   = FMath::Max(SegmentLength, 2);
+
+	bool bUseNormalSolver = false;
+	const FIKCompiledConstraint* CompiledConstraints = GetSegmentableConstraints(Constraints, NumPoints,
+		SegmentLength, bUseNormalSolver);
+
+	if (bUseNormalSolver)
+	{
+		return SolveRangeLimitedFABRIK(InTransforms, Constraints, EffectorTargetLocation, OutTransforms,
+			MaxRootDragDistance, RootDragStiffness, Precision, MaxIterations, UnreachableRule, DebugDrawer, 1.0f, 0.0f,
+			OutStats);
+	}
+
+	// Out-of-reach targets on constrained chains are left to range-limited FABRIK, which iterates from the straight
+	// chain
+	bool bShortcutUpdated = false;
+	bool bSeeded          = false;
+	if (TrySolveUnreachable(InTransforms, CompiledConstraints, EffectorTargetLocation, OutTransforms,
+		MaxRootDragDistance, RootDragStiffness, UnreachableRule, bShortcutUpdated, bSeeded))
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_Unreachable);
+		return bShortcutUpdated;
+	}
+	if (bSeeded)
+	{
+		return SolveRangeLimitedFABRIK(InTransforms, Constraints, EffectorTargetLocation, OutTransforms,
+			MaxRootDragDistance, RootDragStiffness, Precision, MaxIterations, UnreachableRule, DebugDrawer, 1.0f, 0.0f,
+			OutStats);
+	}
+
+	OutTransforms.Reset(NumPoints);
+	OutTransforms.Append(InTransforms);
+
+	float StartSlop = FVector::Dist(InTransforms[NumPoints - 1].GetLocation(), EffectorTargetLocation);
+	if (StartSlop <= Precision)
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_AlreadyAtTarget, 0, StartSlop);
+		return false;
+	}
+
+	FMemMark Mark(FMemStack::Get());
+
+	FScratchVectorArray Points;
+	FScratchFloatArray BoneLengths;
+	Points.Reserve(NumPoints);
+	for (const FTransform& Transform : InTransforms)
+	{
+		Points.Add(Transform.GetLocation());
+	}
+	float ReachSum = ComputeBoneLengths(InTransforms, BoneLengths);
+
+	// Pick key points; the effector is always one
+	FScratchIndexArray KeyIndices;
+	for (int32 PointIndex = 0; PointIndex < NumPoints - 1; PointIndex += SegmentLength)
+	{
+		KeyIndices.Add(PointIndex);
+	}
+	KeyIndices.Add(NumPoints - 1);
+	int32 NumKeys = KeyIndices.Num();
+
+	// Coarse solve over the key points. A key chord starts as its segment's span in the input pose, and can grow
+	// up to the segment's summed bone length, which it reaches when the segment is straight.
+	FScratchVectorArray KeyPoints;
+	FScratchFloatArray KeyLengths;
+	KeyPoints.Reserve(NumKeys);
+	KeyLengths.Reserve(NumKeys);
+	for (int32 KeyIndex = 0; KeyIndex < NumKeys; ++KeyIndex)
+	{
+		KeyPoints.Add(Points[KeyIndices[KeyIndex]]);
+		KeyLengths.Add(KeyIndex == 0 ? 0.0f : FVector::Dist(KeyPoints[KeyIndex - 1], KeyPoints[KeyIndex]));
+	}
+	StraightenKeyLengths(KeyIndices, BoneLengths, ReachSum, FVector::Dist(Points[0], EffectorTargetLocation),
+		KeyLengths);
+
+	int32 Iterations = 0;
+	SolveLocationsFABRIK(KeyPoints.GetData(), Points[0], KeyLengths.GetData(), NumKeys, nullptr,
+		EffectorTargetLocation, MaxRootDragDistance, RootDragStiffness, Precision, MaxIterations, &Iterations);
+
+	// Refine each segment, root to effector
+	Points[0] = KeyPoints[0];
+	for (int32 KeyIndex = 1; KeyIndex < NumKeys; ++KeyIndex)
+	{
+		int32 First = KeyIndices[KeyIndex - 1];
+		int32 Last  = KeyIndices[KeyIndex];
+
+		// Carry the segment's starting shape over onto the solved span
+		FVector OldSpan = InTransforms[Last].GetLocation() - InTransforms[First].GetLocation();
+		FVector NewSpan = KeyPoints[KeyIndex] - Points[First];
+		FQuat SpanRotation = FQuat::Identity;
+		if (OldSpan.Normalize() && NewSpan.Normalize())
+		{
+			SpanRotation = FQuat::FindBetweenNormals(OldSpan, NewSpan);
+		}
+
+		for (int32 PointIndex = First + 1; PointIndex <= Last; ++PointIndex)
+		{
+			Points[PointIndex] = Points[First] +
+				SpanRotation.RotateVector(InTransforms[PointIndex].GetLocation() - InTransforms[First].GetLocation());
+		}
+
+		FVector SegmentTarget = (KeyIndex == NumKeys - 1) ? EffectorTargetLocation : KeyPoints[KeyIndex];
+		SolveLocationsFABRIK(
+			Points.GetData() + First,
+			Points[First],
+			BoneLengths.GetData() + First,
+			Last - First + 1,
+			CompiledConstraints != nullptr ? CompiledConstraints + First : nullptr,
+			SegmentTarget,
+			0.0f,
+			1.0f,
+			Precision,
+			FineIterations
+		);
+	}
+
+	// Only the coarse solve's iterations are counted; they're the ones MaxIterations bounds
+	float FinalSlop = FVector::Dist(Points[NumPoints - 1], EffectorTargetLocation);
+	FIKSolveStats::Record(OutStats, FinalSlop <= Precision ? EIKSolveTermination::IK_Converged :
+		EIKSolveTermination::IK_MaxIterations, Iterations, FinalSlop);
+
+	// Write back locations, then update bone rotations
+	for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+	{
+		OutTransforms[PointIndex].SetLocation(Points[PointIndex]);
+	}
+
+	for (int32 PointIndex = 0; PointIndex < NumPoints - 1; ++PointIndex)
+	{
+		if (!FMath::IsNearlyZero(BoneLengths[PointIndex + 1]))
+		{
+			UpdateParentRotation(OutTransforms[PointIndex], InTransforms[PointIndex],
+				OutTransforms[PointIndex + 1], InTransforms[PointIndex + 1]);
+		}
+	}
+
+	return true;
+}
+
+bool FRangeLimitedFABRIK::SolveParallelSegmentedFABRIK(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraintTable& Constraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	int32 SegmentLength,
+	int32 FineIterations,
+	EIKUnreachableRule UnreachableRule,
+	IIKDebugDrawer* DebugDrawer,
+	FIKSolveStats* OutStats)
+{
+	// Below this many points, segments are solved on the calling thread; dispatching them costs more than it saves
+	const int32 MinPointsForWorkers = 128;
+
+	int32 NumPoints = InTransforms.Num();
+	SegmentLength   = FMath::Max(SegmentLength, 2);
+
+	bool bUseNormalSolver = false;
+	const FIKCompiledConstraint* CompiledConstraints = GetSegmentableConstraints(Constraints, NumPoints,
+		SegmentLength, bUseNormalSolver);
+
+	if (bUseNormalSolver)
+	{
+		return SolveRangeLimitedFABRIK(InTransforms, Constraints, EffectorTargetLocation, OutTransforms,
+			MaxRootDragDistance, RootDragStiffness, Precision, MaxIterations, UnreachableRule, DebugDrawer, 1.0f, 0.0f,
+			OutStats);
+	}
+
+	// Out-of-reach targets on constrained chains are left to range-limited FABRIK, which iterates from the straight
+	// chain
+	bool bShortcutUpdated = false;
+	bool bSeeded          = false;
+	if (TrySolveUnreachable(InTransforms, CompiledConstraints, EffectorTargetLocation, OutTransforms,
+		MaxRootDragDistance, RootDragStiffness, UnreachableRule, bShortcutUpdated, bSeeded))
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_Unreachable);
+		return bShortcutUpdated;
+	}
+	if (bSeeded)
+	{
+		return SolveRangeLimitedFABRIK(InTransforms, Constraints, EffectorTargetLocation, OutTransforms,
+			MaxRootDragDistance, RootDragStiffness, Precision, MaxIterations, UnreachableRule, DebugDrawer, 1.0f, 0.0f,
+			OutStats);
+	}
+
+	OutTransforms.Reset(NumPoints);
+	OutTransforms.Append(InTransforms);
+
+	float StartSlop = FVector::Dist(InTransforms[NumPoints - 1].GetLocation(), EffectorTargetLocation);
+	if (StartSlop <= Precision)
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_AlreadyAtTarget, 0, StartSlop);
+		return false;
+	}
+
+	FMemMark Mark(FMemStack::Get());
+
+	FScratchVectorArray Points;
+	FScratchFloatArray BoneLengths;
+	Points.Reserve(NumPoints);
+	for (const FTransform& Transform : InTransforms)
+	{
+		Points.Add(Transform.GetLocation());
+	}
+	float MaxReach = ComputeBoneLengths(InTransforms, BoneLengths);
+
+	// Segment boundaries; the effector is always one
+	FScratchIndexArray BoundaryIndices;
+	for (int32 PointIndex = 0; PointIndex < NumPoints - 1; PointIndex += SegmentLength)
+	{
+		BoundaryIndices.Add(PointIndex);
+	}
+	BoundaryIndices.Add(NumPoints - 1);
+	int32 NumBoundaries = BoundaryIndices.Num();
+	int32 NumSegments   = NumBoundaries - 1;
+
+	FScratchVectorArray BoundaryPoints;
+	FScratchFloatArray BoundaryLengths;
+	BoundaryPoints.AddUninitialized(NumBoundaries);
+	BoundaryLengths.AddUninitialized(NumBoundaries);
+
+	// Each segment works on its own copy of its points, including both boundaries, so workers never share writes.
+	// Segment i's copy starts at BoundaryIndices[i] + i.
+	FScratchVectorArray SegmentPoints;
+	SegmentPoints.AddUninitialized(NumPoints + NumSegments);
+
+	// Segment errors add up along the chain once the segments are joined, so each gets its share of Precision
+	float SegmentPrecision = Precision / NumSegments;
+	FVector RootStart      = Points[0];
+	float RequiredReach    = FVector::Dist(RootStart, EffectorTargetLocation);
+	bool bUseWorkers       = NumPoints >= MinPointsForWorkers;
+
+	float Slop      = StartSlop;
+	int32 NumSweeps = 0;
+	while (Slop > Precision && NumSweeps < MaxIterations)
+	{
+		++NumSweeps;
+
+		// Solve the boundaries on this thread, treating each segment as one rigid bone as long as its current span.
+		// Spans grow toward their segments' full length if they're too short to reach.
+		for (int32 Boundary = 0; Boundary < NumBoundaries; ++Boundary)
+		{
+			BoundaryPoints[Boundary]  = Points[BoundaryIndices[Boundary]];
+			BoundaryLengths[Boundary] = (Boundary == 0) ? 0.0f :
+				FVector::Dist(BoundaryPoints[Boundary - 1], BoundaryPoints[Boundary]);
+		}
+		StraightenKeyLengths(BoundaryIndices, BoneLengths, MaxReach, RequiredReach, BoundaryLengths);
+
+		SolveLocationsFABRIK(BoundaryPoints.GetData(), RootStart, BoundaryLengths.GetData(), NumBoundaries, nullptr,
+			EffectorTargetLocation, MaxRootDragDistance, RootDragStiffness, SegmentPrecision, MaxIterations);
+
+		// Solve the segments between the boundaries
+		ParallelFor(NumSegments, [&](int32 Segment)
+		{
+			int32 First          = BoundaryIndices[Segment];
+			int32 Last           = BoundaryIndices[Segment + 1];
+			FVector* SegmentData = SegmentPoints.GetData() + First + Segment;
+
+			// Carry the segment's current shape onto its new span
+			FVector OldSpan = Points[Last] - Points[First];
+			FVector NewSpan = BoundaryPoints[Segment + 1] - BoundaryPoints[Segment];
+			FQuat SpanRotation = FQuat::Identity;
+			if (OldSpan.Normalize() && NewSpan.Normalize())
+			{
+				SpanRotation = FQuat::FindBetweenNormals(OldSpan, NewSpan);
+			}
+
+			for (int32 PointIndex = First; PointIndex <= Last; ++PointIndex)
+			{
+				SegmentData[PointIndex - First] = BoundaryPoints[Segment] + SpanRotation.RotateVector(Points[PointIndex] - Points[First]);
+			}
+
+			FVector SegmentTarget = (Segment == NumSegments - 1) ? EffectorTargetLocation : BoundaryPoints[Segment + 1];
+			SolveLocationsFABRIK(
+				SegmentData,
+				BoundaryPoints[Segment],
+				BoneLengths.GetData() + First,
+				Last - First + 1,
+				CompiledConstraints != nullptr ? CompiledConstraints + First : nullptr,
+				SegmentTarget,
+				0.0f,
+				1.0f,
+				SegmentPrecision,
+				FineIterations
+			);
+		}, !bUseWorkers);
+
+		// Join the segments, root to effector: each is moved, without turning it, to start where the previous one
+		// ended. Every bone keeps its length, and the boundaries move with the segments, so the next sweep starts
+		// from the spans the segments actually reached.
+		Points[0] = SegmentPoints[0];
+		for (int32 Segment = 0; Segment < NumSegments; ++Segment)
+		{
+			int32 First                = BoundaryIndices[Segment];
+			int32 Last                 = BoundaryIndices[Segment + 1];
+			const FVector* SegmentData = SegmentPoints.GetData() + First + Segment;
+
+			FVector Offset = Points[First] - SegmentData[0];
+			for (int32 PointIndex = First + 1; PointIndex <= Last; ++PointIndex)
+			{
+				Points[PointIndex] = SegmentData[PointIndex - First] + Offset;
+			}
+		}
+
+		Slop = FVector::Dist(Points[NumPoints - 1], EffectorTargetLocation);
+	}
+	FIKSolveStats::Record(OutStats, Slop <= Precision ? EIKSolveTermination::IK_Converged :
+		EIKSolveTermination::IK_MaxIterations, NumSweeps, Slop);
+
+	// Write back locations, then update bone rotations
+	for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+	{
+		OutTransforms[PointIndex].SetLocation(Points[PointIndex]);
+	}
+
+	for (int32 PointIndex = 0; PointIndex < NumPoints - 1; ++PointIndex)
+	{
+		if (!FMath::IsNearlyZero(BoneLengths[PointIndex + 1]))
+		{
+			UpdateParentRotation(OutTransforms[PointIndex], InTransforms[PointIndex],
+				OutTransforms[PointIndex + 1], InTransforms[PointIndex + 1]);
+		}
+	}
+
+	return true;
+}
+
+bool FRangeLimitedFABRIK::SolveDampedLeastSquares(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraintTable& Constraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float Precision,
+	int32 MaxIterations,
+	float Damping,
+	EIKUnreachableRule UnreachableRule,
+	IIKDebugDrawer* DebugDrawer,
+	FIKSolveStats* OutStats)
+{
+	int32 NumPoints     = InTransforms.Num();
+	int32 EffectorIndex = NumPoints - 1;
+
+	const FIKCompiledConstraint* CompiledConstraints = nullptr;
+	if (Constraints.bHasActiveConstraints && Constraints.Num() == NumPoints)
+	{
+		CompiledConstraints = Constraints.Entries.GetData();
+	}
+
+	bool bUseFABRIK = NumPoints < 2 || (Constraints.bHasActiveConstraints && CompiledConstraints == nullptr);
+	for (int32 i = 0; CompiledConstraints != nullptr && i < NumPoints && !bUseFABRIK; ++i)
+	{
+		bUseFABRIK = CompiledConstraints[i].Type == EIKCompiledConstraintType::IKCC_Custom;
+	}
+
+	if (bUseFABRIK)
+	{
+		return SolveRangeLimitedFABRIK(InTransforms, Constraints, EffectorTargetLocation, OutTransforms,
+			0.0f, 1.0f, Precision, MaxIterations, UnreachableRule, DebugDrawer, 1.0f, 0.0f, OutStats);
+	}
+
+	// Out-of-reach targets on constrained chains are left to range-limited FABRIK, which iterates from the straight
+	// chain
+	bool bShortcutUpdated = false;
+	bool bSeeded          = false;
+	if (TrySolveUnreachable(InTransforms, CompiledConstraints, EffectorTargetLocation, OutTransforms,
+		0.0f, 1.0f, UnreachableRule, bShortcutUpdated, bSeeded))
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_Unreachable);
+		return bShortcutUpdated;
+	}
+	if (bSeeded)
+	{
+		return SolveRangeLimitedFABRIK(InTransforms, Constraints, EffectorTargetLocation, OutTransforms,
+			0.0f, 1.0f, Precision, MaxIterations, UnreachableRule, DebugDrawer, 1.0f, 0.0f, OutStats);
+	}
+
+	OutTransforms.Reset(NumPoints);
+	OutTransforms.Append(InTransforms);
+
+	float StartSlop = FVector::Dist(InTransforms[EffectorIndex].GetLocation(), EffectorTargetLocation);
+	if (StartSlop <= Precision)
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_AlreadyAtTarget, 0, StartSlop);
+		return false;
+	}
+
+	FMemMark Mark(FMemStack::Get());
+
+	// Points[i] is the location of point i; Bones[i] is the vector from point i to point i + 1
+	FScratchVectorArray Points;
+	FScratchVectorArray Bones;
+	FScratchVectorArray JointRotations;
+	Points.Reserve(NumPoints);
+	Bones.AddUninitialized(EffectorIndex);
+	JointRotations.AddUninitialized(EffectorIndex);
+
+	float ChainLength = 0.0f;
+	for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+	{
+		Points.Add(InTransforms[PointIndex].GetLocation());
+		if (PointIndex > 0)
+		{
+			Bones[PointIndex - 1] = Points[PointIndex] - Points[PointIndex - 1];
+			ChainLength += Bones[PointIndex - 1].Size();
+		}
+	}
+
+	// Keep each step small enough for the linearization to hold: limit both how far the effector is asked to move, 
+	// and how far any joint may turn (near a stretched pose, damping alone still allows large rotations)
+	const float MaxJointStepRadians = 0.35f;
+	float MaxStep        = 0.25f * ChainLength;
+	float DampingSquared = Damping * Damping;
+
+	float Slop           = FVector::Dist(Points[EffectorIndex], EffectorTargetLocation);
+	int32 IterationCount = 0;
+	bool bSingular       = false;
+	while ((Slop > Precision) && (IterationCount < MaxIterations))
+	{
+		++IterationCount;
+
+		FVector Error = (EffectorTargetLocation - Points[EffectorIndex]).GetClampedToMaxSize(MaxStep);
+
+		// Accumulate J * J^T. The Jacobian is never built: a ball joint with lever R (joint to effector) contributes 
+		// |R|^2 * I - R * R^T, and a hinge with axis A contributes C * C^T, where C = A x R.
+		FVector Row0(DampingSquared, 0.0f, 0.0f);
+		FVector Row1(0.0f, DampingSquared, 0.0f);
+		FVector Row2(0.0f, 0.0f, DampingSquared);
+		for (int32 Joint = 0; Joint < EffectorIndex; ++Joint)
+		{
+			FVector Lever = Points[EffectorIndex] - Points[Joint];
+			if (CompiledConstraints != nullptr && CompiledConstraints[Joint].Type == EIKCompiledConstraintType::IKCC_Planar)
+			{
+				FVector Column = FVector::CrossProduct(CompiledConstraints[Joint].RotationAxis, Lever);
+				Row0 += Column * Column.X;
+				Row1 += Column * Column.Y;
+				Row2 += Column * Column.Z;
+			}
+			else
+			{
+				float LeverSizeSquared = Lever.SizeSquared();
+				Row0 += FVector(LeverSizeSquared, 0.0f, 0.0f) - Lever * Lever.X;
+				Row1 += FVector(0.0f, LeverSizeSquared, 0.0f) - Lever * Lever.Y;
+				Row2 += FVector(0.0f, 0.0f, LeverSizeSquared) - Lever * Lever.Z;
+			}
+		}
+
+		// Solve (J * J^T + Damping^2 * I) * Y = Error by Cramer's rule; the matrix is symmetric positive definite
+		FVector Cross12 = FVector::CrossProduct(Row1, Row2);
+		float Determinant = FVector::DotProduct(Row0, Cross12);
+		if (FMath::Abs(Determinant) <= SMALL_NUMBER)
+		{
+			bSingular = true;
+			break;
+		}
+
+		FVector Y = FVector(
+			FVector::DotProduct(Error, Cross12),
+			FVector::DotProduct(Error, FVector::CrossProduct(Row2, Row0)),
+			FVector::DotProduct(Error, FVector::CrossProduct(Row0, Row1))) / Determinant;
+
+		// Joint rotations are J^T * Y: R x Y for a ball joint, A * (C . Y) for a hinge
+		float MaxJointStepSquared = 0.0f;
+		for (int32 Joint = 0; Joint < EffectorIndex; ++Joint)
+		{
+			FVector Lever = Points[EffectorIndex] - Points[Joint];
+			if (CompiledConstraints != nullptr && CompiledConstraints[Joint].Type == EIKCompiledConstraintType::IKCC_Planar)
+			{
+				const FVector& Axis = CompiledConstraints[Joint].RotationAxis;
+				JointRotations[Joint] = Axis * FVector::DotProduct(FVector::CrossProduct(Axis, Lever), Y);
+			}
+			else
+			{
+				JointRotations[Joint] = FVector::CrossProduct(Lever, Y);
+			}
+			MaxJointStepSquared = FMath::Max(MaxJointStepSquared, JointRotations[Joint].SizeSquared());
+		}
+
+		// Scale all rotations together, so the step keeps its direction
+		if (MaxJointStepSquared > FMath::Square(MaxJointStepRadians))
+		{
+			float StepScale = MaxJointStepRadians * FMath::InvSqrt(MaxJointStepSquared);
+			for (int32 Joint = 0; Joint < EffectorIndex; ++Joint)
+			{
+				JointRotations[Joint] *= StepScale;
+			}
+		}
+
+		// Forward kinematics. Each joint's rotation applies to every bone after it, so bone i is turned by the 
+		// rotations of joints 0..i, composed in the frame they were computed in.
+		FQuat Accumulated = FQuat::Identity;
+		for (int32 Joint = 0; Joint < EffectorIndex; ++Joint)
+		{
+			FVector RotationAxis = JointRotations[Joint];
+			float Angle          = RotationAxis.Size();
+			if (Angle > KINDA_SMALL_NUMBER)
+			{
+				Accumulated = Accumulated * FQuat(RotationAxis / Angle, Angle);
+			}
+
+			FVector Child = Points[Joint] + Accumulated.RotateVector(Bones[Joint]);
+			if (CompiledConstraints != nullptr && CompiledConstraints[Joint].Type == EIKCompiledConstraintType::IKCC_Planar)
+			{
+				Child = FPlanarRotation::EnforceCompiled(CompiledConstraints[Joint], Points[Joint], Child);
+			}
+
+			Points[Joint + 1] = Child;
+		}
+
+		for (int32 Joint = 0; Joint < EffectorIndex; ++Joint)
+		{
+			Bones[Joint] = Points[Joint + 1] - Points[Joint];
+		}
+
+		Slop = FVector::Dist(Points[EffectorIndex], EffectorTargetLocation);
+	}
+	// A singular step can't make progress, however many iterations are left
+	FIKSolveStats::Record(OutStats, Slop <= Precision ? EIKSolveTermination::IK_Converged :
+		(bSingular ? EIKSolveTermination::IK_Stagnated : EIKSolveTermination::IK_MaxIterations), IterationCount, Slop);
+
+	// Write back locations, then update bone rotations
+	for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+	{
+		OutTransforms[PointIndex].SetLocation(Points[PointIndex]);
+	}
+
+	for (int32 PointIndex = 0; PointIndex < EffectorIndex; ++PointIndex)
+	{
+		if (!Bones[PointIndex].IsNearlyZero())
+		{
+			UpdateParentRotation(OutTransforms[PointIndex], InTransforms[PointIndex],
+				OutTransforms[PointIndex + 1], InTransforms[PointIndex + 1]);
+		}
+	}
+
+	return true;
+}
+
+bool FRangeLimitedFABRIK::SolveSplineIK(
+	const TArray<FTransform>& InTransforms,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	const TArray<FVector>& ControlPoints,
+	const TArray<float>& ArcLengths,
+	float Precision,
+	int32 MaxIterations,
+	EIKUnreachableRule UnreachableRule,
+	IIKDebugDrawer* DebugDrawer,
+	FIKSolveStats* OutStats)
+{
+	int32 NumPoints     = InTransforms.Num();
+	int32 EffectorIndex = NumPoints - 1;
+
+	OutTransforms.Reset(NumPoints);
+	OutTransforms.Append(InTransforms);
+
+	if (NumPoints < 2)
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_NotSolved);
+		return false;
+	}
+
+	// Out of reach, no curve fits; the chain is laid straight as by the other solvers
+	bool bShortcutUpdated = false;
+	bool bSeeded          = false;
+	if (TrySolveUnreachable(InTransforms, nullptr, EffectorTargetLocation, OutTransforms, 0.0f, 1.0f,
+		UnreachableRule, bShortcutUpdated, bSeeded))
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_Unreachable);
+		return bShortcutUpdated;
+	}
+
+	float StartSlop = FVector::Dist(InTransforms[EffectorIndex].GetLocation(), EffectorTargetLocation);
+	if (StartSlop <= Precision)
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_AlreadyAtTarget, 0, StartSlop);
+		return false;
+	}
+
+	FMemMark Mark(FMemStack::Get());
+
+	// Bone lengths from the table, if it fits this chain
+	FScratchFloatArray BoneLengths;
+	float ChainLength;
+	if (ArcLengths.Num() == NumPoints)
+	{
+		BoneLengths.AddUninitialized(NumPoints);
+		BoneLengths[0] = 0.0f;
+		for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+		{
+			BoneLengths[PointIndex] = ArcLengths[PointIndex] - ArcLengths[PointIndex - 1];
+		}
+		ChainLength = ArcLengths[EffectorIndex];
+	}
+	else
+	{
+		ChainLength = ComputeBoneLengths(InTransforms, BoneLengths);
+	}
+
+	FScratchVectorArray Points;
+	Points.AddUninitialized(NumPoints);
+
+	FVector Root = InTransforms[0].GetLocation();
+	Points[0]    = Root;
+
+	FVector StartDirection = (InTransforms[1].GetLocation() - Root).GetSafeNormal();
+	FVector ToTarget       = EffectorTargetLocation - Root;
+	float Distance         = ToTarget.Size();
+	FVector Chord          = Distance > KINDA_SMALL_NUMBER ? ToTarget / Distance : StartDirection;
+
+	int32 NumBones   = NumPoints - 1;
+	int32 Iterations = 0;
+
+	if (NumBones == 1)
+	{
+		// Nothing to bend; just aim the bone
+		Points[1] = Root + Chord * BoneLengths[1];
+	}
+	else
+	{
+		if (NumBones == 2)
+		{
+			// The two bones below solve this on their own, keeping the bend they have
+			Points[1] = InTransforms[1].GetLocation();
+		}
+		else
+		{
+			// Which way the curve bows, perpendicular to the chord, as it leaves the root and as it reaches the target.
+			// Failing the control points and the first bone, the chain's own bend; failing that, any way at all.
+			FVector RootBow;
+			FVector TargetBow;
+			if (ControlPoints.Num() > 0)
+			{
+				RootBow   = FVector::VectorPlaneProject(ControlPoints[0] - Root, Chord).GetSafeNormal();
+				TargetBow = FVector::VectorPlaneProject(ControlPoints.Last() - EffectorTargetLocation,
+					Chord).GetSafeNormal();
+			}
+			else
+			{
+				RootBow   = FVector::VectorPlaneProject(StartDirection, Chord).GetSafeNormal();
+				TargetBow = RootBow;
+			}
+
+			if (RootBow.IsZero())
+			{
+				RootBow = TargetBow;
+			}
+			if (RootBow.IsZero())
+			{
+				RootBow = FVector::VectorPlaneProject(InTransforms[EffectorIndex].GetLocation() - Root,
+					Chord).GetSafeNormal();
+			}
+			if (RootBow.IsZero())
+			{
+				FVector Unused;
+				Chord.FindBestAxisVectors(RootBow, Unused);
+			}
+			if (TargetBow.IsZero())
+			{
+				TargetBow = RootBow;
+			}
+
+			// The curve's total bend, from leaving the root to reaching the target. Its end tangents are those of a
+			// circular arc with this bend over the chord, which is straight at 0 and loops right round at 2 * PI.
+			const float MaxBend = 0.98f * 2.0f * PI;
+
+			// Start from the bend of a chain of equal bones inscribed in a circle, reaching the target: solve
+			// sin(Bend / 2) = (Distance / MeanBoneLength) * sin(Bend / (2 * NumBones)) by bisection. The left side
+			// minus the right is positive for small bends, and negative at a full loop.
+			float DistanceInBones = Distance * NumBones / ChainLength;
+			float Low             = 0.0f;
+			float High            = MaxBend;
+			for (int32 Step = 0; Step < 24; ++Step)
+			{
+				float Middle = 0.5f * (Low + High);
+				if (FMath::Sin(0.5f * Middle) > DistanceInBones * FMath::Sin(0.5f * Middle / NumBones))
+				{
+					Low = Middle;
+				}
+				else
+				{
+					High = Middle;
+				}
+			}
+
+			// Sample the curve finely enough that no bone spans less than a few steps
+			int32 NumSteps = FMath::Max(16, 4 * NumBones);
+
+			// Fit the bend to the chain. A walk that ends past the target means the curve is too short, so the bend
+			// goes up. The first step nudges the starting bend; then secant steps, kept inside the bracket found so
+			// far, bisecting when they'd leave it.
+			float Bend         = 0.5f * (Low + High);
+			float PrevBend     = 0.0f;
+			float PrevResidual = 0.0f;
+			Low                = 0.0f;
+			High               = MaxBend;
+			int32 MaxSteps     = FMath::Max(MaxIterations, 1);
+
+			for (;;)
+			{
+				float HalfBend     = 0.5f * Bend;
+				float TangentSize  = Distance / FMath::Square(FMath::Cos(0.25f * Bend));
+				FVector AlongChord = Chord * FMath::Cos(HalfBend);
+				float Across       = FMath::Sin(HalfBend);
+
+				float Residual = WalkSplineCurve(Root, (AlongChord + RootBow * Across) * TangentSize,
+					EffectorTargetLocation, (AlongChord - TargetBow * Across) * TangentSize, NumSteps,
+					BoneLengths.GetData(), NumPoints, Points.GetData());
+				++Iterations;
+
+				if (FMath::Abs(Residual) <= Precision || Iterations >= MaxSteps)
+				{
+					break;
+				}
+
+				if (Residual > 0.0f)
+				{
+					Low = Bend;
+				}
+				else
+				{
+					High = Bend;
+				}
+
+				float NextBend = Bend + (Residual > 0.0f ? 0.05f : -0.05f);
+				if (Iterations > 1 && Residual != PrevResidual)
+				{
+					NextBend = Bend - Residual * (Bend - PrevBend) / (Residual - PrevResidual);
+				}
+				if (!(NextBend > Low && NextBend < High))
+				{
+					NextBend = 0.5f * (Low + High);
+				}
+
+				PrevBend     = Bend;
+				PrevResidual = Residual;
+				Bend         = NextBend;
+			}
+		}
+
+		// The last two bones close what's left of the gap: the effector goes on the target, and the point before it
+		// on the circle of points a bone's length from both its parent and the target, nearest where the walk put it.
+		// Targets too far or too near for them leave the two bones straight, or folded, toward the target.
+		int32 KneeIndex    = EffectorIndex - 1;
+		const FVector Base = Points[KneeIndex - 1];
+		float UpperLength  = BoneLengths[KneeIndex];
+		float LowerLength  = BoneLengths[EffectorIndex];
+
+		FVector BaseToTarget = EffectorTargetLocation - Base;
+		float BaseDistance   = BaseToTarget.Size();
+		FVector Axis         = BaseDistance > KINDA_SMALL_NUMBER ? BaseToTarget / BaseDistance : Chord;
+
+		if (BaseDistance >= UpperLength + LowerLength)
+		{
+			Points[KneeIndex]     = Base + Axis * UpperLength;
+			Points[EffectorIndex] = Points[KneeIndex] + Axis * LowerLength;
+		}
+		else if (BaseDistance <= FMath::Abs(UpperLength - LowerLength))
+		{
+			Points[KneeIndex] = Base + Axis * (UpperLength >= LowerLength ? UpperLength : -UpperLength);
+
+			FVector KneeToTarget = (EffectorTargetLocation - Points[KneeIndex]).GetSafeNormal();
+			Points[EffectorIndex] = Points[KneeIndex] + (KneeToTarget.IsZero() ? Axis : KneeToTarget) * LowerLength;
+		}
+		else
+		{
+			float AlongAxis = (BaseDistance * BaseDistance + UpperLength * UpperLength - LowerLength * LowerLength) /
+				(2.0f * BaseDistance);
+			float Radius    = FMath::Sqrt(FMath::Max(UpperLength * UpperLength - AlongAxis * AlongAxis, 0.0f));
+
+			FVector Outward = FVector::VectorPlaneProject(Points[KneeIndex] - Base, Axis);
+			if (!Outward.Normalize())
+			{
+				FVector Unused;
+				Axis.FindBestAxisVectors(Outward, Unused);
+			}
+
+			Points[KneeIndex]     = Base + Axis * AlongAxis + Outward * Radius;
+			Points[EffectorIndex] = EffectorTargetLocation;
+		}
+	}
+
+	float FinalSlop = FVector::Dist(Points[EffectorIndex], EffectorTargetLocation);
+	FIKSolveStats::Record(OutStats, FinalSlop <= Precision ? EIKSolveTermination::IK_Converged :
+		EIKSolveTermination::IK_MaxIterations, Iterations, FinalSlop);
+
+	for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+	{
+		OutTransforms[PointIndex].SetLocation(Points[PointIndex]);
+	}
+
+	for (int32 PointIndex = 0; PointIndex < EffectorIndex; ++PointIndex)
+	{
+		if (!FVector::PointsAreNear(OutTransforms[PointIndex].GetLocation(),
+			OutTransforms[PointIndex + 1].GetLocation(), KINDA_SMALL_NUMBER))
+		{
+			UpdateParentRotation(OutTransforms[PointIndex], InTransforms[PointIndex],
+				OutTransforms[PointIndex + 1], InTransforms[PointIndex + 1]);
+		}
+	}
+
+	return true;
+}
+
+float FRangeLimitedFABRIK::WalkSplineCurve(
+	const FVector& Root,
+	const FVector& StartTangent,
+	const FVector& Target,
+	const FVector& EndTangent,
+	int32 NumSteps,
+	const float* BoneLengths,
+	int32 NumPoints,
+	FVector* OutPoints)
+{
+	float StepAlpha = 1.0f / NumSteps;
+
+	FVector ExitDirection = (Target - FMath::CubicInterp(Root, StartTangent, Target, EndTangent,
+		(NumSteps - 1) * StepAlpha)).GetSafeNormal();
+	if (ExitDirection.IsZero())
+	{
+		ExitDirection = (Target - Root).GetSafeNormal();
+	}
+
+	// Each point lies on the step from StepStart to StepEnd, and the next point is searched for from there
+	OutPoints[0]      = Root;
+	FVector StepStart = Root;
+	FVector StepEnd   = FMath::CubicInterp(Root, StartTangent, Target, EndTangent, StepAlpha);
+	int32 Step        = 1;
+
+	for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+	{
+		const FVector& Parent   = OutPoints[PointIndex - 1];
+		float BoneLengthSquared = BoneLengths[PointIndex] * BoneLengths[PointIndex];
+
+		while (Step <= NumSteps && FVector::DistSquared(Parent, StepEnd) < BoneLengthSquared)
+		{
+			StepStart = StepEnd;
+			++Step;
+			StepEnd   = FMath::CubicInterp(Root, StartTangent, Target, EndTangent, Step * StepAlpha);
+		}
+
+		if (Step > NumSteps)
+		{
+			OutPoints[PointIndex] = Parent + ExitDirection * BoneLengths[PointIndex];
+			continue;
+		}
+
+		// StepStart is inside the bone's sphere around Parent and StepEnd isn't: solve for where the step crosses
+		// it, |StepStart + Alpha * StepSpan - Parent| = BoneLength
+		FVector StepSpan   = StepEnd - StepStart;
+		FVector FromParent = StepStart - Parent;
+		float A     = StepSpan.SizeSquared();
+		float HalfB = FVector::DotProduct(FromParent, StepSpan);
+		float C     = FromParent.SizeSquared() - BoneLengthSquared;
+		float Alpha = (A > SMALL_NUMBER) ?
+			FMath::Clamp((-HalfB + FMath::Sqrt(FMath::Max(HalfB * HalfB - A * C, 0.0f))) / A, 0.0f, 1.0f) : 1.0f;
+
+		OutPoints[PointIndex] = StepStart + StepSpan * Alpha;
+		StepStart             = OutPoints[PointIndex];
+	}
+
+	const FVector& Effector = OutPoints[NumPoints - 1];
+	if (Step > NumSteps)
+	{
+		return FVector::DotProduct(Effector - Target, ExitDirection);
+	}
+
+	// Short of the target: the rest of the curve's length
+	float Remaining = FVector::Dist(Effector, StepEnd);
+	while (Step < NumSteps)
+	{
+		++Step;
+		FVector Next = FMath::CubicInterp(Root, StartTangent, Target, EndTangent, Step * StepAlpha);
+		Remaining   += FVector::Dist(StepEnd, Next);
+		StepEnd      = Next;
+	}
+
+	return -Remaining;
+}
+
+bool FRangeLimitedFABRIK::SolveClosedLoopFABRIK(
+	const TArray<FTransform>& InTransforms,
+	const TArray<FIKBoneConstraint*>& Constraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	IIKDebugDrawer* DebugDrawer,
+	float Relaxation,
+	float StagnationRatio,
+	FIKSolveStats* OutStats
+)
+{
+	FMemMark Mark(FMemStack::Get());
+
+	FScratchConstraintArray CompiledConstraints;
+	bool bHasActiveConstraints = FIKCompiledConstraintTable::CompileEntries(Constraints, CompiledConstraints);
+
+	return SolveClosedLoopFABRIKCompiled(
+		InTransforms,
+		Constraints,
+		bHasActiveConstraints ? CompiledConstraints.GetData() : nullptr,
+		EffectorTargetLocation,
+		OutTransforms,
+		MaxRootDragDistance,
+		RootDragStiffness,
+		Precision,
+		MaxIterations,
+		DebugDrawer,
+		Relaxation,
+		StagnationRatio,
+		OutStats
+	);
+}
+
+bool FRangeLimitedFABRIK::SolveClosedLoopFABRIK(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraintTable& Constraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	IIKDebugDrawer* DebugDrawer,
+	float Relaxation,
+	float StagnationRatio,
+	FIKSolveStats* OutStats
+)
+{
+	return SolveClosedLoopFABRIKCompiled(
+		InTransforms,
+		Constraints.Constraints,
+		Constraints.bHasActiveConstraints ? Constraints.Entries.GetData() : nullptr,
+		EffectorTargetLocation,
+		OutTransforms,
+		MaxRootDragDistance,
+		RootDragStiffness,
+		Precision,
+		MaxIterations,
+		DebugDrawer,
+		Relaxation,
+		StagnationRatio,
+		OutStats
+	);
+}
+
+bool FRangeLimitedFABRIK::SolveClosedLoopFABRIKCompiled(
+	const TArray<FTransform>& InTransforms,
+	const TArray<FIKBoneConstraint*>& Constraints,
+	const FIKCompiledConstraint* CompiledConstraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	IIKDebugDrawer* DebugDrawer,
+	float Relaxation,
+	float StagnationRatio,
+	FIKSolveStats* OutStats
+)
+{
+	FMemMark Mark(FMemStack::Get());
+
+	// Number of points in the chain. Number of bones = NumPoints - 1
+	int32 NumPoints = InTransforms.Num();
+	int32 EffectorIndex       = NumPoints - 1;
+
+	// Gather bone transforms. Reset keeps the caller's allocation.
+	OutTransforms.Reset(NumPoints);
+	OutTransforms.Append(InTransforms);
+
+	if (NumPoints < 2)
+	{
+		// Need at least one bone to do IK!
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_NotSolved);
+		return false;
+	}
+	// Gather bone lengths. BoneLengths contains the length of the bone ENDING at this point,
+	
+	// i.e., BoneLengths[i] contains the distance between point i-1 and point i
+	FScratchFloatArray BoneLengths;
+	float MaximumReach = ComputeBoneLengths(InTransforms, BoneLengths);
+	float RootToEffectorLength = FVector::Dist(InTransforms[0].GetLocation(), InTransforms[EffectorIndex].GetLocation());
+
+	bool bBoneLocationUpdated = false;
+
+	// Point locations at the start of each iteration, for over-relaxation
+	bool bRelax = !FMath::IsNearlyEqual(Relaxation, 1.0f);
+	FScratchVectorArray PreviousLocations;
+	if (bRelax)
+	{
+		PreviousLocations.AddUninitialized(NumPoints);
+	}
+	
+	// Check distance between tip location and effector location
+	float Slop = FVector::Dist(OutTransforms[EffectorIndex].GetLocation(), EffectorTargetLocation);
+	if (Slop > Precision)
+	{
+		// The closed loop method is identical, except the root is dragged a second time to maintain
+		// distance with the effector.		
+
+		// Set tip bone at end effector location.
+		OutTransforms[EffectorIndex].SetLocation(EffectorTargetLocation);
+		
+		FIKIterationMonitor Monitor(Precision, MaxIterations, StagnationRatio);
+		while (Monitor.ShouldContinue(Slop))
+		{
+			if (bRelax)
+			{
+				for (int32 PointIndex = 1; PointIndex < EffectorIndex; ++PointIndex)
+				{
+					PreviousLocations[PointIndex] = OutTransforms[PointIndex].GetLocation();
+				}
+			}
+
+			// "Forward Reaching" stage - adjust bones from end effector.
+			FABRIKForwardPass(
+				InTransforms,
+				Constraints,
+				CompiledConstraints,
+				BoneLengths,
+				OutTransforms,
+				DebugDrawer
+			);
+			
+			// Drag the root if enabled
+			DragPointTethered(
+				InTransforms[0],
+				OutTransforms[1],
+				BoneLengths[1],
+				MaxRootDragDistance,
+				RootDragStiffness,
+				OutTransforms[0]
+			);
+
+			// Drag the root again, toward the effector (since they're connected in a closed loop)
+			DragPointTethered(
+				InTransforms[0],
+				OutTransforms[EffectorIndex],
+				RootToEffectorLength,
+				MaxRootDragDistance,
+				RootDragStiffness,
+				OutTransforms[0]
+			);
+
+			if (bRelax)
+			{
+				RelaxPoints(PreviousLocations, Relaxation, OutTransforms);
+			}
+
+			// "Backward Reaching" stage - adjust bones from root.
+			FABRIKBackwardPass(
+				InTransforms,
+				Constraints,
+				CompiledConstraints,
+				BoneLengths,
+				OutTransforms,
+				DebugDrawer
+			);
+
+			Slop = FVector::Dist(OutTransforms[EffectorIndex].GetLocation(), EffectorTargetLocation);
+		}
+		Monitor.Report(OutStats);
+				
+		bBoneLocationUpdated = true;
+	}
+	else
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_AlreadyAtTarget, 0, Slop);
+	}
+	
+	// Update bone rotations
+	if (bBoneLocationUpdated)
+	{
+		for (int32 PointIndex = 0; PointIndex < NumPoints - 1; ++PointIndex)
+		{
+			if (!FMath::IsNearlyZero(BoneLengths[PointIndex + 1]))
+			{
+				UpdateParentRotation(OutTransforms[PointIndex], InTransforms[PointIndex],
+					OutTransforms[PointIndex + 1], InTransforms[PointIndex + 1]);
+			}
+		}
+
+		// Update the last bone's rotation. Unlike normal fabrik, it's assumed to point toward the root bone,
+		// so it's rotation must be updated
+		if (!FMath::IsNearlyZero(RootToEffectorLength))
+		{
+			UpdateParentRotation(OutTransforms[EffectorIndex], InTransforms[EffectorIndex],
+				OutTransforms[0], InTransforms[0]);
+		}
+	}
+
+	return bBoneLocationUpdated;
+};
+
+bool FRangeLimitedFABRIK::SolveNoisyThreePoint(
+	const FNoisyThreePointClosedLoop& InClosedLoop,
+	const FTransform& EffectorAReference,
+	const FTransform& EffectorBReference,
+	FNoisyThreePointClosedLoop& OutClosedLoop,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	IIKDebugDrawer* DebugDrawer
+)
+{
+	// Temporary transforms for each point
+	FTransform A    = InClosedLoop.EffectorATransform;
+	FTransform B    = InClosedLoop.EffectorBTransform;
+	FTransform Root = InClosedLoop.RootTransform;
+
+	// Compute bone lengths
+	float DistAToRoot = InClosedLoop.TargetRootADistance;
+	float DistBToRoot = InClosedLoop.TargetRootBDistance;
+	float DistAToB    = InClosedLoop.TargetABDistance;
+	float DistARef    = FVector::Dist(A.GetLocation(), EffectorAReference.GetLocation());
+	float DistBRef    = FVector::Dist(B.GetLocation(), EffectorBReference.GetLocation());
+
+	// Now start the noisy solver method. The idea here is that A, B, and Root are out of whack;
+	// move them so inter-joint distances are satisfied again. Keep doing this until things settle down.
+
+	// See www.andreasaristidou.com/publications/papers/Extending_FABRIK_with_Model_Cοnstraints.pdf Figure 9 for
+	// description of each phase. Hopefully I'm implementing this right; unfortunatley the paper is vague
+
+	FVector LastA = A.GetLocation();
+	FVector LastB = B.GetLocation();
+
+	int32 IterationCount = 0;
+
+	// Phase 1 (Fig. 9 b): go around the loop
+	DragPoint(Root, DistAToRoot, A);
+	DragPoint(A, DistAToB, B);
+	DragPointTethered(InClosedLoop.RootTransform, B, DistBToRoot, MaxRootDragDistance, RootDragStiffness, Root);
+	DragPoint(Root, DistAToRoot, A);
+
+	// Phase 2 (Fig. 9 c): Reset root and go other way
+	Root.SetLocation(InClosedLoop.RootTransform.GetLocation());
+	DragPoint(Root, DistBToRoot, B);
+	DragPoint(B, DistAToB, A);
+
+	// Phase 3 (Fig. 9 d): Drag both effectors such that their distances to reference points (outside the closed loop)
+	// and distances from root are maintained
+	DragPoint(Root, DistAToRoot, A);
+	DragPoint(EffectorAReference, DistARef, A);	
+	DragPoint(Root, DistBToRoot, B);
+	DragPoint(EffectorBReference, DistBRef, B);	
+
+	// Phase 4 (Fig. 9 b): Same as phase 1
+	DragPoint(Root, DistAToRoot, A);
+	DragPoint(A, DistAToB, B);
+	DragPointTethered(InClosedLoop.RootTransform, B, DistBToRoot, MaxRootDragDistance, RootDragStiffness, Root);
+	DragPoint(Root, DistAToRoot, A);
+
+	// Phase 5 (Fig. 9 c): Same as phase 2, but don't reset root
+	DragPoint(Root, DistBToRoot, B);
+	DragPoint(B, DistAToB, A);
+
+	float PrecisionSq = Precision * Precision;
+	float Delta = FMath::Max(FVector::DistSquared(A.GetLocation(), LastA), FVector::DistSquared(B.GetLocation(), LastB));
+	LastA = A.GetLocation();
+	LastB = B.GetLocation();
+
+	while ((Delta > PrecisionSq) && (IterationCount++ < MaxIterations))
+	{
+		// Iterate phases 3-5 only
+		// Phase 3
+		DragPoint(Root, DistAToRoot, A);
+		DragPoint(EffectorAReference, DistARef, A);
+		DragPoint(Root, DistBToRoot, B);
+		DragPoint(EffectorBReference, DistBRef, B);
+		
+		// Phase 4
+		DragPoint(Root, DistAToRoot, A);
+		DragPoint(A, DistAToB, B);
+		DragPointTethered(InClosedLoop.RootTransform, B, DistBToRoot, MaxRootDragDistance, RootDragStiffness, Root);
+		DragPoint(Root, DistAToRoot, A);
+				
+		// Phase 5
+		DragPoint(Root, DistBToRoot, B);
+		DragPoint(B, DistAToB, A);
+
+		Delta = FMath::Max(FVector::DistSquared(A.GetLocation(), LastA), FVector::DistSquared(B.GetLocation(), LastB));
+		LastA = A.GetLocation();
+		LastB = B.GetLocation();		
+	}
+	
+	// Update rotations
+	if (!FMath::IsNearlyZero(DistAToRoot))
+	{
+		UpdateParentRotation(Root, InClosedLoop.RootTransform, A, InClosedLoop.EffectorATransform);
+	}
+	
+	if (!FMath::IsNearlyZero(DistAToB))
+	{
+		UpdateParentRotation(A, InClosedLoop.EffectorATransform, B, InClosedLoop.EffectorBTransform);
+	}
+
+	if (!FMath::IsNearlyZero(DistBToRoot))
+	{
+		UpdateParentRotation(B, InClosedLoop.EffectorBTransform, Root, InClosedLoop.RootTransform);
+	}
+	
+	// Copy transforms to output
+	OutClosedLoop.EffectorATransform = A;
+	OutClosedLoop.EffectorBTransform = B;
+	OutClosedLoop.RootTransform = Root;
+
+	return true;
+}
+
+bool FRangeLimitedFABRIK::SolveRigidThreePoint(
+	const FNoisyThreePointClosedLoop& InClosedLoop,
+	const FTransform& EffectorATarget,
+	const FTransform& EffectorBTarget,
+	FNoisyThreePointClosedLoop& OutClosedLoop,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	FIKSolveStats* OutStats
+)
+{
+	OutClosedLoop = InClosedLoop;
+
+	float RootA = InClosedLoop.TargetRootADistance;
+	float RootB = InClosedLoop.TargetRootBDistance;
+	float AB    = InClosedLoop.TargetABDistance;
+	if (RootA < KINDA_SMALL_NUMBER)
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_NotSolved);
+		return false;
+	}
+
+	// Lay out the rigid triangle on a plane: root at the origin, A along the X axis, B above it
+	float RefBX = (RootA * RootA + RootB * RootB - AB * AB) / (2.0f * RootA);
+	float RefBY = FMath::Sqrt(FMath::Max(0.0f, RootB * RootB - RefBX * RefBX));
+	if (RefBY < KINDA_SMALL_NUMBER)
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_NotSolved);
+		return false;
+	}
+
+	FVector2D RefPoints[3] = { FVector2D(0.0f, 0.0f), FVector2D(RootA, 0.0f), FVector2D(RefBX, RefBY) };
+
+	FVector RootStart = InClosedLoop.RootTransform.GetLocation();
+	FVector Targets[3] = { RootStart, EffectorATarget.GetLocation(), EffectorBTarget.GetLocation() };
+	float Weights[3]   = { FMath::Max(RootDragStiffness, KINDA_SMALL_NUMBER), 1.0f, 1.0f };
+	float TotalWeight  = Weights[0] + Weights[1] + Weights[2];
+
+	// The fitted triangle lies in the plane through the targets, and keeps the winding (root, A, B) of the input loop.
+	// If the targets wind the other way, lay the triangle out mirrored, so it is not fitted flipped over.
+	FVector InNormal = FVector::CrossProduct(
+		InClosedLoop.EffectorATransform.GetLocation() - RootStart,
+		InClosedLoop.EffectorBTransform.GetLocation() - RootStart);
+	FVector Normal = FVector::CrossProduct(Targets[1] - Targets[0], Targets[2] - Targets[0]);
+	if (!Normal.Normalize())
+	{
+		Normal = InNormal.GetSafeNormal();
+		if (Normal.IsZero())
+		{
+			FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_NotSolved);
+			return false;
+		}
+	}
+	else if (FVector::DotProduct(Normal, InNormal) < 0.0f)
+	{
+		for (FVector2D& Point : RefPoints)
+		{
+			Point.Y = -Point.Y;
+		}
+	}
+
+	// Basis for the plane
+	FVector PlaneX = FVector::VectorPlaneProject(Targets[1] - Targets[0], Normal);
+	if (!PlaneX.Normalize())
+	{
+		FVector Unused;
+		Normal.FindBestAxisVectors(PlaneX, Unused);
+	}
+	FVector PlaneY = FVector::CrossProduct(Normal, PlaneX);
+
+	// Weighted centroids
+	FVector TargetCentroid(0.0f);
+	FVector2D RefCentroid(0.0f, 0.0f);
+	for (int32 i = 0; i < 3; ++i)
+	{
+		TargetCentroid += Targets[i] * Weights[i];
+		RefCentroid    += RefPoints[i] * Weights[i];
+	}
+	TargetCentroid /= TotalWeight;
+	RefCentroid    /= TotalWeight;
+
+	// The best in-plane rotation is a 2D Procrustes problem: its cosine and sine are proportional to the
+	// weighted sums of dot and cross products of the centered point pairs
+	FVector2D TargetPlanar[3];
+	float SumDot   = 0.0f;
+	float SumCross = 0.0f;
+	for (int32 i = 0; i < 3; ++i)
+	{
+		FVector Centered  = Targets[i] - TargetCentroid;
+		TargetPlanar[i]   = FVector2D(FVector::DotProduct(Centered, PlaneX), FVector::DotProduct(Centered, PlaneY));
+		FVector2D Ref     = RefPoints[i] - RefCentroid;
+		SumDot           += Weights[i] * (Ref.X * TargetPlanar[i].X + Ref.Y * TargetPlanar[i].Y);
+		SumCross         += Weights[i] * (Ref.X * TargetPlanar[i].Y - Ref.Y * TargetPlanar[i].X);
+	}
+
+	float RotationLength = FMath::Sqrt(SumDot * SumDot + SumCross * SumCross);
+	float Cos = 1.0f;
+	float Sin = 0.0f;
+	if (RotationLength > SMALL_NUMBER)
+	{
+		Cos = SumDot / RotationLength;
+		Sin = SumCross / RotationLength;
+	}
+
+	FVector Fitted[3];
+	for (int32 i = 0; i < 3; ++i)
+	{
+		FVector2D Ref = RefPoints[i] - RefCentroid;
+		Fitted[i] = TargetCentroid +
+			PlaneX * (Cos * Ref.X - Sin * Ref.Y) +
+			PlaneY * (Sin * Ref.X + Cos * Ref.Y);
+	}
+
+	// Limit root drag by shifting the whole triangle
+	FVector RootDisplacement = Fitted[0] - RootStart;
+	FVector LimitedDisplacement = (MaxRootDragDistance < KINDA_SMALL_NUMBER) ? FVector::ZeroVector :
+		RootDisplacement.GetClampedToMaxSize(MaxRootDragDistance);
+	FVector Shift = LimitedDisplacement - RootDisplacement;
+
+	OutClosedLoop.RootTransform.SetLocation(Fitted[0] + Shift);
+	OutClosedLoop.EffectorATransform.SetLocation(Fitted[1] + Shift);
+	OutClosedLoop.EffectorBTransform.SetLocation(Fitted[2] + Shift);
+
+	// Update rotations
+	UpdateParentRotation(OutClosedLoop.RootTransform, InClosedLoop.RootTransform,
+		OutClosedLoop.EffectorATransform, InClosedLoop.EffectorATransform);
+
+	if (!FMath::IsNearlyZero(AB))
+	{
+		UpdateParentRotation(OutClosedLoop.EffectorATransform, InClosedLoop.EffectorATransform,
+			OutClosedLoop.EffectorBTransform, InClosedLoop.EffectorBTransform);
+	}
+
+	if (!FMath::IsNearlyZero(RootB))
+	{
+		UpdateParentRotation(OutClosedLoop.EffectorBTransform, InClosedLoop.EffectorBTransform,
+			OutClosedLoop.RootTransform, InClosedLoop.RootTransform);
+	}
+
+	FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_Converged, 0, FMath::Max(
+		FVector::Dist(OutClosedLoop.EffectorATransform.GetLocation(), Targets[1]),
+		FVector::Dist(OutClosedLoop.EffectorBTransform.GetLocation(), Targets[2])));
+	return true;
+}
+
+bool FRangeLimitedFABRIK::SolveTreeFABRIK(
+	const TArray<FTransform>& InTransforms,
+	const TArray<int32>& ParentIndices,
+	const TArray<FIKCompiledConstraint>& Constraints,
+	const TArray<int32>& EffectorIndices,
+	const TArray<FVector>& EffectorTargets,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	FIKSolveStats* OutStats)
+{
+	FMemMark Mark(FMemStack::Get());
+
+	int32 NumPoints    = InTransforms.Num();
+	int32 NumEffectors = EffectorIndices.Num();
+
+	OutTransforms.Reset(NumPoints);
+	OutTransforms.Append(InTransforms);
+
+	if (NumPoints < 2 || NumEffectors == 0 || ParentIndices.Num() != NumPoints || EffectorTargets.Num() != NumEffectors)
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_NotSolved);
+		return false;
+	}
+
+	const FIKCompiledConstraint* CompiledConstraints = (Constraints.Num() == NumPoints) ? Constraints.GetData() : nullptr;
+
+	// Bone lengths, indexed by the point the bone ends at
+	FScratchFloatArray BoneLengths;
+	BoneLengths.AddUninitialized(NumPoints);
+	BoneLengths[0] = 0.0f;
+
+	if (ParentIndices[0] != INDEX_NONE)
+	{
+#if ENABLE_IK_DEBUG
+		UE_LOG(LogRTIK, Warning, TEXT("Tree FABRIK: point 0 must be the root"));
+#endif // ENABLE_IK_DEBUG
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_NotSolved);
+		return false;
+	}
+
+	for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+	{
+		int32 ParentIndex = ParentIndices[PointIndex];
+		if (ParentIndex < 0 || ParentIndex >= PointIndex)
+		{
+#if ENABLE_IK_DEBUG
+			UE_LOG(LogRTIK, Warning, TEXT("Tree FABRIK: point %d must have a parent, stored before it"), PointIndex);
+#endif // ENABLE_IK_DEBUG
+			FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_NotSolved);
+			return false;
+		}
+		BoneLengths[PointIndex] = FVector::Dist(InTransforms[ParentIndex].GetLocation(), InTransforms[PointIndex].GetLocation());
+	}
+
+	// Which effector each point is (if any), and whether a point leads to any effector
+	FScratchIndexArray EffectorSlots;
+	FScratchIndexArray ActiveFlags;
+	EffectorSlots.Init(INDEX_NONE, NumPoints);
+	ActiveFlags.Init(0, NumPoints);
+
+	for (int32 Slot = 0; Slot < NumEffectors; ++Slot)
+	{
+		int32 EffectorIndex = EffectorIndices[Slot];
+		if (EffectorIndex <= 0 || EffectorIndex >= NumPoints)
+		{
+#if ENABLE_IK_DEBUG
+			UE_LOG(LogRTIK, Warning, TEXT("Tree FABRIK: effector index %d is the root, or out of range"), EffectorIndex);
+#endif // ENABLE_IK_DEBUG
+			FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_NotSolved);
+			return false;
+		}
+
+		EffectorSlots[EffectorIndex] = Slot;
+		for (int32 PointIndex = EffectorIndex; PointIndex != INDEX_NONE && !ActiveFlags[PointIndex]; PointIndex = ParentIndices[PointIndex])
+		{
+			ActiveFlags[PointIndex] = 1;
+		}
+	}
+
+	// Check distance between each effector and its target
+	float Slop = 0.0f;
+	for (int32 Slot = 0; Slot < NumEffectors; ++Slot)
+	{
+		Slop = FMath::Max(Slop, FVector::Dist(OutTransforms[EffectorIndices[Slot]].GetLocation(), EffectorTargets[Slot]));
+	}
+
+	if (Slop <= Precision)
+	{
+		FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_AlreadyAtTarget, 0, Slop);
+		return false;
+	}
+
+	// Set effectors at their targets
+	for (int32 Slot = 0; Slot < NumEffectors; ++Slot)
+	{
+		OutTransforms[EffectorIndices[Slot]].SetLocation(EffectorTargets[Slot]);
+	}
+
+	// Per-point sum and count of the locations its children drag it to
+	FScratchVectorArray ChildPulls;
+	FScratchIndexArray ChildPullCounts;
+	ChildPulls.AddUninitialized(NumPoints);
+	ChildPullCounts.AddUninitialized(NumPoints);
+
+	FIKIterationMonitor Monitor(Precision, MaxIterations, 0.0f);
+	while (Monitor.ShouldContinue(Slop))
+	{
+		// "Forward Reaching" stage - from the effectors toward the root, visiting children before parents
+		FMemory::Memzero(ChildPulls.GetData(), NumPoints * sizeof(FVector));
+		FMemory::Memzero(ChildPullCounts.GetData(), NumPoints * sizeof(int32));
+
+		for (int32 PointIndex = NumPoints - 1; PointIndex > 0; --PointIndex)
+		{
+			if (!ActiveFlags[PointIndex])
+			{
+				continue;
+			}
+
+			int32 ParentIndex = ParentIndices[PointIndex];
+
+			if (EffectorSlots[PointIndex] == INDEX_NONE)
+			{
+				// Sub-bases settle at the centroid of what their children want
+				OutTransforms[PointIndex].SetLocation(ChildPulls[PointIndex] / ChildPullCounts[PointIndex]);
+
+				if (CompiledConstraints != nullptr && CompiledConstraints[PointIndex].Type == EIKCompiledConstraintType::IKCC_Planar)
+				{
+					FPlanarRotation::EnforceCompiled(CompiledConstraints[PointIndex],
+						OutTransforms[ParentIndex].GetLocation(), OutTransforms[PointIndex]);
+				}
+			}
+
+			// Where this point would drag its parent
+			FVector PointLocation = OutTransforms[PointIndex].GetLocation();
+			ChildPulls[ParentIndex] += PointLocation +
+				(OutTransforms[ParentIndex].GetLocation() - PointLocation).GetUnsafeNormal() * BoneLengths[PointIndex];
+			++ChildPullCounts[ParentIndex];
+		}
+
+		// Drag the root if enabled
+		DragPointTethered(
+			InTransforms[0],
+			FTransform(ChildPulls[0] / ChildPullCounts[0]),
+			0.0f,
+			MaxRootDragDistance,
+			RootDragStiffness,
+			OutTransforms[0]
+		);
+
+		// "Backward Reaching" stage - from the root out, visiting parents before children. Effectors stay on target.
+		for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+		{
+			if (EffectorSlots[PointIndex] != INDEX_NONE)
+			{
+				continue;
+			}
+
+			int32 ParentIndex = ParentIndices[PointIndex];
+			DragPoint(OutTransforms[ParentIndex], BoneLengths[PointIndex], OutTransforms[PointIndex]);
+
+			if (CompiledConstraints != nullptr && CompiledConstraints[PointIndex].Type == EIKCompiledConstraintType::IKCC_Planar)
+			{
+				FPlanarRotation::EnforceCompiled(CompiledConstraints[PointIndex],
+					OutTransforms[ParentIndex].GetLocation(), OutTransforms[PointIndex]);
+			}
+		}
+
+		Slop = 0.0f;
+		for (int32 Slot = 0; Slot < NumEffectors; ++Slot)
+		{
+			int32 EffectorIndex = EffectorIndices[Slot];
+			Slop = FMath::Max(Slop, FMath::Abs(BoneLengths[EffectorIndex] -
+				FVector::Dist(OutTransforms[ParentIndices[EffectorIndex]].GetLocation(), EffectorTargets[Slot])));
+		}
+	}
+	Monitor.Report(OutStats);
+
+	// Place effectors based on how close we got to the targets
+	for (int32 Slot = 0; Slot < NumEffectors; ++Slot)
+	{
+		int32 EffectorIndex = EffectorIndices[Slot];
+		DragPoint(OutTransforms[ParentIndices[EffectorIndex]], BoneLengths[EffectorIndex], OutTransforms[EffectorIndex]);
+	}
+
+	// Update bone rotations. Each parent turns toward the centroid of its children; reuse the pull buffers.
+	FScratchVectorArray& NewChildSums = ChildPulls;
+	FScratchIndexArray& ChildCounts   = ChildPullCounts;
+	FScratchVectorArray OldChildSums;
+	OldChildSums.AddZeroed(NumPoints);
+	FMemory::Memzero(NewChildSums.GetData(), NumPoints * sizeof(FVector));
+	FMemory::Memzero(ChildCounts.GetData(), NumPoints * sizeof(int32));
+
+	for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+	{
+		if (!FMath::IsNearlyZero(BoneLengths[PointIndex]))
+		{
+			int32 ParentIndex = ParentIndices[PointIndex];
+			OldChildSums[ParentIndex] += InTransforms[PointIndex].GetLocation();
+			NewChildSums[ParentIndex] += OutTransforms[PointIndex].GetLocation();
+			++ChildCounts[ParentIndex];
+		}
+	}
+
+	for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+	{
+		if (ChildCounts[PointIndex] == 0)
+		{
+			continue;
+		}
+
+		FVector OldCentroid = OldChildSums[PointIndex] / ChildCounts[PointIndex];
+		FVector NewCentroid = NewChildSums[PointIndex] / ChildCounts[PointIndex];
+
+		// Children may balance out around a branch point
+		if (FVector::DistSquared(OldCentroid, InTransforms[PointIndex].GetLocation()) > KINDA_SMALL_NUMBER &&
+			FVector::DistSquared(NewCentroid, OutTransforms[PointIndex].GetLocation()) > KINDA_SMALL_NUMBER)
+		{
+			UpdateParentRotation(OutTransforms[PointIndex], InTransforms[PointIndex],
+				FTransform(NewCentroid), FTransform(OldCentroid));
+		}
+	}
+
+	return true;
+}
+
+FORCEINLINE void FRangeLimitedFABRIK::EnforceCompiledConstraint(
+	int32 ConstraintIndex,
+	const FIKCompiledConstraint& Compiled,
+	const TArray<FTransform>& InTransforms,
+	const TArray<FIKBoneConstraint*>& Constraints,
+	TArray<FTransform>& OutTransforms,
+	IIKDebugDrawer* DebugDrawer
+)
+{
+	switch (Compiled.Type)
+	{
+	case EIKCompiledConstraintType::IKCC_None:
+		break;
+	case EIKCompiledConstraintType::IKCC_Planar:
+		FPlanarRotation::EnforceCompiled(
+			Compiled,
+			OutTransforms[ConstraintIndex].GetLocation(),
+			OutTransforms[ConstraintIndex + 1]
+		);
+		break;
+	case EIKCompiledConstraintType::IKCC_Custom:
+		INC_DWORD_STAT(STAT_RTIK_ConstraintEnforcements);
+		if (Compiled.Source->SetupFn)
+		{
+			Compiled.Source->SetupFn(
+				ConstraintIndex,
+				InTransforms,
+				Constraints,
+				OutTransforms
+			);
+		}
+
+		Compiled.Source->EnforceConstraint(
+			ConstraintIndex,
+			InTransforms,
+			Constraints,
+			OutTransforms,
+			DebugDrawer
+		);
+		break;
+	}
+}
+
+const FIKCompiledConstraint* FRangeLimitedFABRIK::GetSegmentableConstraints(
+	const FIKCompiledConstraintTable& Constraints,
+	int32 NumPoints,
+	int32 SegmentLength,
+	bool& bOutUseNormalSolver)
+{
+	const FIKCompiledConstraint* CompiledConstraints = nullptr;
+	if (Constraints.bHasActiveConstraints && Constraints.Num() == NumPoints)
+	{
+		CompiledConstraints = Constraints.Entries.GetData();
+	}
+
+	bOutUseNormalSolver = NumPoints <= 2 * SegmentLength + 1 ||
+		(Constraints.bHasActiveConstraints && CompiledConstraints == nullptr);
+	for (int32 i = 0; CompiledConstraints != nullptr && i < NumPoints && !bOutUseNormalSolver; ++i)
+	{
+		bOutUseNormalSolver = CompiledConstraints[i].Type == EIKCompiledConstraintType::IKCC_Custom;
+	}
+
+	return CompiledConstraints;
+}
+
+void FRangeLimitedFABRIK::StraightenKeyLengths(
+	const FScratchIndexArray& KeyIndices,
+	const FScratchFloatArray& BoneLengths,
+	float MaxReach,
+	float RequiredReach,
+	FScratchFloatArray& KeyLengths)
+{
+	float SpanSum = 0.0f;
+	for (int32 KeyIndex = 1; KeyIndex < KeyIndices.Num(); ++KeyIndex)
+	{
+		SpanSum += KeyLengths[KeyIndex];
+	}
+
+	if (RequiredReach <= SpanSum || MaxReach <= SpanSum + KINDA_SMALL_NUMBER)
+	{
+		return;
+	}
+
+	// Grow every span the same fraction of the way to its segment's full length
+	float Straighten = FMath::Min((RequiredReach - SpanSum) / (MaxReach - SpanSum), 1.0f);
+	for (int32 KeyIndex = 1; KeyIndex < KeyIndices.Num(); ++KeyIndex)
+	{
+		float SegmentReach = 0.0f;
+		for (int32 PointIndex = KeyIndices[KeyIndex - 1] + 1; PointIndex <= KeyIndices[KeyIndex]; ++PointIndex)
+		{
+			SegmentReach += BoneLengths[PointIndex];
+		}
+		KeyLengths[KeyIndex] += Straighten * (SegmentReach - KeyLengths[KeyIndex]);
+	}
+}
+
+bool FRangeLimitedFABRIK::SolveLocationsFABRIK(
+	FVector* Points,
+	const FVector& RootStart,
+	const float* BoneLengths,
+	int32 NumPoints,
+	const FIKCompiledConstraint* CompiledConstraints,
+	const FVector& EffectorTargetLocation,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	int32* OutIterations)
+{
+	if (OutIterations != nullptr)
+	{
+		*OutIterations = 0;
+	}
+
+	if (NumPoints < 2)
+	{
+		return false;
+	}
+
+	int32 EffectorIndex = NumPoints - 1;
+	float Slop = FVector::Dist(Points[EffectorIndex], EffectorTargetLocation);
+	if (Slop <= Precision)
+	{
+		return false;
+	}
+
+	auto Drag = [](const FVector& MaintainDistancePoint, float BoneLength, const FVector& PointToMove)
+	{
+		return MaintainDistancePoint + (PointToMove - MaintainDistancePoint).GetUnsafeNormal() * BoneLength;
+	};
+
+	auto Enforce = [CompiledConstraints, Points](int32 ConstraintIndex)
+	{
+		if (CompiledConstraints != nullptr && CompiledConstraints[ConstraintIndex].Type == EIKCompiledConstraintType::IKCC_Planar)
+		{
+			Points[ConstraintIndex + 1] = FPlanarRotation::EnforceCompiled(CompiledConstraints[ConstraintIndex],
+				Points[ConstraintIndex], Points[ConstraintIndex + 1]);
+		}
+	};
+
+	bool bRootFixed = MaxRootDragDistance < KINDA_SMALL_NUMBER || RootDragStiffness < KINDA_SMALL_NUMBER;
+
+	Points[EffectorIndex] = EffectorTargetLocation;
+
+	int32 IterationCount = 0;
+	while ((Slop > Precision) && (IterationCount < MaxIterations))
+	{
+		++IterationCount;
+
+		// "Forward Reaching" stage
+		for (int32 PointIndex = EffectorIndex - 1; PointIndex > 0; --PointIndex)
+		{
+			Points[PointIndex] = Drag(Points[PointIndex + 1], BoneLengths[PointIndex + 1], Points[PointIndex]);
+			Enforce(PointIndex - 1);
+		}
+
+		// Drag the root if enabled, as in DragPointTethered
+		if (bRootFixed)
+		{
+			Points[0] = RootStart;
+		}
+		else
+		{
+			FVector RootTarget = FMath::IsNearlyZero(BoneLengths[1]) ? Points[1] : Drag(Points[1], BoneLengths[1], Points[0]);
+			Points[0] = RootStart + ((RootTarget - RootStart) / RootDragStiffness).GetClampedToMaxSize(MaxRootDragDistance);
+		}
+
+		// "Backward Reaching" stage
+		for (int32 PointIndex = 1; PointIndex < EffectorIndex; ++PointIndex)
+		{
+			Points[PointIndex] = Drag(Points[PointIndex - 1], BoneLengths[PointIndex], Points[PointIndex]);
+			Enforce(PointIndex - 1);
+		}
+
+		Slop = FMath::Abs(BoneLengths[EffectorIndex] - FVector::Dist(Points[EffectorIndex - 1], EffectorTargetLocation));
+	}
+
+	// Place effector based on how close we got to the target
+	Points[EffectorIndex] = Drag(Points[EffectorIndex - 1], BoneLengths[EffectorIndex], Points[EffectorIndex]);
+
+	if (OutIterations != nullptr)
+	{
+		*OutIterations = IterationCount;
+	}
+
+	return true;
+}
+
+bool FRangeLimitedFABRIK::TrySolveUnreachable(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraint* CompiledConstraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	EIKUnreachableRule UnreachableRule,
+	bool& bOutBoneLocationUpdated,
+	bool& bOutSeeded)
+{
+	bOutSeeded = false;
+
+	int32 NumPoints = InTransforms.Num();
+	if (NumPoints < 2)
+	{
+		return false;
+	}
+
+	float MaximumReach = 0.0f;
+	for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+	{
+		MaximumReach += FVector::Dist(InTransforms[PointIndex - 1].GetLocation(), InTransforms[PointIndex].GetLocation());
+	}
+
+	FVector RootLocation = InTransforms[0].GetLocation();
+	FVector ToTarget     = EffectorTargetLocation - RootLocation;
+	float TargetDistance = ToTarget.Size();
+	if (TargetDistance <= MaximumReach)
+	{
+		return false;
+	}
+
+	// How far the root moves toward the target. FABRIK with root dragging converges to a straight chain whose root
+	// is displaced by the clamped, stiffness-scaled shortfall, so that is used directly.
+	float Shortfall        = TargetDistance - MaximumReach;
+	float RootDisplacement = 0.0f;
+
+	switch (UnreachableRule)
+	{
+	case EIKUnreachableRule::IK_Abort:
+		OutTransforms.Reset(NumPoints);
+		OutTransforms.Append(InTransforms);
+		bOutBoneLocationUpdated = false;
+		return true;
+
+	case EIKUnreachableRule::IK_DragRoot:
+		RootDisplacement = Shortfall;
+		break;
+
+	case EIKUnreachableRule::IK_Reach:
+	default:
+		if (MaxRootDragDistance >= KINDA_SMALL_NUMBER && RootDragStiffness >= KINDA_SMALL_NUMBER)
+		{
+			RootDisplacement = FMath::Min(Shortfall / RootDragStiffness, MaxRootDragDistance);
+
+			// Dragging brings the target within reach; the chain won't end up straight
+			if (RootDisplacement >= Shortfall)
+			{
+				return false;
+			}
+		}
+		break;
+	}
+
+	FVector Direction = ToTarget / TargetDistance;
+
+	// Lay each bone along the line from the root to the target
+	OutTransforms.Reset(NumPoints);
+	OutTransforms.Append(InTransforms);
+	OutTransforms[0].SetLocation(RootLocation + Direction * RootDisplacement);
+
+	for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+	{
+		float BoneLength = FVector::Dist(InTransforms[PointIndex - 1].GetLocation(), InTransforms[PointIndex].GetLocation());
+		OutTransforms[PointIndex].SetLocation(OutTransforms[PointIndex - 1].GetLocation() + Direction * BoneLength);
+	}
+
+	// Where the constraints allow it, FABRIK converges to that line. Where they don't, the answer isn't the line
+	// with each bone clamped in turn, so the line only seeds the iterative solver.
+	if (CompiledConstraints != nullptr)
+	{
+		bOutSeeded = true;
+		return false;
+	}
+
+	// Update bone rotations
+	for (int32 PointIndex = 0; PointIndex < NumPoints - 1; ++PointIndex)
+	{
+		if (!FMath::IsNearlyZero(FVector::Dist(InTransforms[PointIndex].GetLocation(), InTransforms[PointIndex + 1].GetLocation())))
+		{
+			UpdateParentRotation(OutTransforms[PointIndex], InTransforms[PointIndex],
+				OutTransforms[PointIndex + 1], InTransforms[PointIndex + 1]);
+		}
+	}
+
+	bOutBoneLocationUpdated = true;
+	return true;
+}
+
+bool FRangeLimitedFABRIK::TrySolveFixedChain(
+	const TArray<FTransform>& InTransforms,
+	const FIKCompiledConstraint* CompiledConstraints,
+	const FVector& EffectorTargetLocation,
+	TArray<FTransform>& OutTransforms,
+	float MaxRootDragDistance,
+	float RootDragStiffness,
+	float Precision,
+	int32 MaxIterations,
+	float StagnationRatio,
+	FIKSolveStats* OutStats,
+	bool& bOutBoneLocationUpdated)
+{
+	int32 NumPoints = InTransforms.Num();
+	if (NumPoints < 2 || NumPoints > 4)
+	{
+		return false;
+	}
+
+	// Custom constraints need the full transform arrays
+	if (CompiledConstraints != nullptr)
+	{
+		for (int32 i = 0; i < NumPoints; ++i)
+		{
+			if (CompiledConstraints[i].Type == EIKCompiledConstraintType::IKCC_Custom)
+			{
+				return false;
+			}
+		}
+	}
+
+	switch (NumPoints)
+	{
+	case 2:
+		bOutBoneLocationUpdated = TFixedChainFABRIK<2>::Solve(InTransforms, CompiledConstraints, EffectorTargetLocation,
+			OutTransforms, MaxRootDragDistance, RootDragStiffness, Precision, MaxIterations, StagnationRatio, OutStats);
+		break;
+	case 3:
+		bOutBoneLocationUpdated = TFixedChainFABRIK<3>::Solve(InTransforms, CompiledConstraints, EffectorTargetLocation,
+			OutTransforms, MaxRootDragDistance, RootDragStiffness, Precision, MaxIterations, StagnationRatio, OutStats);
+		break;
+	default:
+		bOutBoneLocationUpdated = TFixedChainFABRIK<4>::Solve(InTransforms, CompiledConstraints, EffectorTargetLocation,
+			OutTransforms, MaxRootDragDistance, RootDragStiffness, Precision, MaxIterations, StagnationRatio, OutStats);
+		break;
+	}
+
+	return true;
+}
+
+void FRangeLimitedFABRIK::RelaxPoints(
+	const FScratchVectorArray& PreviousLocations,
+	float Relaxation,
+	TArray<FTransform>& Transforms)
+{
+	// The root is handled by root dragging, and the effector stays on the target
+	int32 EffectorIndex = Transforms.Num() - 1;
+	for (int32 PointIndex = 1; PointIndex < EffectorIndex; ++PointIndex)
+	{
+		const FVector& Previous = PreviousLocations[PointIndex];
+		Transforms[PointIndex].SetLocation(Previous + (Transforms[PointIndex].GetLocation() - Previous) * Relaxation);
+	}
+}
+
+void FRangeLimitedFABRIK::FABRIKForwardPass(
+	const TArray<FTransform>& InTransforms,
+	const TArray<FIKBoneConstraint*>& Constraints,
+	const FIKCompiledConstraint* CompiledConstraints,
+	const FScratchFloatArray& BoneLengths,
+	TArray<FTransform>& OutTransforms,
+	IIKDebugDrawer* DebugDrawer
+)
+{
+	int32 NumPoints     = InTransforms.Num();
+	int32 EffectorIndex = NumPoints - 1;
+
+	if (CompiledConstraints == nullptr)
+	{
+		// Nothing to enforce; just drag each parent
+		for (int32 PointIndex = EffectorIndex - 1; PointIndex > 0; --PointIndex)
+		{
+			DragPoint(OutTransforms[PointIndex + 1], BoneLengths[PointIndex + 1], OutTransforms[PointIndex]);
+		}
+		return;
+	}
+
+	for (int32 PointIndex = EffectorIndex - 1; PointIndex > 0; --PointIndex)
+	{
+		FTransform& CurrentPoint = OutTransforms[PointIndex];
+		FTransform& ChildPoint = OutTransforms[PointIndex + 1];
+
+		// Move the parent to maintain starting bone lengths
+		DragPoint(ChildPoint, BoneLengths[PointIndex + 1], CurrentPoint);
+
+		// Enforce parent's constraint any time child is moved
+		EnforceCompiledConstraint(
+			PointIndex - 1,
+			CompiledConstraints[PointIndex - 1],
+			InTransforms,
+			Constraints,
+			OutTransforms,
+			DebugDrawer
+		);
+	}
+}
+	
+void FRangeLimitedFABRIK::FABRIKBackwardPass(
+	const TArray<FTransform>& InTransforms,
+	const TArray<FIKBoneConstraint*>& Constraints,
+	const FIKCompiledConstraint* CompiledConstraints,
+	const FScratchFloatArray& BoneLengths,
+	TArray<FTransform>& OutTransforms,
+	IIKDebugDrawer* DebugDrawer
+	)
+{
+	int32 NumPoints     = InTransforms.Num();
+	int32 EffectorIndex = NumPoints - 1;
+
+	if (CompiledConstraints == nullptr)
+	{
+		// Nothing to enforce; just drag each child
+		for (int32 PointIndex = 1; PointIndex < EffectorIndex; PointIndex++)
+		{
+			DragPoint(OutTransforms[PointIndex - 1], BoneLengths[PointIndex], OutTransforms[PointIndex]);
+		}
+		return;
+	}
+
+	for (int32 PointIndex = 1; PointIndex < EffectorIndex; PointIndex++)
+	{
+		FTransform& ParentPoint  = OutTransforms[PointIndex - 1];
+		FTransform& CurrentPoint = OutTransforms[PointIndex];
+		
+		// Move the child to maintain starting bone lengths
+		DragPoint(ParentPoint, BoneLengths[PointIndex], CurrentPoint);
+		
+		// Enforce parent's constraint any time child is moved
+		EnforceCompiledConstraint(
+			PointIndex - 1,
+			CompiledConstraints[PointIndex - 1],
+			InTransforms,
+			Constraints,
+			OutTransforms,
+			DebugDrawer
+		);
+	}
+}
+
+FORCEINLINE void FRangeLimitedFABRIK::DragPoint(
+	const FTransform& MaintainDistancePoint,
+	float BoneLength,
+	FTransform& PointToMove
+) 
+{
+	PointToMove.SetLocation(MaintainDistancePoint.GetLocation() +
+		(PointToMove.GetLocation() - MaintainDistancePoint.GetLocation()).GetUnsafeNormal() *
+		BoneLength);
+}
+
+void FRangeLimitedFABRIK::DragPointTethered(
+	const FTransform& StartingTransform,
+	const FTransform& MaintainDistancePoint,
+	float BoneLength,
+	float MaxDragDistance,
+	float DragStiffness,
+	FTransform& PointToDrag
+)
+{
+	if (MaxDragDistance < KINDA_SMALL_NUMBER || DragStiffness < KINDA_SMALL_NUMBER)
+	{
+		PointToDrag = StartingTransform;
+		return;
+	}  
+		
+	FVector Target;
+	if (FMath::IsNearlyZero(BoneLength))
+	{
+		Target = MaintainDistancePoint.GetLocation();
+	}
+	else
+	{
+		Target = MaintainDistancePoint.GetLocation() +
+			(PointToDrag.GetLocation() - MaintainDistancePoint.GetLocation()).GetUnsafeNormal() *
+			BoneLength;
+	}
+		
+	FVector Displacement = Target - StartingTransform.GetLocation();
+
+	// Root drag stiffness 'pulls' the root back (set to 1.0 to disable)
+	Displacement /= DragStiffness;	
+	
+	// limit root displacement to drag length
+	FVector LimitedDisplacement = Displacement.GetClampedToMaxSize(MaxDragDistance);
+	PointToDrag.SetLocation(StartingTransform.GetLocation() + LimitedDisplacement);
+}
+
+void FRangeLimitedFABRIK::UpdateParentRotation(
+	FTransform& NewParentTransform, 
+	const FTransform& OldParentTransform,
+	const FTransform& NewChildTransform,
+	const FTransform& OldChildTransform)
+{
+	FVector OldDir = (OldChildTransform.GetLocation() - OldParentTransform.GetLocation()).GetUnsafeNormal();
+	FVector NewDir = (NewChildTransform.GetLocation() - NewParentTransform.GetLocation()).GetUnsafeNormal();
+	
+	FQuat DeltaRotation = FQuat::FindBetweenNormals(OldDir, NewDir);
+	
+	NewParentTransform.SetRotation(DeltaRotation * OldParentTransform.GetRotation());
+	NewParentTransform.NormalizeRotation();
+}
+
+float FRangeLimitedFABRIK::ComputeSplineArcLengths(
+	const TArray<FTransform>& InTransforms,
+	TArray<float>& OutArcLengths
+)
+{
+	int32 NumPoints = InTransforms.Num();
+	OutArcLengths.Reset(NumPoints);
+
+	float ArcLength = 0.0f;
+	for (int32 i = 0; i < NumPoints; ++i)
+	{
+		if (i > 0)
+		{
+			ArcLength += FVector::Dist(InTransforms[i - 1].GetLocation(), InTransforms[i].GetLocation());
+		}
+		OutArcLengths.Add(ArcLength);
+	}
+
+	return ArcLength;
+}
+
+float FRangeLimitedFABRIK::ComputeBoneLengths(
+	const TArray<FTransform>& InTransforms,
+	FScratchFloatArray& OutBoneLengths
+)
+{
+	int32 NumPoints = InTransforms.Num();
+	float MaximumReach = 0.0f;
+	OutBoneLengths.Reset(NumPoints);
+
+	// Root always has zero length
+	OutBoneLengths.Add(0.0f);
+
+	for (int32 i = 1; i < NumPoints; ++i)
+	{
+		OutBoneLengths.Add(FVector::Dist(InTransforms[i - 1].GetLocation(),
+			InTransforms[i].GetLocation()));
+		MaximumReach  += OutBoneLengths[i];
+	}
+	
+	return MaximumReach;
+}
@@ -0,0 +1,147 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "RTIKAllocationCounter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// Counter of the innermost scope open on this thread, if any
+	thread_local int32* ThreadCallCounter = nullptr;
+
+	// Forwards everything to the allocator it wrapped, counting calls on threads with a scope open
+	class FRTIKCountingMalloc : public FMalloc
+	{
+	public:
+
+		explicit FRTIKCountingMalloc(FMalloc* InInner)
+			:
+			Inner(InInner)
+		{ }
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountCall();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			CountCall();
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			CountCall();
+			Inner->Free(Original);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return Inner->QuantizeSize(Count, Alignment);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+		{
+			return Inner->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual void Trim() override
+		{
+			Inner->Trim();
+		}
+
+		virtual void SetupTLSCachesOnCurrentThread() override
+		{
+			Inner->SetupTLSCachesOnCurrentThread();
+		}
+
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+		{
+			Inner->ClearAndDisableTLSCachesOnCurrentThread();
+		}
+
+		virtual void InitializeStatsMetadata() override
+		{
+			Inner->InitializeStatsMetadata();
+		}
+
+		virtual void UpdateStats() override
+		{
+			Inner->UpdateStats();
+		}
+
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override
+		{
+			Inner->GetAllocatorStats(OutStats);
+		}
+
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override
+		{
+			Inner->DumpAllocatorStats(Ar);
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return Inner->IsInternallyThreadSafe();
+		}
+
+		virtual bool ValidateHeap() override
+		{
+			return Inner->ValidateHeap();
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override
+		{
+			return Inner->GetDescriptiveName();
+		}
+
+	protected:
+
+		FORCEINLINE void CountCall()
+		{
+			if (ThreadCallCounter != nullptr)
+			{
+				++(*ThreadCallCounter);
+			}
+		}
+
+		FMalloc* Inner;
+	};
+
+	// Wraps GMalloc the first time it's called. If another wrapper got in between reading GMalloc and swapping it,
+	// try again on top of that one.
+	FRTIKCountingMalloc* InstallCountingMalloc()
+	{
+		for (;;)
+		{
+			FMalloc* Current = GMalloc;
+			FRTIKCountingMalloc* Counting = new FRTIKCountingMalloc(Current);
+			if (FPlatformAtomics::InterlockedCompareExchangePointer(reinterpret_cast<void**>(&GMalloc), Counting, Current) == Current)
+			{
+				return Counting;
+			}
+			delete Counting;
+		}
+	}
+}
+
+FRTIKAllocationCounterScope::FRTIKAllocationCounterScope()
+	:
+	NumCalls(0),
+	OuterCounter(ThreadCallCounter)
+{
+	static FRTIKCountingMalloc* CountingMalloc = InstallCountingMalloc();
+	(void)CountingMalloc;
+
+	ThreadCallCounter = &NumCalls;
+}
+
+FRTIKAllocationCounterScope::~FRTIKAllocationCounterScope()
+{
+	ThreadCallCounter = OuterCounter;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
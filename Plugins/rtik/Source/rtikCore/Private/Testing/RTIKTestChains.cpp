@@ -0,0 +1,61 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "RTIKTestChains.h"
+
+void FRTIKTestChain::Generate(FRandomStream& Random, int32 NumPoints, float InBoneLength, float ConstraintDensity,
+	float MaxBendDegrees)
+{
+	BoneLength = InBoneLength;
+	Transforms.Reset(NumPoints);
+	PlanarConstraints.Reset(NumPoints);
+	PlanarConstraints.AddDefaulted(NumPoints);
+
+	TArray<FIKBoneConstraint*> ConstraintPointers;
+	ConstraintPointers.Init(nullptr, NumPoints);
+
+	FVector Location(0.0f, 0.0f, 0.0f);
+	float Angle = 0.0f;
+	Transforms.Add(FTransform(Location));
+	for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+	{
+		Angle += FMath::DegreesToRadians(Random.FRandRange(-MaxBendDegrees, MaxBendDegrees));
+		FVector Direction(FMath::Cos(Angle), 0.0f, FMath::Sin(Angle));
+
+		// The constraint on a point limits the bone from it to its child
+		if (Random.FRand() < ConstraintDensity)
+		{
+			FPlanarRotation& Constraint = PlanarConstraints[PointIndex - 1];
+			Constraint.RotationAxis      = FVector(0.0f, 1.0f, 0.0f);
+			Constraint.ForwardDirection  = Direction;
+			Constraint.FailsafeDirection = Direction;
+			Constraint.MinDegrees        = -60.0f;
+			Constraint.MaxDegrees        = 60.0f;
+			Constraint.Initialize();
+			ConstraintPointers[PointIndex - 1] = &Constraint;
+		}
+
+		Location += Direction * BoneLength;
+		Transforms.Add(FTransform(Location));
+	}
+
+	Reach = BoneLength * (NumPoints - 1);
+	Constraints.Compile(ConstraintPointers);
+}
+
+FVector FRTIKTestChain::MakeTarget(FRandomStream& Random, bool bReachable) const
+{
+	float Distance = bReachable ? Random.FRandRange(0.33f, 0.8f) * Reach : 1.5f * Reach;
+	return Transforms[0].GetLocation() + Random.GetUnitVector() * Distance;
+}
+
+float FRTIKTestChain::MaxBoneLengthError(const TArray<FTransform>& Solved) const
+{
+	float MaxError = 0.0f;
+	for (int32 PointIndex = 1; PointIndex < Solved.Num(); ++PointIndex)
+	{
+		float Length = FVector::Dist(Solved[PointIndex - 1].GetLocation(), Solved[PointIndex].GetLocation());
+		MaxError = FMath::Max(MaxError, FMath::Abs(Length - BoneLength));
+	}
+	return MaxError;
+}
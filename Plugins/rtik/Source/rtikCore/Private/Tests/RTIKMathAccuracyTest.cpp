@@ -0,0 +1,183 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "IKMath.h"
+#include "Constraints.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const int32 NumSamples = 4096;
+
+	// Acos is badly conditioned near 0 and 180 degrees, so the old results carry some error of their own there
+	const float AngleTolerance  = 1e-3f;
+	const float VectorTolerance = 1e-3f;
+
+	// Samples closer than this to a limit may fall either side of it, by rounding alone
+	const float LimitMarginDegrees = 0.05f;
+
+	// The signed angle the way it was measured before FIKMath::SignedAngle
+	float SignedAngleAcos(const FVector& From, const FVector& To, const FVector& SignReference)
+	{
+		FVector Axis = FVector::CrossProduct(From, To);
+		if (!Axis.Normalize())
+		{
+			return 0.0f;
+		}
+
+		float Rad = FMath::Acos(FMath::Clamp(FVector::DotProduct(From.GetSafeNormal(), To.GetSafeNormal()), -1.0f, 1.0f));
+		return (FVector::DotProduct(Axis, SignReference) > 0.0f) ? Rad : -Rad;
+	}
+}
+
+// The trig-free kernels in FIKMath, and the cosine-space comparisons built on them, against the Acos round-trips
+// they replaced. Each case draws random inputs, and checks both give the same answer within rounding.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRTIKMathAccuracyTest, "RTIK.Math.MatchesAngleSpace",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FRTIKMathAccuracyTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(29);
+
+	// Comparing cosines against a cosine limit, as the foot rotation limit does
+	int32 NumLimitMismatches = 0;
+	for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+	{
+		FVector Flat  = Random.GetUnitVector();
+		FVector Slope = Random.GetUnitVector();
+		float LimitDegrees = Random.FRandRange(0.0f, 180.0f);
+
+		float Cos = FVector::DotProduct(Flat, Slope);
+		float Degrees = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(Cos, -1.0f, 1.0f)));
+		if (FMath::Abs(Degrees - LimitDegrees) < LimitMarginDegrees)
+		{
+			continue;
+		}
+
+		bool bWithinCos   = !(Cos < FMath::Cos(FMath::DegreesToRadians(LimitDegrees)));
+		bool bWithinAngle = !(Degrees > LimitDegrees);
+		if (bWithinCos != bWithinAngle)
+		{
+			++NumLimitMismatches;
+		}
+	}
+	TestEqual(TEXT("Cosine limit checks that disagree with the angle check"), NumLimitMismatches, 0);
+
+	// Signed angles, as used for torso twist and pitch. Inputs aren't normalized, as for the projected pitch vectors.
+	float MaxSignedAngleError = 0.0f;
+	for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+	{
+		FVector From = Random.GetUnitVector() * Random.FRandRange(0.5f, 2.0f);
+		FVector To   = Random.GetUnitVector() * Random.FRandRange(0.5f, 2.0f);
+		FVector SignReference = Random.GetUnitVector();
+
+		float Error = FMath::Abs(FIKMath::SignedAngle(From, To, SignReference) - SignedAngleAcos(From, To, SignReference));
+		MaxSignedAngleError = FMath::Max(MaxSignedAngleError, Error);
+	}
+	TestTrue(FString::Printf(TEXT("SignedAngle error %f is within tolerance"), MaxSignedAngleError),
+		MaxSignedAngleError <= AngleTolerance);
+
+	// Rotations built from a cosine, as the foot rotation controller builds its offset
+	float MaxQuatFromCosError = 0.0f;
+	for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+	{
+		FVector Axis = Random.GetUnitVector();
+		FVector Probe = Random.GetUnitVector();
+		float Cos = Random.FRandRange(-1.0f, 1.0f);
+
+		FQuat FromCos   = FIKMath::QuatFromAxisAndCos(Axis, Cos);
+		FQuat FromAngle = FQuat(Axis, FMath::Acos(Cos));
+		float Error = (FromCos.RotateVector(Probe) - FromAngle.RotateVector(Probe)).Size();
+		MaxQuatFromCosError = FMath::Max(MaxQuatFromCosError, Error);
+	}
+	TestTrue(FString::Printf(TEXT("QuatFromAxisAndCos error %f is within tolerance"), MaxQuatFromCosError),
+		MaxQuatFromCosError <= VectorTolerance);
+
+	// Shortest rotations between directions, as used by UpdateParentRotation and knee correction
+	float MaxShortestArcError = 0.0f;
+	for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+	{
+		FVector From = Random.GetUnitVector();
+		FVector To   = Random.GetUnitVector();
+		FVector Probe = Random.GetUnitVector();
+
+		FVector Axis = FVector::CrossProduct(From, To);
+		if (!Axis.Normalize())
+		{
+			continue;
+		}
+
+		FQuat FromAngle = FQuat(Axis, FMath::Acos(FMath::Clamp(FVector::DotProduct(From, To), -1.0f, 1.0f)));
+		FQuat Arc = FIKMath::ShortestArc(From, To, Axis);
+		float Error = (Arc.RotateVector(Probe) - FromAngle.RotateVector(Probe)).Size();
+		MaxShortestArcError = FMath::Max(MaxShortestArcError, Error);
+	}
+	TestTrue(FString::Printf(TEXT("ShortestArc error %f is within tolerance"), MaxShortestArcError),
+		MaxShortestArcError <= VectorTolerance);
+
+	// Opposite directions turn halfway around the fallback axis
+	FVector FallbackAxis(0.0f, 0.0f, 1.0f);
+	FQuat HalfTurn = FIKMath::ShortestArc(FVector(1.0f, 0.0f, 0.0f), FVector(-1.0f, 0.0f, 0.0f), FallbackAxis);
+	TestTrue(TEXT("ShortestArc between opposite directions turns around the fallback axis"),
+		HalfTurn.RotateVector(FVector(0.0f, 1.0f, 0.0f)).Equals(FVector(0.0f, -1.0f, 0.0f), VectorTolerance));
+
+	// Planar constraints, compiled, against the Acos and RotateAngleAxis clamp they used before
+	int32 NumPlanarCompared = 0;
+	float MaxPlanarError = 0.0f;
+	for (int32 Sample = 0; Sample < NumSamples; ++Sample)
+	{
+		FPlanarRotation Planar;
+		Planar.RotationAxis      = Random.GetUnitVector();
+		Planar.ForwardDirection  = FVector::VectorPlaneProject(Random.GetUnitVector(), Planar.RotationAxis).GetSafeNormal();
+		Planar.FailsafeDirection = Planar.ForwardDirection;
+		Planar.MinDegrees        = Random.FRandRange(-180.0f, 0.0f);
+		Planar.MaxDegrees        = Random.FRandRange(0.0f, 180.0f);
+		if (Planar.ForwardDirection.IsZero())
+		{
+			continue;
+		}
+
+		TArray<FIKBoneConstraint*> Pointers({ &Planar });
+		FIKCompiledConstraintTable Table;
+		Table.Compile(Pointers);
+
+		FVector Parent = Random.GetUnitVector() * 10.0f;
+		FVector Child  = Parent + Random.GetUnitVector() * Random.FRandRange(1.0f, 20.0f);
+
+		FVector UpDirection = FVector::CrossProduct(Planar.RotationAxis, Planar.ForwardDirection);
+		FVector BoneDirection = FVector::VectorPlaneProject(Child - Parent, Planar.RotationAxis);
+		float BoneLength = (Child - Parent).Size();
+		if (!BoneDirection.Normalize())
+		{
+			continue;
+		}
+
+		float AngleDeg = FMath::RadiansToDegrees((FVector::DotProduct(BoneDirection, UpDirection) > 0.0f) ?
+			FMath::Acos(FMath::Clamp(FVector::DotProduct(BoneDirection, Planar.ForwardDirection), -1.0f, 1.0f)) :
+			-FMath::Acos(FMath::Clamp(FVector::DotProduct(BoneDirection, Planar.ForwardDirection), -1.0f, 1.0f)));
+		if (FMath::Abs(AngleDeg - Planar.MinDegrees) < LimitMarginDegrees ||
+			FMath::Abs(AngleDeg - Planar.MaxDegrees) < LimitMarginDegrees ||
+			FMath::Abs(FMath::Abs(AngleDeg) - 180.0f) < LimitMarginDegrees)
+		{
+			continue;
+		}
+
+		float TargetDeg = FMath::Clamp(AngleDeg, Planar.MinDegrees, Planar.MaxDegrees);
+		FVector Expected = Parent + Planar.ForwardDirection.RotateAngleAxis(TargetDeg, Planar.RotationAxis) * BoneLength;
+		FVector Compiled = FPlanarRotation::EnforceCompiled(Table.Entries[0], Parent, Child);
+
+		// Relative to the bone, so long bones don't dominate
+		MaxPlanarError = FMath::Max(MaxPlanarError, (Compiled - Expected).Size() / BoneLength);
+		++NumPlanarCompared;
+	}
+	TestTrue(TEXT("Planar constraint samples were compared"), NumPlanarCompared > NumSamples / 2);
+	TestTrue(FString::Printf(TEXT("Compiled planar constraint error %f is within tolerance"), MaxPlanarError),
+		MaxPlanarError <= VectorTolerance);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,78 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "Misc/AutomationTest.h"
+#include "RangeLimitedFABRIK.h"
+#include "RTIKTestChains.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// SolveParallelSegmentedFABRIK against SolveRangeLimitedFABRIK, on the same long chains and targets, with the same
+// iteration limit. The poses differ, but the segmented solve must keep every bone's length and leave the root
+// alone, and reach the target at least as often. Unconstrained, it should reach every target.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRTIKParallelSegmentedTest, "RTIK.Solvers.ParallelSegmentedMatchesSerial",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FRTIKParallelSegmentedTest::RunTest(const FString& Parameters)
+{
+	const float Precision       = 0.01f;
+	const int32 MaxIterations   = 20;
+	const int32 SegmentLength   = 8;
+	const int32 NumTargets      = 8;
+
+	// Float error from joining the segments back up; far below anything visible
+	const float LengthTolerance = 0.01f;
+
+	FRandomStream Random(36);
+
+	for (int32 NumPoints : { 65, 129 })
+	{
+		for (float ConstraintDensity : { 0.0f, 0.5f })
+		{
+			FRTIKTestChain Chain;
+			Chain.Generate(Random, NumPoints, 10.0f, ConstraintDensity);
+
+			TArray<FTransform> SerialOut;
+			TArray<FTransform> SegmentedOut;
+			int32 NumSerialConverged    = 0;
+			int32 NumSegmentedConverged = 0;
+			float MaxLengthError        = 0.0f;
+			float MaxRootMovement       = 0.0f;
+
+			for (int32 TargetIndex = 0; TargetIndex < NumTargets; ++TargetIndex)
+			{
+				FVector Target = Chain.Transforms[0].GetLocation() +
+					Random.GetUnitVector() * Random.FRandRange(0.33f, 0.8f) * Chain.Reach;
+
+				FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(Chain.Transforms, Chain.Constraints, Target, SerialOut,
+					0.0f, 1.0f, Precision, MaxIterations);
+				FRangeLimitedFABRIK::SolveParallelSegmentedFABRIK(Chain.Transforms, Chain.Constraints, Target,
+					SegmentedOut, 0.0f, 1.0f, Precision, MaxIterations, SegmentLength, 2);
+
+				// Serial FABRIK's result is within Precision of the target up to rounding in its slop measure
+				NumSerialConverged    += FVector::Dist(SerialOut.Last().GetLocation(), Target) <= 1.01f * Precision ? 1 : 0;
+				NumSegmentedConverged += FVector::Dist(SegmentedOut.Last().GetLocation(), Target) <= 1.01f * Precision ? 1 : 0;
+
+				MaxLengthError  = FMath::Max(MaxLengthError, Chain.MaxBoneLengthError(SegmentedOut));
+				MaxRootMovement = FMath::Max(MaxRootMovement,
+					FVector::Dist(SegmentedOut[0].GetLocation(), Chain.Transforms[0].GetLocation()));
+			}
+
+			FString Config = FString::Printf(TEXT("%d points, constraint density %.1f"), NumPoints, ConstraintDensity);
+			TestTrue(FString::Printf(TEXT("%s: bone length error %f is within tolerance"), *Config, MaxLengthError),
+				MaxLengthError <= LengthTolerance);
+			TestTrue(FString::Printf(TEXT("%s: root stays put"), *Config), MaxRootMovement <= KINDA_SMALL_NUMBER);
+			TestTrue(FString::Printf(TEXT("%s: segmented reaches %d targets, serial %d"), *Config,
+				NumSegmentedConverged, NumSerialConverged), NumSegmentedConverged >= NumSerialConverged);
+
+			if (ConstraintDensity == 0.0f)
+			{
+				TestEqual(FString::Printf(TEXT("%s: targets reached"), *Config), NumSegmentedConverged, NumTargets);
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
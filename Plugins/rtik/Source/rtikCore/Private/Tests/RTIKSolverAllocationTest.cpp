@@ -0,0 +1,87 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "Misc/AutomationTest.h"
+#include "RangeLimitedFABRIK.h"
+#include "AnalyticIK.h"
+#include "RTIKTestChains.h"
+#include "RTIKAllocationCounter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// The solvers the nodes run every frame, with the same inputs twice. The first run sizes the output arrays and
+// warms the thread's FMemStack; the second must not touch the heap at all. Stats collection should be off (it
+// is unless a stat command is active), since a stats capture buffers its own messages.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRTIKSolverAllocationTest, "RTIK.Solvers.NoSteadyStateAllocations",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FRTIKSolverAllocationTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(1);
+
+	// Long enough to skip the unrolled fixed-length solvers, and half constrained
+	FRTIKTestChain Chain;
+	Chain.Generate(Random, 8, 10.0f, 0.5f);
+
+	// A leg, as solved by the leg IK node
+	FRTIKTestChain Leg;
+	Leg.Generate(Random, 3, 40.0f, 0.0f);
+
+	// Two arms off a waist, as solved by the arm torso node
+	TArray<FTransform> TreeTransforms;
+	TArray<int32> TreeParentIndices;
+	TArray<FIKCompiledConstraint> TreeConstraints;
+	for (int32 PointIndex = 0; PointIndex < 7; ++PointIndex)
+	{
+		int32 Side = PointIndex < 4 ? 1 : -1;
+		int32 Depth = PointIndex == 0 ? 0 : (PointIndex < 4 ? PointIndex : PointIndex - 3);
+		TreeTransforms.Add(FTransform(FVector(0.0f, Side * Depth * 20.0f, 0.0f)));
+		TreeParentIndices.Add(PointIndex == 0 ? INDEX_NONE : (Depth == 1 ? 0 : PointIndex - 1));
+	}
+	TreeConstraints.AddDefaulted(TreeTransforms.Num());
+
+	TArray<int32> TreeEffectorIndices({ 3, 6 });
+	TArray<FVector> TreeEffectorTargets({ FVector(20.0f, 40.0f, 10.0f), FVector(20.0f, -40.0f, 10.0f) });
+
+	FVector ReachableTarget   = Chain.Transforms[0].GetLocation() + FVector(30.0f, 0.0f, 30.0f);
+	FVector UnreachableTarget = Chain.Transforms[0].GetLocation() + FVector(2.0f * Chain.Reach, 0.0f, 0.0f);
+	FVector LegTarget         = Leg.Transforms[0].GetLocation() + FVector(50.0f, 0.0f, 10.0f);
+
+	TArray<FTransform> ChainOut;
+	TArray<FTransform> LegOut;
+	TArray<FTransform> TreeOut;
+	FIKSolveStats Stats;
+
+	auto SolveAll = [&]()
+	{
+		FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(Chain.Transforms, Chain.Constraints, ReachableTarget, ChainOut,
+			0.0f, 1.0f, 0.01f, 20, EIKUnreachableRule::IK_Reach, nullptr, 1.0f, 0.0f, &Stats);
+		FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(Chain.Transforms, Chain.Constraints, ReachableTarget, ChainOut,
+			0.0f, 1.0f, 0.01f, 20, EIKUnreachableRule::IK_Reach, nullptr, 1.3f, 0.0f, &Stats);
+		FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(Chain.Transforms, Chain.Constraints, UnreachableTarget, ChainOut,
+			0.0f, 1.0f, 0.01f, 20, EIKUnreachableRule::IK_Reach, nullptr, 1.0f, 0.0f, &Stats);
+
+		bool bUpdated = false;
+		if (!FAnalyticIK::SolveTwoBone(Leg.Transforms, Leg.Constraints, LegTarget, LegOut, 0.01f, bUpdated))
+		{
+			FRangeLimitedFABRIK::SolveRangeLimitedFABRIK(Leg.Transforms, Leg.Constraints, LegTarget, LegOut);
+		}
+
+		FRangeLimitedFABRIK::SolveTreeFABRIK(TreeTransforms, TreeParentIndices, TreeConstraints, TreeEffectorIndices,
+			TreeEffectorTargets, TreeOut, 5.0f, 1.0f, 0.01f, 20, &Stats);
+	};
+
+	SolveAll();
+
+	int32 NumAllocatorCalls = 0;
+	{
+		FRTIKAllocationCounterScope AllocationCounter;
+		SolveAll();
+		NumAllocatorCalls = AllocationCounter.GetNumCalls();
+	}
+
+	TestEqual(TEXT("Allocator calls during a steady-state solve"), NumAllocatorCalls, 0);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,85 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "Misc/AutomationTest.h"
+#include "RangeLimitedFABRIK.h"
+#include "RTIKTestChains.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// SolveSplineIK, with and without a control point, on reachable and unreachable targets. It must reach every reachable
+// target, keep every bone's length and leave the root alone, and report unreachable targets as such.
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRTIKSplineSolverTest, "RTIK.Solvers.SplineKeepsBoneLengths",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FRTIKSplineSolverTest::RunTest(const FString& Parameters)
+{
+	const float Precision     = 0.01f;
+	const int32 MaxIterations = 20;
+	const int32 NumTargets    = 16;
+	const int32 NumReachable  = NumTargets * 3 / 4;
+
+	// Float error from placing points on the curve; far below anything visible
+	const float LengthTolerance = 0.01f;
+
+	FRandomStream Random(38);
+
+	for (int32 NumPoints : { 5, 12, 30 })
+	{
+		FRTIKTestChain Chain;
+		Chain.Generate(Random, NumPoints, 10.0f, 0.0f);
+
+		TArray<float> ArcLengths;
+		FRangeLimitedFABRIK::ComputeSplineArcLengths(Chain.Transforms, ArcLengths);
+
+		TArray<FTransform> OutTransforms;
+		TArray<FVector> ControlPoints;
+		FIKSolveStats Stats;
+		int32 NumReachableConverged = 0;
+		int32 NumUnreachableReported = 0;
+		float MaxLengthError  = 0.0f;
+		float MaxRootMovement = 0.0f;
+
+		for (int32 TargetIndex = 0; TargetIndex < NumTargets; ++TargetIndex)
+		{
+			bool bReachable = TargetIndex % 4 != 3;
+			FVector RootLocation = Chain.Transforms[0].GetLocation();
+			FVector Target = RootLocation + Random.GetUnitVector() * Chain.Reach *
+				(bReachable ? Random.FRandRange(0.2f, 0.9f) : Random.FRandRange(1.1f, 1.5f));
+
+			// Every other target bends the curve through a point off the straight line to it
+			ControlPoints.Reset();
+			if (TargetIndex % 2 == 0)
+			{
+				ControlPoints.Add(FMath::Lerp(RootLocation, Target, 0.5f) + Random.GetUnitVector() * 0.1f * Chain.Reach);
+			}
+
+			FRangeLimitedFABRIK::SolveSplineIK(Chain.Transforms, Target, OutTransforms, ControlPoints, ArcLengths,
+				Precision, MaxIterations, EIKUnreachableRule::IK_Reach, nullptr, &Stats);
+
+			if (bReachable)
+			{
+				NumReachableConverged += Stats.Termination == EIKSolveTermination::IK_Converged ? 1 : 0;
+			}
+			else
+			{
+				NumUnreachableReported += Stats.Termination == EIKSolveTermination::IK_Unreachable ? 1 : 0;
+			}
+
+			MaxLengthError  = FMath::Max(MaxLengthError, Chain.MaxBoneLengthError(OutTransforms));
+			MaxRootMovement = FMath::Max(MaxRootMovement, FVector::Dist(OutTransforms[0].GetLocation(), RootLocation));
+		}
+
+		FString Config = FString::Printf(TEXT("%d points"), NumPoints);
+		TestTrue(FString::Printf(TEXT("%s: bone length error %f is within tolerance"), *Config, MaxLengthError),
+			MaxLengthError <= LengthTolerance);
+		TestTrue(FString::Printf(TEXT("%s: root stays put"), *Config), MaxRootMovement <= KINDA_SMALL_NUMBER);
+		TestEqual(FString::Printf(TEXT("%s: reachable targets reached"), *Config), NumReachableConverged, NumReachable);
+		TestEqual(FString::Printf(TEXT("%s: unreachable targets reported"), *Config), NumUnreachableReported,
+			NumTargets - NumReachable);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,8 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikCore.h"
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, rtikCore);
+
+DEFINE_LOG_CATEGORY(LogRTIK)
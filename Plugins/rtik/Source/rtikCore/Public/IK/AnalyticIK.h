@@ -0,0 +1,106 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IKSolverTypes.h"
+
+
+//	Closed-form solvers for the short chains humanoid rigs are actually made of. Like the FABRIK solvers, these
+//	work on generic transforms, which must all be in the same space.
+//
+//	These are an alternative to FABRIK, not a replacement: each solver checks that the chain shape and its
+//	constraints are ones it can solve exactly, and reports failure otherwise, so the caller can fall back to
+//	FRangeLimitedFABRIK. The root of the chain is always fixed; root dragging is not supported.
+
+struct RTIKCORE_API FAnalyticIK
+{
+public:
+
+	// Solves a two-bone (three point) chain in one step, using the law of cosines.
+	//
+	// The middle point is placed on the circle of locations that keep both bone lengths with the effector on
+	// EffectorTargetLocation. Where on that circle depends on the constraints:
+	//
+	// - If either bone has a planar constraint, it acts as a hinge. The middle point is placed so that bone lies in the
+	//   constraint's rotation plane (the constraint on the second bone is used if both have one). There are up to
+	//   two such points; the one closer to the starting middle point is preferred, if it is within limits.
+	// - Otherwise, the chain keeps bending in the plane it is already bent in.
+	//
+	// Every planar constraint must be satisfied, within Precision, by the result. If not, or if the target is out of
+	// reach, or the constraints are of any other type, the chain can't be solved here.
+	//
+	// @param InTransforms - The starting transforms of each chain point. Not modified. Must contain 3 transforms.
+	// @param Constraints - Compiled constraints for each chain point.
+	// @param EffectorTargetLocation - Where the effector should go.
+	// @param OutTransforms - The updated transforms. Untouched if this returns false. Rotations are updated as in
+	//   FRangeLimitedFABRIK::SolveRangeLimitedFABRIK, and the effector's rotation is likewise not updated.
+	// @param Precision - Tolerance for constraint checks. If the effector is already this close to the target, nothing moves.
+	// @param bOutBoneLocationUpdated - Set to true if any transforms in OutTransforms were changed.
+	// @return - True if the chain was solved; false if the caller should use FABRIK instead.
+	static bool SolveTwoBone(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraintTable& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float Precision,
+		bool& bOutBoneLocationUpdated
+	);
+
+	// Solves a three-bone (four point) chain whose first bone does not move, like a hip or clavicle segment.
+	// The remaining two bones are solved as in SolveTwoBone. The first bone's constraint is not enforced.
+	// Parameters are as in SolveTwoBone; InTransforms must contain 4 transforms.
+	static bool SolveThreeBoneFixedRoot(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraintTable& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float Precision,
+		bool& bOutBoneLocationUpdated
+	);
+
+	// Picks SolveTwoBone or SolveThreeBoneFixedRoot based on the number of points. Returns false for any other
+	// chain length, or if the chosen solver can't handle this chain.
+	static bool TrySolve(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraintTable& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float Precision,
+		bool& bOutBoneLocationUpdated
+	);
+
+protected:
+
+	// Solves the two bones from Root, through Mid, to the effector. Constraints are the compiled constraints of the
+	// two bones. On success, returns the new middle point in OutMid; the effector goes on the target.
+	static bool SolveTriangle(
+		const FVector& Root,
+		const FVector& Mid,
+		const FVector& Effector,
+		const FIKCompiledConstraint& RootConstraint,
+		const FIKCompiledConstraint& MidConstraint,
+		const FVector& EffectorTargetLocation,
+		float Precision,
+		FVector& OutMid
+	);
+
+	// Checks that the bone from Parent to Child satisfies Constraint, to within Precision
+	static bool SatisfiesConstraint(
+		const FIKCompiledConstraint& Constraint,
+		const FVector& Parent,
+		const FVector& Child,
+		float Precision
+	);
+
+	// Shared by the public solvers: solves the last two bones of a chain of NumPoints (3 or 4) points,
+	// leaving the rest in place
+	static bool SolveLastTwoBones(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraintTable& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float Precision,
+		bool& bOutBoneLocationUpdated
+	);
+};
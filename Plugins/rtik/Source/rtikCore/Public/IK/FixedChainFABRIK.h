@@ -0,0 +1,177 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IKSolverTypes.h"
+#include "Constraints.h"
+#include "RangeLimitedFABRIK.h"
+
+/*
+* Range-limited FABRIK specialized for a chain with a fixed number of points.
+*
+* Most chains are short (a leg is 3 points, an arm 3 or 4), so the generic solver's per-point array indexing
+* and pass bookkeeping is a large part of its cost. Here the point count is a template parameter: points and bone
+* lengths live in fixed-size arrays on the stack, and the passes have constant trip counts the compiler can unroll.
+*
+* Produces the same result as FRangeLimitedFABRIK::SolveRangeLimitedFABRIK. Only compiled constraints of type
+* IKCC_None and IKCC_Planar are supported; chains with custom constraints must use the generic solver.
+* FRangeLimitedFABRIK dispatches to this automatically for 2, 3 and 4 point chains.
+*/
+template<int32 NumPoints>
+struct TFixedChainFABRIK
+{
+	static_assert(NumPoints >= 2, "Need at least one bone to do IK!");
+
+public:
+
+	enum { EffectorIndex = NumPoints - 1 };
+
+	// See FRangeLimitedFABRIK::SolveRangeLimitedFABRIK. InTransforms must contain exactly NumPoints transforms.
+	// CompiledConstraints is nullptr, or holds NumPoints entries, none of which are IKCC_Custom. Over-relaxation is
+	// not supported.
+	static bool Solve(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraint* CompiledConstraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance,
+		float RootDragStiffness,
+		float Precision,
+		int32 MaxIterations,
+		float StagnationRatio = 0.0f,
+		FIKSolveStats* OutStats = nullptr)
+	{
+		check(InTransforms.Num() == NumPoints);
+
+		OutTransforms.Reset(NumPoints);
+		OutTransforms.Append(InTransforms);
+
+		const FTransform* InData = InTransforms.GetData();
+
+		// Points[i] is the location of point i; BoneLengths[i] is the length of the bone ENDING at point i
+		FVector StartPoints[NumPoints];
+		FVector Points[NumPoints];
+		float BoneLengths[NumPoints];
+
+		for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+		{
+			StartPoints[PointIndex] = InData[PointIndex].GetLocation();
+			Points[PointIndex]      = StartPoints[PointIndex];
+		}
+
+		BoneLengths[0] = 0.0f;
+		for (int32 PointIndex = 1; PointIndex < NumPoints; ++PointIndex)
+		{
+			BoneLengths[PointIndex] = FVector::Dist(StartPoints[PointIndex - 1], StartPoints[PointIndex]);
+		}
+
+		// Check distance between tip location and effector location
+		float Slop = FVector::Dist(Points[EffectorIndex], EffectorTargetLocation);
+		if (Slop <= Precision)
+		{
+			FIKSolveStats::Record(OutStats, EIKSolveTermination::IK_AlreadyAtTarget, 0, Slop);
+			return false;
+		}
+
+		// Set tip bone at end effector location.
+		Points[EffectorIndex] = EffectorTargetLocation;
+
+		FIKIterationMonitor Monitor(Precision, MaxIterations, StagnationRatio);
+		while (Monitor.ShouldContinue(Slop))
+		{
+			// "Forward Reaching" stage - adjust bones from end effector.
+			for (int32 PointIndex = EffectorIndex - 1; PointIndex > 0; --PointIndex)
+			{
+				Points[PointIndex] = DragPoint(Points[PointIndex + 1], BoneLengths[PointIndex + 1], Points[PointIndex]);
+				EnforceConstraint(CompiledConstraints, PointIndex - 1, Points);
+			}
+
+			// Drag the root if enabled
+			Points[0] = DragPointTethered(StartPoints[0], Points[1], BoneLengths[1],
+				MaxRootDragDistance, RootDragStiffness, Points[0]);
+
+			// "Backward Reaching" stage - adjust bones from root.
+			for (int32 PointIndex = 1; PointIndex < EffectorIndex; ++PointIndex)
+			{
+				Points[PointIndex] = DragPoint(Points[PointIndex - 1], BoneLengths[PointIndex], Points[PointIndex]);
+				EnforceConstraint(CompiledConstraints, PointIndex - 1, Points);
+			}
+
+			Slop = FMath::Abs(BoneLengths[EffectorIndex] -
+				FVector::Dist(Points[EffectorIndex - 1], EffectorTargetLocation));
+		}
+		Monitor.Report(OutStats);
+
+		// Place effector based on how close we got to the target
+		Points[EffectorIndex] = Points[EffectorIndex - 1] +
+			(Points[EffectorIndex] - Points[EffectorIndex - 1]).GetUnsafeNormal() * BoneLengths[EffectorIndex];
+
+		// Write back locations, then update bone rotations
+		FTransform* OutData = OutTransforms.GetData();
+		for (int32 PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+		{
+			OutData[PointIndex].SetLocation(Points[PointIndex]);
+		}
+
+		for (int32 PointIndex = 0; PointIndex < EffectorIndex; ++PointIndex)
+		{
+			if (!FMath::IsNearlyZero(BoneLengths[PointIndex + 1]))
+			{
+				FRangeLimitedFABRIK::UpdateParentRotation(OutData[PointIndex], InData[PointIndex],
+					OutData[PointIndex + 1], InData[PointIndex + 1]);
+			}
+		}
+
+		return true;
+	}
+
+protected:
+
+	// Moves the child of point ConstraintIndex to satisfy that point's constraint
+	static FORCEINLINE void EnforceConstraint(
+		const FIKCompiledConstraint* CompiledConstraints,
+		int32 ConstraintIndex,
+		FVector (&Points)[NumPoints])
+	{
+		if (CompiledConstraints != nullptr &&
+			CompiledConstraints[ConstraintIndex].Type == EIKCompiledConstraintType::IKCC_Planar)
+		{
+			Points[ConstraintIndex + 1] = FPlanarRotation::EnforceCompiled(
+				CompiledConstraints[ConstraintIndex],
+				Points[ConstraintIndex],
+				Points[ConstraintIndex + 1]
+			);
+		}
+	}
+
+	// Location-only versions of FRangeLimitedFABRIK::DragPoint and DragPointTethered
+	static FORCEINLINE FVector DragPoint(
+		const FVector& MaintainDistancePoint,
+		float BoneLength,
+		const FVector& PointToMove)
+	{
+		return MaintainDistancePoint + (PointToMove - MaintainDistancePoint).GetUnsafeNormal() * BoneLength;
+	}
+
+	static FORCEINLINE FVector DragPointTethered(
+		const FVector& TetherPoint,
+		const FVector& MaintainDistancePoint,
+		float BoneLength,
+		float MaxDragDistance,
+		float DragStiffness,
+		const FVector& PointToDrag)
+	{
+		if (MaxDragDistance < KINDA_SMALL_NUMBER || DragStiffness < KINDA_SMALL_NUMBER)
+		{
+			return TetherPoint;
+		}
+
+		FVector Target = FMath::IsNearlyZero(BoneLength) ? MaintainDistancePoint :
+			DragPoint(MaintainDistancePoint, BoneLength, PointToDrag);
+
+		// Root drag stiffness 'pulls' the root back (set to 1.0 to disable), then limit displacement to drag length
+		FVector Displacement = (Target - TetherPoint) / DragStiffness;
+		return TetherPoint + Displacement.GetClampedToMaxSize(MaxDragDistance);
+	}
+};
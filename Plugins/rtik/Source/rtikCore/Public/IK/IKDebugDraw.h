@@ -0,0 +1,30 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+* Debug drawing for solvers and constraints. rtikCore has no world to draw into, so a caller that wants debug
+* drawing passes one of these to the solver, which hands it on to the chain's constraints. Pass nullptr to draw
+* nothing.
+*
+* Locations and directions are in the space the chain is solved in (for the anim nodes, component space); the
+* implementation maps them into the world. Called from whichever thread runs the solve.
+*
+* rtik implements this for characters; see FIKCharacterDebugDrawer.
+*/
+class RTIKCORE_API IIKDebugDrawer
+{
+public:
+
+	virtual ~IIKDebugDrawer()
+	{ }
+
+	// Draws a direction from Base, at a fixed length
+	virtual void DrawVector(const FVector& Base, const FVector& Direction, const FLinearColor& Color) = 0;
+
+	// Draws text at Offset from the owner of the chain. Format is a printf-style string literal taking two floats.
+	virtual void DrawValueString(const FVector& Offset, const TCHAR* Format, float Value, float SecondValue,
+		const FColor& Color) = 0;
+};
@@ -0,0 +1,101 @@
+// Copyright (c) Henry Cooney 2017
+
+/*
+* Small vector-space geometry kernels shared by the IK solvers and nodes.
+*
+* These work from dot and cross products directly, instead of going through Acos and back through
+* sin / cos to rebuild a rotation. Inputs are expected in the same space; directions are noted where
+* they must be normalized.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FIKMath
+{
+public:
+
+	// Shortest rotation taking unit vector From onto unit vector To. Unlike FQuat::FindBetweenNormals, if the
+	// vectors point in opposite directions the rotation is 180 degrees around FallbackAxis (which must be normalized
+	// and should be perpendicular to From), rather than around an arbitrary axis.
+	static FORCEINLINE FQuat ShortestArc(const FVector& From, const FVector& To, const FVector& FallbackAxis)
+	{
+		if (FVector::CrossProduct(From, To).SizeSquared() <= SMALL_NUMBER && FVector::DotProduct(From, To) < 0.0f)
+		{
+			return FQuat(FallbackAxis.X, FallbackAxis.Y, FallbackAxis.Z, 0.0f);
+		}
+
+		return FQuat::FindBetweenNormals(From, To);
+	}
+
+	// Rotation by the angle whose cosine is CosAngle, around the normalized Axis. Uses the half-angle identities,
+	// so no trig is needed. The angle is taken to be in [0, 180] degrees.
+	static FORCEINLINE FQuat QuatFromAxisAndCos(const FVector& Axis, float CosAngle)
+	{
+		CosAngle = FMath::Clamp(CosAngle, -1.0f, 1.0f);
+		float HalfSin = FMath::Sqrt(0.5f * (1.0f - CosAngle));
+		float HalfCos = FMath::Sqrt(0.5f * (1.0f + CosAngle));
+		return FQuat(Axis.X * HalfSin, Axis.Y * HalfSin, Axis.Z * HalfSin, HalfCos);
+	}
+
+	// Angle in radians, in [-PI, PI], between From and To. Neither needs to be normalized. The angle is positive
+	// if From x To points the same way as SignReference, else negative. Returns 0 if From and To are colinear.
+	static FORCEINLINE float SignedAngle(const FVector& From, const FVector& To, const FVector& SignReference)
+	{
+		FVector Cross = FVector::CrossProduct(From, To);
+		float CrossSizeSquared = Cross.SizeSquared();
+		if (CrossSizeSquared <= SMALL_NUMBER)
+		{
+			return 0.0f;
+		}
+
+		float Sin = FMath::Sqrt(CrossSizeSquared);
+		if (FVector::DotProduct(Cross, SignReference) <= 0.0f)
+		{
+			Sin = -Sin;
+		}
+
+		return FMath::Atan2(Sin, FVector::DotProduct(From, To));
+	}
+
+	// Maps a direction on a plane, given by its cosine and sine against the plane's 0-angle direction, to a value
+	// in [-2, 2] that increases monotonically with the signed angle in (-180, 180] degrees. Zero degrees maps to zero.
+	// Comparing these is equivalent to comparing the angles themselves. Only the sign of SinAngle is used.
+	static FORCEINLINE float PlanarPseudoAngle(float CosAngle, float SinAngle)
+	{
+		return (SinAngle > 0.0f) ? (1.0f - CosAngle) : (CosAngle - 1.0f);
+	}
+
+	// Projects Direction onto the plane spanned by the orthonormal vectors Forward and Up, and clamps it to lie
+	// between MinDirection and MaxDirection (given with their pseudo-angles; see PlanarPseudoAngle). Direction
+	// need not be normalized, but must not be normal to the plane. Returns a unit vector on the plane.
+	static FORCEINLINE FVector ClampPlanarDirection(
+		const FVector& Direction,
+		const FVector& Forward,
+		const FVector& Up,
+		const FVector& MinDirection,
+		float MinPseudoAngle,
+		const FVector& MaxDirection,
+		float MaxPseudoAngle)
+	{
+		float X = FVector::DotProduct(Direction, Forward);
+		float Y = FVector::DotProduct(Direction, Up);
+		float InvLength = FMath::InvSqrt(X * X + Y * Y);
+		X *= InvLength;
+		Y *= InvLength;
+
+		// Same ordering as FMath::Clamp, so inverted limits behave the same way
+		float PseudoAngle = PlanarPseudoAngle(X, Y);
+		if (PseudoAngle < MinPseudoAngle)
+		{
+			return MinDirection;
+		}
+		else if (PseudoAngle >= MaxPseudoAngle)
+		{
+			return MaxDirection;
+		}
+
+		return Forward * X + Up * Y;
+	}
+};
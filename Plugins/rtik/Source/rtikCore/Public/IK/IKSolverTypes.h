@@ -0,0 +1,465 @@
+// Copyright (c) Henry Cooney 2017
+
+/*
+* Types shared by the solvers: how a solve is configured and how it went, and bone constraints. Needs nothing
+* from the engine beyond Core and CoreUObject; skeleton-aware types (bones, chains) are in IK.h, in rtik.
+*/
+
+#pragma once
+
+#include "rtikCore.h"
+#include "CoreMinimal.h"
+#include "UObject/ObjectMacros.h"
+#include "UObject/Object.h"
+#include "IKStats.h"
+#include "IKDebugDraw.h"
+#include "IKSolverTypes.generated.h"
+
+#define ENABLE_IK_DEBUG (1 && !(UE_BUILD_SHIPPING || UE_BUILD_TEST))
+#define ENABLE_IK_DEBUG_VERBOSE (0 && !(UE_BUILD_SHIPPING || UE_BUILD_TEST))
+
+
+/*
+* Specifies what IK should do if the target is unreachable
+*/
+UENUM(BlueprintType)
+enum class EIKUnreachableRule : uint8
+{
+	// Abort IK, return to pre-IK pose
+	IK_Abort        UMETA(DisplayName = "Abort IK"),
+
+	// Reach as far toward the target as possible. The root bone moves only as far as the solver's root drag settings allow
+	IK_Reach        UMETA(DisplayName = "Reach for Target"),
+	
+	// Drag the root bone toward the target so it can be reached, ignoring root drag limits (caution, this is likely to give weird results)
+	IK_DragRoot     UMETA(DisplayName = "Drag Chain Root")
+
+};
+
+/*
+* Why an iterative solver stopped
+*/
+UENUM(BlueprintType)
+enum class EIKSolveTermination : uint8
+{
+	// The solver did not run (e.g., the chain was too short)
+	IK_NotSolved       UMETA(DisplayName = "Not Solved"),
+
+	// The effector started within Precision of the target; nothing moved
+	IK_AlreadyAtTarget UMETA(DisplayName = "Already At Target"),
+
+	// The effector reached the target, within Precision
+	IK_Converged       UMETA(DisplayName = "Converged"),
+
+	// An iteration improved the slop by less than the stagnation ratio, so further iterations were not worth running
+	// (typically, constraints keep the target out of reach)
+	IK_Stagnated       UMETA(DisplayName = "Stagnated"),
+
+	// Ran out of iterations
+	IK_MaxIterations   UMETA(DisplayName = "Max Iterations"),
+
+	// The target was out of reach; see EIKUnreachableRule. Unconstrained chains are handled directly, without
+	// iterating; constrained chains iterate until the slop settles.
+	IK_Unreachable     UMETA(DisplayName = "Unreachable")
+};
+
+// Reported by an iterative solver for one solve
+struct FIKSolveStats
+{
+	// Iterations actually run
+	int32 Iterations;
+
+	// Final distance measure between effector and target, as used by the solver's Precision test
+	float FinalSlop;
+
+	EIKSolveTermination Termination;
+
+	FIKSolveStats()
+		:
+		Iterations(0),
+		FinalSlop(0.0f),
+		Termination(EIKSolveTermination::IK_NotSolved)
+	{ }
+
+	// Every solver reports its outcome here once per solve, so the RTIK stat counters are kept here as well;
+	// Stats may be nullptr
+	static FORCEINLINE void Record(FIKSolveStats* Stats, EIKSolveTermination Termination, int32 Iterations = 0,
+		float FinalSlop = 0.0f)
+	{
+		if (Stats != nullptr)
+		{
+			Stats->Iterations  = Iterations;
+			Stats->FinalSlop   = FinalSlop;
+			Stats->Termination = Termination;
+		}
+
+#if STATS
+		CountSolve(Termination, Iterations, FinalSlop);
+#endif // STATS
+
+		FIKFrameCounters::AddSolve(Iterations);
+	}
+
+#if STATS
+	static FORCEINLINE void CountSolve(EIKSolveTermination Termination, int32 Iterations, float FinalSlop)
+	{
+		INC_DWORD_STAT(STAT_RTIK_Solves);
+		INC_DWORD_STAT_BY(STAT_RTIK_Iterations, Iterations);
+
+		switch (Termination)
+		{
+		case EIKSolveTermination::IK_NotSolved:
+			INC_DWORD_STAT(STAT_RTIK_NotSolved);
+			return;
+		case EIKSolveTermination::IK_AlreadyAtTarget:
+			INC_DWORD_STAT(STAT_RTIK_AlreadyAtTarget);
+			return;
+		case EIKSolveTermination::IK_Unreachable:
+			INC_DWORD_STAT(STAT_RTIK_Unreachable);
+			return;
+		case EIKSolveTermination::IK_Converged:
+			INC_DWORD_STAT(STAT_RTIK_Converged);
+			break;
+		case EIKSolveTermination::IK_Stagnated:
+			INC_DWORD_STAT(STAT_RTIK_Stagnated);
+			break;
+		case EIKSolveTermination::IK_MaxIterations:
+			INC_DWORD_STAT(STAT_RTIK_MaxIterations);
+			break;
+		}
+
+		// Slop bands only mean something for solves that iterated
+		if (FinalSlop < 0.1f)
+		{
+			INC_DWORD_STAT(STAT_RTIK_SlopTiny);
+		}
+		else if (FinalSlop < 1.0f)
+		{
+			INC_DWORD_STAT(STAT_RTIK_SlopSmall);
+		}
+		else if (FinalSlop < 10.0f)
+		{
+			INC_DWORD_STAT(STAT_RTIK_SlopMedium);
+		}
+		else
+		{
+			INC_DWORD_STAT(STAT_RTIK_SlopLarge);
+		}
+	}
+#endif // STATS
+};
+
+// Decides when an iterative solve should stop, and why. Use as the loop condition:
+// while (Monitor.ShouldContinue(Slop)) { ...iterate, update Slop... }
+struct FIKIterationMonitor
+{
+public:
+
+	// The solve stagnates after this many iterations in a row each improve the slop by less than StagnationRatio.
+	// FABRIK often makes little progress for an iteration or two, then speeds up again as the chain unfolds.
+	enum { StagnantIterationsToStop = 3 };
+
+	// A StagnationRatio of 0 disables the stagnation test, so only Precision and MaxIterations stop the solve
+	FIKIterationMonitor(float InPrecision, int32 InMaxIterations, float InStagnationRatio)
+		:
+		Precision(InPrecision),
+		MaxIterations(InMaxIterations),
+		StagnationRatio(InStagnationRatio),
+		Iterations(0),
+		StagnantIterations(0),
+		LastSlop(0.0f),
+		Termination(EIKSolveTermination::IK_NotSolved)
+	{ }
+
+	FORCEINLINE bool ShouldContinue(float Slop)
+	{
+		// The first iteration's slop is measured differently from the starting slop, so compare from the second on
+		if (StagnationRatio > 0.0f && Iterations > 1)
+		{
+			StagnantIterations = ((LastSlop - Slop) < StagnationRatio * LastSlop) ? StagnantIterations + 1 : 0;
+		}
+
+		if (Slop <= Precision)
+		{
+			Termination = EIKSolveTermination::IK_Converged;
+		}
+		else if (StagnantIterations >= StagnantIterationsToStop)
+		{
+			Termination = EIKSolveTermination::IK_Stagnated;
+		}
+		else if (Iterations >= MaxIterations)
+		{
+			Termination = EIKSolveTermination::IK_MaxIterations;
+		}
+		else
+		{
+			LastSlop = Slop;
+			++Iterations;
+			return true;
+		}
+
+		LastSlop = Slop;
+		return false;
+	}
+
+	// If bTargetUnreachable, a solve that didn't converge is reported as IK_Unreachable; no iteration count would
+	// have been enough
+	FORCEINLINE void Report(FIKSolveStats* Stats, bool bTargetUnreachable = false) const
+	{
+		bool bReportUnreachable = bTargetUnreachable && Termination != EIKSolveTermination::IK_Converged;
+		FIKSolveStats::Record(Stats, bReportUnreachable ? EIKSolveTermination::IK_Unreachable : Termination,
+			Iterations, LastSlop);
+	}
+
+protected:
+	float Precision;
+	int32 MaxIterations;
+	float StagnationRatio;
+	int32 Iterations;
+	int32 StagnantIterations;
+	float LastSlop;
+	EIKSolveTermination Termination;
+};
+
+// Adapts an iterative solver's iteration budget to how a chain actually converges. Nodes keep one of these, ask it
+// for the budget before each solve, and record each solve's stats afterward.
+//
+// It keeps a short rolling history of solves. If the chain has converged every time recently, the budget drops
+// to one more than the most iterations any of those solves needed. If a solve runs out of a lowered budget, the
+// budget goes straight back to MaxIterations. The budget never exceeds MaxIterations unless the node opts in with
+// bAllowGrowth; then, if the chain chronically runs out of iterations at full budget (over a quarter of recent
+// solves), the budget grows past MaxIterations, up to a global ceiling. Solves that stagnate don't count; more
+// iterations wouldn't help them.
+//
+// Console variables: rtik.AdaptiveIterations (0 disables adapting everywhere) and rtik.MaxIterationsCeiling.
+struct RTIKCORE_API FIKAdaptiveIterations
+{
+public:
+
+	FIKAdaptiveIterations()
+	{
+		Reset();
+	}
+
+	// Iterations to allow the next solve, given the designer's MaxIterations. More than MaxIterations only if
+	// bAllowGrowth.
+	int32 GetBudget(int32 MaxIterations, bool bAllowGrowth = false) const;
+
+	// Records how a solve, run with the budget from GetBudget, went. Pass the same bAllowGrowth as to GetBudget.
+	void Record(const FIKSolveStats& Stats, int32 MaxIterations, bool bAllowGrowth = false);
+
+	// Forget the history and go back to MaxIterations
+	void Reset();
+
+protected:
+
+	enum { HistorySize = 16 };
+
+	int32 IterationHistory[HistorySize];
+	bool MissHistory[HistorySize];
+	int32 NumRecorded;
+	int32 NextIndex;
+
+	// 0 until the history first fills
+	int32 Budget;
+
+	// MaxIterations the history was recorded with; if the designer changes it, start over
+	int32 RecordedMaxIterations;
+};
+
+struct FIKCompiledConstraint;
+
+/*
+* A range-of-motion constraint on a bone used in IK.
+* 
+* ROM constraints have access to the entire bone chain, before and after IK, and
+* may modify and and all transforms in the chain. 
+* 
+* The base constraint type does nothing.
+*/
+
+USTRUCT(BlueprintType)
+struct RTIKCORE_API FIKBoneConstraint 
+{
+	
+	GENERATED_USTRUCT_BODY()
+
+public:
+
+	// Constraint should only be enforced if this is set to true
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Settings")
+	bool bEnabled;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Settings")
+	bool bEnableDebugDraw;
+
+public:
+
+	FIKBoneConstraint()
+		:
+		bEnabled(true),
+		bEnableDebugDraw(false)
+	{ }
+
+	virtual ~FIKBoneConstraint()
+	{ }
+
+	// Initialize the constraint. This function must be called before
+	// the constraint is used. Returns initialization success.	
+	virtual	bool Initialize() 
+	{
+		return true;
+	}
+
+	// Enforces the constraint. Will modify OutCSTransforms if needed.
+	// @param Index - The index of this constraint in Constraints; should correspond to the same bone in in InCSTransforms and OutCSTransforms
+	// @param ReferenceCSTransforms - Array of bone transforms before skeletal controls (e.g., IK) are applied. Not necessarily in the reference pose (although they might be, depending on your needs)
+	// @param Constraints - Array of constraints for each bone (including this one, at index Index)	
+	// @param CSTransforms - Array of transforms as skeletal controls (e.g., IK) are being applied; this array will be modified in place
+	// @param DebugDrawer - Optional; may be left as nullptr, but is required for debug drawing.
+	virtual void EnforceConstraint(
+		int32 Index,
+		const TArray<FTransform>& ReferenceCSTransforms,
+		const TArray<FIKBoneConstraint*>& Constraints,
+		TArray<FTransform>& CSTransforms,
+		IIKDebugDrawer* DebugDrawer = nullptr
+	) { }
+
+	// Bakes this constraint into OutCompiled, so solvers can enforce it without virtual calls. Settings are read 
+	// once, at compile time; chains compile their constraints when bone references are initialized.
+	void Compile(FIKCompiledConstraint& OutCompiled);
+
+	// Optional lambda to evaluate before the constraint is enforced. It can set up examine the chain and set 
+	// things up appropriately. Leave unbound if not needed; constraints with a SetupFn always take the slow
+	// (virtual) path through EnforceConstraint.
+	TFunction<void(
+		int32 Index,
+		const TArray<FTransform>& ReferenceCSTransforms,
+		const TArray<FIKBoneConstraint*>& Constraints,
+		TArray<FTransform>& CSTransforms
+		)> SetupFn;
+
+protected:
+
+	// Subclasses may override this to fill in a compiled representation. Return false if the constraint
+	// can only be enforced through EnforceConstraint.
+	virtual bool CompileInto(FIKCompiledConstraint& OutCompiled) const
+	{
+		return false;
+	}
+};
+
+/*
+* How a compiled constraint is enforced by the solver
+*/
+enum class EIKCompiledConstraintType : uint8
+{
+	// Nothing to enforce (no constraint, disabled, or FNoBoneConstraint)
+	IKCC_None,
+
+	// Planar rotation, enforced inline from precomputed basis vectors
+	IKCC_Planar,
+
+	// Anything else; enforced by calling SetupFn and EnforceConstraint on Source
+	IKCC_Custom
+};
+
+/*
+* A constraint baked into plain data for the FABRIK passes. Only the fields for Type are meaningful.
+*/
+struct RTIKCORE_API FIKCompiledConstraint
+{
+public:
+
+	FIKCompiledConstraint()
+		:
+		Type(EIKCompiledConstraintType::IKCC_None),
+		Source(nullptr)
+	{ }
+
+	EIKCompiledConstraintType Type;
+
+	// The constraint this was compiled from; used by IKCC_Custom
+	FIKBoneConstraint* Source;
+
+	// Planar: rotation axis, and an orthonormal basis for the rotation plane
+	FVector RotationAxis;
+	FVector ForwardDirection;
+	FVector UpDirection;
+
+	// Planar: direction used when the bone is normal to the rotation plane, already projected onto the plane
+	FVector FailsafeDirection;
+
+	// Planar: bone directions at the angle limits
+	FVector MinDirection;
+	FVector MaxDirection;
+
+	// Planar: angle limits as monotonic pseudo-angles, built from the cosine and sine of each limit. 
+	// See FIKMath::PlanarPseudoAngle.
+	float MinPseudoAngle;
+	float MaxPseudoAngle;
+};
+
+/*
+* The constraints of a chain, compiled once and reused every solve.
+*/
+struct RTIKCORE_API FIKCompiledConstraintTable
+{
+public:
+
+	FIKCompiledConstraintTable()
+		:
+		bHasActiveConstraints(false)
+	{ }
+
+	// One constraint per chain point, root first. May contain nulls.
+	TArray<FIKBoneConstraint*> Constraints;
+
+	// Constraints, compiled. Same length as Constraints.
+	TArray<FIKCompiledConstraint> Entries;
+
+	// False if every entry is IKCC_None, in which case solvers skip constraint enforcement entirely
+	bool bHasActiveConstraints;
+
+	// Copies InConstraints and compiles each one
+	void Compile(const TArray<FIKBoneConstraint*>& InConstraints);
+
+	void Reset();
+
+	int32 Num() const
+	{
+		return Entries.Num();
+	}
+
+	// Compiles InConstraints into OutEntries. Returns true if any entry needs enforcing.
+	template<typename AllocatorType>
+	static bool CompileEntries(const TArray<FIKBoneConstraint*>& InConstraints, TArray<FIKCompiledConstraint, AllocatorType>& OutEntries)
+	{
+		bool bAnyActive = false;
+		OutEntries.Reset(InConstraints.Num());
+		for (FIKBoneConstraint* Constraint : InConstraints)
+		{
+			FIKCompiledConstraint& Entry = OutEntries[OutEntries.AddDefaulted()];
+			if (Constraint != nullptr)
+			{
+				Constraint->Compile(Entry);
+				bAnyActive |= (Entry.Type != EIKCompiledConstraintType::IKCC_None);
+			}
+		}
+		return bAnyActive;
+	}
+};
+
+/*
+ * Wrapper class allows these to be set 'polymorphically' during property-window setup
+ */
+UCLASS(BlueprintType, EditInlineNew, DefaultToInstanced, abstract)
+class RTIKCORE_API UIKBoneConstraintWrapper : public UObject
+{ 
+	GENERATED_BODY()
+
+public:
+
+	// Subclasses must override this to return the internal constraint struct
+	virtual FIKBoneConstraint* GetConstraint() { return nullptr; }
+};
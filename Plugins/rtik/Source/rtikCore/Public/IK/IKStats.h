@@ -0,0 +1,109 @@
+// Copyright (c) Henry Cooney 2017
+
+/*
+* Stats for the RTIK solvers and nodes. Use 'stat RTIK' to view them in game, or capture them with the stats profiler.
+*
+* Counters are per frame. Node cycle stats are scoped by the owning actor as well, so a stats capture shows
+* which characters the time was spent on.
+*
+* FIKFrameCounters keeps a few of the same totals without the stats system, for tools that run without a stats
+* capture (such as the demo project's crowd stress test).
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("RTIK"), STATGROUP_RTIK, STATCAT_Advanced);
+
+// Solves, and how they ended. See EIKSolveTermination.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Solves"), STAT_RTIK_Solves, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Solver Iterations"), STAT_RTIK_Iterations, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Solves Already At Target"), STAT_RTIK_AlreadyAtTarget, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Solves Converged"), STAT_RTIK_Converged, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Solves Stagnated"), STAT_RTIK_Stagnated, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Solves Out Of Iterations"), STAT_RTIK_MaxIterations, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Solves Unreachable"), STAT_RTIK_Unreachable, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Solves Not Run"), STAT_RTIK_NotSolved, STATGROUP_RTIK, RTIKCORE_API);
+
+// Final slop of iterated solves, in bands
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Final Slop < 0.1"), STAT_RTIK_SlopTiny, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Final Slop 0.1 - 1"), STAT_RTIK_SlopSmall, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Final Slop 1 - 10"), STAT_RTIK_SlopMedium, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Final Slop >= 10"), STAT_RTIK_SlopLarge, STATGROUP_RTIK, RTIKCORE_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Constraint Enforcements"), STAT_RTIK_ConstraintEnforcements, STATGROUP_RTIK, RTIKCORE_API);
+
+// Ground traces
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces Issued"), STAT_RTIK_TracesIssued, STATGROUP_RTIK, RTIKCORE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces Skipped"), STAT_RTIK_TracesSkipped, STATGROUP_RTIK, RTIKCORE_API);
+
+// Totals of node time, solves and traces, from every thread, since they were last consumed. Counting is off until
+// enabled; when off, each count costs one branch.
+struct RTIKCORE_API FIKFrameCounters
+{
+public:
+
+	struct FTotals
+	{
+		FTotals()
+			:
+			NodeSeconds(0.0),
+			Solves(0),
+			Iterations(0),
+			TracesIssued(0),
+			TracesSkipped(0)
+		{ }
+
+		// Summed over all threads
+		double NodeSeconds;
+
+		int64 Solves;
+		int64 Iterations;
+		int64 TracesIssued;
+		int64 TracesSkipped;
+	};
+
+	static void SetEnabled(bool bInEnabled);
+
+	static bool IsEnabled()
+	{
+		return bEnabled;
+	}
+
+	static void AddNodeCycles(uint32 Cycles);
+	static void AddSolve(int32 Iterations);
+	static void AddTraces(int32 Issued, int32 Skipped);
+
+	// Returns the totals counted since the last call, and starts counting again from zero
+	static FTotals Consume();
+
+	// Times a node evaluation, if counting is enabled
+	struct FNodeScope
+	{
+		FNodeScope()
+			:
+			StartCycles(IsEnabled() ? FPlatformTime::Cycles() : 0)
+		{ }
+
+		~FNodeScope()
+		{
+			if (StartCycles != 0)
+			{
+				AddNodeCycles(FPlatformTime::Cycles() - StartCycles);
+			}
+		}
+
+		uint32 StartCycles;
+	};
+
+private:
+
+	static bool bEnabled;
+	static volatile int64 NodeCycles;
+	static volatile int64 Solves;
+	static volatile int64 Iterations;
+	static volatile int64 TracesIssued;
+	static volatile int64 TracesSkipped;
+};
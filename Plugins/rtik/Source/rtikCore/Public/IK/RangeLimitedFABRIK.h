@@ -0,0 +1,665 @@
+﻿// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/MemStack.h"
+#include "IKSolverTypes.h"
+
+
+//	Range-limited FABRIK solvers and related functions. Does not need to be in the context of a Skeleton; 
+//	this solver is designed to work with generic transforms. Make sure all transforms are in the same space, though!
+//
+//	See www.andreasaristidou.com/FABRIK.html for details of the FABRIK algorithm.
+
+
+// A three-point closed loop, containing two noisy effectors.
+// This is a very specific type of IK 'chain', used for the torso upper and lower body triangles.
+
+struct RTIKCORE_API FNoisyThreePointClosedLoop
+{
+public:
+
+	FNoisyThreePointClosedLoop(const FTransform& InEffectorATransform, 
+		const FTransform& InEffectorBTransform,
+		const FTransform& InRootTransform,
+		float InTargetRootADistance,
+		float InTargetRootBDistance,
+		float InTargetABDistance)
+		:
+		EffectorATransform(InEffectorATransform),
+		EffectorBTransform(InEffectorBTransform),
+		RootTransform(InRootTransform),
+		TargetRootADistance(InTargetRootADistance),
+		TargetRootBDistance(InTargetRootBDistance),
+		TargetABDistance(InTargetABDistance)
+	{ }
+		
+	FNoisyThreePointClosedLoop()
+	{ }
+
+	// The first noisy effector
+	FTransform EffectorATransform;
+
+	// The second noisy effector
+	FTransform EffectorBTransform;
+
+	// The root transform. Not IKed onto a target location, but may be constrained not to drag too far from
+	// its starting position	
+	FTransform RootTransform;
+
+	// The desired distance between A and the root	
+	float TargetRootADistance; 
+
+	// The desired distance between B and the root
+	float TargetRootBDistance;
+
+	// The desired distance between A and B
+	float TargetABDistance;
+};
+
+struct RTIKCORE_API FRangeLimitedFABRIK
+{
+public:
+
+	// Temporary per-solve arrays are allocated from the calling thread's FMemStack, so solving does not
+	// touch the heap once the stack is warm. Never hold onto one of these past the solve that made it.
+	typedef TArray<float, TMemStackAllocator<>> FScratchFloatArray;
+	typedef TArray<FIKCompiledConstraint, TMemStackAllocator<>> FScratchConstraintArray;
+	typedef TArray<FVector, TMemStackAllocator<>> FScratchVectorArray;
+	typedef TArray<int32, TMemStackAllocator<>> FScratchIndexArray;
+
+	template<int32 NumPoints>
+	friend struct TFixedChainFABRIK;
+	friend struct FAnalyticIK;
+	
+	// Uses the FABRIK algorithm to solve the IK problem on a chain of rigidly-connected points.	
+	//  
+	// InTransforms is a list of transforms representing the starting position of each point. The 0th element
+	// of this array is the ROOT. The last element is the EFFECTOR (sometimes called the 'tip' in code).
+	//
+	// The root point represents the start of the chain; its displacement from its starting position is limited.
+	// The effector represents the end of the chain, FABRIK will attempt to move this to EffectorTargetLocation,
+	// while maintaining inter-point distances.
+	//
+	// Each chain point, except the effector, has a CHILD - this is simply the next point in the chain. Correspondingly,
+	// each point except the root has a PARENT, which is the previous point. The displacement between a parent and its child 
+	// is loosely referred to as a BONE.	
+	// 
+	// FABRIK is an iterative algorithm. It will adjust each point in the chain in a forward-and-backward manner,
+	// until either the distance between the effector and EffectorTargetLocation is less than Precision, or MaxIterations
+	// iterations (up and down the chain) have been performed.
+	//
+	// In principal, FABRIK pays attention only to the location of each chain point, not their rotations. However, 
+	// this is impractical when working with skeletal bones. Once the final locations of each chain point are 
+	// determined, the rotation of each transform is updated as follows:
+	// 
+	// - Let P be a chain point which is not effector, and let C be its child, before FABRIK
+	// - Let P' and C' be the corresponding chain points after FABRIK is applied
+	// - Let Q be the shortest rotation from (C - P) to (C' - P')
+	// - Add the rotation Q to the rotation of P'	
+	//
+	// In other words, the rotation of each point transform is updated with the smallest rotation to make it 
+	// 'point toward' the newly adjusted child point.	
+	//
+	// The effector's rotation is NOT updated (unlike in the UE4 FABRIK implementation), you will need to do this
+	// yourself after running FABRIK.
+	//
+	// Parameter descriptions follow:
+	// 	
+	// @param InTransforms - The starting transforms of each chain point. Not modified. Must contain at least 2 transforms.
+	// @param Constraints - Constraints corresponding to each chain point; entries should be set to nullptr for points that don't need a constraint.
+	//   Constraints are enforced each time a point moves.	
+	//	 Strong constraints may degrade the results of FABRIK, it's up to you to figure out what works.
+	// @param EffectorTargetLocation - Where you want the effector to go. FABRIK will attempt to move the effector as close
+	//   as possible to this point.
+	// @param OutTransforms - The updated transforms for each chain point after FABRIK runs. Will be reset and filled with new transforms;
+	//   its allocation is kept, so callers can reuse the same array every frame without reallocating.
+	// @param MaxRootDragDistance - How far the root may move from its original position. Set to 0 for no movement.
+	// @param RootDragStiffness - How much the root will resist being moved from the original position. 1.0 means no resistance; 
+	//   increase for more resistance. Settings less than 1.0 will make it move more.
+	// @param Precision - Iteration will terminate when the effector is within this distance from the target.
+	//   Decrease for possibly better results but possibly worse performance.
+	// @param MaxIterations - The maximum number of iterations to run. Increase for possibly better results but 
+	//   possibly worse performance.
+	// @param UnreachableRule - What to do if the target is farther from the root than the chain can reach. Unreachable
+	//   targets are solved in a single pass, by laying the chain out straight toward the target; see EIKUnreachableRule.
+	//   With active constraints, the straight chain is only the starting pose, and the solver iterates from it.
+	// @param DebugDrawer - Used for debug drawing. May safely be set to nullptr or ignored.
+	// @param Relaxation - Over-relaxation factor. Each iteration, points are pushed this many times as far as the
+	//   forward pass moved them, before the backward pass pulls them back into a valid chain. 1.0 is plain FABRIK;
+	//   values a little above 1 (1.2 - 1.5) often converge in fewer iterations, too high will overshoot.
+	// @param StagnationRatio - Iteration stops early if several iterations in a row each improve the slop by less 
+	//   than this fraction (e.g., 0.01 for 1%), as when constraints keep the target from being reached exactly. 0
+	//   disables this. See FIKIterationMonitor.
+	// @param OutStats - Optional. Receives the iteration count, final slop, and why the solve stopped.
+	// @return - True if any transforms in OutTransforms were updated; otherwise, false. If false, the contents of OutTransforms is identical to InTransforms.
+	static bool SolveRangeLimitedFABRIK(
+		const TArray<FTransform>& InTransforms,
+		const TArray<FIKBoneConstraint*>& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance = 0.0f,
+		float RootDragStiffness = 1.0f,
+		float Precision = 0.01f,
+		int32 MaxIterations = 20,
+		EIKUnreachableRule UnreachableRule = EIKUnreachableRule::IK_Reach,
+		IIKDebugDrawer* DebugDrawer = nullptr,
+		float Relaxation = 1.0f,
+		float StagnationRatio = 0.0f,
+		FIKSolveStats* OutStats = nullptr
+	);
+
+	// As above, but uses constraints that were compiled ahead of time (e.g., by the chain, at initialization).
+	// Prefer this when solving the same chain every frame; the overload above compiles the constraints on every call.
+	static bool SolveRangeLimitedFABRIK(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraintTable& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance = 0.0f,
+		float RootDragStiffness = 1.0f,
+		float Precision = 0.01f,
+		int32 MaxIterations = 20,
+		EIKUnreachableRule UnreachableRule = EIKUnreachableRule::IK_Reach,
+		IIKDebugDrawer* DebugDrawer = nullptr,
+		float Relaxation = 1.0f,
+		float StagnationRatio = 0.0f,
+		FIKSolveStats* OutStats = nullptr
+	);
+
+	// Hierarchical FABRIK for long chains (tails, tentacles, ropes), where plain FABRIK converges slowly.
+	//
+	// Every SegmentLength-th point is picked as a key point, and the chain of key points is solved first, with root
+	// dragging, for up to MaxIterations. Its bone lengths start as the straight-line distances between neighbouring
+	// keys; if those can't reach the target, they are all lengthened toward their segments' summed bone lengths, as
+	// if the segments straightened out. Each segment between two keys is then laid onto its solved key-to-key span, 
+	// keeping its shape, and refined with up to FineIterations iterations of FABRIK, its root fixed to the end of the
+	// previous segment. The key chain ignores constraints; planar constraints are enforced during refinement.
+	//
+	// Chains no longer than two segments, and chains with custom constraints, are solved by SolveRangeLimitedFABRIK.
+	// Other parameters and the return value are as in SolveRangeLimitedFABRIK. OutStats counts only the key chain's
+	// iterations.
+	//
+	// @param SegmentLength - Number of bones between key points. Must be at least 2.
+	// @param FineIterations - Maximum iterations for each segment's refinement.
+	static bool SolveCoarseToFineFABRIK(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraintTable& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance = 0.0f,
+		float RootDragStiffness = 1.0f,
+		float Precision = 0.01f,
+		int32 MaxIterations = 20,
+		int32 SegmentLength = 8,
+		int32 FineIterations = 3,
+		EIKUnreachableRule UnreachableRule = EIKUnreachableRule::IK_Reach,
+		IIKDebugDrawer* DebugDrawer = nullptr,
+		FIKSolveStats* OutStats = nullptr
+	);
+
+	// FABRIK for very long chains (ropes, cables), spread over worker threads.
+	//
+	// The chain is split into segments of SegmentLength bones. Each sweep first solves the short chain of segment
+	// boundary points with FABRIK, on the calling thread, using each segment's current end-to-end span as its bone
+	// length. Spans too short to reach the target are lengthened toward their segments' full length, as if the
+	// segments straightened. Then every segment is solved concurrently, with its root pinned to its start boundary
+	// and its end pulled onto the next boundary, for up to FineIterations iterations. Finally the segments are joined
+	// again, root to effector, each moved to start where the previous one ended. Sweeps stop once the joined chain's
+	// effector is within Precision of the target, or after MaxIterations sweeps; usually one or two are needed.
+	//
+	// Bone lengths are always kept exactly. The point placement differs from serial FABRIK's, but on long chains 
+	// the effector usually gets within Precision in far fewer passes over the chain. Chains shorter than 128 points
+	// are solved on the calling thread, without using workers.
+	//
+	// Chains no longer than two segments, and chains with custom constraints, are solved by SolveRangeLimitedFABRIK.
+	// Other parameters and the return value are as in SolveRangeLimitedFABRIK. OutStats counts sweeps as iterations.
+	//
+	// @param SegmentLength - Number of bones per segment. Must be at least 2.
+	// @param FineIterations - Maximum FABRIK iterations for each segment, per sweep.
+	static bool SolveParallelSegmentedFABRIK(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraintTable& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance = 0.0f,
+		float RootDragStiffness = 1.0f,
+		float Precision = 0.01f,
+		int32 MaxIterations = 20,
+		int32 SegmentLength = 32,
+		int32 FineIterations = 2,
+		EIKUnreachableRule UnreachableRule = EIKUnreachableRule::IK_Reach,
+		IIKDebugDrawer* DebugDrawer = nullptr,
+		FIKSolveStats* OutStats = nullptr
+	);
+
+	// Damped least squares (DLS) Jacobian solver. An alternative to FABRIK for heavily constrained chains, such as
+	// spines, where FABRIK tends to oscillate between the constraints and run out of iterations.
+	//
+	// Every joint is a ball joint, except that a joint with a planar constraint is a hinge around the constraint's
+	// rotation axis. Each iteration takes one damped least squares step toward the target. That needs only a 3x3 
+	// solve, whatever the chain length. The joint limits are then enforced from root to effector.
+	//
+	// The root never moves, except when the target is unreachable and UnreachableRule allows dragging it. Chains with
+	// custom constraints are solved by SolveRangeLimitedFABRIK. Other parameters and the return value are as in
+	// SolveRangeLimitedFABRIK.
+	//
+	// @param Damping - Distance, in the same units as the transforms, that controls how strongly each step is damped.
+	//   Higher values are more stable near singular poses (e.g., a fully stretched chain) but converge more slowly.
+	static bool SolveDampedLeastSquares(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraintTable& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float Precision = 0.01f,
+		int32 MaxIterations = 20,
+		float Damping = 1.0f,
+		EIKUnreachableRule UnreachableRule = EIKUnreachableRule::IK_Reach,
+		IIKDebugDrawer* DebugDrawer = nullptr,
+		FIKSolveStats* OutStats = nullptr
+	);
+
+	// Spline IK, for spines and tails: bends the chain along a smooth curve from its root to the target.
+	//
+	// The curve is a cubic from the root to EffectorTargetLocation, with tangents shaped like a circular arc: it bows
+	// out to one side as it leaves the root and back in as it reaches the target. How far it bows is fitted so the
+	// curve is as long as the chain. Each fitting step walks the chain along the curve from the root, each point
+	// placed where the curve is one bone length from the point before it, so bones keep their lengths; the bend is
+	// adjusted by how far past (or short of) the target the walk ends. That takes a few steps, each O(N), however long
+	// the chain. The last two bones then close what's left of the gap exactly, in the plane the walk left them in
+	// (a two-bone chain is solved by that alone).
+	//
+	// Targets very close to the root, which the chain could only reach by coiling into a near-complete loop, may not
+	// be reached. The root does not move, except as UnreachableRule allows for targets out of reach. Constraints are
+	// not enforced.
+	//
+	// @param InTransforms - The starting transforms of each chain point. Not modified.
+	// @param EffectorTargetLocation - Where the effector should go.
+	// @param OutTransforms - The updated transforms. Rotations are updated as in SolveRangeLimitedFABRIK.
+	// @param ControlPoints - Optional. The curve bows toward the first as it leaves the root, and toward the last as
+	//   it reaches the target; any in between are not used. Without any, it bows the way the first bone points.
+	// @param ArcLengths - Optional, from ComputeSplineArcLengths, usually once for the reference pose. If it doesn't
+	//   have an entry per point, bone lengths are measured from InTransforms.
+	// @param MaxIterations - Most fitting steps to take.
+	// Other parameters and the return value are as in SolveRangeLimitedFABRIK. OutStats counts fitting steps as
+	// iterations.
+	static bool SolveSplineIK(
+		const TArray<FTransform>& InTransforms,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		const TArray<FVector>& ControlPoints,
+		const TArray<float>& ArcLengths,
+		float Precision = 0.01f,
+		int32 MaxIterations = 20,
+		EIKUnreachableRule UnreachableRule = EIKUnreachableRule::IK_Reach,
+		IIKDebugDrawer* DebugDrawer = nullptr,
+		FIKSolveStats* OutStats = nullptr
+	);
+
+	// Arc-length table for SolveSplineIK: fills OutArcLengths with each point's distance from the root, along the
+	// chain. The last entry is the chain's length, which is returned.
+	static float ComputeSplineArcLengths(
+		const TArray<FTransform>& InTransforms,
+		TArray<float>& OutArcLengths
+	);
+
+	// Solves FABRIK on a CLOSED LOOP, that is, a chain where the effector is assumed to be connected to the root.
+	//
+	// Note that you will probably HAVE to use root dragging if you want this solver to work! If the root is not allowed to drag,
+	// the solution degenerates and this solver will behave like normal FABRIK.	
+	// 	
+	// I'm not sure how well constraints will work with this solver, but they are nonetheless supported for the sake of
+	// keeping a consistent interface. You're welcome to try them out but results may be bad.	
+	//
+	// @param InTransforms - The starting transforms of each chain point. Not modified. Must contain at least 2 transforms. Because this
+	//   is a closed loop, the last transform is assumed to be conneted to the first one.	
+	// @param Constraints - Constraints corresponding to each chain point; entries should be set to nullptr for points that don't need a constraint.
+	//   Constraints are enforced each time a point moves.
+	//	 Strong constraints may degrade the results of FABRIK, it's up to you to figure out what works.
+	// @param EffectorTargetLocation - Where you want the effector to go. FABRIK will attempt to move the effector as close
+	//    as possible to this point.
+	// @param OutTransforms - The updated transforms for each chain point after FABRIK runs. Will be reset and filled with new transforms;
+	//   its allocation is kept, so callers can reuse the same array every frame without reallocating.
+	// @param MaxRootDragDistance - How far the root may move from its original position. Set to 0 for no movement.
+	// @param RootDragStiffness - How much the root will resist being moved from the original position. 1.0 means no resistance; 
+	//   increase for more resistance. Settings less than 1.0 will make it move more.
+	// @param Precision - Iteration will terminate when the effector is within this distance from the target.
+	//   Decrease for possibly better results but possibly worse performance.
+	// @param MaxIterations - The maximum number of iterations to run. Increase for possibly better results but 
+	//   possibly worse performance.
+	// @param DebugDrawer - Used for debug drawing. May safely be set to nullptr or ignored.
+	// @param Relaxation, StagnationRatio, OutStats - As in SolveRangeLimitedFABRIK.
+	// @return - True if any transforms in OutTransforms were updated; otherwise, false. If false, the contents of OutTransforms is identical to InTransforms.
+	static bool SolveClosedLoopFABRIK(
+		const TArray<FTransform>& InTransforms,
+		const TArray<FIKBoneConstraint*>& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance = 10.0f,
+		float RootDragStiffness = 1.0f,
+		float Precision = 0.01f,
+		int32 MaxIterations = 20,
+		IIKDebugDrawer* DebugDrawer = nullptr,
+		float Relaxation = 1.0f,
+		float StagnationRatio = 0.0f,
+		FIKSolveStats* OutStats = nullptr
+	);
+
+	// As above, but uses constraints that were compiled ahead of time.
+	static bool SolveClosedLoopFABRIK(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraintTable& Constraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance = 10.0f,
+		float RootDragStiffness = 1.0f,
+		float Precision = 0.01f,
+		int32 MaxIterations = 20,
+		IIKDebugDrawer* DebugDrawer = nullptr,
+		float Relaxation = 1.0f,
+		float StagnationRatio = 0.0f,
+		FIKSolveStats* OutStats = nullptr
+	);
+
+	// Runs closed-loop FABRIK multiple times, attempting to move both 'noisy effectors' to their targets.
+	// See www.andreasaristidou.com/publications/papers/Extending_FABRIK_with_Model_Cοnstraints.pdf
+	//
+	// @param InClosedLoop - Input closed loop; describes starting positions of the  closed loop
+	// @param EffectorATarget - Target location for noisy effector A
+	// @param EffectorBTarget - Target location for noisy effector B
+	// @param OutClosedLoop - Adjusted transforms of the closed loop points will be output here. 
+	// @param MaxRootDragDistance - How far the root point may be dragged from its starting position
+	// @param RootDragStiffness - How much the root resists being dragged. Set to 1.0 for no resistance; higher will resist dragging, lower will enhance dragging
+	// @param Precision - Solver will stop iterating when both Effector A and Effector B moved less than this amount on the last iteration.
+	// @param MaxIterations - The maximum number of iterations the solver may run
+	// @param DebugDrawer - Optional, used for debug drawing.
+	// @result True if at least on transform changed. This algorithm always changes the transforms, so it always returns true.
+	static bool SolveNoisyThreePoint(
+		const FNoisyThreePointClosedLoop& InClosedLoop,
+		const FTransform& EffectorATarget,
+		const FTransform& EffectorBTarget,
+		FNoisyThreePointClosedLoop& OutClosedLoop,
+		float MaxRootDragDistance = 0.0f,
+		float RootDragStiffness = 1.0f,
+		float Precision = 0.01f,
+		int32 MaxIterations = 20,
+		IIKDebugDrawer* DebugDrawer = nullptr		
+	);
+
+	// Closed-form alternative to SolveNoisyThreePoint. Treats the closed loop as a rigid triangle, with side lengths
+	// given by the loop's target distances, and finds the placement of that triangle that best fits (in the weighted
+	// least-squares sense) the effector targets and the root's starting location. Runs in constant time.
+	//
+	// The triangle keeps the winding of InClosedLoop. If the best fit would drag the root farther than
+	// MaxRootDragDistance, the whole triangle is shifted back until it doesn't.
+	//
+	// @param InClosedLoop - Input closed loop; describes starting positions and desired side lengths
+	// @param EffectorATarget - Target location for noisy effector A
+	// @param EffectorBTarget - Target location for noisy effector B
+	// @param OutClosedLoop - Adjusted transforms of the closed loop points will be output here. Rotations are updated 
+	//   as in SolveNoisyThreePoint.
+	// @param MaxRootDragDistance - How far the root point may be dragged from its starting position
+	// @param RootDragStiffness - Weight of the root's starting location in the fit, relative to the effector targets.
+	//   1.0 weighs all three equally; higher keeps the root closer to where it started.
+	// @param OutStats - Optional. A fit is reported as converged, with no iterations, and the farther effector's
+	//   distance from its target as the final slop; a loop that can't be fitted is reported as not solved.
+	// @result True if the transforms were updated. False if the target side lengths don't form a triangle with
+	//   nonzero area and a nonzero root-A side, in which case OutClosedLoop is a copy of InClosedLoop.
+	static bool SolveRigidThreePoint(
+		const FNoisyThreePointClosedLoop& InClosedLoop,
+		const FTransform& EffectorATarget,
+		const FTransform& EffectorBTarget,
+		FNoisyThreePointClosedLoop& OutClosedLoop,
+		float MaxRootDragDistance = 0.0f,
+		float RootDragStiffness = 1.0f,
+		FIKSolveStats* OutStats = nullptr
+	);
+
+	// Multiple-effector FABRIK over a tree of points, such as a spine branching into two arms (and a head).
+	// All effectors are solved together, in one sequence of passes over the whole tree.
+	//
+	// Points are stored contiguously, parents before children; point 0 is the root. Each forward pass works from the
+	// effectors back to the root. A point with several children that lead to effectors (a 'sub-base') is placed at the
+	// centroid of the locations each of those children would drag it to. Each backward pass then works from the root
+	// out, dragging every point, so branches without an effector are carried along rigidly.
+	//
+	// Rotations are updated as in SolveRangeLimitedFABRIK. Branch points are rotated toward the centroid of their children.
+	//
+	// @param InTransforms - The starting transforms of each point, parents before children. Not modified.
+	// @param ParentIndices - The parent of each point. Must be INDEX_NONE for the root (point 0), and less than the point's 
+	//   own index for every other point.
+	// @param Constraints - Empty, or one compiled constraint per point, limiting the bone from that point's parent to the
+	//   point. Note this differs from chains, where entry i limits the bone STARTING at point i. Only planar constraints 
+	//   are enforced; others are ignored.
+	// @param EffectorIndices - Points to move onto targets. Must not include the root. 
+	// @param EffectorTargets - Target location for each entry of EffectorIndices.
+	// @param OutTransforms - The updated transforms. Will be reset and filled, keeping its allocation.
+	// @param MaxRootDragDistance - How far the root may move from its original position. Set to 0 for no movement.
+	// @param RootDragStiffness - How much the root will resist being moved; as in SolveRangeLimitedFABRIK.
+	// @param Precision - Iteration will terminate when every effector is within this distance of its target.
+	// @param MaxIterations - The maximum number of iterations to run.
+	// @param OutStats - Optional. Receives the iteration count, final slop, and why the solve stopped.
+	// @return - True if any transforms in OutTransforms were updated; otherwise, false.
+	static bool SolveTreeFABRIK(
+		const TArray<FTransform>& InTransforms,
+		const TArray<int32>& ParentIndices,
+		const TArray<FIKCompiledConstraint>& Constraints,
+		const TArray<int32>& EffectorIndices,
+		const TArray<FVector>& EffectorTargets,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance = 0.0f,
+		float RootDragStiffness = 1.0f,
+		float Precision = 0.01f,
+		int32 MaxIterations = 20,
+		FIKSolveStats* OutStats = nullptr
+	);
+	
+protected:
+
+	// Solver implementations. CompiledConstraints has one entry per point, or is nullptr if no constraint needs
+	// enforcing. Constraints is only read by IKCC_Custom entries, which pass it on to EnforceConstraint.
+	static bool SolveRangeLimitedFABRIKCompiled(
+		const TArray<FTransform>& InTransforms,
+		const TArray<FIKBoneConstraint*>& Constraints,
+		const FIKCompiledConstraint* CompiledConstraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance,
+		float RootDragStiffness,
+		float Precision,
+		int32 MaxIterations,
+		EIKUnreachableRule UnreachableRule,
+		IIKDebugDrawer* DebugDrawer,
+		float Relaxation,
+		float StagnationRatio,
+		FIKSolveStats* OutStats
+	);
+
+	static bool SolveClosedLoopFABRIKCompiled(
+		const TArray<FTransform>& InTransforms,
+		const TArray<FIKBoneConstraint*>& Constraints,
+		const FIKCompiledConstraint* CompiledConstraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance,
+		float RootDragStiffness,
+		float Precision,
+		int32 MaxIterations,
+		IIKDebugDrawer* DebugDrawer,
+		float Relaxation,
+		float StagnationRatio,
+		FIKSolveStats* OutStats
+	);
+
+	// Shared by the segmented solvers: returns the compiled constraints to enforce (nullptr if none), and whether the 
+	// chain must be solved by SolveRangeLimitedFABRIK instead (too short, or has custom constraints)
+	static const FIKCompiledConstraint* GetSegmentableConstraints(
+		const FIKCompiledConstraintTable& Constraints,
+		int32 NumPoints,
+		int32 SegmentLength,
+		bool& bOutUseNormalSolver
+	);
+
+	// Shared by the segmented solvers. KeyLengths[i] is the straight-line span of the segment ending at key point
+	// KeyIndices[i] (KeyLengths[0] is not read). If the spans add up to less than RequiredReach, every span is
+	// lengthened the same fraction of the way to its segment's summed bone length, as if the segments straightened,
+	// until they add up to RequiredReach or MaxReach (the whole chain's length).
+	static void StraightenKeyLengths(
+		const FScratchIndexArray& KeyIndices,
+		const FScratchFloatArray& BoneLengths,
+		float MaxReach,
+		float RequiredReach,
+		FScratchFloatArray& KeyLengths
+	);
+
+	// Range-limited FABRIK on bare point locations, which are modified in place. Points[0] is the root, which is 
+	// tethered to RootStart. BoneLengths[i] is the length of the bone ending at point i; BoneLengths[0] is not read. 
+	// CompiledConstraints may be nullptr; only planar constraints are enforced. Rotations are left to the caller.
+	// Returns true if any points moved. If OutIterations isn't nullptr, it receives the number of iterations run.
+	static bool SolveLocationsFABRIK(
+		FVector* Points,
+		const FVector& RootStart,
+		const float* BoneLengths,
+		int32 NumPoints,
+		const FIKCompiledConstraint* CompiledConstraints,
+		const FVector& EffectorTargetLocation,
+		float MaxRootDragDistance,
+		float RootDragStiffness,
+		float Precision,
+		int32 MaxIterations,
+		int32* OutIterations = nullptr
+	);
+
+	// Handles a target that is out of reach of the chain according to UnreachableRule. IK_Abort returns the input
+	// pose. Otherwise the chain is laid out in a straight line from the (possibly dragged) root toward the target;
+	// without active constraints (CompiledConstraints is nullptr) that is the answer, and no iteration is needed.
+	// A constrained chain can't simply be clamped bone by bone, so the straight chain is left in OutTransforms as a
+	// seed for range-limited FABRIK to iterate from, bOutSeeded is set and false is returned.
+	// Also returns false, without touching OutTransforms, if the target is within reach, or if the rule allows the
+	// root to be dragged close enough to reach it; the iterative solver must be used instead.
+	static bool TrySolveUnreachable(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraint* CompiledConstraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance,
+		float RootDragStiffness,
+		EIKUnreachableRule UnreachableRule,
+		bool& bOutBoneLocationUpdated,
+		bool& bOutSeeded
+	);
+
+	// Runs TFixedChainFABRIK if there is a specialization for this chain length and its constraints allow it.
+	// Returns false, without touching OutTransforms, if the generic solver must be used instead.
+	static bool TrySolveFixedChain(
+		const TArray<FTransform>& InTransforms,
+		const FIKCompiledConstraint* CompiledConstraints,
+		const FVector& EffectorTargetLocation,
+		TArray<FTransform>& OutTransforms,
+		float MaxRootDragDistance,
+		float RootDragStiffness,
+		float Precision,
+		int32 MaxIterations,
+		float StagnationRatio,
+		FIKSolveStats* OutStats,
+		bool& bOutBoneLocationUpdated
+	);
+
+	// Over-relaxation: moves each point other than the root and effector Relaxation times as far from its previous
+	// location as the last pass moved it
+	static void RelaxPoints(
+		const FScratchVectorArray& PreviousLocations,
+		float Relaxation,
+		TArray<FTransform>& Transforms
+	);
+
+	// Enforces the constraint of the bone starting at point ConstraintIndex, after its child has moved
+	static FORCEINLINE void EnforceCompiledConstraint(
+		int32 ConstraintIndex,
+		const FIKCompiledConstraint& Compiled,
+		const TArray<FTransform>& InTransforms,
+		const TArray<FIKBoneConstraint*>& Constraints,
+		TArray<FTransform>& OutTransforms,
+		IIKDebugDrawer* DebugDrawer
+	);
+
+	// Updates the rotation of the parent to point toward the child, using the shortest rotation
+	static void UpdateParentRotation(
+		FTransform& NewParentTransform,
+		const FTransform& OldParentTransform,
+		const FTransform& NewChildTransform,
+		const FTransform& OldChildTransform
+	);
+
+	// Iterate from effector to root
+	static void FABRIKForwardPass(
+		const TArray<FTransform>& InTransforms,
+		const TArray<FIKBoneConstraint*>& Constraints,
+		const FIKCompiledConstraint* CompiledConstraints,
+		const FScratchFloatArray& BoneLengths,
+		TArray<FTransform>& OutTransforms,
+		IIKDebugDrawer* DebugDrawer = nullptr 
+	);
+	
+	// Iterate from root to effector
+	static void FABRIKBackwardPass(
+		const TArray<FTransform>& InTransforms,
+		const TArray<FIKBoneConstraint*>& Constraints,
+		const FIKCompiledConstraint* CompiledConstraints,
+		const FScratchFloatArray& BoneLengths,
+		TArray<FTransform>& OutTransforms,
+		IIKDebugDrawer* DebugDrawer = nullptr
+	);
+
+	// The core FABRIK method. Projects PointToMove onto the vector between itself and MaintainDistancePoint, 
+	// such that the distance between them is BoneLength. This enforces the core FABRIK constraint, that inter-point
+	// distances don't change. Thus, PointToMove is 'dragged' toward MaintainDistancePoint and the original interpoint
+	// distance is maintained.
+	static FORCEINLINE void DragPoint(
+		const FTransform& MaintainDistancePoint,
+		float BoneLength,
+		FTransform& PointToMove
+	);
+
+	// Drags PointToDrag relative to MaintainDistancePoint; that is, PointToDrag is moved so that it attempts
+	// to maintain the distance BoneLength between itself and MaintainDistancePoint. However, PointToDrag is 'tethered'
+	// to TetherPoint; it cannot ever be dragged father than MaxDragDistance from TetherPoint. Additionally, the 
+	// tether acts like a spring, instantaneously pulling MaintainDistancePoint back toward TetherPoint by an amount dictated by DragStiffnes;
+	// specifically, the required displacement (before clamping to MaxDragDisplacement) is divided by DragStiffness.
+	// 
+	// Basically, this is like EnforcePointDistance, but with the additional stronger constraint that PointToDrag
+	// can never be moved father than MaxDragDistance from StartingTransform.
+	static void DragPointTethered(
+		const FTransform& TetherPoint,
+		const FTransform& MaintainDistancePoint,
+		float BoneLength,
+		float MaxDragDistance,
+		float DragStiffness,
+		FTransform& PointToDrag
+	);
+
+	// Walks a chain along the cubic from Root to Target with the given end tangents, sampled at NumSteps even
+	// parameter steps. Each point is placed where the curve is BoneLengths[i] from the point before it; bones left
+	// over once the curve ends carry on along its last step. Root goes in OutPoints[0]. Returns how far along the
+	// curve the walk ended past the target; negative if it ended short.
+	static float WalkSplineCurve(
+		const FVector& Root,
+		const FVector& StartTangent,
+		const FVector& Target,
+		const FVector& EndTangent,
+		int32 NumSteps,
+		const float* BoneLengths,
+		int32 NumPoints,
+		FVector* OutPoints
+	);
+
+	// Compute bone lengths and store in BoneLengths. BoneLengths will be reset and refilled.
+	// Each entry contains the length of bone ending at point i, i.e., OutBoneLengths[i] contains the starting distance 
+	// between point i and point i-1.
+	// Returns the maximum reach.
+	static float ComputeBoneLengths(
+		const TArray<FTransform>& InTransforms,
+		FScratchFloatArray& OutBoneLengths
+	);
+};
@@ -0,0 +1,42 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/*
+* Counts the heap allocator calls (Malloc, Realloc and Free) the calling thread makes while the scope is open, for
+* tests that check code runs without allocating.
+*
+* Counting is thread-local: calls on other threads are never counted, and cost them one thread-local read. The
+* first scope opened wraps GMalloc in a forwarding allocator, once, with an atomic exchange. The wrapper is never
+* removed, so no thread is ever left calling through an allocator that has gone away, and nothing swaps GMalloc
+* back and forth while other threads are allocating.
+*
+* Scopes may nest; an inner scope's calls are not added to the outer one's.
+*/
+class RTIKCORE_API FRTIKAllocationCounterScope
+{
+public:
+
+	FRTIKAllocationCounterScope();
+	~FRTIKAllocationCounterScope();
+
+	// Allocator calls made on this thread since the scope was opened
+	int32 GetNumCalls() const
+	{
+		return NumCalls;
+	}
+
+private:
+
+	FRTIKAllocationCounterScope(const FRTIKAllocationCounterScope&) = delete;
+	FRTIKAllocationCounterScope& operator=(const FRTIKAllocationCounterScope&) = delete;
+
+	int32 NumCalls;
+	int32* OuterCounter;
+};
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,35 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "IKSolverTypes.h"
+#include "Constraints.h"
+
+/*
+* A generated chain for the solver tests and the RTIKBench commandlet: a random walk in the XZ plane, with bones of
+* equal length, so planar constraints around Y can hold its starting pose. The same seed gives the same chain.
+*/
+struct RTIKCORE_API FRTIKTestChain
+{
+	TArray<FTransform> Transforms;
+
+	// Storage for the constraints the table points to; never resized after the table is compiled
+	TArray<FPlanarRotation> PlanarConstraints;
+	FIKCompiledConstraintTable Constraints;
+
+	float BoneLength;
+	float Reach;
+
+	// Each bone turns up to MaxBendDegrees from the one before it. Each bone is constrained, to within 60 degrees of
+	// its starting direction, with probability ConstraintDensity.
+	void Generate(FRandomStream& Random, int32 NumPoints, float InBoneLength, float ConstraintDensity,
+		float MaxBendDegrees = 20.0f);
+
+	// Somewhere between a third and four fifths of the chain's reach from the root, or half again beyond its reach
+	FVector MakeTarget(FRandomStream& Random, bool bReachable) const;
+
+	// Largest difference between a bone's length in Solved and its length in the starting pose
+	float MaxBoneLengthError(const TArray<FTransform>& Solved) const;
+};
@@ -0,0 +1,7 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+RTIKCORE_API DECLARE_LOG_CATEGORY_EXTERN(LogRTIK, All, All)
@@ -0,0 +1,17 @@
+// Copyright (c) Henry Cooney 2017
+
+using UnrealBuildTool;
+
+public class rtikCore : ModuleRules
+{
+    public rtikCore(ReadOnlyTargetRules Target) : base(Target)
+    {
+        // Solver math only. Keep this module free of Engine and animation dependencies, so it can be built and
+        // linked without them; anything that needs a world, a skeleton or an anim graph belongs in rtik.
+        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject" });
+
+        PublicIncludePaths.AddRange(new string[] { "rtikCore/Public", "rtikCore/Public/IK", "rtikCore/Public/Testing" });
+
+        PrivateIncludePaths.AddRange(new string[] { "rtikCore/Private", "rtikCore/Private/IK", "rtikCore/Private/Tests" });
+    }
+}
@@ -0,0 +1,63 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikEditor.h"
+#include "AssetTypeActions_RTIKRigAsset.h"
+#include "Framework/MultiBox/MultiBoxBuilder.h"
+#include "IK/RTIKRigAsset.h"
+
+FText FAssetTypeActions_RTIKRigAsset::GetName() const
+{
+	return FText::FromString(FString("RTIK Rig"));
+}
+
+FColor FAssetTypeActions_RTIKRigAsset::GetTypeColor() const
+{
+	return FColor(0, 255, 255);
+}
+
+UClass* FAssetTypeActions_RTIKRigAsset::GetSupportedClass() const
+{
+	return URTIKRigAsset::StaticClass();
+}
+
+uint32 FAssetTypeActions_RTIKRigAsset::GetCategories()
+{
+	return EAssetTypeCategories::Animation;
+}
+
+bool FAssetTypeActions_RTIKRigAsset::HasActions(const TArray<UObject*>& InObjects) const
+{
+	return true;
+}
+
+void FAssetTypeActions_RTIKRigAsset::GetActions(const TArray<UObject*>& InObjects, FMenuBuilder& MenuBuilder)
+{
+	TArray<TWeakObjectPtr<URTIKRigAsset>> Rigs = GetTypedWeakObjectPtrs<URTIKRigAsset>(InObjects);
+
+	MenuBuilder.AddMenuEntry(
+		FText::FromString(FString("Rebake")),
+		FText::FromString(FString("Rebuilds the baked chain data from the rig's mesh and chain settings")),
+		FSlateIcon(),
+		FUIAction(FExecuteAction::CreateSP(this, &FAssetTypeActions_RTIKRigAsset::ExecuteRebake, Rigs)));
+}
+
+void FAssetTypeActions_RTIKRigAsset::ExecuteRebake(TArray<TWeakObjectPtr<URTIKRigAsset>> Rigs)
+{
+	for (const TWeakObjectPtr<URTIKRigAsset>& RigPtr : Rigs)
+	{
+		URTIKRigAsset* Rig = RigPtr.Get();
+		if (Rig == nullptr)
+		{
+			continue;
+		}
+
+		Rig->Bake();
+		Rig->MarkPackageDirty();
+
+		if (!Rig->IsBaked())
+		{
+			UE_LOG(LogRTIKEditor, Warning, TEXT("Could not bake RTIK rig %s -- make sure it has a mesh and at least one chain"),
+				*Rig->GetName());
+		}
+	}
+}
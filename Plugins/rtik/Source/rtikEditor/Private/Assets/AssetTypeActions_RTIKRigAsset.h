@@ -0,0 +1,29 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AssetTypeActions_Base.h"
+
+class URTIKRigAsset;
+
+/*
+* Content browser actions for RTIK rig assets. Adds a Rebake action, for after the mesh has changed.
+*/
+class FAssetTypeActions_RTIKRigAsset : public FAssetTypeActions_Base
+{
+public:
+
+	// IAssetTypeActions interface
+	virtual FText GetName() const override;
+	virtual FColor GetTypeColor() const override;
+	virtual UClass* GetSupportedClass() const override;
+	virtual uint32 GetCategories() override;
+	virtual bool HasActions(const TArray<UObject*>& InObjects) const override;
+	virtual void GetActions(const TArray<UObject*>& InObjects, FMenuBuilder& MenuBuilder) override;
+	// End IAssetTypeActions interface
+
+protected:
+
+	void ExecuteRebake(TArray<TWeakObjectPtr<URTIKRigAsset>> Rigs);
+};
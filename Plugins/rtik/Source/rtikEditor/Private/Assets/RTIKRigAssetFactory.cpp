@@ -0,0 +1,20 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikEditor.h"
+#include "RTIKRigAssetFactory.h"
+#include "IK/RTIKRigAsset.h"
+
+URTIKRigAssetFactory::URTIKRigAssetFactory(const FObjectInitializer& ObjectInitializer)
+	:
+	Super(ObjectInitializer)
+{
+	SupportedClass = URTIKRigAsset::StaticClass();
+	bCreateNew = true;
+	bEditAfterNew = true;
+}
+
+UObject* URTIKRigAssetFactory::FactoryCreateNew(UClass* Class, UObject* InParent, FName Name, EObjectFlags Flags,
+	UObject* Context, FFeedbackContext* Warn)
+{
+	return NewObject<URTIKRigAsset>(InParent, Class, Name, Flags);
+}
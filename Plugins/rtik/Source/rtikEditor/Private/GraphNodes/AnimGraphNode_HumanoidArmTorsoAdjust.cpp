@@ -1,25 +1,47 @@
-// Copyright (c) Henry Cooney 2017
-
-#include "rtikEditor.h"
-#include "AnimGraphNode_HumanoidArmTorsoAdjust.h"
-
-
-FText UAnimGraphNode_HumanoidArmTorsoAdjust::GetNodeTitle(ENodeTitleType::Type TitleType) const
-{
-	return FText::FromString(FString("IK Humanoid Arm Torso Adjustment"));
-}
-
-FLinearColor UAnimGraphNode_HumanoidArmTorsoAdjust::GetNodeTitleColor() const
-{
-	return FLinearColor(0, 1, 1, 1);
-}
-
-FString UAnimGraphNode_HumanoidArmTorsoAdjust::GetNodeCategory() const
-{
-	return FString("IK Nodes");
-}
-
-FText UAnimGraphNode_HumanoidArmTorsoAdjust::GetControllerDescription() const
-{
-	return FText::FromString(FString("Adjust humanoid torso rotation before IK"));
-}
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikEditor.h"
+#include "AnimGraphNode_HumanoidArmTorsoAdjust.h"
+#include "Kismet2/CompilerResultsLog.h"
+#include "RTIKNodeValidation.h"
+
+
+FText UAnimGraphNode_HumanoidArmTorsoAdjust::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return FText::FromString(FString("IK Humanoid Arm Torso Adjustment"));
+}
+
+FLinearColor UAnimGraphNode_HumanoidArmTorsoAdjust::GetNodeTitleColor() const
+{
+	return FLinearColor(0, 1, 1, 1);
+}
+
+FString UAnimGraphNode_HumanoidArmTorsoAdjust::GetNodeCategory() const
+{
+	return FString("IK Nodes");
+}
+
+FText UAnimGraphNode_HumanoidArmTorsoAdjust::GetControllerDescription() const
+{
+	return FText::FromString(FString("Adjust humanoid torso rotation before IK"));
+}
+
+void UAnimGraphNode_HumanoidArmTorsoAdjust::ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog)
+{
+	Super::ValidateAnimNodeDuringCompilation(ForSkeleton, MessageLog);
+
+	FRTIKNodeValidation::ValidateChainInput(this, ForSkeleton, MessageLog, Node.LeftArmHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidArmTorsoAdjust, LeftArmHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidArmTorsoAdjust, LeftArm), 1);
+	FRTIKNodeValidation::ValidateChainInput(this, ForSkeleton, MessageLog, Node.RightArmHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidArmTorsoAdjust, RightArmHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidArmTorsoAdjust, RightArm), 1);
+	FRTIKNodeValidation::ValidateBone(this, ForSkeleton, MessageLog, Node.WaistBone, TEXT("Waist Bone"));
+	FRTIKNodeValidation::ValidatePrecision(this, MessageLog, Node.Precision);
+
+	// The node evaluates with these fixed, so there's no need to check them every frame
+	FVector ForwardAxis = FIKUtil::IKBoneAxisToVector(Node.SkeletonForwardAxis);
+	FVector UpAxis      = FIKUtil::IKBoneAxisToVector(Node.SkeletonUpAxis);
+	if (!FVector::CrossProduct(ForwardAxis, UpAxis).IsNormalized())
+	{
+		MessageLog.Error(TEXT("@@ - Skeleton Forward Axis and Skeleton Up Axis must be orthogonal"), this);
+	}
+}
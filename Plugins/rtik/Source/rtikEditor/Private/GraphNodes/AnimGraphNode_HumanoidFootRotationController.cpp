@@ -1,24 +1,36 @@
-// Copyright (c) Henry Cooney 2017
-
-#include "rtikEditor.h"
-#include "AnimGraphNode_HumanoidFootRotationController.h"
-
-FText UAnimGraphNode_HumanoidFootRotationController::GetNodeTitle(ENodeTitleType::Type TitleType) const
-{
-	return FText::FromString(FString("Humanoid Foot Rotation Controller"));
-}
-
-FLinearColor UAnimGraphNode_HumanoidFootRotationController::GetNodeTitleColor() const
-{
-	return FLinearColor(0, 1, 1, 1);
-}
-
-FString UAnimGraphNode_HumanoidFootRotationController::GetNodeCategory() const
-{
-	return FString("IK Nodes");
-}
-
-FText UAnimGraphNode_HumanoidFootRotationController::GetControllerDescription() const
-{
-	return FText::FromString(FString("Rotate a humanoid's foot to match the slope of the floor"));
-}
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikEditor.h"
+#include "AnimGraphNode_HumanoidFootRotationController.h"
+#include "Kismet2/CompilerResultsLog.h"
+#include "RTIKNodeValidation.h"
+
+FText UAnimGraphNode_HumanoidFootRotationController::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return FText::FromString(FString("Humanoid Foot Rotation Controller"));
+}
+
+FLinearColor UAnimGraphNode_HumanoidFootRotationController::GetNodeTitleColor() const
+{
+	return FLinearColor(0, 1, 1, 1);
+}
+
+FString UAnimGraphNode_HumanoidFootRotationController::GetNodeCategory() const
+{
+	return FString("IK Nodes");
+}
+
+FText UAnimGraphNode_HumanoidFootRotationController::GetControllerDescription() const
+{
+	return FText::FromString(FString("Rotate a humanoid's foot to match the slope of the floor"));
+}
+
+void UAnimGraphNode_HumanoidFootRotationController::ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog)
+{
+	Super::ValidateAnimNodeDuringCompilation(ForSkeleton, MessageLog);
+
+	FRTIKNodeValidation::ValidateLegInput(this, ForSkeleton, MessageLog, Node.LegHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidFootRotationController, LegHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidFootRotationController, Leg));
+	FRTIKNodeValidation::ValidateTraceDataInput(this, MessageLog, Node.TraceDataHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidFootRotationController, TraceDataHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidFootRotationController, TraceData));
+}
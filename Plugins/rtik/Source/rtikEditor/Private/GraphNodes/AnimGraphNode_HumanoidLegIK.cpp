@@ -1,24 +1,37 @@
-// Copyright (c) Henry Cooney 2017
-
-#include "rtikEditor.h"
-#include "AnimGraphNode_HumanoidLegIK.h"
-
-FText UAnimGraphNode_HumanoidLegIK::GetNodeTitle(ENodeTitleType::Type TitleType) const
-{
-	return FText::FromString(FString("Humanoid Leg IK Solver"));
-}
-
-FLinearColor UAnimGraphNode_HumanoidLegIK::GetNodeTitleColor() const
-{
-	return FLinearColor(0, 1, 1, 1);
-}
-
-FString UAnimGraphNode_HumanoidLegIK::GetNodeCategory() const
-{
-	return FString("IK Nodes");
-}
-
-FText UAnimGraphNode_HumanoidLegIK::GetControllerDescription() const
-{
-	return FText::FromString(FString("IK a humanoid two-bone leg to a location"));
-}
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikEditor.h"
+#include "AnimGraphNode_HumanoidLegIK.h"
+#include "Kismet2/CompilerResultsLog.h"
+#include "RTIKNodeValidation.h"
+
+FText UAnimGraphNode_HumanoidLegIK::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return FText::FromString(FString("Humanoid Leg IK Solver"));
+}
+
+FLinearColor UAnimGraphNode_HumanoidLegIK::GetNodeTitleColor() const
+{
+	return FLinearColor(0, 1, 1, 1);
+}
+
+FString UAnimGraphNode_HumanoidLegIK::GetNodeCategory() const
+{
+	return FString("IK Nodes");
+}
+
+FText UAnimGraphNode_HumanoidLegIK::GetControllerDescription() const
+{
+	return FText::FromString(FString("IK a humanoid two-bone leg to a location"));
+}
+
+void UAnimGraphNode_HumanoidLegIK::ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog)
+{
+	Super::ValidateAnimNodeDuringCompilation(ForSkeleton, MessageLog);
+
+	FRTIKNodeValidation::ValidateLegInput(this, ForSkeleton, MessageLog, Node.LegHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidLegIK, LegHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidLegIK, Leg));
+	FRTIKNodeValidation::ValidateTraceDataInput(this, MessageLog, Node.TraceDataHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidLegIK, TraceDataHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidLegIK, TraceData));
+	FRTIKNodeValidation::ValidatePrecision(this, MessageLog, Node.Precision);
+}
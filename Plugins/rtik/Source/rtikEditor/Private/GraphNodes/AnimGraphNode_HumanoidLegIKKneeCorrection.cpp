@@ -1,24 +1,34 @@
-// Copyright (c) Henry Cooney 2017
-
-#include "rtikEditor.h"
-#include "AnimGraphNode_HumanoidLegIKKneeCorrection.h"
-
-FText UAnimGraphNode_HumanoidLegIKKneeCorrection::GetNodeTitle(ENodeTitleType::Type TitleType) const
-{
-	return FText::FromString(FString("Humanoid Leg IK Knee Correction"));
-}
-
-FLinearColor UAnimGraphNode_HumanoidLegIKKneeCorrection::GetNodeTitleColor() const
-{
-	return FLinearColor(0, 1, 1, 1);
-}
-
-FString UAnimGraphNode_HumanoidLegIKKneeCorrection::GetNodeCategory() const
-{
-	return FString("IK Nodes");
-}
-
-FText UAnimGraphNode_HumanoidLegIKKneeCorrection::GetControllerDescription() const
-{
-	return FText::FromString(FString("Corrects knee angle after IK"));
-}
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikEditor.h"
+#include "AnimGraphNode_HumanoidLegIKKneeCorrection.h"
+#include "Kismet2/CompilerResultsLog.h"
+#include "RTIKNodeValidation.h"
+
+FText UAnimGraphNode_HumanoidLegIKKneeCorrection::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return FText::FromString(FString("Humanoid Leg IK Knee Correction"));
+}
+
+FLinearColor UAnimGraphNode_HumanoidLegIKKneeCorrection::GetNodeTitleColor() const
+{
+	return FLinearColor(0, 1, 1, 1);
+}
+
+FString UAnimGraphNode_HumanoidLegIKKneeCorrection::GetNodeCategory() const
+{
+	return FString("IK Nodes");
+}
+
+FText UAnimGraphNode_HumanoidLegIKKneeCorrection::GetControllerDescription() const
+{
+	return FText::FromString(FString("Corrects knee angle after IK"));
+}
+
+void UAnimGraphNode_HumanoidLegIKKneeCorrection::ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog)
+{
+	Super::ValidateAnimNodeDuringCompilation(ForSkeleton, MessageLog);
+
+	FRTIKNodeValidation::ValidateLegInput(this, ForSkeleton, MessageLog, Node.LegHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidLegIKKneeCorrection, LegHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidLegIKKneeCorrection, Leg));
+}
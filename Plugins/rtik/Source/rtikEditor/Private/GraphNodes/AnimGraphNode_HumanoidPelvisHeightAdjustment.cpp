@@ -1,24 +1,42 @@
-// Copyright (c) Henry Cooney 2017
-
-#include "rtikEditor.h"
-#include "AnimGraphNode_HumanoidPelvisHeightAdjustment.h"
-
-FText UAnimGraphNode_HumanoidPelvisHeightAdjustment::GetNodeTitle(ENodeTitleType::Type TitleType) const
-{
-	return FText::FromString(FString("IK Biped Hip Adjustment"));
-}
-
-FLinearColor UAnimGraphNode_HumanoidPelvisHeightAdjustment::GetNodeTitleColor() const
-{
-	return FLinearColor(0, 1, 1, 1);
-}
-
-FString UAnimGraphNode_HumanoidPelvisHeightAdjustment::GetNodeCategory() const
-{
-	return FString("IK Nodes");
-}
-
-FText UAnimGraphNode_HumanoidPelvisHeightAdjustment::GetControllerDescription() const
-{
-	return FText::FromString(FString("Adjusts the hips and pelvis so legs can reach the floor during IK"));
-}
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikEditor.h"
+#include "AnimGraphNode_HumanoidPelvisHeightAdjustment.h"
+#include "Kismet2/CompilerResultsLog.h"
+#include "RTIKNodeValidation.h"
+
+FText UAnimGraphNode_HumanoidPelvisHeightAdjustment::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return FText::FromString(FString("IK Biped Hip Adjustment"));
+}
+
+FLinearColor UAnimGraphNode_HumanoidPelvisHeightAdjustment::GetNodeTitleColor() const
+{
+	return FLinearColor(0, 1, 1, 1);
+}
+
+FString UAnimGraphNode_HumanoidPelvisHeightAdjustment::GetNodeCategory() const
+{
+	return FString("IK Nodes");
+}
+
+FText UAnimGraphNode_HumanoidPelvisHeightAdjustment::GetControllerDescription() const
+{
+	return FText::FromString(FString("Adjusts the hips and pelvis so legs can reach the floor during IK"));
+}
+
+void UAnimGraphNode_HumanoidPelvisHeightAdjustment::ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog)
+{
+	Super::ValidateAnimNodeDuringCompilation(ForSkeleton, MessageLog);
+
+	FRTIKNodeValidation::ValidateLegInput(this, ForSkeleton, MessageLog, Node.LeftLegHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidPelvisHeightAdjustment, LeftLegHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidPelvisHeightAdjustment, LeftLeg));
+	FRTIKNodeValidation::ValidateLegInput(this, ForSkeleton, MessageLog, Node.RightLegHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidPelvisHeightAdjustment, RightLegHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidPelvisHeightAdjustment, RightLeg));
+	FRTIKNodeValidation::ValidateTraceDataInput(this, MessageLog, Node.LeftLegTraceDataHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidPelvisHeightAdjustment, LeftLegTraceDataHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidPelvisHeightAdjustment, LeftLegTraceData));
+	FRTIKNodeValidation::ValidateTraceDataInput(this, MessageLog, Node.RightLegTraceDataHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidPelvisHeightAdjustment, RightLegTraceDataHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidPelvisHeightAdjustment, RightLegTraceData));
+	FRTIKNodeValidation::ValidateBoneInput(this, ForSkeleton, MessageLog, Node.PelvisBoneHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidPelvisHeightAdjustment, PelvisBoneHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_HumanoidPelvisHeightAdjustment, PelvisBone));
+}
@@ -1,24 +1,38 @@
-// Copyright (c) Henry Cooney 2017
-
-#include "rtikEditor.h"
-#include "AnimGraphNode_IKHumanoidLegTrace.h"
-
-FText UAnimGraphNode_IKHumanoidLegTrace::GetNodeTitle(ENodeTitleType::Type TitleType) const
-{
-	return FText::FromString(FString("Humanoid IK Leg Trace"));
-}
-
-FLinearColor UAnimGraphNode_IKHumanoidLegTrace::GetNodeTitleColor() const
-{
-	return FLinearColor(0, 1, 1, 1);
-}
-
-FString UAnimGraphNode_IKHumanoidLegTrace::GetNodeCategory() const
-{
-	return FString("IK Nodes");
-}
-
-FText UAnimGraphNode_IKHumanoidLegTrace::GetControllerDescription() const
-{
-	return FText::FromString(FString("Traces from the leg to the floor, providing trace data used later in IK"));
-}
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikEditor.h"
+#include "AnimGraphNode_IKHumanoidLegTrace.h"
+#include "Kismet2/CompilerResultsLog.h"
+#include "RTIKNodeValidation.h"
+
+FText UAnimGraphNode_IKHumanoidLegTrace::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return FText::FromString(FString("Humanoid IK Leg Trace"));
+}
+
+FLinearColor UAnimGraphNode_IKHumanoidLegTrace::GetNodeTitleColor() const
+{
+	return FLinearColor(0, 1, 1, 1);
+}
+
+FString UAnimGraphNode_IKHumanoidLegTrace::GetNodeCategory() const
+{
+	return FString("IK Nodes");
+}
+
+FText UAnimGraphNode_IKHumanoidLegTrace::GetControllerDescription() const
+{
+	return FText::FromString(FString("Traces from the leg to the floor, providing trace data used later in IK"));
+}
+
+void UAnimGraphNode_IKHumanoidLegTrace::ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog)
+{
+	Super::ValidateAnimNodeDuringCompilation(ForSkeleton, MessageLog);
+
+	FRTIKNodeValidation::ValidateLegInput(this, ForSkeleton, MessageLog, Node.LegHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_IKHumanoidLegTrace, LegHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_IKHumanoidLegTrace, Leg));
+	FRTIKNodeValidation::ValidateBoneInput(this, ForSkeleton, MessageLog, Node.PelvisBoneHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_IKHumanoidLegTrace, PelvisBoneHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_IKHumanoidLegTrace, PelvisBone));
+	FRTIKNodeValidation::ValidateTraceDataInput(this, MessageLog, Node.TraceDataHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_IKHumanoidLegTrace, TraceDataHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_IKHumanoidLegTrace, TraceData));
+}
@@ -1,27 +1,39 @@
-// Copyright(c) Henry Cooney 2017
-
-#include "rtikEditor.h"
-#include "AnimGraphNode_RangeLimitedFabrik.h"
-#include "Animation/AnimInstance.h"
-#include "AnimNodeEditModes.h"
-
-
-FText UAnimGraphNode_RangeLimitedFabrik::GetNodeTitle(ENodeTitleType::Type TitleType) const
-{
-	return FText::FromString(FString("Range Limited FABRIK"));
-}
-
-FLinearColor UAnimGraphNode_RangeLimitedFabrik::GetNodeTitleColor() const
-{
-	return FLinearColor(0, 1, 1, 1);
-}
-
-FString UAnimGraphNode_RangeLimitedFabrik::GetNodeCategory() const
-{
-	return FString("IK Nodes");
-}
-
-FText UAnimGraphNode_RangeLimitedFabrik::GetControllerDescription() const
-{
-	return FText::FromString(FString("FABRIK solver with range limits"));
-}
+// Copyright(c) Henry Cooney 2017
+
+#include "rtikEditor.h"
+#include "AnimGraphNode_RangeLimitedFabrik.h"
+#include "Kismet2/CompilerResultsLog.h"
+#include "RTIKNodeValidation.h"
+#include "Animation/AnimInstance.h"
+#include "AnimNodeEditModes.h"
+
+
+FText UAnimGraphNode_RangeLimitedFabrik::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return FText::FromString(FString("Range Limited FABRIK"));
+}
+
+FLinearColor UAnimGraphNode_RangeLimitedFabrik::GetNodeTitleColor() const
+{
+	return FLinearColor(0, 1, 1, 1);
+}
+
+FString UAnimGraphNode_RangeLimitedFabrik::GetNodeCategory() const
+{
+	return FString("IK Nodes");
+}
+
+FText UAnimGraphNode_RangeLimitedFabrik::GetControllerDescription() const
+{
+	return FText::FromString(FString("FABRIK solver with range limits"));
+}
+
+void UAnimGraphNode_RangeLimitedFabrik::ValidateAnimNodeDuringCompilation(USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog)
+{
+	Super::ValidateAnimNodeDuringCompilation(ForSkeleton, MessageLog);
+
+	// The solver needs a root and an effector
+	FRTIKNodeValidation::ValidateChainInput(this, ForSkeleton, MessageLog, Node.IKChainHandle,
+		GET_MEMBER_NAME_CHECKED(FAnimNode_RangeLimitedFabrik, IKChainHandle), GET_MEMBER_NAME_CHECKED(FAnimNode_RangeLimitedFabrik, IKChain), 2);
+	FRTIKNodeValidation::ValidatePrecision(this, MessageLog, Node.Precision);
+}
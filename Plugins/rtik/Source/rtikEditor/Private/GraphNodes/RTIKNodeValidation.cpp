@@ -0,0 +1,198 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "rtikEditor.h"
+#include "RTIKNodeValidation.h"
+#include "AnimGraphNode_Base.h"
+#include "Animation/Skeleton.h"
+#include "Engine/SkeletalMesh.h"
+#include "Kismet2/CompilerResultsLog.h"
+#include "IK/RTIKRigAsset.h"
+
+namespace
+{
+	// Checks a chain's bones against the skeleton, the way building its definition will at runtime
+	template<typename ChainType>
+	void CheckChainSettings(UAnimGraphNode_Base* GraphNode, USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog,
+		const ChainType& Settings, FName HandleName)
+	{
+		if (ForSkeleton == nullptr)
+		{
+			return;
+		}
+
+		ChainType Chain = Settings;
+		TArray<FName> BoneNames;
+		TArray<FIKBoneConstraint*> Constraints;
+		Chain.GatherDefinitionInputs(BoneNames, Constraints);
+
+		FString Problem;
+		if (!FIKChainDefinitionCache::CheckChain(ForSkeleton->GetReferenceSkeleton(), BoneNames,
+			ChainType::GetDefinitionChecks(), Problem))
+		{
+			MessageLog.Error(*FString::Printf(TEXT("@@ - %s is not valid for skeleton %s: %s"),
+				*HandleName.ToString(), *ForSkeleton->GetName(), *Problem), GraphNode);
+		}
+	}
+
+	// Warns if Rig was baked for a mesh with another skeleton. Its chains still work, but look bones up by name.
+	void CheckRigSkeleton(UAnimGraphNode_Base* GraphNode, USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog,
+		const URTIKRigAsset& Rig)
+	{
+		if (ForSkeleton != nullptr && Rig.Mesh != nullptr && Rig.Mesh->Skeleton != ForSkeleton)
+		{
+			MessageLog.Warning(*FString::Printf(TEXT("@@ - rig %s is for mesh %s, which doesn't use skeleton %s. Its baked data won't be used."),
+				*Rig.GetName(), *Rig.Mesh->GetName(), *ForSkeleton->GetName()), GraphNode);
+		}
+	}
+
+	void WarnMissingRigChain(UAnimGraphNode_Base* GraphNode, FCompilerResultsLog& MessageLog, const URTIKRigAsset& Rig,
+		FName HandleName)
+	{
+		MessageLog.Warning(*FString::Printf(TEXT("@@ - rig %s has no chain named %s. The handle's own settings will be used."),
+			*Rig.GetName(), *HandleName.ToString()), GraphNode);
+	}
+}
+
+bool FRTIKNodeValidation::IsPinLinked(const UAnimGraphNode_Base* GraphNode, FName PropertyName)
+{
+	const UEdGraphPin* Pin = GraphNode->FindPin(PropertyName.ToString());
+	return Pin != nullptr && Pin->LinkedTo.Num() > 0;
+}
+
+bool FRTIKNodeValidation::ShouldCheckHandle(UAnimGraphNode_Base* GraphNode, FCompilerResultsLog& MessageLog,
+	FName HandleName, FName HandleProperty, FName WrapperProperty)
+{
+	if (IsPinLinked(GraphNode, HandleProperty) || IsPinLinked(GraphNode, WrapperProperty))
+	{
+		return false;
+	}
+
+	if (HandleName == NAME_None)
+	{
+		MessageLog.Error(*FString::Printf(TEXT("@@ - %s is not set. Give the handle a name, or connect a wrapper to %s."),
+			*HandleProperty.ToString(), *WrapperProperty.ToString()), GraphNode);
+		return false;
+	}
+
+	return true;
+}
+
+void FRTIKNodeValidation::ValidateLegInput(UAnimGraphNode_Base* GraphNode, USkeleton* ForSkeleton,
+	FCompilerResultsLog& MessageLog, const FHumanoidLegChainHandle& Handle, FName HandleProperty, FName WrapperProperty)
+{
+	if (!ShouldCheckHandle(GraphNode, MessageLog, Handle.Name, HandleProperty, WrapperProperty))
+	{
+		return;
+	}
+
+	const FHumanoidLegChain* Settings = &Handle.Chain;
+	if (Handle.Rig != nullptr)
+	{
+		FIKChainDefinitionPtr BakedDefinition;
+		if (const FHumanoidLegChain* RigSettings = Handle.Rig->FindLeg(Handle.Name, BakedDefinition))
+		{
+			Settings = RigSettings;
+			CheckRigSkeleton(GraphNode, ForSkeleton, MessageLog, *Handle.Rig);
+		}
+		else
+		{
+			WarnMissingRigChain(GraphNode, MessageLog, *Handle.Rig, Handle.Name);
+		}
+	}
+
+	// A leg with no bones named is set up by another node
+	if (Settings->HipBone.BoneRef.BoneName == NAME_None && Settings->ThighBone.BoneRef.BoneName == NAME_None &&
+		Settings->ShinBone.BoneRef.BoneName == NAME_None && Settings->FootBone.BoneRef.BoneName == NAME_None)
+	{
+		return;
+	}
+
+	CheckChainSettings(GraphNode, ForSkeleton, MessageLog, *Settings, Handle.Name);
+}
+
+void FRTIKNodeValidation::ValidateChainInput(UAnimGraphNode_Base* GraphNode, USkeleton* ForSkeleton,
+	FCompilerResultsLog& MessageLog, const FRangeLimitedIKChainHandle& Handle, FName HandleProperty,
+	FName WrapperProperty, int32 MinBones)
+{
+	if (!ShouldCheckHandle(GraphNode, MessageLog, Handle.Name, HandleProperty, WrapperProperty))
+	{
+		return;
+	}
+
+	const FRangeLimitedIKChain* Settings = &Handle.Chain;
+	if (Handle.Rig != nullptr)
+	{
+		FIKChainDefinitionPtr BakedDefinition;
+		if (const FRangeLimitedIKChain* RigSettings = Handle.Rig->FindChain(Handle.Name, BakedDefinition))
+		{
+			Settings = RigSettings;
+			CheckRigSkeleton(GraphNode, ForSkeleton, MessageLog, *Handle.Rig);
+		}
+		else
+		{
+			WarnMissingRigChain(GraphNode, MessageLog, *Handle.Rig, Handle.Name);
+		}
+	}
+
+	// A chain with no bones is set up by another node
+	int32 NumBones = Settings->BonesRootToEffector.Num();
+	if (NumBones == 0)
+	{
+		return;
+	}
+
+	if (NumBones < MinBones)
+	{
+		MessageLog.Error(*FString::Printf(TEXT("@@ - %s has %d bones; this node needs at least %d"),
+			*Handle.Name.ToString(), NumBones, MinBones), GraphNode);
+		return;
+	}
+
+	CheckChainSettings(GraphNode, ForSkeleton, MessageLog, *Settings, Handle.Name);
+}
+
+void FRTIKNodeValidation::ValidateBoneInput(UAnimGraphNode_Base* GraphNode, USkeleton* ForSkeleton,
+	FCompilerResultsLog& MessageLog, const FIKBoneHandle& Handle, FName HandleProperty, FName WrapperProperty)
+{
+	if (!ShouldCheckHandle(GraphNode, MessageLog, Handle.Name, HandleProperty, WrapperProperty))
+	{
+		return;
+	}
+
+	// A bone with no name is set up by another node
+	if (Handle.Bone.BoneRef.BoneName != NAME_None)
+	{
+		ValidateBone(GraphNode, ForSkeleton, MessageLog, Handle.Bone, *Handle.Name.ToString());
+	}
+}
+
+void FRTIKNodeValidation::ValidateTraceDataInput(UAnimGraphNode_Base* GraphNode, FCompilerResultsLog& MessageLog,
+	const FHumanoidIKTraceDataHandle& Handle, FName HandleProperty, FName WrapperProperty)
+{
+	ShouldCheckHandle(GraphNode, MessageLog, Handle.Name, HandleProperty, WrapperProperty);
+}
+
+void FRTIKNodeValidation::ValidateBone(UAnimGraphNode_Base* GraphNode, USkeleton* ForSkeleton,
+	FCompilerResultsLog& MessageLog, const FIKBone& Bone, const TCHAR* Description)
+{
+	if (ForSkeleton == nullptr)
+	{
+		return;
+	}
+
+	if (ForSkeleton->GetReferenceSkeleton().FindBoneIndex(Bone.BoneRef.BoneName) == INDEX_NONE)
+	{
+		MessageLog.Error(*FString::Printf(TEXT("@@ - %s: skeleton %s has no bone named %s"),
+			Description, *ForSkeleton->GetName(), *Bone.BoneRef.BoneName.ToString()), GraphNode);
+	}
+}
+
+void FRTIKNodeValidation::ValidatePrecision(UAnimGraphNode_Base* GraphNode, FCompilerResultsLog& MessageLog,
+	float Precision)
+{
+	if (Precision <= 0.0f)
+	{
+		MessageLog.Error(*FString::Printf(TEXT("@@ - Precision is %f; it must be greater than zero"), Precision),
+			GraphNode);
+	}
+}
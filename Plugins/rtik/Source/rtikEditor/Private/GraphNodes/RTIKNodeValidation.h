@@ -0,0 +1,52 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IK/IKInstanceState.h"
+
+class UAnimGraphNode_Base;
+class USkeleton;
+class FCompilerResultsLog;
+
+/*
+* Checks shared by the RTIK graph nodes' ValidateAnimNodeDuringCompilation. Only values set on the node itself are
+* checked; anything connected to a pin is only known at runtime, and is still checked there.
+*
+* Each input is a handle plus a wrapper pin. An input is an error if nothing is connected and the handle has no name.
+* A handle with settings (or a rig) has them checked against the skeleton being compiled for. A handle without
+* settings is assumed to name a slot set up by another node, and isn't checked further.
+*/
+struct FRTIKNodeValidation
+{
+public:
+
+	// True if the pin for the node property named PropertyName is shown and connected
+	static bool IsPinLinked(const UAnimGraphNode_Base* GraphNode, FName PropertyName);
+
+	static void ValidateLegInput(UAnimGraphNode_Base* GraphNode, USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog,
+		const FHumanoidLegChainHandle& Handle, FName HandleProperty, FName WrapperProperty);
+
+	// MinBones is the fewest bones the node can solve
+	static void ValidateChainInput(UAnimGraphNode_Base* GraphNode, USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog,
+		const FRangeLimitedIKChainHandle& Handle, FName HandleProperty, FName WrapperProperty, int32 MinBones);
+
+	static void ValidateBoneInput(UAnimGraphNode_Base* GraphNode, USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog,
+		const FIKBoneHandle& Handle, FName HandleProperty, FName WrapperProperty);
+
+	static void ValidateTraceDataInput(UAnimGraphNode_Base* GraphNode, FCompilerResultsLog& MessageLog,
+		const FHumanoidIKTraceDataHandle& Handle, FName HandleProperty, FName WrapperProperty);
+
+	// For bones set directly on the node, rather than through an input
+	static void ValidateBone(UAnimGraphNode_Base* GraphNode, USkeleton* ForSkeleton, FCompilerResultsLog& MessageLog,
+		const FIKBone& Bone, const TCHAR* Description);
+
+	static void ValidatePrecision(UAnimGraphNode_Base* GraphNode, FCompilerResultsLog& MessageLog, float Precision);
+
+protected:
+
+	// False if the input is connected, or is an error because it isn't set. Otherwise the handle's settings
+	// should be checked.
+	static bool ShouldCheckHandle(UAnimGraphNode_Base* GraphNode, FCompilerResultsLog& MessageLog, FName HandleName,
+		FName HandleProperty, FName WrapperProperty);
+};
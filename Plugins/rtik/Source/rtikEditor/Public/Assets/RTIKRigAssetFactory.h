@@ -0,0 +1,25 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Factories/Factory.h"
+#include "RTIKRigAssetFactory.generated.h"
+
+/*
+* Creates RTIK rig assets from the content browser (Animation > RTIK Rig)
+*/
+UCLASS()
+class RTIKEDITOR_API URTIKRigAssetFactory : public UFactory
+{
+	GENERATED_BODY()
+
+public:
+
+	URTIKRigAssetFactory(const FObjectInitializer& ObjectInitializer);
+
+	// UFactory interface
+	virtual UObject* FactoryCreateNew(UClass* Class, UObject* InParent, FName Name, EObjectFlags Flags,
+		UObject* Context, FFeedbackContext* Warn) override;
+	// End UFactory interface
+};
@@ -1,18 +1,35 @@
-// Copyright (c) Henry Cooney 2017
- 
-#include "rtikEditor.h"
- 
-IMPLEMENT_GAME_MODULE(FrtikEditorModule, rtikEditor);
-
-DEFINE_LOG_CATEGORY(LogRTIKEditor)
- 
-void FrtikEditorModule::StartupModule()
-{
-	UE_LOG(LogRTIKEditor, Warning, TEXT("IK editor module staring"));
-}
- 
-void FrtikEditorModule::ShutdownModule()
-{
-	UE_LOG(LogRTIKEditor, Warning, TEXT("IK editor module shutdown"));
-}
- 
+// Copyright (c) Henry Cooney 2017
+ 
+#include "rtikEditor.h"
+#include "AssetToolsModule.h"
+#include "AssetTypeActions_RTIKRigAsset.h"
+ 
+IMPLEMENT_GAME_MODULE(FrtikEditorModule, rtikEditor);
+
+DEFINE_LOG_CATEGORY(LogRTIKEditor)
+ 
+void FrtikEditorModule::StartupModule()
+{
+	UE_LOG(LogRTIKEditor, Warning, TEXT("IK editor module staring"));
+
+	IAssetTools& AssetTools = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools").Get();
+	TSharedPtr<IAssetTypeActions> RigActions = MakeShareable(new FAssetTypeActions_RTIKRigAsset());
+	AssetTools.RegisterAssetTypeActions(RigActions.ToSharedRef());
+	RegisteredAssetTypeActions.Add(RigActions);
+}
+ 
+void FrtikEditorModule::ShutdownModule()
+{
+	UE_LOG(LogRTIKEditor, Warning, TEXT("IK editor module shutdown"));
+
+	if (FModuleManager::Get().IsModuleLoaded("AssetTools"))
+	{
+		IAssetTools& AssetTools = FModuleManager::GetModuleChecked<FAssetToolsModule>("AssetTools").Get();
+		for (const TSharedPtr<IAssetTypeActions>& Actions : RegisteredAssetTypeActions)
+		{
+			AssetTools.UnregisterAssetTypeActions(Actions.ToSharedRef());
+		}
+	}
+	RegisteredAssetTypeActions.Empty();
+}
+ 
@@ -0,0 +1,434 @@
+// Copyright (c) Henry Cooney 2017
+
+#include "CrowdStressTest.h"
+#include "IKDemo.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "IK/IKStats.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/ConstructorHelpers.h"
+
+namespace
+{
+	typedef TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> FCrowdJsonWriter;
+
+	// Characters are dropped onto the ground from this far above the highest tile
+	const float SpawnTraceHeight = 1000.0f;
+
+	const float TileThickness = 50.0f;
+
+	double Mean(const TArray<double>& Samples)
+	{
+		double Sum = 0.0;
+		for (double Sample : Samples)
+		{
+			Sum += Sample;
+		}
+		return Samples.Num() > 0 ? Sum / Samples.Num() : 0.0;
+	}
+
+	// Fraction in [0, 1]
+	double Percentile(TArray<double> Samples, double Fraction)
+	{
+		if (Samples.Num() < 1)
+		{
+			return 0.0;
+		}
+		Samples.Sort();
+		int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * Samples.Num()) - 1, 0, Samples.Num() - 1);
+		return Samples[Index];
+	}
+
+	void HandleCrowdStressTest(const TArray<FString>& Args, UWorld* World)
+	{
+		if (World == nullptr || !World->IsGameWorld())
+		{
+			UE_LOG(LogIKDemo, Warning, TEXT("rtik.CrowdStressTest must be run in a game world"));
+			return;
+		}
+
+		ACrowdStressTest* Test = World->SpawnActor<ACrowdStressTest>();
+		if (Test == nullptr)
+		{
+			return;
+		}
+
+		if (Args.Num() > 0)
+		{
+			TArray<FString> Sizes;
+			Args[0].ParseIntoArray(Sizes, TEXT(","));
+			Test->CrowdSizes.Reset();
+			for (const FString& Size : Sizes)
+			{
+				Test->CrowdSizes.Add(FMath::Max(FCString::Atoi(*Size), 1));
+			}
+		}
+
+		if (Args.Num() > 1)
+		{
+			Test->MeasuredFrames = FMath::Max(FCString::Atoi(*Args[1]), 1);
+		}
+
+		Test->bQuitWhenDone = Args.Num() > 2 && Args[2].Equals(TEXT("quit"), ESearchCase::IgnoreCase);
+		Test->RunTest();
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs CrowdStressTestCommand(
+		TEXT("rtik.CrowdStressTest"),
+		TEXT("Measures RTIK cost over increasing crowd sizes. Usage: rtik.CrowdStressTest [CrowdSizes] [Frames] [quit], ")
+		TEXT("where CrowdSizes is comma separated, e.g. 10,100,500,1000."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&HandleCrowdStressTest));
+}
+
+ACrowdStressTest::ACrowdStressTest()
+	:
+	WarmupFrames(30),
+	MeasuredFrames(300),
+	Spacing(200.0f),
+	MaxTileHeight(40.0f),
+	MaxTileSlopeDegrees(20.0f),
+	Seed(1),
+	bRunOnBeginPlay(false),
+	bQuitWhenDone(false),
+	TileMesh(nullptr),
+	bRunning(false),
+	CrowdIndex(0),
+	FrameInCrowd(0),
+	LastFrameTime(0.0)
+{
+	// Tick after animation has finished for the frame, so the counters hold the whole frame's work
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	CrowdSizes.Add(10);
+	CrowdSizes.Add(100);
+	CrowdSizes.Add(500);
+	CrowdSizes.Add(1000);
+
+	static ConstructorHelpers::FClassFinder<ACharacter> PatrolMannequin(
+		TEXT("/Game/Blueprints/Characters/PatrolMannequin/CHAR_PatrolMannequin"));
+	if (PatrolMannequin.Succeeded())
+	{
+		CharacterClass = PatrolMannequin.Class;
+	}
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> Cube(TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (Cube.Succeeded())
+	{
+		TileMesh = Cube.Object;
+	}
+}
+
+void ACrowdStressTest::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (bRunOnBeginPlay)
+	{
+		RunTest();
+	}
+}
+
+void ACrowdStressTest::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bRunning)
+	{
+		FIKFrameCounters::SetEnabled(false);
+		bRunning = false;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACrowdStressTest::RunTest()
+{
+	if (bRunning)
+	{
+		return;
+	}
+
+	if (CharacterClass == nullptr || CrowdSizes.Num() < 1)
+	{
+		UE_LOG(LogIKDemo, Warning, TEXT("Crowd stress test: no character class or crowd sizes set"));
+		return;
+	}
+
+	int32 LargestCrowd = 0;
+	for (int32 Size : CrowdSizes)
+	{
+		LargestCrowd = FMath::Max(LargestCrowd, Size);
+	}
+
+	// One tile per character, on a square grid big enough for the largest crowd
+	DestroyCrowd();
+	SpawnGround(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(LargestCrowd))));
+
+	Results.Reset();
+	CrowdIndex = 0;
+	FrameInCrowd = 0;
+	bRunning = true;
+
+	FIKFrameCounters::SetEnabled(true);
+	SpawnCrowd(CrowdSizes[0]);
+
+	UE_LOG(LogIKDemo, Display, TEXT("Crowd stress test: started, %d crowd sizes, %d frames each"),
+		CrowdSizes.Num(), MeasuredFrames);
+}
+
+void ACrowdStressTest::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bRunning)
+	{
+		return;
+	}
+
+	double Now = FPlatformTime::Seconds();
+	FIKFrameCounters::FTotals Totals = FIKFrameCounters::Consume();
+
+	// The first measured frame needs a frame before it to time against, so measuring starts one frame after warmup
+	if (FrameInCrowd > WarmupFrames)
+	{
+		FCrowdResult& Result = Results.Last();
+		Result.FrameMilliseconds.Add((Now - LastFrameTime) * 1000.0);
+		Result.NodeMilliseconds.Add(Totals.NodeSeconds * 1000.0);
+		Result.Solves        += Totals.Solves;
+		Result.Iterations    += Totals.Iterations;
+		Result.TracesIssued  += Totals.TracesIssued;
+		Result.TracesSkipped += Totals.TracesSkipped;
+	}
+
+	LastFrameTime = Now;
+	++FrameInCrowd;
+
+	if (FrameInCrowd <= WarmupFrames + MeasuredFrames)
+	{
+		return;
+	}
+
+	LogResult(Results.Last());
+	DestroyCrowd();
+
+	++CrowdIndex;
+	if (CrowdIndex < CrowdSizes.Num())
+	{
+		FrameInCrowd = 0;
+		SpawnCrowd(CrowdSizes[CrowdIndex]);
+	}
+	else
+	{
+		FinishTest();
+	}
+}
+
+void ACrowdStressTest::SpawnGround(int32 GridSize)
+{
+	for (AStaticMeshActor* Tile : GroundTiles)
+	{
+		if (Tile != nullptr)
+		{
+			Tile->Destroy();
+		}
+	}
+	GroundTiles.Reset();
+
+	if (TileMesh == nullptr)
+	{
+		UE_LOG(LogIKDemo, Warning, TEXT("Crowd stress test: could not load the ground tile mesh; characters will fall"));
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	FRandomStream Random(Seed);
+	FVector Origin = GetActorLocation();
+
+	// The cube mesh is 100 units on a side. Tiles overlap a little so tilted neighbours leave no gaps.
+	FVector TileScale(Spacing * 1.1f / 100.0f, Spacing * 1.1f / 100.0f, TileThickness / 100.0f);
+
+	for (int32 Row = 0; Row < GridSize; ++Row)
+	{
+		for (int32 Column = 0; Column < GridSize; ++Column)
+		{
+			FVector Location = Origin + FVector(Row * Spacing, Column * Spacing,
+				Random.FRandRange(-MaxTileHeight, MaxTileHeight));
+			FRotator Rotation(Random.FRandRange(-MaxTileSlopeDegrees, MaxTileSlopeDegrees), 0.0f,
+				Random.FRandRange(-MaxTileSlopeDegrees, MaxTileSlopeDegrees));
+
+			AStaticMeshActor* Tile = World->SpawnActor<AStaticMeshActor>(Location, Rotation);
+			if (Tile == nullptr)
+			{
+				continue;
+			}
+
+			UStaticMeshComponent* TileComponent = Tile->GetStaticMeshComponent();
+			TileComponent->SetMobility(EComponentMobility::Movable);
+			TileComponent->SetStaticMesh(TileMesh);
+			Tile->SetActorScale3D(TileScale);
+			GroundTiles.Add(Tile);
+		}
+	}
+}
+
+void ACrowdStressTest::SpawnCrowd(int32 NumCharacters)
+{
+	UWorld* World = GetWorld();
+	FRandomStream Random(Seed + NumCharacters);
+	FVector Origin = GetActorLocation();
+
+	int32 GridSize = FMath::Max(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters))), 1);
+	float Jitter = Spacing * 0.25f;
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	FCollisionQueryParams QueryParams(FName(TEXT("CrowdStressTestSpawn")));
+
+	Crowd.Reset(NumCharacters);
+	for (int32 CharacterIndex = 0; CharacterIndex < NumCharacters; ++CharacterIndex)
+	{
+		FVector Location = Origin + FVector((CharacterIndex / GridSize) * Spacing + Random.FRandRange(-Jitter, Jitter),
+			(CharacterIndex % GridSize) * Spacing + Random.FRandRange(-Jitter, Jitter), 0.0f);
+		FRotator Rotation(0.0f, Random.FRandRange(-180.0f, 180.0f), 0.0f);
+
+		// Stand the character on the ground below
+		float HalfHeight = CharacterClass->GetDefaultObject<ACharacter>()->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+		FHitResult Hit;
+		FVector TraceStart = Location + FVector(0.0f, 0.0f, MaxTileHeight + SpawnTraceHeight);
+		FVector TraceEnd = Location - FVector(0.0f, 0.0f, MaxTileHeight + SpawnTraceHeight);
+		if (World->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, ECC_Visibility, QueryParams))
+		{
+			Location.Z = Hit.ImpactPoint.Z + HalfHeight;
+		}
+		else
+		{
+			Location.Z += HalfHeight;
+		}
+
+		ACharacter* Character = World->SpawnActor<ACharacter>(CharacterClass, Location, Rotation, SpawnParameters);
+		if (Character == nullptr)
+		{
+			continue;
+		}
+
+		// Characters that aren't rendered (e.g. under -nullrhi) would otherwise skip animation entirely
+		Character->GetMesh()->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones;
+		Character->SpawnDefaultController();
+		Crowd.Add(Character);
+	}
+
+	FCrowdResult& Result = Results[Results.AddDefaulted()];
+	Result.NumCharacters = Crowd.Num();
+	Result.Solves        = 0;
+	Result.Iterations    = 0;
+	Result.TracesIssued  = 0;
+	Result.TracesSkipped = 0;
+	Result.FrameMilliseconds.Reserve(MeasuredFrames);
+	Result.NodeMilliseconds.Reserve(MeasuredFrames);
+}
+
+void ACrowdStressTest::DestroyCrowd()
+{
+	for (ACharacter* Character : Crowd)
+	{
+		if (Character == nullptr)
+		{
+			continue;
+		}
+
+		if (AController* Controller = Character->GetController())
+		{
+			Controller->Destroy();
+		}
+		Character->Destroy();
+	}
+	Crowd.Reset();
+}
+
+void ACrowdStressTest::FinishTest()
+{
+	bRunning = false;
+	FIKFrameCounters::SetEnabled(false);
+
+	WriteResults();
+	UE_LOG(LogIKDemo, Display, TEXT("Crowd stress test: done"));
+
+	if (bQuitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void ACrowdStressTest::LogResult(const FCrowdResult& Result)
+{
+	int32 NumFrames = FMath::Max(Result.FrameMilliseconds.Num(), 1);
+
+	UE_LOG(LogIKDemo, Display,
+		TEXT("Crowd stress test: %4d characters: frame %.2f ms (p95 %.2f), RTIK nodes %.2f ms (p95 %.2f), ")
+		TEXT("%.1f solves, %.1f iterations, %.1f traces issued, %.1f skipped per frame"),
+		Result.NumCharacters,
+		Mean(Result.FrameMilliseconds), Percentile(Result.FrameMilliseconds, 0.95),
+		Mean(Result.NodeMilliseconds), Percentile(Result.NodeMilliseconds, 0.95),
+		static_cast<double>(Result.Solves) / NumFrames, static_cast<double>(Result.Iterations) / NumFrames,
+		static_cast<double>(Result.TracesIssued) / NumFrames, static_cast<double>(Result.TracesSkipped) / NumFrames);
+}
+
+void ACrowdStressTest::WriteResults() const
+{
+	FString Json;
+	FCrowdJsonWriter Writer = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+
+	Writer->WriteObjectStart();
+	Writer->WriteValue(TEXT("Character"), CharacterClass != nullptr ? CharacterClass->GetPathName() : FString());
+	Writer->WriteValue(TEXT("Seed"), Seed);
+	Writer->WriteValue(TEXT("WarmupFrames"), WarmupFrames);
+	Writer->WriteValue(TEXT("MeasuredFrames"), MeasuredFrames);
+
+	Writer->WriteArrayStart(TEXT("Crowds"));
+	for (const FCrowdResult& Result : Results)
+	{
+		int32 NumFrames = FMath::Max(Result.FrameMilliseconds.Num(), 1);
+
+		Writer->WriteObjectStart();
+		Writer->WriteValue(TEXT("NumCharacters"), Result.NumCharacters);
+
+		Writer->WriteValue(TEXT("FrameMsMean"), Mean(Result.FrameMilliseconds));
+		Writer->WriteValue(TEXT("FrameMsMedian"), Percentile(Result.FrameMilliseconds, 0.5));
+		Writer->WriteValue(TEXT("FrameMsP95"), Percentile(Result.FrameMilliseconds, 0.95));
+		Writer->WriteValue(TEXT("FrameMsMax"), Percentile(Result.FrameMilliseconds, 1.0));
+
+		Writer->WriteValue(TEXT("NodeMsMean"), Mean(Result.NodeMilliseconds));
+		Writer->WriteValue(TEXT("NodeMsMedian"), Percentile(Result.NodeMilliseconds, 0.5));
+		Writer->WriteValue(TEXT("NodeMsP95"), Percentile(Result.NodeMilliseconds, 0.95));
+		Writer->WriteValue(TEXT("NodeMsMax"), Percentile(Result.NodeMilliseconds, 1.0));
+		Writer->WriteValue(TEXT("NodeUsPerCharacter"),
+			Result.NumCharacters > 0 ? Mean(Result.NodeMilliseconds) * 1000.0 / Result.NumCharacters : 0.0);
+
+		Writer->WriteValue(TEXT("SolvesPerFrame"), static_cast<double>(Result.Solves) / NumFrames);
+		Writer->WriteValue(TEXT("IterationsPerFrame"), static_cast<double>(Result.Iterations) / NumFrames);
+		Writer->WriteValue(TEXT("TracesIssuedPerFrame"), static_cast<double>(Result.TracesIssued) / NumFrames);
+		Writer->WriteValue(TEXT("TracesSkippedPerFrame"), static_cast<double>(Result.TracesSkipped) / NumFrames);
+		Writer->WriteObjectEnd();
+	}
+	Writer->WriteArrayEnd();
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
+
+	FString OutputPath = FPaths::GameSavedDir() / TEXT("RTIK") / TEXT("CrowdStressTest.json");
+	if (!FFileHelper::SaveStringToFile(Json, *OutputPath))
+	{
+		UE_LOG(LogIKDemo, Error, TEXT("Crowd stress test: could not write %s"), *OutputPath);
+		return;
+	}
+
+	UE_LOG(LogIKDemo, Display, TEXT("Crowd stress test: wrote %s"), *OutputPath);
+}
@@ -0,0 +1,129 @@
+// Copyright (c) Henry Cooney 2017
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/Character.h"
+#include "CrowdStressTest.generated.h"
+
+class AStaticMeshActor;
+
+/*
+* Measures how RTIK scales with crowd size. For each crowd size in turn, spawns that many characters (by default
+* CHAR_PatrolMannequin, which runs the full lower-body IK graph) on a grid of randomly tilted ground tiles, lets
+* them settle, then measures a fixed number of frames: frame time, time spent in RTIK nodes (summed over all
+* threads), solves, solver iterations and traces. Layout comes from a seeded random stream, so runs are repeatable.
+*
+* Results are logged, and written as JSON to Saved/RTIK/CrowdStressTest.json.
+*
+* Place one in a level, or start one from the console (or the command line, with -ExecCmds):
+*
+*   rtik.CrowdStressTest [CrowdSizes] [Frames] [quit]
+*
+* CrowdSizes is comma separated, e.g. 10,100,500,1000 (the default). With 'quit', the game exits when the test is
+* done. For a reproducible headless run, also fix the frame rate:
+*
+*   UE4Editor IKDemo -game -nullrhi -benchmark -fps=30 -ExecCmds="rtik.CrowdStressTest 10,100,500,1000 300 quit"
+*/
+UCLASS()
+class IKDEMO_API ACrowdStressTest : public AActor
+{
+	GENERATED_BODY()
+
+public:
+
+	ACrowdStressTest();
+
+	// Character to spawn. Should use an anim blueprint with RTIK nodes.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	TSubclassOf<ACharacter> CharacterClass;
+
+	// Crowd sizes to measure, in order
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	TArray<int32> CrowdSizes;
+
+	// Frames to run after spawning each crowd, before measuring
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	int32 WarmupFrames;
+
+	// Frames to measure for each crowd
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	int32 MeasuredFrames;
+
+	// Distance between neighbouring characters
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	float Spacing;
+
+	// Ground tiles are raised or lowered by up to this much
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	float MaxTileHeight;
+
+	// Ground tiles are tilted by up to this many degrees
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	float MaxTileSlopeDegrees;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	int32 Seed;
+
+	// If true, the test starts as soon as the actor begins play
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	bool bRunOnBeginPlay;
+
+	// If true, the game exits when the test is done
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stress Test")
+	bool bQuitWhenDone;
+
+	// Starts measuring, from the first crowd size
+	UFUNCTION(BlueprintCallable, Category = "Stress Test")
+	void RunTest();
+
+protected:
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+
+protected:
+
+	// Measurements for one crowd size
+	struct FCrowdResult
+	{
+		int32 NumCharacters;
+
+		// One entry per measured frame
+		TArray<double> FrameMilliseconds;
+		TArray<double> NodeMilliseconds;
+
+		int64 Solves;
+		int64 Iterations;
+		int64 TracesIssued;
+		int64 TracesSkipped;
+	};
+
+	void SpawnGround(int32 GridSize);
+	void SpawnCrowd(int32 NumCharacters);
+	void DestroyCrowd();
+	void FinishTest();
+	void WriteResults() const;
+
+	static void LogResult(const FCrowdResult& Result);
+
+	UPROPERTY(Transient)
+	TArray<ACharacter*> Crowd;
+
+	UPROPERTY(Transient)
+	TArray<AStaticMeshActor*> GroundTiles;
+
+	UPROPERTY(Transient)
+	UStaticMesh* TileMesh;
+
+	bool bRunning;
+	int32 CrowdIndex;
+	int32 FrameInCrowd;
+	double LastFrameTime;
+	TArray<FCrowdResult> Results;
+};
@@ -1,6 +1,8 @@
-// Copyright (c) Henry Cooney 2017
-
-#include "IKDemo.h"
-#include "Modules/ModuleManager.h"
-
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, IKDemo, "IKDemo" );
+// Copyright (c) Henry Cooney 2017
+
+#include "IKDemo.h"
+#include "Modules/ModuleManager.h"
+
+DEFINE_LOG_CATEGORY(LogIKDemo);
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, IKDemo, "IKDemo" );